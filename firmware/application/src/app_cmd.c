@@ -209,6 +209,12 @@ static data_frame_tx_t *cmd_processor_set_ble_pairing_enable(uint16_t cmd, uint1
     return data_frame_make(cmd, STATUS_SUCCESS, 0, NULL);
 }
 
+static data_frame_tx_t *cmd_processor_get_request_queue_size(uint16_t cmd, uint16_t status, uint16_t length, uint8_t *data) {
+    // bytes of requests a client can send ahead while one is processed, in tagged frames
+    uint16_t queue_size = U16HTONS(data_frame_queue_size());
+    return data_frame_make(cmd, STATUS_SUCCESS, sizeof(queue_size), (uint8_t *)&queue_size);
+}
+
 #if defined(PROJECT_CHAMELEON_ULTRA)
 
 static data_frame_tx_t *cmd_processor_hf14a_scan(uint16_t cmd, uint16_t status, uint16_t length, uint8_t *data) {
@@ -1943,6 +1949,7 @@ static cmd_data_map_t m_data_cmd_map[] = {
     {    DATA_CMD_GET_BLE_PAIRING_ENABLE,       NULL,                        cmd_processor_get_ble_pairing_enable,        NULL                   },
     {    DATA_CMD_SET_BLE_PAIRING_ENABLE,       NULL,                        cmd_processor_set_ble_pairing_enable,        NULL                   },
     {    DATA_CMD_GET_ALL_SLOT_NICKS,           NULL,                        cmd_processor_get_all_slot_nicks,            NULL                   },
+    {    DATA_CMD_GET_REQUEST_QUEUE_SIZE,       NULL,                        cmd_processor_get_request_queue_size,        NULL                   },
 
 #if defined(PROJECT_CHAMELEON_ULTRA)
 
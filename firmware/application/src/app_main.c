@@ -1010,8 +1010,10 @@ int main(void) {
             blink_usb_led_status();
         }
         
-        // Data pack process
-        data_frame_process();
+        // Data pack process, a queued request waits until the previous response is sent
+        if (!usb_cdc_tx_busy()) {
+            data_frame_process();
+        }
         // Log print process
         while (NRF_LOG_PROCESS());
         // USB event process
@@ -1021,6 +1023,9 @@ int main(void) {
         // No task to process, system sleep enter.
         // If system idle sometime, we can enter deep sleep state.
         // Some task process done, we can enter cpu sleep state.
-        sleep_system_run(system_off_enter, nrf_pwr_mgmt_run);
+        // A queued request which can be processed now keeps the loop running.
+        if (!data_frame_pending() || usb_cdc_tx_busy()) {
+            sleep_system_run(system_off_enter, nrf_pwr_mgmt_run);
+        }
     }
 }
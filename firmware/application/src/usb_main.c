@@ -41,6 +41,8 @@ volatile bool g_usb_connected = false;
 volatile bool g_usb_port_opened = false;
 volatile bool g_usb_led_marquee_enable = true;
 static uint8_t cdc_data_buffer[NRF_DRV_USBD_EPSIZE];
+// the response buffer is sent in place, the next response has to wait for TX_DONE
+static volatile bool m_usb_tx_busy = false;
 
 /** @brief User event handler @ref app_usbd_cdc_acm_user_ev_handler_t */
 static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const *p_inst, app_usbd_cdc_acm_user_event_t event) {
@@ -61,10 +63,12 @@ static void cdc_acm_user_ev_handler(app_usbd_class_inst_t const *p_inst, app_usb
         case APP_USBD_CDC_ACM_USER_EVT_PORT_CLOSE:
             NRF_LOG_INFO("CDC ACM port closed");
             g_usb_port_opened = false;
+            m_usb_tx_busy = false;
             g_usb_led_marquee_enable = true;
             break;
 
         case APP_USBD_CDC_ACM_USER_EVT_TX_DONE:
+            m_usb_tx_busy = false;
             break;
 
         case APP_USBD_CDC_ACM_USER_EVT_RX_DONE: {
@@ -114,6 +118,7 @@ static void usbd_user_ev_handler(app_usbd_event_type_t event) {
             sleep_timer_start(SLEEP_DELAY_MS_USB_POWER_DISCONNECTED);
             NRF_LOG_INFO("USB power removed");
             g_usb_connected = false;
+            m_usb_tx_busy = false;
             g_usb_led_marquee_enable = false;
             app_usbd_stop();
             break;
@@ -149,10 +154,15 @@ void usb_cdc_init(void) {
 }
 
 void usb_cdc_write(const void *p_buf, uint16_t length) {
+    m_usb_tx_busy = true;
     ret_code_t err_code = app_usbd_cdc_acm_write(&m_app_cdc_acm, p_buf, length);
     APP_ERROR_CHECK(err_code);
 }
 
+bool usb_cdc_tx_busy(void) {
+    return m_usb_tx_busy;
+}
+
 // override fputc to printf to cdc serial
 /* dont't enable
 int fputc(int ch, FILE *f){
@@ -6,6 +6,7 @@
 
 void usb_cdc_init(void);
 void usb_cdc_write(const void *p_buf, uint16_t length);
+bool usb_cdc_tx_busy(void);
 bool is_usb_working(void);
 
 #endif
@@ -1,5 +1,6 @@
 #include "dataframe.h"
 #include "netdata.h"
+#include "app_util_platform.h"
 
 #define NRF_LOG_MODULE_NAME data_frame
 #include "nrf_log.h"
@@ -17,8 +18,21 @@ static uint16_t m_data_cmd;
 static uint16_t m_data_status;
 static uint16_t m_data_len;
 static uint8_t *m_data_buffer;
+static bool m_data_tagged;
+static uint16_t m_data_tag;
 static volatile bool m_data_completed = false;
 static data_frame_cbk_t m_frame_process_cbk = NULL;
+// the response made while a tagged frame is processed is tagged as well
+static bool m_tx_tagged = false;
+static uint16_t m_tx_tag;
+
+// Bytes which arrive while a frame waits for processing are queued here, so that a client can
+// send its next requests without waiting for the responses to the previous ones.
+// Head and tail run freely, the size must divide 65536.
+#define DATA_FRAME_RX_QUEUE_SIZE 1024
+static uint8_t m_rx_queue[DATA_FRAME_RX_QUEUE_SIZE];
+static volatile uint16_t m_rx_queue_head = 0;
+static volatile uint16_t m_rx_queue_tail = 0;
 
 static uint8_t compute_lrc(uint8_t *buf, uint16_t bufsize) {
     uint8_t lrc = 0x00;
@@ -55,7 +69,11 @@ data_frame_tx_t *data_frame_make(uint16_t cmd, uint16_t status, uint16_t data_le
     //     NRF_LOG_HEXDUMP_INFO(data, data_length);
     // }
 
-    netdata_frame_postamble_t *tx_post = (netdata_frame_postamble_t *)((uint8_t *)&m_netdata_frame_tx_buf + sizeof(netdata_frame_preamble_t) + data_length);
+    uint16_t tag_length = m_tx_tagged ? NETDATA_FRAME_TAG_LENGTH : 0;
+    if (m_tx_tagged) {
+        cmd |= NETDATA_FRAME_TAGGED;
+    }
+    netdata_frame_postamble_t *tx_post = (netdata_frame_postamble_t *)((uint8_t *)&m_netdata_frame_tx_buf + sizeof(netdata_frame_preamble_t) + tag_length + data_length);
     // sof
     m_netdata_frame_tx_buf.pre.sof = NETDATA_FRAME_SOF;
     // sof lrc
@@ -65,17 +83,22 @@ data_frame_tx_t *data_frame_make(uint16_t cmd, uint16_t status, uint16_t data_le
     // status
     m_netdata_frame_tx_buf.pre.status = U16HTONS(status);
     // data_length
-    m_netdata_frame_tx_buf.pre.len = U16HTONS(data_length);
+    m_netdata_frame_tx_buf.pre.len = U16HTONS(tag_length + data_length);
     // head lrc
     m_netdata_frame_tx_buf.pre.lrc2 = compute_lrc((uint8_t *)&m_netdata_frame_tx_buf.pre, offsetof(netdata_frame_preamble_t, lrc2));
+    // tag
+    if (m_tx_tagged) {
+        m_netdata_frame_tx_buf.data[0] = m_tx_tag >> 8;
+        m_netdata_frame_tx_buf.data[1] = m_tx_tag & 0xff;
+    }
     // data
     if (data_length > 0) {
-        memcpy(&m_netdata_frame_tx_buf.data, data, data_length);
+        memcpy(&m_netdata_frame_tx_buf.data[tag_length], data, data_length);
     }
     // length out.
-    m_frame_tx_buf_info.length = (sizeof(netdata_frame_preamble_t) + data_length + sizeof(netdata_frame_postamble_t));
+    m_frame_tx_buf_info.length = (sizeof(netdata_frame_preamble_t) + tag_length + data_length + sizeof(netdata_frame_postamble_t));
     // data all lrc
-    tx_post->lrc3 = compute_lrc((uint8_t *)&m_netdata_frame_tx_buf.data, data_length);
+    tx_post->lrc3 = compute_lrc((uint8_t *)&m_netdata_frame_tx_buf.data, tag_length + data_length);
     return (&m_frame_tx_buf_info);
 }
 
@@ -87,24 +110,13 @@ void data_frame_reset(void) {
 }
 
 /**
- * @brief Package receiving, which is used to receive the sent from the data packet and perform splicing processing
- * @param data: Receive byte array
- * @param length:The length of the receiving byte array
+ * @brief Frame parser, takes bytes up to the end of the first complete frame
+ * @param data: Received bytes
+ * @param length: Number of received bytes
+ * @return Number of bytes taken
  */
-void data_frame_receive(uint8_t *data, uint16_t length) {
-    // buffer wait process
-    if (m_data_completed) {
-        NRF_LOG_ERROR("Data frame wait process.");
-        return;
-    }
-    // buffer overflow
-    if (m_data_rx_position + length > sizeof(m_netdata_frame_rx_buf)) {
-        NRF_LOG_ERROR("Data frame wait overflow.");
-        data_frame_reset();
-        return;
-    }
-    // frame process
-    for (int i = 0; i < length; i++) {
+static uint16_t data_frame_parse(const uint8_t *data, uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
         // copy to buffer
         ((uint8_t *)(&m_netdata_frame_rx_buf))[m_data_rx_position] = data[i];
         if (m_data_rx_position == offsetof(netdata_frame_preamble_t, sof)) {
@@ -112,32 +124,38 @@ void data_frame_receive(uint8_t *data, uint16_t length) {
                 // not sof byte
                 NRF_LOG_ERROR("Data frame no sof byte.");
                 data_frame_reset();
-                return;
+                continue;
             }
         } else if (m_data_rx_position == offsetof(netdata_frame_preamble_t, lrc1)) {
             if (m_netdata_frame_rx_buf.pre.lrc1 != compute_lrc((uint8_t *)&m_netdata_frame_rx_buf.pre, offsetof(netdata_frame_preamble_t, lrc1))) {
                 // not sof lrc byte
                 NRF_LOG_ERROR("Data frame sof lrc error.");
                 data_frame_reset();
-                return;
+                continue;
             }
         } else if (m_data_rx_position == offsetof(netdata_frame_preamble_t, lrc2)) {  // frame head lrc
             if (m_netdata_frame_rx_buf.pre.lrc2 != compute_lrc((uint8_t *)&m_netdata_frame_rx_buf.pre, offsetof(netdata_frame_preamble_t, lrc2))) {
                 // frame head lrc error
                 NRF_LOG_ERROR("Data frame head lrc error.");
                 data_frame_reset();
-                return;
+                continue;
             }
             // frame head complete, cache info
             m_data_cmd = U16NTOHS(m_netdata_frame_rx_buf.pre.cmd);
             m_data_status = U16NTOHS(m_netdata_frame_rx_buf.pre.status);
             m_data_len = U16NTOHS(m_netdata_frame_rx_buf.pre.len);
+            m_data_tagged = (m_data_cmd & NETDATA_FRAME_TAGGED) != 0;
             NRF_LOG_INFO("Data frame data length %d.", m_data_len);
             // check data length
-            if (m_data_len > NETDATA_MAX_DATA_LENGTH) {
+            if (m_data_len > NETDATA_MAX_DATA_LENGTH + (m_data_tagged ? NETDATA_FRAME_TAG_LENGTH : 0)) {
                 NRF_LOG_ERROR("Data frame data length larger than max.");
                 data_frame_reset();
-                return;
+                continue;
+            }
+            if (m_data_tagged && m_data_len < NETDATA_FRAME_TAG_LENGTH) {
+                NRF_LOG_ERROR("Data frame tag missing.");
+                data_frame_reset();
+                continue;
             }
         } else if (m_data_rx_position >= offsetof(netdata_frame_raw_t, data)) {   // frame data
             // check all data ready.
@@ -146,23 +164,60 @@ void data_frame_receive(uint8_t *data, uint16_t length) {
                 if (rx_post->lrc3 == compute_lrc((uint8_t *)&m_netdata_frame_rx_buf.data, m_data_len)) {
                     // ok, lrc for data is check success.
                     // and we are receive completed
-                    m_data_buffer = m_data_len > 0 ? (uint8_t *)&m_netdata_frame_rx_buf.data : NULL;
+                    uint8_t *payload = (uint8_t *)&m_netdata_frame_rx_buf.data;
+                    if (m_data_tagged) {
+                        m_data_tag = (payload[0] << 8) | payload[1];
+                        m_data_cmd &= ~NETDATA_FRAME_TAGGED;
+                        m_data_len -= NETDATA_FRAME_TAG_LENGTH;
+                        payload += NETDATA_FRAME_TAG_LENGTH;
+                    }
+                    m_data_buffer = m_data_len > 0 ? payload : NULL;
                     m_data_completed = true;
                     // NRF_LOG_INFO("RX Data frame: cmd = 0x%04x (%i), status = 0x%04x, length = %d%s", m_data_cmd, m_data_cmd, m_data_status, m_data_len, m_data_len > 0 ? ", data =" : "");
                     // if (m_data_len > 0) {
                     //     NRF_LOG_HEXDUMP_INFO(m_data_buffer, m_data_len);
                     // }
+                    return i + 1;
                 } else {
                     // data frame lrc error
                     NRF_LOG_ERROR("Data frame finally lrc error.");
                     data_frame_reset();
+                    continue;
                 }
-                return;
             }
         }
         // index update
         m_data_rx_position++;
     }
+    return length;
+}
+
+/**
+ * @brief Package receiving, which is used to receive the sent from the data packet and perform splicing processing
+ * @param data: Receive byte array
+ * @param length:The length of the receiving byte array
+ */
+void data_frame_receive(uint8_t *data, uint16_t length) {
+    // nothing waits, parse in place
+    if (!m_data_completed && m_rx_queue_head == m_rx_queue_tail) {
+        uint16_t used = data_frame_parse(data, length);
+        data += used;
+        length -= used;
+    }
+    if (length == 0) {
+        return;
+    }
+    // the rest waits until the current frame is processed
+    uint16_t head = m_rx_queue_head;
+    if ((uint16_t)(head - m_rx_queue_tail) + length > DATA_FRAME_RX_QUEUE_SIZE) {
+        NRF_LOG_ERROR("Data frame queue overflow.");
+        return;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        m_rx_queue[(uint16_t)(head + i) % DATA_FRAME_RX_QUEUE_SIZE] = data[i];
+    }
+    __DMB();
+    m_rx_queue_head = head + length;
 }
 
 /**
@@ -175,14 +230,37 @@ void data_frame_process(void) {
     if (m_data_completed) {
         // to process data frame
         if (m_frame_process_cbk != NULL) {
+            m_tx_tagged = m_data_tagged;
+            m_tx_tag = m_data_tag;
             m_frame_process_cbk(m_data_cmd, m_data_status, m_data_len, m_data_buffer);
+            m_tx_tagged = false;
         }
-        // reset after process data frame.
+        // reset after process data frame, and parse what was queued meanwhile up to the next frame.
+        // The receive events may run in interrupt context, they must not parse at the same time.
+        CRITICAL_REGION_ENTER();
         data_frame_reset();
         m_data_completed = false;
+        while (!m_data_completed && m_rx_queue_tail != m_rx_queue_head) {
+            m_rx_queue_tail += data_frame_parse(&m_rx_queue[m_rx_queue_tail % DATA_FRAME_RX_QUEUE_SIZE], 1);
+        }
+        CRITICAL_REGION_EXIT();
     }
 }
 
+/**
+ * @brief A complete frame waits for data_frame_process()
+ */
+bool data_frame_pending(void) {
+    return m_data_completed;
+}
+
+/**
+ * @brief Size of the queue for requests received while one is processed
+ */
+uint16_t data_frame_queue_size(void) {
+    return DATA_FRAME_RX_QUEUE_SIZE;
+}
+
 /**
  * @brief Package processing registration registration
  */
@@ -15,6 +15,8 @@ typedef struct {
 
 void data_frame_receive(uint8_t *data, uint16_t length);
 void data_frame_process(void);
+bool data_frame_pending(void);
+uint16_t data_frame_queue_size(void);
 void on_data_frame_complete(data_frame_cbk_t callback);
 
 data_frame_tx_t *data_frame_make(
@@ -19,6 +19,10 @@
  *
  *  The data length max is 4096, frame length is 1 + 1 + 2 + 2 + 2 + 1 + n + 1 = (10 + n)
  *  So, one frame will be between 10 and 4106 bytes.
+ *
+ *  Tagged frames: a request with bit 15 of CMD set carries a 2 byte tag (u16) in front of its data. The response has
+ *  bit 15 of CMD set as well and starts with the same tag, so that a client can have several requests in flight
+ *  and match the responses. The tag does not count against the 4096 bytes of data.
  * *********************************************************************************************************************************
  */
 
@@ -34,6 +38,8 @@ typedef struct {
 } PACKED netdata_frame_preamble_t;
 
 #define NETDATA_FRAME_SOF 0x11
+#define NETDATA_FRAME_TAGGED 0x8000
+#define NETDATA_FRAME_TAG_LENGTH 2
 
 typedef struct {
     uint8_t lrc3;
@@ -42,7 +48,7 @@ typedef struct {
 // For reception and CRC check
 typedef struct {
     netdata_frame_preamble_t pre;
-    uint8_t data[NETDATA_MAX_DATA_LENGTH];
+    uint8_t data[NETDATA_FRAME_TAG_LENGTH + NETDATA_MAX_DATA_LENGTH];
     netdata_frame_postamble_t foopost; // Probably not at that offset!
 } PACKED netdata_frame_raw_t;
 
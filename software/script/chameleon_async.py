@@ -0,0 +1,625 @@
+import asyncio
+import collections
+import struct
+from typing import AsyncIterator, Iterable, Union
+
+import serial
+
+from chameleon_com import (CMDInvalidException, DataFrameParser, FRAME_TAG_LENGTH, NotOpenException,
+                           OpenFailException, PIPELINE_WINDOW, Response)
+from chameleon_cmd import ChameleonCMD
+from chameleon_enum import Command, MfcKeyType, SlotNumber, Status, TagSenseType, TagSpecificType
+from chameleon_utils import expect_response
+
+
+class AsyncChameleonCom:
+    """
+        Chameleon device on an asyncio event loop
+
+        Same frames as ChameleonCom, built and parsed by the same DataFrameParser, but without
+        threads: responses complete futures from a receive task and timeouts are loop timers,
+        so one loop can drive several devices. Commands to one device take turns.
+
+        Serial ports need a POSIX system, elsewhere use a tcp: bridge.
+    """
+    data_frame_sof = 0x11
+    data_max_length = 4096
+
+    def __init__(self):
+        self.commands = []
+        # bytes of requests the device queues while it processes one, 0 if it doesn't support tagged frames
+        self.request_queue_size = 0
+        self.next_tag = 0
+        self.codec = DataFrameParser(self.data_frame_sof, self.data_max_length)
+        self.writer: Union[asyncio.StreamWriter, serial.Serial, None] = None
+        self.pipe: Union[asyncio.ReadTransport, None] = None
+        self.receiver: Union[asyncio.Task, None] = None
+        self.waiting: dict[object, asyncio.Future] = {}
+        self.lock = asyncio.Lock()
+
+    def isOpen(self) -> bool:
+        """
+            Chameleon is connected and init.
+
+        :return:
+        """
+        return self.writer is not None
+
+    def check_open(self) -> None:
+        """
+
+        :return:
+        """
+        if not self.isOpen():
+            raise NotOpenException("Please call open() function to start device.")
+
+    def check_command(self, cmd: int) -> None:
+        """
+            Check the device declared cmd in its capabilities, if it declared them.
+
+        :param cmd: cmd
+        :return:
+        """
+        if len(self.commands) and cmd not in self.commands:
+            raise CMDInvalidException(f"This device doesn't declare that it can support this command: {cmd}.\n"
+                                      f"Make sure firmware is up to date and matches client")
+
+    async def open(self, port: str) -> "AsyncChameleonCom":
+        """
+            Open chameleon port to communication
+
+        :param port: com port, ttyXXX or tcp:host:port
+        :return:
+        """
+        if self.isOpen():
+            return self
+        loop = asyncio.get_running_loop()
+        try:
+            if port.startswith('tcp:'):
+                host, _, port = port[4:].partition(':')
+                reader, self.writer = await asyncio.open_connection(host, int(port))
+            else:
+                device = serial.Serial(port=port, baudrate=115200, timeout=0)
+                try:
+                    device.dtr = True  # must make dtr enable
+                except Exception:
+                    # not all serial support dtr, e.g. virtual serial over BLE
+                    pass
+                reader = asyncio.StreamReader()
+                # the pipe transport owns the port and closes it
+                self.pipe, _ = await loop.connect_read_pipe(lambda: asyncio.StreamReaderProtocol(reader), device)
+                self.writer = device
+        except Exception as e:
+            raise OpenFailException(e)
+        self.request_queue_size = 0
+        self.receiver = asyncio.create_task(self.receive(reader, DataFrameParser(self.data_frame_sof,
+                                                                                 self.data_max_length)))
+        return self
+
+    async def close(self):
+        """
+            Close chameleon and fail the requests still waiting.
+
+        :return:
+        """
+        if self.receiver is not None and self.receiver is not asyncio.current_task():
+            self.receiver.cancel()
+            try:
+                await self.receiver
+            except asyncio.CancelledError:
+                pass
+        self.receiver = None
+        try:
+            if self.pipe is not None:
+                self.pipe.close()
+            elif isinstance(self.writer, asyncio.StreamWriter):
+                self.writer.close()
+        except Exception:
+            pass
+        self.pipe = None
+        self.writer = None
+        for future in self.waiting.values():
+            if not future.done():
+                future.set_exception(NotOpenException("Device closed while waiting for a response."))
+        self.waiting.clear()
+
+    async def receive(self, reader: asyncio.StreamReader, parser: DataFrameParser):
+        """
+            Task to receive data from chameleon device.
+
+        :return:
+        """
+        try:
+            while True:
+                data_bytes = await reader.read(65536)
+                if not data_bytes:
+                    break
+                for data_cmd, data_status, data_response in parser.feed(data_bytes):
+                    data_cmd, data_tag, data_response = parser.untag(data_cmd, data_response)
+                    # tagged requests wait under (cmd, tag)
+                    future = self.waiting.pop(data_cmd if data_tag is None else (data_cmd, data_tag), None)
+                    if future is not None and not future.done():
+                        future.set_result(Response(data_cmd, data_status, data_response))
+                    else:
+                        print(f"No task wait process: ${data_cmd}")
+        except OSError as e:
+            print(f"Receive error {e}.")
+        await self.close()
+
+    def send_frame(self, cmd: int, data: Union[bytes, None], status: int, key) -> asyncio.Future:
+        """
+            Write a frame and register the future its response completes.
+
+        :param key: cmd, or (cmd, tag) for tagged frames
+        :return: future of the response
+        """
+        self.check_open()
+        future = asyncio.get_running_loop().create_future()
+        self.waiting[key] = future
+        self.writer.write(self.codec.make(cmd, data, status, None if key == cmd else key[1]))
+        return future
+
+    async def wait_response(self, cmd: int, key, future: asyncio.Future, timeout: float) -> Response:
+        """
+            Wait for the response of send_frame.
+
+        :return: response data
+        """
+        try:
+            response = await asyncio.wait_for(future, timeout)
+        except asyncio.TimeoutError:
+            raise TimeoutError(f"CMD {cmd} exec timeout")
+        finally:
+            if self.waiting.get(key) is future:
+                del self.waiting[key]
+        if response.status == Status.INVALID_CMD:
+            raise CMDInvalidException(f"Device unsupported cmd: {cmd}")
+        return response
+
+    async def send_cmd(self, cmd: int, data: Union[bytes, None] = None, status: int = 0,
+                       timeout: float = 3) -> Response:
+        """
+            Send cmd to device and wait for its response, as ChameleonCom.send_cmd_sync.
+
+        :param cmd: cmd
+        :param data: bytes data (optional)
+        :param status: status (optional)
+        :param timeout: wait response timeout
+        :return: response data
+        """
+        self.check_command(cmd)
+        async with self.lock:
+            return await self.wait_response(cmd, cmd, self.send_frame(cmd, data, status, cmd), timeout)
+
+    async def send_cmd_auto(self, cmd: int, data: Union[bytes, None] = None, status: int = 0,
+                            close: bool = False):
+        """
+            Send cmd to device without waiting for a response.
+
+        :param close: close connection after sending
+        :return:
+        """
+        self.check_open()
+        async with self.lock:
+            self.writer.write(self.codec.make(cmd, data, status))
+            if isinstance(self.writer, asyncio.StreamWriter):
+                await self.writer.drain()
+        if close:
+            await self.close()
+
+    async def send_cmds_pipelined(self, requests: Iterable[tuple[int, Union[bytes, None]]],
+                                  window: int = PIPELINE_WINDOW, timeout: float = 3) -> AsyncIterator[Response]:
+        """
+            Send cmds with up to window of them in flight, and yield the responses in order,
+            as ChameleonCom.send_cmds_pipelined.
+
+            The device is reserved until the iteration ends, other commands to it wait.
+
+        :param requests: iterable of (cmd, data), consumed ahead of the responses
+        :param window: maximum number of requests in flight
+        :param timeout: wait response timeout of each request
+        :return: iterator of responses
+        """
+        async with self.lock:
+            if not self.request_queue_size:
+                for cmd, data in requests:
+                    self.check_command(cmd)
+                    yield await self.wait_response(cmd, cmd, self.send_frame(cmd, data, 0, cmd), timeout)
+                return
+
+            in_flight = collections.deque()  # (cmd, key, future, frame size)
+            in_flight_bytes = 0
+            requests = iter(requests)
+            request = next(requests, None)
+            try:
+                while request is not None or in_flight:
+                    # fill the window. The request queue of the device must hold all but the one it processes.
+                    while request is not None and len(in_flight) < window:
+                        cmd, data = request
+                        self.check_command(cmd)
+                        size = 10 + FRAME_TAG_LENGTH + (len(data) if data else 0)
+                        if in_flight and in_flight_bytes + size > self.request_queue_size:
+                            break
+                        key = (cmd, self.next_tag)
+                        self.next_tag = (self.next_tag + 1) & 0xFFFF
+                        in_flight.append((cmd, key, self.send_frame(cmd, data, 0, key), size))
+                        in_flight_bytes += size
+                        request = next(requests, None)
+                    cmd, key, future, size = in_flight.popleft()
+                    in_flight_bytes -= size
+                    yield await self.wait_response(cmd, key, future, timeout)
+            finally:
+                # stopped early, the responses still on their way are dropped
+                for _, key, future, _ in in_flight:
+                    if self.waiting.get(key) is future:
+                        del self.waiting[key]
+                    future.cancel()
+
+
+class AsyncChameleonCMD:
+    """
+        Chameleon cmd function as coroutines, e.g. `await cmd.get_app_version()`
+
+        The commands of a reader session (HF14A scan and raw, MF1 block auth/read/write), of
+        setting up emulator slots (slot types and nicks, MF1 emulator blocks and config, anti
+        collision data, detection log) and the device settings. They build their requests and
+        parse the responses with the static methods of ChameleonCMD, so both clients send the
+        same frames. The other commands (LF, MF0/NTAG emulator, key recovery acquisitions, BLE
+        and buttons) are only on ChameleonCMD.
+    """
+
+    def __init__(self, chameleon: AsyncChameleonCom):
+        """
+        :param chameleon: chameleon instance, @see AsyncChameleonCom
+        """
+        self.device = chameleon
+
+    @expect_response(Status.SUCCESS)
+    async def get_app_version(self):
+        """
+            Get firmware version number(application)
+        """
+        return ChameleonCMD.get_app_version_response(await self.device.send_cmd(Command.GET_APP_VERSION))
+
+    @expect_response(Status.SUCCESS)
+    async def get_device_capabilities(self):
+        """
+        Get list of commands that client understands
+        """
+        try:
+            resp = await self.device.send_cmd(Command.GET_DEVICE_CAPABILITIES)
+        except CMDInvalidException:
+            resp = None
+        return ChameleonCMD.get_device_capabilities_response(resp)
+
+    @expect_response(Status.SUCCESS)
+    async def get_request_queue_size(self):
+        """
+        Get the number of request bytes the device queues while it processes a command.
+
+        :return:
+        """
+        resp = await self.device.send_cmd(Command.GET_REQUEST_QUEUE_SIZE)
+        return ChameleonCMD.get_request_queue_size_response(resp)
+
+    @expect_response(Status.SUCCESS)
+    async def get_device_mode(self):
+        return ChameleonCMD.get_device_mode_response(await self.device.send_cmd(Command.GET_DEVICE_MODE))
+
+    async def is_device_reader_mode(self) -> bool:
+        """
+            Get device mode, reader or tag.
+
+        :return: True is reader mode, else tag mode
+        """
+        return await self.get_device_mode()
+
+    @expect_response(Status.SUCCESS)
+    async def set_device_reader_mode(self, reader_mode: bool = True):
+        """
+            Change device mode, reader or tag.
+
+        :param reader_mode: True if reader mode, False if tag mode.
+        :return:
+        """
+        return await self.device.send_cmd(Command.CHANGE_DEVICE_MODE, struct.pack('!B', reader_mode))
+
+    @expect_response(Status.HF_TAG_OK)
+    async def hf14a_scan(self):
+        """
+        14a tags in the scanning field.
+
+        :return:
+        """
+        return ChameleonCMD.hf14a_scan_response(await self.device.send_cmd(Command.HF14A_SCAN))
+
+    @expect_response(Status.HF_TAG_OK)
+    async def hf14a_raw(self, options, resp_timeout_ms=100, data=[], bitlen=None):
+        """
+        Send raw cmd to 14a tag.
+
+        :param options:
+        :param resp_timeout_ms:
+        :param data:
+        :param bit_owned_by_the_last_byte:
+        :return:
+        """
+        data = ChameleonCMD.hf14a_raw_request(options, resp_timeout_ms, data, bitlen)
+        resp = await self.device.send_cmd(Command.HF14A_RAW, data, timeout=(resp_timeout_ms // 1000) + 1)
+        resp.parsed = resp.data
+        return resp
+
+    async def hf14a_raw_pipelined(self, requests: Iterable[tuple[dict, int, bytes]]) -> AsyncIterator[Union[bytes, None]]:
+        """
+        Send raw cmds to 14a tag without waiting for each response before sending the next one.
+
+        :param requests: iterable of (options, resp_timeout_ms, data)
+        :return: iterator of the tag responses, None when the tag didn't answer
+        """
+        frames = ((Command.HF14A_RAW, ChameleonCMD.hf14a_raw_request(*request)) for request in requests)
+        async for resp in self.device.send_cmds_pipelined(frames):
+            yield resp.data if resp.status == Status.HF_TAG_OK else None
+
+    @expect_response([Status.HF_TAG_OK, Status.MF_ERR_AUTH])
+    async def mf1_auth_one_key_block(self, block, type_value: MfcKeyType, key):
+        """
+        Verify the mf1 key, only verify the specified type of key for a single sector.
+
+        :param block:
+        :param type_value:
+        :param key:
+        :return:
+        """
+        data = ChameleonCMD.mf1_block_request(block, type_value, key)
+        resp = await self.device.send_cmd(Command.MF1_AUTH_ONE_KEY_BLOCK, data)
+        resp.parsed = resp.status == Status.HF_TAG_OK
+        return resp
+
+    @expect_response(Status.HF_TAG_OK)
+    async def mf1_read_one_block(self, block, type_value: MfcKeyType, key):
+        """
+        Read one mf1 block.
+
+        :param block:
+        :param type_value:
+        :param key:
+        :return:
+        """
+        data = ChameleonCMD.mf1_block_request(block, type_value, key)
+        resp = await self.device.send_cmd(Command.MF1_READ_ONE_BLOCK, data)
+        resp.parsed = resp.data
+        return resp
+
+    @expect_response(Status.HF_TAG_OK)
+    async def mf1_write_one_block(self, block, type_value: MfcKeyType, key, block_data):
+        """
+        Write mf1 single block.
+
+        :param block:
+        :param type_value:
+        :param key:
+        :param block_data:
+        :return:
+        """
+        data = ChameleonCMD.mf1_block_request(block, type_value, key) + struct.pack('!16s', block_data)
+        resp = await self.device.send_cmd(Command.MF1_WRITE_ONE_BLOCK, data)
+        resp.parsed = resp.status == Status.HF_TAG_OK
+        return resp
+
+    @expect_response(Status.SUCCESS)
+    async def get_slot_info(self):
+        """
+        Get slots info.
+
+        :return:
+        """
+        return ChameleonCMD.get_slot_info_response(await self.device.send_cmd(Command.GET_SLOT_INFO))
+
+    @expect_response(Status.SUCCESS)
+    async def get_active_slot(self):
+        """
+        Get selected slot.
+
+        :return:
+        """
+        return ChameleonCMD.get_active_slot_response(await self.device.send_cmd(Command.GET_ACTIVE_SLOT))
+
+    @expect_response(Status.SUCCESS)
+    async def set_active_slot(self, slot_index: SlotNumber):
+        """
+        Set the card slot currently active for use.
+
+        :param slot_index: Card slot index
+        :return:
+        """
+        return await self.device.send_cmd(Command.SET_ACTIVE_SLOT, ChameleonCMD.slot_request(slot_index))
+
+    @expect_response(Status.SUCCESS)
+    async def set_slot_tag_type(self, slot_index: SlotNumber, tag_type: TagSpecificType):
+        """
+        Set the label type of the emulated card of the current card slot, saved with the next slot_data_config_save.
+
+        :param slot_index:  Card slot number
+        :param tag_type:  label type
+        :return:
+        """
+        data = ChameleonCMD.slot_request(slot_index, 'H', tag_type)
+        return await self.device.send_cmd(Command.SET_SLOT_TAG_TYPE, data)
+
+    @expect_response(Status.SUCCESS)
+    async def set_slot_data_default(self, slot_index: SlotNumber, tag_type: TagSpecificType):
+        """
+        Set the data of the emulated card in the specified card slot as the default data, in flash too.
+
+        :param slot_index: Card slot number
+        :param tag_type:  The default label type to set
+        :return:
+        """
+        data = ChameleonCMD.slot_request(slot_index, 'H', tag_type)
+        return await self.device.send_cmd(Command.SET_SLOT_DATA_DEFAULT, data)
+
+    @expect_response(Status.SUCCESS)
+    async def set_slot_enable(self, slot_index: SlotNumber, sense_type: TagSenseType, enabled: bool):
+        """
+        Set whether the specified card slot is enabled.
+
+        :param slot_index: Card slot number
+        :param enable: Whether to enable
+        :return:
+        """
+        data = ChameleonCMD.slot_request(slot_index, 'BB', sense_type, enabled)
+        return await self.device.send_cmd(Command.SET_SLOT_ENABLE, data)
+
+    @expect_response(Status.SUCCESS)
+    async def set_slot_tag_nick(self, slot: SlotNumber, sense_type: TagSenseType, name: str):
+        """
+        Set the nick name of the slot.
+
+        :param slot:  Card slot number
+        :param sense_type:  field type
+        :param name:  Card slot nickname
+        :return:
+        """
+        data = ChameleonCMD.set_slot_tag_nick_request(slot, sense_type, name)
+        return await self.device.send_cmd(Command.SET_SLOT_TAG_NICK, data)
+
+    @expect_response(Status.SUCCESS)
+    async def get_slot_tag_nick(self, slot: SlotNumber, sense_type: TagSenseType):
+        """
+        Get the nick name of the slot.
+
+        :param slot:  Card slot number
+        :param sense_type:  field type
+        :return:
+        """
+        data = ChameleonCMD.slot_request(slot, 'B', sense_type)
+        return ChameleonCMD.get_slot_tag_nick_response(await self.device.send_cmd(Command.GET_SLOT_TAG_NICK, data))
+
+    @expect_response(Status.SUCCESS)
+    async def delete_slot_tag_nick(self, slot: SlotNumber, sense_type: TagSenseType):
+        """
+        Delete the nick name of the slot.
+
+        :param slot:  Card slot number
+        :param sense_type:  field type
+        :return:
+        """
+        data = ChameleonCMD.slot_request(slot, 'B', sense_type)
+        return await self.device.send_cmd(Command.DELETE_SLOT_TAG_NICK, data)
+
+    @expect_response(Status.SUCCESS)
+    async def slot_data_config_save(self):
+        """
+        Update the configuration and data of the card slot to flash.
+        :return:
+        """
+        return await self.device.send_cmd(Command.SLOT_DATA_CONFIG_SAVE)
+
+    @expect_response(Status.SUCCESS)
+    async def mf1_write_emu_block_data(self, block_start: int, block_data: bytes):
+        """
+        Set the block data of the analog card of MF1.
+
+        :param block_start:  Start setting the location of block data, including this location
+        :param block_data:  The byte buffer of the block data to be set can contain multiple block data,
+                            automatically from block_start  increment
+        :return:
+        """
+        data = struct.pack(f'!B{len(block_data)}s', block_start, block_data)
+        return await self.device.send_cmd(Command.MF1_WRITE_EMU_BLOCK_DATA, data)
+
+    @expect_response(Status.SUCCESS)
+    async def mf1_read_emu_block_data(self, block_start: int, block_count: int):
+        """
+            Gets data for selected block range
+        """
+        data = struct.pack('!BB', block_start, block_count)
+        resp = await self.device.send_cmd(Command.MF1_READ_EMU_BLOCK_DATA, data)
+        resp.parsed = resp.data
+        return resp
+
+    @expect_response(Status.SUCCESS)
+    async def hf14a_set_anti_coll_data(self, uid: bytes, atqa: bytes, sak: bytes, ats: bytes = b''):
+        """
+        Set anti-collision data of current HF slot (UID/SAK/ATQA/ATS).
+
+        :param uid:  uid bytes
+        :param atqa: atqa bytes
+        :param sak:  sak bytes
+        :param ats:  ats bytes (optional)
+        :return:
+        """
+        data = ChameleonCMD.hf14a_set_anti_coll_data_request(uid, atqa, sak, ats)
+        return await self.device.send_cmd(Command.HF14A_SET_ANTI_COLL_DATA, data)
+
+    @expect_response(Status.SUCCESS)
+    async def hf14a_get_anti_coll_data(self):
+        """
+        Get anti-collision data from current HF slot (UID/SAK/ATQA/ATS)
+
+        :return:
+        """
+        resp = await self.device.send_cmd(Command.HF14A_GET_ANTI_COLL_DATA)
+        return ChameleonCMD.hf14a_get_anti_coll_data_response(resp)
+
+    @expect_response(Status.SUCCESS)
+    async def mf1_get_emulator_config(self):
+        """
+            Get the Mifare Classic emulator settings, @see ChameleonCMD.mf1_get_emulator_config
+        """
+        resp = await self.device.send_cmd(Command.MF1_GET_EMULATOR_CONFIG)
+        return ChameleonCMD.mf1_get_emulator_config_response(resp)
+
+    @expect_response(Status.SUCCESS)
+    async def mf1_set_detection_enable(self, enabled: bool):
+        """
+        Set whether to enable the detection of the current card slot.
+
+        :param enable: Whether to enable
+        :return:
+        """
+        return await self.device.send_cmd(Command.MF1_SET_DETECTION_ENABLE, struct.pack('!B', enabled))
+
+    @expect_response(Status.SUCCESS)
+    async def mf1_get_detection_count(self):
+        """
+        Get the statistics of the current detection records.
+
+        :return:
+        """
+        resp = await self.device.send_cmd(Command.MF1_GET_DETECTION_COUNT)
+        return ChameleonCMD.mf1_get_detection_count_response(resp)
+
+    @expect_response(Status.SUCCESS)
+    async def mf1_get_detection_log(self, index: int):
+        """
+        Get detection logs from the specified index position.
+
+        :param index: start index
+        :return:
+        """
+        resp = await self.device.send_cmd(Command.MF1_GET_DETECTION_LOG, struct.pack('!I', index))
+        return ChameleonCMD.mf1_get_detection_log_response(resp)
+
+    @expect_response(Status.SUCCESS)
+    async def get_device_settings(self):
+        """
+        Get all possible settings, @see ChameleonCMD.get_device_settings
+        """
+        return ChameleonCMD.get_device_settings_response(await self.device.send_cmd(Command.GET_DEVICE_SETTINGS))
+
+    @expect_response(Status.SUCCESS)
+    async def get_battery_info(self):
+        """
+        Get battery info
+        """
+        return ChameleonCMD.get_battery_info_response(await self.device.send_cmd(Command.GET_BATTERY_INFO))
+
+    @expect_response(Status.SUCCESS)
+    async def save_settings(self):
+        """
+        Store settings to flash memory
+        """
+        resp = await self.device.send_cmd(Command.SAVE_SETTINGS)
+        resp.parsed = resp.status == Status.SUCCESS
+        return resp
@@ -20,11 +20,12 @@ from pathlib import Path
 from platform import uname
 from datetime import datetime
 import hardnested_utils
+import mfcrack
 
 import chameleon_com
 import chameleon_cmd
 from chameleon_utils import ArgumentParserNoExit, ArgsParserError, UnexpectedResponseError, execute_tool, \
-    tqdm_if_exists, print_key_table
+    tqdm_if_exists, print_key_table, HardnestedStream, read_key_dic
 from chameleon_utils import CLITree
 from chameleon_utils import CR, CG, CB, CC, CY, C0, color_string
 from chameleon_utils import print_mem_dump
@@ -686,6 +687,8 @@ class HWConnect(BaseCLIUnit):
                     return
             self.device_com.open(args.port)
             self.device_com.commands = self.cmd.get_device_capabilities()
+            if Command.GET_REQUEST_QUEUE_SIZE in self.device_com.commands:
+                self.device_com.request_queue_size = self.cmd.get_request_queue_size()
             major, minor = self.cmd.get_app_version()
             model = ['Ultra', 'Lite'][self.cmd.get_device_model()]
             print(f" {{ Chameleon {model} connected: v{major}.{minor} }}")
@@ -954,6 +957,10 @@ class HFMFNested(ReaderRequiredUnit):
         if nt_level == 0:  # It's a staticnested tag?
             nt_uid_obj = self.cmd.mf1_static_nested_acquire(
                 block_known, type_known, key_known, block_target, type_target)
+            if mfcrack.available():
+                nonces = [(nt_item['nt'], nt_item['nt_enc']) for nt_item in nt_uid_obj['nts']]
+                return self.check_candidate_keys(block_target, type_target, lambda: mfcrack.staticnested(
+                    nt_uid_obj['uid'], int(type_target), nonces))
             cmd_param = f"{nt_uid_obj['uid']} {int(type_target)}"
             for nt_item in nt_uid_obj['nts']:
                 cmd_param += f" {nt_item['nt']} {nt_item['nt_enc']}"
@@ -961,6 +968,10 @@ class HFMFNested(ReaderRequiredUnit):
         else:
             dist_obj = self.cmd.mf1_detect_nt_dist(block_known, type_known, key_known)
             nt_obj = self.cmd.mf1_nested_acquire(block_known, type_known, key_known, block_target, type_target)
+            if mfcrack.available():
+                nonces = [(nt_item['nt'], nt_item['nt_enc'], nt_item['par']) for nt_item in nt_obj]
+                return self.check_candidate_keys(block_target, type_target, lambda: mfcrack.nested(
+                    dist_obj['uid'], dist_obj['dist'], nonces))
             # create cmd
             cmd_param = f"{dist_obj['uid']} {dist_obj['dist']}"
             for nt_item in nt_obj:
@@ -1003,6 +1014,25 @@ class HFMFNested(ReaderRequiredUnit):
             # No keys recover, and no errors.
             return None
 
+    def check_candidate_keys(self, block_target, type_target, recover) -> Union[str, None]:
+        """
+            Run an in-process recovery and verify its candidate keys on the tag.
+
+        :param recover: callable returning the candidate keys as ints
+        :return:
+        """
+        time_start = timeit.default_timer()
+        try:
+            key_list = [format(key, '012x') for key in recover()]
+        except ValueError:
+            return None
+        print(f"   [ Time elapsed {timeit.default_timer() - time_start:#.1f}s ]")
+        print(f" - [{len(key_list)} candidate key(s) found ]")
+        for key in key_list:
+            if self.cmd.mf1_auth_one_key_block(block_target, type_target, bytearray.fromhex(key)):
+                return key
+        return None
+
     def on_exec(self, args: argparse.Namespace):
         block_known = args.blk
         # default to A
@@ -1029,6 +1059,9 @@ class HFMFNested(ReaderRequiredUnit):
 
 @hf_mf.command('darkside')
 class HFMFDarkside(ReaderRequiredUnit):
+    # candidates are tried on the card once the traces narrowed them down to this many
+    verify_max = 64
+
     def __init__(self):
         super().__init__()
         self.darkside_list = []
@@ -1060,39 +1093,46 @@ class HFMFDarkside(ReaderRequiredUnit):
                 self.darkside_list.clear()
 
             self.darkside_list.append(darkside_obj)
-            recover_params = f"{darkside_obj['uid']}"
-            for darkside_item in self.darkside_list:
-                recover_params += f" {darkside_item['nt1']} {darkside_item['ks1']} {darkside_item['par']}"
-                recover_params += f" {darkside_item['nr']} {darkside_item['ar']}"
-            if sys.platform == "win32":
-                cmd_recover = f"darkside.exe {recover_params}"
-            else:
-                cmd_recover = f"./darkside {recover_params}"
-            # subprocess.run(cmd_recover, cwd=os.path.abspath("../bin/"), shell=True)
-            # print(f"   Executing {cmd_recover}")
-            # start a decrypt process
-            process = self.sub_process(cmd_recover)
-            # wait end
-            process.wait_process()
-            # get output
-            output_str = process.get_output_sync()
-            if 'key not found' in output_str:
-                print(f" - No key found, retrying({retry_count})...")
+            key_list, left = self.decrypt(darkside_obj['uid'])
+            if len(key_list) == 0 or left > self.verify_max:
+                # stop acquiring as soon as the candidates are few enough to try on the card
+                if left:
+                    print(f" - {left} candidates left after {len(self.darkside_list)} traces, acquiring more...")
+                else:
+                    print(f" - No key found, retrying({retry_count})...")
                 retry_count += 1
                 continue  # retry
-            else:
-                key_list = []
-                for line in output_str.split('\n'):
-                    sea_obj = re.search(r"([a-fA-F0-9]{12})", line)
-                    if sea_obj is not None:
-                        key_list.append(sea_obj[1])
-                # auth key
-                for key in key_list:
-                    key_bytes = bytearray.fromhex(key)
-                    if self.cmd.mf1_auth_one_key_block(block_target, type_target, key_bytes):
-                        return key
+            # auth key
+            for key in key_list:
+                if self.cmd.mf1_auth_one_key_block(block_target, type_target, bytearray.fromhex(key)):
+                    return key
         return None
 
+    def decrypt(self, uid):
+        """
+            Candidate keys left after the traces acquired so far, and how many they are.
+
+        :param uid:
+        :return:
+        """
+        if mfcrack.available():
+            keys, remaining = mfcrack.darkside(uid, self.darkside_list)
+            return [format(key, '012x') for key in keys], remaining[-1]
+        # the tool reads the traces as binary records on stdin
+        records = b''.join(struct.pack('!IIQQII', uid, item['nt1'], item['par'], item['ks1'], item['nr'], item['ar'])
+                           for item in self.darkside_list)
+        output_str = subprocess.run([str(default_cwd / "darkside")], input=records, capture_output=True,
+                                    cwd=default_cwd).stdout.decode()
+        key_list, left = [], 0
+        for line in output_str.split('\n'):
+            sea_obj = re.search(r"^Trace \d+: (\d+) candidates", line)
+            if sea_obj is not None:
+                left = int(sea_obj[1])
+            sea_obj = re.search(r"^Key\d+: ([a-fA-F0-9]{12})", line)
+            if sea_obj is not None:
+                key_list.append(sea_obj[1])
+        return key_list, left
+
     def on_exec(self, args: argparse.Namespace):
         key = self.recover_key(0x03, MfcKeyType.A)
         if key is not None:
@@ -1120,6 +1160,8 @@ class HFMFHardNested(ReaderRequiredUnit):
         dsttype_group.add_argument('--tb', '--tB', action='store_true', help="Target B key")
         parser.add_argument('--slow', action='store_true', help="Use slower acquisition mode (more nonces)")
         parser.add_argument('--keep-nonce-file', action='store_true', help="Keep the generated nonce file (nonces.bin)")
+        parser.add_argument('--no-stream', action='store_true',
+                            help="Collect all nonces before starting hardnested instead of streaming them while acquiring")
         parser.add_argument('--max-runs', type=int, default=200, metavar="<dec>",
                             help="Maximum acquisition runs per attempt before giving up (default: 200)")
         # Add max acquisition attempts
@@ -1127,7 +1169,10 @@ class HFMFHardNested(ReaderRequiredUnit):
                             help="Maximum acquisition attempts if MSB sum is invalid (default: 3)")
         return parser
 
-    def recover_key(self, slow_mode, block_known, type_known, key_known, block_target, type_target, keep_nonce_file, max_runs, max_attempts):
+    hardnested_stream = None
+
+    def recover_key(self, slow_mode, block_known, type_known, key_known, block_target, type_target, keep_nonce_file, max_runs, max_attempts,
+                    stream_mode=True):
         """
         Recover a key using the HardNested attack via a nonce file, with dynamic MSB-based acquisition and restart on invalid sum.
 
@@ -1140,6 +1185,7 @@ class HFMFHardNested(ReaderRequiredUnit):
         :param keep_nonce_file: Boolean indicating whether to keep the nonce file.
         :param max_runs: Maximum number of acquisition runs per attempt.
         :param max_attempts: Maximum number of full acquisition attempts.
+        :param stream_mode: Feed nonces to a running hardnested while acquiring and stop once it has enough.
         :return: Recovered key as a hex string, or None if not found.
         """
         print(" - Starting HardNested attack...")
@@ -1152,6 +1198,9 @@ class HFMFHardNested(ReaderRequiredUnit):
             print(f"\n--- Starting Acquisition Attempt {attempt + 1}/{max_attempts} ---")
             total_raw_nonces_bytes = bytearray()  # Accumulator for raw nonces for THIS attempt
             nonces_buffer.clear()  # Clear buffer for each new attempt
+            if self.hardnested_stream is not None:
+                self.hardnested_stream.close()
+                self.hardnested_stream = None
 
             # --- MSB Tracking Initialization (Reset for each attempt) ---
             seen_msbs = [False] * 256
@@ -1204,6 +1253,8 @@ class HFMFHardNested(ReaderRequiredUnit):
             nonces_buffer.extend(uid_for_file)
             nonces_buffer.extend(struct.pack('!BB', block_target, type_target.value & 0x01))
             print(f"   Nonce file header prepared: {nonces_buffer.hex().upper()}")
+            if stream_mode:
+                self.hardnested_stream = HardnestedStream(bytes(nonces_buffer))
 
             # 2. Acquire nonces dynamically based on MSB criteria (Inner loop for runs)
             print(f"   Acquiring nonces (slow mode: {slow_mode}, max runs: {max_runs}). This may take a while...")
@@ -1230,6 +1281,8 @@ class HFMFHardNested(ReaderRequiredUnit):
 
                     # Append successfully acquired nonces to the total buffer for this attempt
                     total_raw_nonces_bytes.extend(raw_nonces_bytes_this_run)
+                    if self.hardnested_stream is not None:
+                        self.hardnested_stream.send_batch(raw_nonces_bytes_this_run)
 
                     # --- Process acquired nonces for MSB tracking ---
                     num_pairs_this_run = len(raw_nonces_bytes_this_run) // 9
@@ -1260,7 +1313,29 @@ class HFMFHardNested(ReaderRequiredUnit):
                         print()  # Print a newline after progress update
 
                     # --- Check termination condition ---
-                    if unique_msb_count == 256:
+                    if self.hardnested_stream is not None:
+                        hn = self.hardnested_stream
+                        nonces, states, done, reduced, sent = hn.status()
+                        print(f"   Hardnested: {nonces} nonces reduced, {states:.0f} states left "
+                              f"(2^{math.log2(max(states, 1)):.1f}), {reduced}/{sent} batches")
+                        if done:
+                            print(color_string((CG, "   Hardnested has enough nonces. Stopping acquisition runs.")))
+                            acquisition_goal_met = True
+                            acquisition_success = True
+                            break
+                        if not hn.alive():
+                            print(color_string((CR, "   Hardnested stopped while reducing the key space.")))
+                            acquisition_goal_met = False
+                            break
+
+                    if unique_msb_count == 256 and self.hardnested_stream is not None:
+                        # hardnested decides when to stop, only an invalid sum needs a restart
+                        if msb_parity_sum not in hardnested_utils.hardnested_sums:
+                            print(color_string((CR, f"   Parity sum {msb_parity_sum} is INVALID (Expected one of {hardnested_utils.hardnested_sums}).")))
+                            acquisition_goal_met = False
+                            acquisition_success = False
+                            break
+                    elif unique_msb_count == 256:
                         print()
                         print(f"{color_string((CG, '   All 256 unique MSBs found.'))} Final parity sum: {msb_parity_sum}")
                         if msb_parity_sum in hardnested_utils.hardnested_sums:
@@ -1296,6 +1371,10 @@ class HFMFHardNested(ReaderRequiredUnit):
 
             # --- Post-Acquisition Summary for this attempt ---
             print(f"\n   Finished acquisition phase for attempt {attempt + 1}.")
+            if (self.hardnested_stream is not None and not acquisition_success and run_count >= max_runs
+                    and unique_msb_count == 256 and msb_parity_sum in hardnested_utils.hardnested_sums):
+                print(color_string((CY, "   Reached max runs, letting hardnested work with the nonces it has.")))
+                acquisition_success = True
             if acquisition_success:
                 print(color_string((CG, f"   Successfully acquired nonces meeting the MSB sum criteria in {run_count} runs.")))
                 # Append collected raw nonces to the main buffer for the file
@@ -1367,7 +1446,10 @@ class HFMFHardNested(ReaderRequiredUnit):
             # 4. Prepare and run the external hardnested tool, redirecting output
             print(color_string((CC, "--- Running Hardnested Tool (Output redirected) ---")))
 
-            output_str = execute_tool('hardnested', [os.path.abspath(nonce_file_path)])
+            if self.hardnested_stream is not None:
+                output_str = self.hardnested_stream.finish()
+            else:
+                output_str = execute_tool('hardnested', [os.path.abspath(nonce_file_path)])
 
             print(color_string((CC, "--- Hardnested Tool Finished ---")))
 
@@ -1457,10 +1539,15 @@ class HFMFHardNested(ReaderRequiredUnit):
             return
 
         # Pass the max_runs and max_attempts arguments
-        recovered_key = self.recover_key(
-            args.slow, block_known, type_known, key_known_bytes, block_target, type_target,
-            args.keep_nonce_file, args.max_runs, args.max_attempts
-        )
+        try:
+            recovered_key = self.recover_key(
+                args.slow, block_known, type_known, key_known_bytes, block_target, type_target,
+                args.keep_nonce_file, args.max_runs, args.max_attempts, not args.no_stream
+            )
+        finally:
+            if self.hardnested_stream is not None:
+                self.hardnested_stream.close()
+                self.hardnested_stream = None
 
         if recovered_key:
             print(f" - Key Found: Block {block_target} Type {type_target.name} Key = {color_string((CG, recovered_key.upper()))}")
@@ -1495,21 +1582,45 @@ class HFMFStaticEncryptedNested(ReaderRequiredUnit):
 
         check_speed = 1.95  # sec per 64 keys
 
+        key_dics = {}
         for sector in range(args.starting_sector, args.sectors):
             sector_name = str(sector).zfill(2)
-            print('Recovering', sector, 'sector...')
+            print('Generating candidates for', sector, 'sector...')
             execute_tool('staticnested_1nt', [uid, sector_name, format(acquire_datas['nts']['a'][sector]['nt'], 'x').zfill(8), format(
                 acquire_datas['nts']['a'][sector]['nt_enc'], 'x').zfill(8), str(acquire_datas['nts']['a'][sector]['parity']).zfill(4)])
             execute_tool('staticnested_1nt', [uid, sector_name, format(acquire_datas['nts']['b'][sector]['nt'], 'x').zfill(8), format(
                 acquire_datas['nts']['b'][sector]['nt_enc'], 'x').zfill(8), str(acquire_datas['nts']['b'][sector]['parity']).zfill(4)])
             a_key_dic = f"keys_{uid}_{sector_name}_{format(acquire_datas['nts']['a'][sector]['nt'], 'x').zfill(8)}.dic"
             b_key_dic = f"keys_{uid}_{sector_name}_{format(acquire_datas['nts']['b'][sector]['nt'], 'x').zfill(8)}.dic"
-            execute_tool('staticnested_2x1nt_rf08s', [a_key_dic, b_key_dic])
+            key_dics[sector] = (a_key_dic, b_key_dic)
+
+        def dic_keys(name):
+            return read_key_dic(os.path.join(tempfile.gettempdir(), name))
+
+        def nt_of(key_type, sector):
+            return acquire_datas['nts'][key_type][sector]['nt']
+
+        print('Filtering candidates of all sectors...')
+        native = mfcrack.available()
+        filtered = {}
+        if native:
+            for sector, (a_key_dic, b_key_dic) in key_dics.items():
+                a_keys, b_keys = mfcrack.rf08s_filter(
+                    nt_of('a', sector), [int.from_bytes(k, 'big') for k in dic_keys(a_key_dic)],
+                    nt_of('b', sector), [int.from_bytes(k, 'big') for k in dic_keys(b_key_dic)])
+                filtered[sector] = ([k.to_bytes(6, 'big') for k in a_keys], [k.to_bytes(6, 'big') for k in b_keys])
+        else:
+            # one run filters all sectors, so the seed tables are only built once
+            execute_tool('staticnested_2x1nt_rf08s', [dic for pair in key_dics.values() for dic in pair])
+            for sector, (a_key_dic, b_key_dic) in key_dics.items():
+                filtered[sector] = (dic_keys(a_key_dic.replace('.dic', '_filtered.dic')),
+                                    dic_keys(b_key_dic.replace('.dic', '_filtered.dic')))
 
-            keys = open(os.path.join(tempfile.gettempdir(), b_key_dic.replace('.dic', '_filtered.dic'))).readlines()
-            keys_bytes = []
-            for key in keys:
-                keys_bytes.append(bytes.fromhex(key.strip()))
+        for sector in range(args.starting_sector, args.sectors):
+            print('Recovering', sector, 'sector...')
+            a_key_dic, b_key_dic = key_dics[sector]
+
+            keys_bytes = filtered[sector][1]
 
             key = None
 
@@ -1524,12 +1635,17 @@ class HFMFStaticEncryptedNested(ReaderRequiredUnit):
                     break
 
             if key:
-                a_key = execute_tool('staticnested_2x1nt_rf08s_1key', [format(
-                    acquire_datas['nts']['b'][sector]['nt'], 'x').zfill(8), key, a_key_dic])
-                keys_bytes = []
-                for key in a_key.split('\n'):
-                    keys_bytes.append(bytes.fromhex(key.strip()))
-                data = self.cmd.mf1_check_keys_on_block(sector * 4 + 3, 0x60, keys_bytes)
+                if native:
+                    keys_bytes = [k.to_bytes(6, 'big') for k in mfcrack.rf08s_1key(
+                        nt_of('b', sector), int(key, 16), nt_of('a', sector),
+                        [int.from_bytes(k, 'big') for k in dic_keys(a_key_dic)])]
+                else:
+                    a_key = execute_tool('staticnested_2x1nt_rf08s_1key', [format(
+                        nt_of('b', sector), 'x').zfill(8), key, a_key_dic])
+                    keys_bytes = []
+                    for key in a_key.split('\n'):
+                        keys_bytes.append(bytes.fromhex(key.strip()))
+                data = self.cmd.mf1_check_keys_on_block(sector * 4 + 3, 0x60, keys_bytes) if keys_bytes else None
                 if data:
                     key = data.hex().zfill(12)
                     print('Found A key', key)
@@ -1537,10 +1653,7 @@ class HFMFStaticEncryptedNested(ReaderRequiredUnit):
                     continue
                 else:
                     print('Failed to find A key by fast method, trying all possible keys')
-                    keys = open(os.path.join(tempfile.gettempdir(), a_key_dic.replace('.dic', '_filtered.dic'))).readlines()
-                    keys_bytes = []
-                    for key in keys:
-                        keys_bytes.append(bytes.fromhex(key.strip()))
+                    keys_bytes = filtered[sector][0]
 
                     print('Start checking possible A keys, will take up to', math.floor(
                         len(keys_bytes) / 64 * check_speed), 'seconds for', len(keys_bytes), 'keys')
@@ -2086,6 +2199,25 @@ def _run_mfkey32v2(items):
     return None
 
 
+def _match_keys(records, keys):
+    """
+        Which detection log records each key is the key of: one row of match flags per key
+    """
+    if mfcrack.available():
+        # one compiled pass over all keys and records instead of a bitwise crypto1 per pair
+        return mfcrack.test_keys([
+            (int(item['uid'], 16), int(item['nt'], 16), int(item['nr'], 16), int(item['ar'], 16))
+            for item in records
+        ], [int(key, 16) for key in keys])
+    return [[Crypto1.mfkey32_is_reader_has_key(
+        int(item['uid'], 16),
+        int(item['nt'], 16),
+        int(item['nr'], 16),
+        int(item['ar'], 16),
+        key,
+    ) for item in records] for key in keys]
+
+
 class ItemGenerator:
     def __init__(self, rs, uid_found_keys = set()):
         self.rs: list = rs
@@ -2094,8 +2226,7 @@ class ItemGenerator:
         self.j = 1
         self.found = set()
         self.keys = set()
-        for known_key in uid_found_keys:
-            self.test_key(known_key)
+        self.test_keys(sorted(uid_found_keys))
 
     def __iter__(self):
         return self
@@ -2124,19 +2255,20 @@ class ItemGenerator:
         return "{uid}-{nt}-{nr}-{ar}".format(**item)
 
     def test_key(self, key, items = list()):
-        for item in self.rs:
-            item_key = self.key_from_item(item)
-            if item_key in self.found:
-                continue
-            if (item in items) or (Crypto1.mfkey32_is_reader_has_key(
-                int(item['uid'], 16),
-                int(item['nt'], 16),
-                int(item['nr'], 16),
-                int(item['ar'], 16),
-                key,
-            )):
-                self.keys.add(key)
-                self.found.add(item_key)
+        for item in items:
+            self.keys.add(key)
+            self.found.add(self.key_from_item(item))
+        self.test_keys([key])
+
+    def test_keys(self, keys):
+        pending = [item for item in self.rs if self.key_from_item(item) not in self.found]
+        if not keys or not pending:
+            return
+        for key, matches in zip(keys, _match_keys(pending, keys)):
+            for item, match in zip(pending, matches):
+                if match:
+                    self.keys.add(key)
+                    self.found.add(self.key_from_item(item))
 
 @hf_mf.command('elog')
 class HFMFELog(DeviceRequiredUnit):
@@ -2203,18 +2335,37 @@ class HFMFELog(DeviceRequiredUnit):
 
             result_maps[uid][block][type].append(item)
 
+        native = mfcrack.available()
+        if native:
+            # the library cracks every uid/block/key group of the log in one call, on all cores
+            key_maps = {uid: {block: {keyType: set() for keyType in result_maps[uid][block]}
+                              for block in result_maps[uid]} for uid in result_maps}
+            for uid, block, keyType, key in mfcrack.mfkey32_log(result_list):
+                key_maps[uid][block][keyType].add(key)
+            # it tries the keys of a uid on the later groups only, try them all on those left without one
+            for uid, key_maps_for_uid in key_maps.items():
+                uid_keys = sorted({key for key_maps_for_block in key_maps_for_uid.values()
+                                   for keys in key_maps_for_block.values() for key in keys})
+                for block, key_maps_for_block in key_maps_for_uid.items():
+                    for keyType, keys in key_maps_for_block.items():
+                        if uid_keys and not keys:
+                            matches = _match_keys(result_maps[uid][block][keyType], uid_keys)
+                            keys.update(key for key, row in zip(uid_keys, matches) if any(row))
+            result_maps = key_maps
+
         for uid in result_maps.keys():
             print(f" - Detection log for uid [{uid.upper()}]")
             result_maps_for_uid = result_maps[uid]
-            uid_found_keys = set()
-            for block in result_maps_for_uid:
-                for keyType in 'AB':
-                    records = result_maps_for_uid[block][keyType] if keyType in result_maps_for_uid[block] else []
-                    if len(records) < 1:
-                        continue
-                    print(f"  > Decrypting block {block} key {keyType} detect log...")
-                    result_maps[uid][block][keyType] = self.decrypt_by_list(records, uid_found_keys)
-                    uid_found_keys.update(result_maps[uid][block][keyType])
+            if not native:
+                uid_found_keys = set()
+                for block in result_maps_for_uid:
+                    for keyType in 'AB':
+                        records = result_maps_for_uid[block][keyType] if keyType in result_maps_for_uid[block] else []
+                        if len(records) < 1:
+                            continue
+                        print(f"  > Decrypting block {block} key {keyType} detect log...")
+                        result_maps[uid][block][keyType] = self.decrypt_by_list(records, uid_found_keys)
+                        uid_found_keys.update(result_maps[uid][block][keyType])
 
             print("  > Result ---------------------------")
             for block in result_maps_for_uid.keys():
@@ -2918,6 +3069,44 @@ class HFMFUDUMP(MFUAuthArgsUnit):
                             help="Force writing as either raw binary or hex.")
         return parser
 
+    def dump_pipelined(self, start_page, stop_page, options, fd, save_as_eml) -> bool:
+        """
+            Dump pages until the first error, returns True if it stopped early.
+        """
+        # without a key every page is a plain READ, so the reads don't depend on each other and the
+        # device can get the next one while it executes the current one
+        def reads():
+            for i in range(start_page, stop_page):
+                # the field stays on until the last page, the first read selects the tag
+                yield {**options, 'auto_select': int(i == start_page and options['auto_select']),
+                       'keep_rf_field': int(i != stop_page - 1)}, 200, struct.pack('!BB', 0x30, i)
+
+        last_page = start_page - 1
+        try:
+            for i, resp in zip(range(start_page, stop_page), self.cmd.hf14a_raw_pipelined(reads())):
+                if resp is None or len(resp) == 0:
+                    break
+                last_page = i
+                data = resp[:4]
+                print(f" - Page {i:2}: {data.hex()}")
+                if fd is not None:
+                    if save_as_eml:
+                        fd.write(data.hex()+'\n')
+                    else:
+                        fd.write(data)
+        except (chameleon_com.CMDInvalidException, TimeoutError):
+            pass
+
+        if last_page != stop_page - 1:
+            # stopped on the first error, but reads sent after it may have left the field on
+            try:
+                self.cmd.hf14a_raw(options={**options, 'auto_select': 0, 'keep_rf_field': 0},
+                                   resp_timeout_ms=200, data=struct.pack('!BB', 0x30, 0))
+            except (ValueError, chameleon_com.CMDInvalidException, TimeoutError):
+                pass
+            return True
+        return False
+
     def do_dump(self, args: argparse.Namespace, param, fd, save_as_eml):
         if args.qty is not None:
             stop_page = min(args.page + args.qty, 256)
@@ -3038,7 +3227,13 @@ class HFMFUDUMP(MFUAuthArgsUnit):
                 fd.close()
                 fd = None
 
-        for i in range(args.page, stop_page):
+        if param.key is None:
+            needs_stop = self.dump_pipelined(args.page, stop_page, options, fd, save_as_eml)
+            pages = range(0)
+        else:
+            pages = range(args.page, stop_page)
+
+        for i in pages:
             # this could be done once in theory but the command would need to be optimized properly
             if param.key is not None and not needs_stop:
                 resp = self.cmd.hf14a_raw(options=options, resp_timeout_ms=200, data=struct.pack('!B', 0x1B)+param.key)
@@ -3237,6 +3432,15 @@ class CrackEffect:
             sys.stdout.write("\033[2A\033[1G\033[K" + data)
             self.draw_static_box()
 
+    def set_status(self, text):
+        """Show the given text on the line above the box, replacing the previous one."""
+        if not self.output_enabled:
+            return
+        with self.display_lock:
+            # Padding line above the box, then back to the middle row
+            sys.stdout.write(f"\033[3A\033[1G\033[K{text}\033[3B")
+            sys.stdout.flush()
+
     def display_current_state(self):
         """Display the current state of all blocks."""
         if not self.output_enabled:
@@ -3503,73 +3707,60 @@ class HFMFUULCG(ReaderRequiredUnit):
 
         signal.signal(signal.SIGINT, signal_handler)
 
+        # ERndB per segment, each taken with the segments cracked before it restored
         ciphertexts = {1: challenges["challenge_25"],
                       0: challenges["challenge_50"],
                       3: challenges["challenge_75"],
                       2: challenges["challenge_100"]}
 
-        try:
-            for key_segment_idx in [1, 0, 3, 2]:
-                ciphertext = ciphertexts[key_segment_idx]
-
-                cmd = [
-                    str(default_cwd / "mfulc_des_brute"),
-                    "-c",
-                    challenges['challenge_0'],
-                    ciphertext,
-                    "".join(key_segment_values.values()),
-                    str(key_segment_idx + 1),
-                    str(num_threads)
-                ]
+        # A single run cracks the segments in the order 2, 1, 4, 3 and streams its progress
+        cmd = [
+            str(default_cwd / "mfulc_des_brute"),
+            "-a",
+            challenges['challenge_0'],
+            *[ciphertexts[key_segment_idx] for key_segment_idx in range(4)],
+            str(num_threads)
+        ]
 
-                try:
-                    result = subprocess.run(cmd, capture_output=True, text=True, timeout=3600)
-
-                    if "Could not detect LFSR" in result.stderr:
-                        key_found = False
-                        crack_effect.stop_event.set()
-                        crack_effect.erase_key()
-                        print(f"\n\n\n[-] Error: {result.stderr}\033[?25h")
-                        break
-
-                    if "No matching key was found" in result.stdout:
-                        key_found = False
-                        crack_effect.stop_event.set()
-                        crack_effect.erase_key()
-                        print(f"\n\n\n[-] Error: No matching key found for segment {key_segment_idx + 1}\033[?25h")
-                        break
-
-                    if "Full key (hex): " not in result.stdout:
-                        key_found = False
-                        crack_effect.stop_event.set()
-                        crack_effect.erase_key()
-                        print("\n\n\n[-] Error: Unexpected output from mfulc_des_brute\033[?25h")
-                        break
-
-                    # Extract the key segment from output
-                    full_key_line = [line for line in result.stdout.split('\n') if "Full key (hex):" in line][0]
-                    full_key = full_key_line.split("Full key (hex): ")[1].strip()
-                    key_segment_values[key_segment_idx] = full_key[(8*key_segment_idx):][:8]
-                    key_found = True
-                    crack_effect.add_cracked_block(key_segment_idx, key_segment_values[key_segment_idx])
-
-                except subprocess.TimeoutExpired:
-                    key_found = False
-                    crack_effect.stop_event.set()
-                    crack_effect.erase_key()
-                    print(f"\n\n\n[-] Error: Timeout cracking segment {key_segment_idx + 1}\033[?25h")
-                    break
-                except Exception as e:
-                    key_found = False
+        process = None
+        try:
+            process = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+            for line in process.stdout:
+                fields = dict(field.split("=", 1) for field in line.split()[1:] if "=" in field)
+                if line.startswith("progress "):
+                    crack_effect.set_status(f"[+] Segment {fields['segment']}: {fields['percent']}% searched, "
+                                            f"{int(fields['keys_per_s']) / 1e6:.1f} M keys/s, "
+                                            f"ETA {int(fields['eta_s']) // 60}m{int(fields['eta_s']) % 60:02d}s max")
+                elif line.startswith("found "):
+                    key_segment_idx = int(fields['segment']) - 1
+                    key_segment_values[key_segment_idx] = fields['key']
+                    crack_effect.add_cracked_block(key_segment_idx, fields['key'])
+                elif line.startswith("No matching key was found"):
                     crack_effect.stop_event.set()
                     crack_effect.erase_key()
-                    print(f"\n\n\n[-] Error: {e}\033[?25h")
+                    print(f"\n\n\n[-] Error: No matching key found for segment {line.split()[-1].rstrip('.')}\033[?25h")
                     break
+                elif line.startswith("Full key (hex): "):
+                    key_found = True
+            process.wait()
+
+            if not key_found and not crack_effect.stop_event.is_set():
+                stderr = process.stderr.read()
+                crack_effect.stop_event.set()
+                crack_effect.erase_key()
+                if "Could not detect LFSR" in stderr:
+                    print(f"\n\n\n[-] Error: {stderr}\033[?25h")
+                else:
+                    print("\n\n\n[-] Error: Unexpected output from mfulc_des_brute\033[?25h")
         except Exception as e:
+            key_found = False
             crack_effect.stop_event.set()
-            print(f"\n\n\nAn error occurred: {e}\033[?25h")
+            crack_effect.erase_key()
+            print(f"\n\n\n[-] Error: {e}\033[?25h")
             traceback.print_exc()
         finally:
+            if process is not None and process.poll() is None:
+                process.kill()
             effect_thread.join()
 
         if key_found:
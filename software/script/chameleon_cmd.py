@@ -1,6 +1,6 @@
 import struct
 import ctypes
-from typing import Union
+from typing import Iterable, Iterator, Union
 
 import chameleon_com
 from chameleon_utils import expect_response, reconstruct_full_nt, parity_to_str
@@ -29,7 +29,13 @@ class ChameleonCMD:
         """
             Get firmware version number(application)
         """
-        resp = self.device.send_cmd_sync(Command.GET_APP_VERSION)
+        return self.get_app_version_response(self.device.send_cmd_sync(Command.GET_APP_VERSION))
+
+    @staticmethod
+    def get_app_version_response(resp):
+        """
+            Parse the GET_APP_VERSION response.
+        """
         if resp.status == Status.SUCCESS:
             resp.parsed = struct.unpack('!BB', resp.data)
         # older protocol, must upgrade!
@@ -68,7 +74,10 @@ class ChameleonCMD:
 
     @expect_response(Status.SUCCESS)
     def get_device_mode(self):
-        resp = self.device.send_cmd_sync(Command.GET_DEVICE_MODE)
+        return self.get_device_mode_response(self.device.send_cmd_sync(Command.GET_DEVICE_MODE))
+
+    @staticmethod
+    def get_device_mode_response(resp):
         if resp.status == Status.SUCCESS:
             resp.parsed, = struct.unpack('!?', resp.data)
         return resp
@@ -103,7 +112,15 @@ class ChameleonCMD:
 
         :return:
         """
-        resp = self.device.send_cmd_sync(Command.HF14A_SCAN)
+        return self.hf14a_scan_response(self.device.send_cmd_sync(Command.HF14A_SCAN))
+
+    @staticmethod
+    def hf14a_scan_response(resp):
+        """
+        Parse the HF14A_SCAN response.
+
+        :return:
+        """
         if resp.status == Status.HF_TAG_OK:
             # uidlen[1]|uid[uidlen]|atqa[2]|sak[1]|atslen[1]|ats[atslen]
             offset = 0
@@ -198,11 +215,23 @@ class ChameleonCMD:
         :param key:
         :return:
         """
-        data = struct.pack('!BB6s', type_value, block, key)
+        data = self.mf1_block_request(block, type_value, key)
         resp = self.device.send_cmd_sync(Command.MF1_AUTH_ONE_KEY_BLOCK, data)
         resp.parsed = resp.status == Status.HF_TAG_OK
         return resp
 
+    @staticmethod
+    def mf1_block_request(block, type_value: MfcKeyType, key) -> bytes:
+        """
+        Build the request data of the mf1 commands on one block, the key that authenticates it.
+
+        :param block:
+        :param type_value:
+        :param key:
+        :return:
+        """
+        return struct.pack('!BB6s', type_value, block, key)
+
     @expect_response(Status.HF_TAG_OK)
     def mf1_read_one_block(self, block, type_value: MfcKeyType, key):
         """
@@ -213,7 +242,7 @@ class ChameleonCMD:
         :param key:
         :return:
         """
-        data = struct.pack('!BB6s', type_value, block, key)
+        data = self.mf1_block_request(block, type_value, key)
         resp = self.device.send_cmd_sync(Command.MF1_READ_ONE_BLOCK, data)
         resp.parsed = resp.data
         return resp
@@ -229,15 +258,15 @@ class ChameleonCMD:
         :param block_data:
         :return:
         """
-        data = struct.pack('!BB6s16s', type_value, block, key, block_data)
+        data = self.mf1_block_request(block, type_value, key) + struct.pack('!16s', block_data)
         resp = self.device.send_cmd_sync(Command.MF1_WRITE_ONE_BLOCK, data)
         resp.parsed = resp.status == Status.HF_TAG_OK
         return resp
 
-    @expect_response(Status.HF_TAG_OK)
-    def hf14a_raw(self, options, resp_timeout_ms=100, data=[], bitlen=None):
+    @staticmethod
+    def hf14a_raw_request(options, resp_timeout_ms=100, data=[], bitlen=None) -> bytes:
         """
-        Send raw cmd to 14a tag.
+        Build the HF14A_RAW request data.
 
         :param options:
         :param resp_timeout_ms:
@@ -274,11 +303,38 @@ class ChameleonCMD:
                 raise ValueError(f'bitlen={bitlen} incompatible with provided data ({len(data)} bytes), '
                                  f'must be between {((len(data) - 1) * 8)+1} and {len(data) * 8} included')
 
-        data = bytes(cs)+struct.pack(f'!HH{len(data)}s', resp_timeout_ms, bitlen, bytearray(data))
+        return bytes(cs)+struct.pack(f'!HH{len(data)}s', resp_timeout_ms, bitlen, bytearray(data))
+
+    @expect_response(Status.HF_TAG_OK)
+    def hf14a_raw(self, options, resp_timeout_ms=100, data=[], bitlen=None):
+        """
+        Send raw cmd to 14a tag.
+
+        :param options:
+        :param resp_timeout_ms:
+        :param data:
+        :param bit_owned_by_the_last_byte:
+        :return:
+        """
+        data = self.hf14a_raw_request(options, resp_timeout_ms, data, bitlen)
         resp = self.device.send_cmd_sync(Command.HF14A_RAW, data, timeout=(resp_timeout_ms // 1000) + 1)
         resp.parsed = resp.data
         return resp
 
+    def hf14a_raw_pipelined(self, requests: Iterable[tuple[dict, int, bytes]]) -> Iterator[Union[bytes, None]]:
+        """
+        Send raw cmds to 14a tag without waiting for each response before sending the next one.
+
+        The device executes them in order, so options such as auto_select and keep_rf_field
+        behave as for consecutive hf14a_raw calls.
+
+        :param requests: iterable of (options, resp_timeout_ms, data)
+        :return: iterator of the tag responses, None when the tag didn't answer
+        """
+        frames = ((Command.HF14A_RAW, self.hf14a_raw_request(*request)) for request in requests)
+        for resp in self.device.send_cmds_pipelined(frames):
+            yield resp.data if resp.status == Status.HF_TAG_OK else None
+
     @expect_response(Status.HF_TAG_OK)
     def mf1_manipulate_value_block(self, src_block, src_type: MfcKeyType, src_key, operator: MfcValueBlockOperator, operand, dst_block, dst_type: MfcKeyType, dst_key):
         """
@@ -682,7 +738,10 @@ class ChameleonCMD:
 
         :return:
         """
-        resp = self.device.send_cmd_sync(Command.GET_SLOT_INFO)
+        return self.get_slot_info_response(self.device.send_cmd_sync(Command.GET_SLOT_INFO))
+
+    @staticmethod
+    def get_slot_info_response(resp):
         if resp.status == Status.SUCCESS:
             resp.parsed = [{'hf': hf, 'lf': lf}
                            for hf, lf in struct.iter_unpack('!HH', resp.data)]
@@ -695,7 +754,10 @@ class ChameleonCMD:
 
         :return:
         """
-        resp = self.device.send_cmd_sync(Command.GET_ACTIVE_SLOT)
+        return self.get_active_slot_response(self.device.send_cmd_sync(Command.GET_ACTIVE_SLOT))
+
+    @staticmethod
+    def get_active_slot_response(resp):
         if resp.status == Status.SUCCESS:
             resp.parsed = resp.data[0]
         return resp
@@ -708,9 +770,15 @@ class ChameleonCMD:
         :param slot_index: Card slot index
         :return:
         """
+        return self.device.send_cmd_sync(Command.SET_ACTIVE_SLOT, self.slot_request(slot_index))
+
+    @staticmethod
+    def slot_request(slot_index: SlotNumber, fmt: str = '', *values) -> bytes:
+        """
+        Request data of the slot commands: the slot in firmware numbering, then the values packed with fmt.
+        """
         # SlotNumber() will raise error for us if slot_index not in slot range
-        data = struct.pack('!B', SlotNumber.to_fw(slot_index))
-        return self.device.send_cmd_sync(Command.SET_ACTIVE_SLOT, data)
+        return struct.pack(f'!B{fmt}', SlotNumber.to_fw(slot_index), *values)
 
     @expect_response(Status.SUCCESS)
     def set_slot_tag_type(self, slot_index: SlotNumber, tag_type: TagSpecificType):
@@ -723,9 +791,7 @@ class ChameleonCMD:
         :param tag_type:  label type
         :return:
         """
-        # SlotNumber() will raise error for us if slot_index not in slot range
-        data = struct.pack('!BH', SlotNumber.to_fw(slot_index), tag_type)
-        return self.device.send_cmd_sync(Command.SET_SLOT_TAG_TYPE, data)
+        return self.device.send_cmd_sync(Command.SET_SLOT_TAG_TYPE, self.slot_request(slot_index, 'H', tag_type))
 
     @expect_response(Status.SUCCESS)
     def delete_slot_sense_type(self, slot_index: SlotNumber, sense_type: TagSenseType):
@@ -736,7 +802,7 @@ class ChameleonCMD:
         :param sense_type: Sense type to disable
         :return:
         """
-        data = struct.pack('!BB', SlotNumber.to_fw(slot_index), sense_type)
+        data = self.slot_request(slot_index, 'B', sense_type)
         return self.device.send_cmd_sync(Command.DELETE_SLOT_SENSE_TYPE, data)
 
     @expect_response(Status.SUCCESS)
@@ -749,8 +815,7 @@ class ChameleonCMD:
         :param tag_type:  The default label type to set
         :return:
         """
-        # SlotNumber() will raise error for us if slot_index not in slot range
-        data = struct.pack('!BH', SlotNumber.to_fw(slot_index), tag_type)
+        data = self.slot_request(slot_index, 'H', tag_type)
         return self.device.send_cmd_sync(Command.SET_SLOT_DATA_DEFAULT, data)
 
     @expect_response(Status.SUCCESS)
@@ -762,8 +827,7 @@ class ChameleonCMD:
         :param enable: Whether to enable
         :return:
         """
-        # SlotNumber() will raise error for us if slot_index not in slot range
-        data = struct.pack('!BBB', SlotNumber.to_fw(slot_index), sense_type, enabled)
+        data = self.slot_request(slot_index, 'BB', sense_type, enabled)
         return self.device.send_cmd_sync(Command.SET_SLOT_ENABLE, data)
 
     def _get_active_lf_tag_type(self) -> TagSpecificType:
@@ -998,7 +1062,10 @@ class ChameleonCMD:
 
         :return:
         """
-        resp = self.device.send_cmd_sync(Command.MF1_GET_DETECTION_COUNT)
+        return self.mf1_get_detection_count_response(self.device.send_cmd_sync(Command.MF1_GET_DETECTION_COUNT))
+
+    @staticmethod
+    def mf1_get_detection_count_response(resp):
         if resp.status == Status.SUCCESS:
             resp.parsed, = struct.unpack('!I', resp.data)
         return resp
@@ -1012,7 +1079,13 @@ class ChameleonCMD:
         :return:
         """
         data = struct.pack('!I', index)
-        resp = self.device.send_cmd_sync(Command.MF1_GET_DETECTION_LOG, data)
+        return self.mf1_get_detection_log_response(self.device.send_cmd_sync(Command.MF1_GET_DETECTION_LOG, data))
+
+    @staticmethod
+    def mf1_get_detection_log_response(resp):
+        """
+        Parse the MF1_GET_DETECTION_LOG response.
+        """
         if resp.status == Status.SUCCESS:
             # convert
             result_list = []
@@ -1188,9 +1261,13 @@ class ChameleonCMD:
         :param ats:  ats bytes (optional)
         :return:
         """
-        data = struct.pack(f'!B{len(uid)}s2s1sB{len(ats)}s', len(uid), uid, atqa, sak, len(ats), ats)
+        data = self.hf14a_set_anti_coll_data_request(uid, atqa, sak, ats)
         return self.device.send_cmd_sync(Command.HF14A_SET_ANTI_COLL_DATA, data)
 
+    @staticmethod
+    def hf14a_set_anti_coll_data_request(uid: bytes, atqa: bytes, sak: bytes, ats: bytes = b'') -> bytes:
+        return struct.pack(f'!B{len(uid)}s2s1sB{len(ats)}s', len(uid), uid, atqa, sak, len(ats), ats)
+
     @expect_response(Status.SUCCESS)
     def set_slot_tag_nick(self, slot: SlotNumber, sense_type: TagSenseType, name: str):
         """
@@ -1201,12 +1278,15 @@ class ChameleonCMD:
         :param name:  Card slot nickname
         :return:
         """
+        data = self.set_slot_tag_nick_request(slot, sense_type, name)
+        return self.device.send_cmd_sync(Command.SET_SLOT_TAG_NICK, data)
+
+    @staticmethod
+    def set_slot_tag_nick_request(slot: SlotNumber, sense_type: TagSenseType, name: str) -> bytes:
         encoded_name = name.encode(encoding="utf8")
         if len(encoded_name) > 32:
             raise ValueError("Your tag nick name too long.")
-        # SlotNumber() will raise error for us if slot not in slot range
-        data = struct.pack(f'!BB{len(encoded_name)}s', SlotNumber.to_fw(slot), sense_type, encoded_name)
-        return self.device.send_cmd_sync(Command.SET_SLOT_TAG_NICK, data)
+        return ChameleonCMD.slot_request(slot, f'B{len(encoded_name)}s', sense_type, encoded_name)
 
     @expect_response(Status.SUCCESS)
     def get_slot_tag_nick(self, slot: SlotNumber, sense_type: TagSenseType):
@@ -1217,12 +1297,30 @@ class ChameleonCMD:
         :param sense_type:  field type
         :return:
         """
-        # SlotNumber() will raise error for us if slot not in slot range
-        data = struct.pack('!BB', SlotNumber.to_fw(slot), sense_type)
-        resp = self.device.send_cmd_sync(Command.GET_SLOT_TAG_NICK, data)
+        data = self.slot_request(slot, 'B', sense_type)
+        return self.get_slot_tag_nick_response(self.device.send_cmd_sync(Command.GET_SLOT_TAG_NICK, data))
+
+    @staticmethod
+    def get_slot_tag_nick_response(resp):
         resp.parsed = resp.data.decode(encoding="utf8")
         return resp
 
+    @expect_response(Status.SUCCESS)
+    def get_request_queue_size(self):
+        """
+        Get the number of request bytes the device queues while it processes a command.
+
+        :return:
+        """
+        resp = self.device.send_cmd_sync(Command.GET_REQUEST_QUEUE_SIZE)
+        return self.get_request_queue_size_response(resp)
+
+    @staticmethod
+    def get_request_queue_size_response(resp):
+        if resp.status == Status.SUCCESS:
+            resp.parsed, = struct.unpack('!H', resp.data)
+        return resp
+
     @expect_response(Status.SUCCESS)
     def get_all_slot_nicks(self):
         resp = self.device.send_cmd_sync(Command.GET_ALL_SLOT_NICKS, b'')
@@ -1267,8 +1365,7 @@ class ChameleonCMD:
         :param sense_type:  field type
         :return:
         """
-        # SlotNumber() will raise error for us if slot not in slot range
-        data = struct.pack('!BB', SlotNumber.to_fw(slot), sense_type)
+        data = self.slot_request(slot, 'B', sense_type)
         return self.device.send_cmd_sync(Command.DELETE_SLOT_TAG_NICK, data)
 
     @expect_response(Status.SUCCESS)
@@ -1283,7 +1380,10 @@ class ChameleonCMD:
 
         :return:
         """
-        resp = self.device.send_cmd_sync(Command.MF1_GET_EMULATOR_CONFIG)
+        return self.mf1_get_emulator_config_response(self.device.send_cmd_sync(Command.MF1_GET_EMULATOR_CONFIG))
+
+    @staticmethod
+    def mf1_get_emulator_config_response(resp):
         if resp.status == Status.SUCCESS:
             b1, b2, b3, b4, b5 = struct.unpack('!????B', resp.data)
             resp.parsed = {'detection': b1,
@@ -1401,7 +1501,10 @@ class ChameleonCMD:
         """
         Get battery info
         """
-        resp = self.device.send_cmd_sync(Command.GET_BATTERY_INFO)
+        return self.get_battery_info_response(self.device.send_cmd_sync(Command.GET_BATTERY_INFO))
+
+    @staticmethod
+    def get_battery_info_response(resp):
         if resp.status == Status.SUCCESS:
             resp.parsed = struct.unpack('!HB', resp.data)
         return resp
@@ -1482,13 +1585,21 @@ class ChameleonCMD:
         try:
             resp = self.device.send_cmd_sync(Command.GET_DEVICE_CAPABILITIES)
         except chameleon_com.CMDInvalidException:
+            resp = None
+        return self.get_device_capabilities_response(resp)
+
+    @staticmethod
+    def get_device_capabilities_response(resp):
+        """
+        Parse the GET_DEVICE_CAPABILITIES response, None if the device rejected the command.
+        """
+        if resp is None:
             print("Chameleon does not understand get_device_capabilities command. Please update firmware")
             return chameleon_com.Response(cmd=Command.GET_DEVICE_CAPABILITIES,
                                           status=Status.NOT_IMPLEMENTED)
-        else:
-            if resp.status == Status.SUCCESS:
-                resp.parsed = [x[0] for x in struct.iter_unpack('!H', resp.data)]
-            return resp
+        if resp.status == Status.SUCCESS:
+            resp.parsed = [x[0] for x in struct.iter_unpack('!H', resp.data)]
+        return resp
 
     @expect_response(Status.SUCCESS)
     def get_device_model(self):
@@ -1517,7 +1628,10 @@ class ChameleonCMD:
         settings[6] = settings_get_ble_pairing_enable(); // does device require pairing
         settings[7:13] = settings_get_ble_pairing_key(); // BLE pairing key
         """
-        resp = self.device.send_cmd_sync(Command.GET_DEVICE_SETTINGS)
+        return self.get_device_settings_response(self.device.send_cmd_sync(Command.GET_DEVICE_SETTINGS))
+
+    @staticmethod
+    def get_device_settings_response(resp):
         if resp.status == Status.SUCCESS:
             if resp.data[0] > CURRENT_VERSION_SETTINGS:
                 raise ValueError("Settings version in app older than Chameleon. "
@@ -1545,7 +1659,10 @@ class ChameleonCMD:
 
         :return:
         """
-        resp = self.device.send_cmd_sync(Command.HF14A_GET_ANTI_COLL_DATA)
+        return self.hf14a_get_anti_coll_data_response(self.device.send_cmd_sync(Command.HF14A_GET_ANTI_COLL_DATA))
+
+    @staticmethod
+    def hf14a_get_anti_coll_data_response(resp):
         if resp.status == Status.SUCCESS and len(resp.data) > 0:
             # uidlen[1]|uid[uidlen]|atqa[2]|sak[1]|atslen[1]|ats[atslen]
             offset = 0
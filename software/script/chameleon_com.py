@@ -1,10 +1,13 @@
 import sys
+import collections
+import heapq
+import itertools
 import queue
 import struct
 import threading
 import time
 import platform
-from typing import Union
+from typing import Iterable, Iterator, Union
 from enum import Enum, auto
 import serial
 import socket
@@ -20,6 +23,13 @@ THREAD_BLOCKING_TIMEOUT = 0.1
 # TODO: client settings
 DEBUG = False
 
+# bit 15 of cmd marks a tagged frame, its data starts with a u16 tag which the response echoes
+FRAME_TAGGED = 0x8000
+FRAME_TAG_LENGTH = 2
+
+# default number of requests in flight for send_cmds_pipelined
+PIPELINE_WINDOW = 8
+
 class TransportType(Enum):
     NONE = auto()
     SERIAL = auto()
@@ -43,6 +53,106 @@ class CMDInvalidException(Exception):
     """
 
 
+class DataFrameParser:
+    """
+        Splits the byte stream from the device into data frames
+
+        A frame is SOF, LRC1, cmd, status, length (big endian u16 each), LRC2, data, LRC3.
+        Each LRC covers all bytes before it. Bytes are buffered until a frame is complete,
+        so the stream can be fed in chunks of any size. Tagged frames may carry max_length
+        bytes of data after their tag.
+    """
+    head = struct.Struct('!BBHHHB')  # up to and including lrc2
+
+    def __init__(self, sof: int = 0x11, max_length: int = 4096):
+        self.sof = sof
+        self.sof_lrc = ChameleonCom.lrc_calc(bytes([sof]))
+        self.max_length = max_length
+        self.buffer = bytearray()
+
+    def error(self, message: str):
+        print(message)
+
+    def make(self, cmd: int, data: Union[bytes, None] = None, status: int = 0, tag: Union[int, None] = None) -> bytes:
+        """
+            Make data frame
+
+        :param cmd: cmd
+        :param data: bytes data (optional)
+        :param status: status (optional)
+        :param tag: u16 tag of a tagged frame (optional)
+        :return: frame
+        """
+        if data is None:
+            data = b''
+        if tag is not None:
+            cmd |= FRAME_TAGGED
+            data = struct.pack('!H', tag) + data
+        head = bytearray(self.head.pack(self.sof, self.sof_lrc, cmd, status, len(data), 0))
+        head[-1] = ChameleonCom.lrc_calc(head[:-1])
+        return bytes(head) + data + bytes([-(sum(head) + sum(data)) & 0xFF])
+
+    def feed(self, data: Union[bytes, bytearray]) -> list[tuple[int, int, bytes]]:
+        """
+            Add received bytes and return the frames they complete.
+
+        :param data: received bytes
+        :return: list of (cmd, status, data)
+        """
+        buffer = self.buffer
+        buffer += data
+        frames = []
+        pos = 0
+        while pos < len(buffer):
+            start = buffer.find(self.sof, pos)
+            if start != pos:
+                self.error("Data frame no sof byte.")
+                if start < 0:
+                    pos = len(buffer)
+                    break
+                pos = start
+            if len(buffer) - pos < 2:
+                break
+            if buffer[pos + 1] != self.sof_lrc:
+                self.error("Data frame sof lrc error.")
+                pos += 1
+                continue
+            if len(buffer) - pos < self.head.size:
+                break
+            _, _, cmd, status, length, lrc2 = self.head.unpack_from(buffer, pos)
+            if lrc2 != -sum(buffer[pos:pos + self.head.size - 1]) & 0xFF:
+                self.error("Data frame head lrc error.")
+                pos += 1
+                continue
+            if length > self.max_length + (FRAME_TAG_LENGTH if cmd & FRAME_TAGGED else 0):
+                self.error("Data frame data length larger than max.")
+                pos += 1
+                continue
+            end = pos + self.head.size + length + 1
+            if len(buffer) < end:
+                break
+            # lrc2 zeroes the sum of the head, so lrc3 only depends on the data
+            if buffer[end - 1] == -sum(buffer[pos + self.head.size:end - 1]) & 0xFF:
+                frames.append((cmd, status, bytes(buffer[pos + self.head.size:end - 1])))
+            else:
+                self.error("Data frame global lrc error.")
+            pos = end
+        del buffer[:pos]
+        return frames
+
+    @staticmethod
+    def untag(cmd: int, data: bytes) -> tuple[int, Union[int, None], bytes]:
+        """
+            Split the tag off a frame.
+
+        :return: cmd, tag (None for untagged frames), data
+        """
+        if cmd & FRAME_TAGGED and len(data) >= FRAME_TAG_LENGTH:
+            tag, = struct.unpack_from('!H', data)
+            return cmd & ~FRAME_TAGGED, tag, data[FRAME_TAG_LENGTH:]
+        return cmd, None, data
+
+
 class Response:
     """
         Chameleon Response Data
@@ -55,6 +165,56 @@ class Response:
         self.parsed = parsed
 
 
+class PendingRequest:
+    """
+        A request waiting for its response
+
+        The receive thread completes it with the response, the timeout thread or close() without.
+    """
+
+    def __init__(self, cmd: int, key, callback=None):
+        self.cmd = cmd
+        self.key = key
+        self.callback = callback
+        self.response: Union[Response, None] = None
+        self.timed_out = False
+        # claimed by the thread that completes it, under the wait lock of ChameleonCom
+        self.done = False
+        self.event = threading.Event()
+
+    def complete(self, response: Union[Response, None], timed_out: bool = False):
+        """
+            Set the response and wake up the waiter, or call the callback.
+
+        :param response: response, None on timeout or close
+        :param timed_out: no response within the timeout
+        :return:
+        """
+        self.response = response
+        self.timed_out = timed_out
+        self.event.set()
+        if callable(self.callback):
+            if response is None:
+                self.callback(self.cmd, None, None)
+            else:
+                self.callback(response.cmd, response.status, response.data)
+
+    def wait(self) -> Response:
+        """
+            Block until the request completes.
+
+        :return: response data
+        """
+        self.event.wait()
+        if self.response is None:
+            if self.timed_out:
+                raise TimeoutError(f"CMD {self.cmd} exec timeout")
+            raise NotOpenException("Device closed while waiting for a response.")
+        if self.response.status == Status.INVALID_CMD:
+            raise CMDInvalidException(f"Device unsupported cmd: {self.cmd}")
+        return self.response
+
+
 class ChameleonCom:
     """
         Chameleon device base class
@@ -71,8 +231,17 @@ class ChameleonCom:
         self.transport: Union[serial.Serial, socket.socket, None] = None
         self.transport_type = TransportType.NONE
         self.send_data_queue = queue.Queue()
-        self.wait_response_map = {}
+        self.codec = DataFrameParser(self.data_frame_sof, self.data_max_length)
+        self.wait_response_map: dict[object, PendingRequest] = {}
+        # (deadline, seq, request) of sent requests, a request may already be done when it comes up
+        self.deadlines = []
+        self.deadline_seq = itertools.count()
+        # guards wait_response_map, deadlines and PendingRequest.done
+        self.wait_lock = threading.Condition()
         self.event_closing = threading.Event()
+        # bytes of requests the device queues while it processes one, 0 if it doesn't support tagged frames
+        self.request_queue_size = 0
+        self.next_tag = 0
 
     def isOpen(self) -> bool:
         """
@@ -126,6 +295,8 @@ class ChameleonCom:
             # clear variable
             self.send_data_queue.queue.clear()
             self.wait_response_map.clear()
+            self.deadlines.clear()
+            self.request_queue_size = 0
             # Start a sub thread to process data
             self.event_closing.clear()
             threading.Thread(target=self.thread_data_receive).start()
@@ -149,12 +320,7 @@ class ChameleonCom:
         :param array: value array
         :return: u8 result
         """
-        # add and cut byte and return
-        ret = 0x00
-        for b in array:
-            ret += b
-            ret &= 0xFF
-        return (0x100 - ret) & 0xFF
+        return -sum(array) & 0xFF
 
     def close(self):
         """
@@ -172,8 +338,22 @@ class ChameleonCom:
             pass
         finally:
             self.transport = None
-        self.wait_response_map.clear()
-        self.send_data_queue.queue.clear()
+        # fail what is still waiting, the requests not sent yet included
+        with self.wait_lock:
+            pending = [request for request in self.wait_response_map.values() if not request.done]
+            while True:
+                try:
+                    pending.append(self.send_data_queue.get_nowait()['request'])
+                    self.send_data_queue.task_done()
+                except queue.Empty:
+                    break
+            for request in pending:
+                request.done = True
+            self.wait_response_map.clear()
+            self.deadlines.clear()
+            self.wait_lock.notify_all()
+        for request in pending:
+            request.complete(None)
 
     def thread_data_receive(self):
         """
@@ -181,11 +361,7 @@ class ChameleonCom:
 
         :return:
         """
-        data_buffer = bytearray()
-        data_position = 0
-        data_cmd = 0x0000
-        data_status = 0x0000
-        data_length = 0x0000
+        parser = DataFrameParser(self.data_frame_sof, self.data_max_length)
 
         while self.isOpen():
             # receive
@@ -193,7 +369,8 @@ class ChameleonCom:
             if self.transport_type is TransportType.SERIAL:
                 try:
                     assert self.transport is not None
-                    data_bytes = bytearray(self.transport.read())
+                    # take all that is waiting, or block for the next byte up to the read timeout
+                    data_bytes = self.transport.read(max(1, self.transport.in_waiting))
                 except Exception as e:
                     if not self.event_closing.is_set():
                         print(f"Serial Error {e}, thread for receiver exit.")
@@ -201,89 +378,42 @@ class ChameleonCom:
                     break
             else:  # SOCKET
                 try:
-                    data_bytes = bytearray(self.transport.recv(1024))
+                    data_bytes = self.transport.recv(65536)
                 except socket.timeout:
                     continue
                 except OSError:
                     print(color_string(CR, 'socket closed'))
-                    self.transport = None
+                    self.close()
                     break
 
-            while len(data_bytes) > 0:
-                data_byte = data_bytes[0]
-                data_bytes = data_bytes[1:]
-                data_buffer.append(data_byte)
-                if data_position < struct.calcsize('!BB'):  # start of frame + lrc1
-                    if data_position == 0:
-                        if data_buffer[data_position] != self.data_frame_sof:
-                            print("Data frame no sof byte.")
-                            data_position = 0
-                            data_buffer.clear()
-                            continue
-                    if data_position == struct.calcsize('!B'):
-                        if data_buffer[data_position] != self.lrc_calc(data_buffer[:data_position]):
-                            data_position = 0
-                            data_buffer.clear()
-                            print("Data frame sof lrc error.")
-                            continue
-                elif data_position == struct.calcsize('!BBHHH'):  # frame head lrc
-                    if data_buffer[data_position] != self.lrc_calc(data_buffer[:data_position]):
-                        data_position = 0
-                        data_buffer.clear()
-                        print("Data frame head lrc error.")
-                        continue
-                    # frame head complete, cache info
-                    _, _, data_cmd, data_status, data_length = struct.unpack("!BBHHH", data_buffer[:data_position])
-                    if data_length > self.data_max_length:
-                        data_position = 0
-                        data_buffer.clear()
-                        print("Data frame data length larger than max.")
-                        continue
-                elif data_position > struct.calcsize('!BBHHH'):  # // frame data
-                    if data_position == (struct.calcsize(f'!BBHHHB{data_length}s')):
-                        if data_buffer[data_position] == self.lrc_calc(data_buffer[:data_position]):
-                            # ok, lrc for data is correct.
-                            # and we are receive completed
-                            # print(f"Buffer data = {data_buffer.hex()}")
-                            data_response = bytes(data_buffer[struct.calcsize('!BBHHHB'):
-                                                              struct.calcsize(f'!BBHHHB{data_length}s')])
-                            if DEBUG:
-                                try:
-                                    command = Command(data_cmd)
-                                    command_string = f"{data_cmd} {command.name}"
-                                except ValueError:
-                                    command_string = f"{data_cmd} (unknown)"
-                                try:
-                                    status_string = str(Status(data_status))
-                                    if data_status == Status.SUCCESS:
-                                        status_string = color_string((CG, status_string.ljust(30)))
-                                    else:
-                                        status_string = color_string((CR, status_string.ljust(30)))
-                                except ValueError:
-                                    status_string = f"{data_status:30x}"
-                                    response = data_response.hex() if data_response is not None else ""
-                                    print(f"<={color_string((CC, command_string.ljust(40)), (CR, status_string), (CY, response))}")
-                            if data_cmd in self.wait_response_map:
-                                # call processor
-                                if 'callback' in self.wait_response_map[data_cmd]:
-                                    fn_call = self.wait_response_map[data_cmd]['callback']
-                                else:
-                                    fn_call = None
-                                if callable(fn_call):
-                                    # delete wait task from map
-                                    del self.wait_response_map[data_cmd]
-                                    fn_call(data_cmd, data_status, data_response)
-                                else:
-                                    self.wait_response_map[data_cmd]['response'] = Response(data_cmd, data_status,
-                                                                                            data_response)
-                            else:
-                                print(f"No task wait process: ${data_cmd}")
+            for data_cmd, data_status, data_response in parser.feed(data_bytes):
+                data_cmd, data_tag, data_response = parser.untag(data_cmd, data_response)
+                # tagged requests wait under (cmd, tag)
+                wait_key = data_cmd if data_tag is None else (data_cmd, data_tag)
+                if DEBUG:
+                    try:
+                        command = Command(data_cmd)
+                        command_string = f"{data_cmd} {command.name}"
+                    except ValueError:
+                        command_string = f"{data_cmd} (unknown)"
+                    try:
+                        status_string = str(Status(data_status))
+                        if data_status == Status.SUCCESS:
+                            status_string = color_string((CG, status_string.ljust(30)))
                         else:
-                            print("Data frame global lrc error.")
-                        data_position = 0
-                        data_buffer.clear()
-                        continue
-                data_position += 1
+                            status_string = color_string((CR, status_string.ljust(30)))
+                    except ValueError:
+                        status_string = f"{data_status:30x}"
+                        response = data_response.hex() if data_response is not None else ""
+                        print(f"<={color_string((CC, command_string.ljust(40)), (CR, status_string), (CY, response))}")
+                with self.wait_lock:
+                    request = self.wait_response_map.pop(wait_key, None)
+                    if request is not None:
+                        request.done = True
+                if request is not None:
+                    request.complete(Response(data_cmd, data_status, data_response))
+                else:
+                    print(f"No task wait process: ${data_cmd}")
 
     def thread_data_transfer(self):
         """
@@ -297,19 +427,25 @@ class ChameleonCom:
                 task = self.send_data_queue.get(block=True, timeout=THREAD_BLOCKING_TIMEOUT)
             except queue.Empty:
                 continue
-            task_cmd = task['cmd']
-            task_timeout = task['timeout']
+            request: PendingRequest = task['request']
             task_close = task['close']
-            # register to wait map
-            if 'callback' in task and callable(task['callback']):
-                self.wait_response_map[task_cmd] = {'callback': task['callback']}  # The callback for this task
-            else:
-                self.wait_response_map[task_cmd] = {'response': None}
-            # set start time
-            start_time = time.time()
-            self.wait_response_map[task_cmd]['start_time'] = start_time
-            self.wait_response_map[task_cmd]['end_time'] = start_time + task_timeout
-            self.wait_response_map[task_cmd]['is_timeout'] = False
+            # register to wait map, the timeout starts now
+            with self.wait_lock:
+                closing = self.event_closing.is_set()
+                if not closing:
+                    self.wait_response_map[request.key] = request
+                    deadline = time.monotonic() + task['timeout']
+                    heapq.heappush(self.deadlines, (deadline, next(self.deadline_seq), request))
+                    if self.deadlines[0][2] is request:
+                        # new earliest deadline
+                        self.wait_lock.notify_all()
+                else:
+                    request.done = True
+            if closing:
+                # close() ran after we took the task from the queue
+                request.complete(None)
+                self.send_data_queue.task_done()
+                break
             assert self.transport_type is not TransportType.NONE
             if self.transport_type == TransportType.SERIAL:
                 try:
@@ -342,36 +478,35 @@ class ChameleonCom:
         :return:
         """
         while self.isOpen():
-            for task_cmd in self.wait_response_map.keys():
-                if time.time() > self.wait_response_map[task_cmd]['end_time']:
-                    if 'callback' in self.wait_response_map[task_cmd]:
-                        # not sync, call function to notify timeout.
-                        self.wait_response_map[task_cmd]['callback'](task_cmd, None, None)
-                    else:
-                        # sync mode, set timeout flag
-                        self.wait_response_map[task_cmd]['is_timeout'] = True
-            time.sleep(THREAD_BLOCKING_TIMEOUT)
-
-    def make_data_frame_bytes(self, cmd: int, data: Union[bytes, None] = None, status: int = 0) -> bytes:
+            expired = []
+            with self.wait_lock:
+                now = time.monotonic()
+                while self.deadlines and self.deadlines[0][0] <= now:
+                    _, _, request = heapq.heappop(self.deadlines)
+                    if request.done:
+                        continue
+                    request.done = True
+                    if self.wait_response_map.get(request.key) is request:
+                        del self.wait_response_map[request.key]
+                    expired.append(request)
+                if not expired:
+                    # sleep until the earliest deadline, a new earlier one or close() wakes us up
+                    self.wait_lock.wait(self.deadlines[0][0] - now if self.deadlines else None)
+            for request in expired:
+                request.complete(None, timed_out=True)
+
+    def make_data_frame_bytes(self, cmd: int, data: Union[bytes, None] = None, status: int = 0,
+                              tag: Union[int, None] = None) -> bytes:
         """
             Make data frame
 
+        :param tag: u16 tag of a tagged frame (optional)
         :return: frame
         """
-        if data is None:
-            data = b''
-        frame = bytearray(struct.pack(f'!BBHHHB{len(data)}sB',
-                                      self.data_frame_sof, 0x00, cmd, status, len(data), 0x00, data, 0x00))
-        # lrc1
-        frame[struct.calcsize('!B')] = self.lrc_calc(frame[:struct.calcsize('!B')])
-        # lrc2
-        frame[struct.calcsize('!BBHHH')] = self.lrc_calc(frame[:struct.calcsize('!BBHHH')])
-        # lrc3
-        frame[struct.calcsize(f'!BBHHHB{len(data)}s')] = self.lrc_calc(frame[:struct.calcsize(f'!BBHHHB{len(data)}s')])
-        return bytes(frame)
+        return self.codec.make(cmd, data, status, tag)
 
     def send_cmd_auto(self, cmd: int, data: Union[bytes, None] = None, status: int = 0, callback=None, timeout: int = 3,
-                      close: bool = False):
+                      close: bool = False, tag: Union[int, None] = None):
         """
             Send cmd to device
 
@@ -381,12 +516,11 @@ class ChameleonCom:
         :param callback: call on response
         :param timeout: wait response timeout
         :param close: close connection after executing
-        :return:
+        :param tag: send as tagged frame, the response is matched by cmd and tag (optional)
+        :return: request to wait on
         """
         self.check_open()
-        # delete old task
-        if cmd in self.wait_response_map:
-            del self.wait_response_map[cmd]
+        request = PendingRequest(cmd, cmd if tag is None else (cmd, tag), callback)
         # make data frame
         if DEBUG:
             try:
@@ -397,11 +531,10 @@ class ChameleonCom:
             cmd_string = f'{cmd:4} {command_name}{f"[{status:04x}]" if status != 0 else ""}'
             hexdata = data.hex() if data is not None else ""
             print(f"<={color_string((CC, cmd_string.ljust(40)), (CY, hexdata))}")
-        data_frame = self.make_data_frame_bytes(cmd, data, status)
-        task = {'cmd': cmd, 'frame': data_frame, 'timeout': timeout, 'close': close}
-        if callable(callback):
-            task['callback'] = callback
+        data_frame = self.make_data_frame_bytes(cmd, data, status, tag)
+        task = {'request': request, 'frame': data_frame, 'timeout': timeout, 'close': close}
         self.send_data_queue.put(task)
+        return request
 
     def send_cmd_sync(self, cmd: int, data: Union[bytes, None] = None, status: int = 0,
                       timeout: int = 3) -> Response:
@@ -420,21 +553,51 @@ class ChameleonCom:
                 raise CMDInvalidException(f"This device doesn't declare that it can support this command: {cmd}.\n"
                                           f"Make sure firmware is up to date and matches client")
         # first to send cmd, no callback mode(sync)
-        self.send_cmd_auto(cmd, data, status, None, timeout)
-        # wait cmd start process
-        while cmd not in self.wait_response_map:
-            time.sleep(0.01)
-        # wait response data set
-        while self.wait_response_map[cmd]['response'] is None:
-            if 'is_timeout' in self.wait_response_map[cmd] and self.wait_response_map[cmd]['is_timeout']:
-                raise TimeoutError(f"CMD {cmd} exec timeout")
-            time.sleep(0.01)
-        # ok, data received.
-        data_response = self.wait_response_map[cmd]['response']
-        del self.wait_response_map[cmd]
-        if data_response.status == Status.INVALID_CMD:
-            raise CMDInvalidException(f"Device unsupported cmd: {cmd}")
-        return data_response
+        request = self.send_cmd_auto(cmd, data, status, None, timeout)
+        # the receive thread or the timeout thread wakes us up
+        return request.wait()
+
+    def send_cmds_pipelined(self, requests: Iterable[tuple[int, Union[bytes, None]]], window: int = PIPELINE_WINDOW,
+                            timeout: int = 3) -> Iterator[Response]:
+        """
+            Send cmds with up to window of them in flight, and yield the responses in order.
+
+            The requests are sent as tagged frames, as long as they fit into the request queue of
+            the device. Devices without tagged frames get them one at a time. Stopping the iteration
+            stops sending, the responses to requests already in flight are dropped.
+
+        :param requests: iterable of (cmd, data), consumed ahead of the responses
+        :param window: maximum number of requests in flight
+        :param timeout: wait response timeout of each request
+        :return: iterator of responses
+        """
+        if not self.request_queue_size:
+            for cmd, data in requests:
+                yield self.send_cmd_sync(cmd, data, timeout=timeout)
+            return
+
+        in_flight = collections.deque()  # (request, frame size)
+        in_flight_bytes = 0
+        requests = iter(requests)
+        request = next(requests, None)
+        while request is not None or in_flight:
+            # fill the window. The request queue of the device must hold all but the one it processes.
+            while request is not None and len(in_flight) < window:
+                cmd, data = request
+                if len(self.commands) and cmd not in self.commands:
+                    raise CMDInvalidException(f"This device doesn't declare that it can support this command: {cmd}.\n"
+                                              f"Make sure firmware is up to date and matches client")
+                size = 10 + FRAME_TAG_LENGTH + (len(data) if data else 0)
+                if in_flight and in_flight_bytes + size > self.request_queue_size:
+                    break
+                tag = self.next_tag
+                self.next_tag = (self.next_tag + 1) & 0xFFFF
+                in_flight.append((self.send_cmd_auto(cmd, data, timeout=timeout, tag=tag), size))
+                in_flight_bytes += size
+                request = next(requests, None)
+            pending, size = in_flight.popleft()
+            in_flight_bytes -= size
+            yield pending.wait()
 
 
 if __name__ == '__main__':
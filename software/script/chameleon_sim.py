@@ -0,0 +1,1051 @@
+#!/usr/bin/env python3
+"""
+    Chameleon device simulator
+
+    Speaks the frame protocol of the firmware (SOF/LRC frames, tagged requests) on a local TCP port
+    or a pty, answers the commands of the firmware command map from slots and settings kept in
+    memory, and reads a simulated card in the reader field, so the client, the CLI and the recovery
+    flows run offline and can be benchmarked repeatably.
+
+    The card is a MIFARE Classic, whose nested, static nested and hardnested nonces are encrypted
+    with its keys as the PRNG of a weak, static or hard card would produce them, or an NTAG215
+    answering HF14A_RAW frames. Exchanges recorded from a real device with --record are answered
+    from the recording with --replay, which is also the only way to get darkside and static
+    encrypted nested answers. LF, MF0/NTAG emulator and value block commands are not simulated.
+
+    python3 chameleon_sim.py [--port PORT | --pty] [--card mf1|ntag215|none] [--latency MS] ...
+    python3 chameleon_sim.py --record session.jsonl --device /dev/ttyACM0
+"""
+import argparse
+import json
+import os
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+from typing import Callable, Optional, Union
+
+from chameleon_com import ChameleonCom, CMDInvalidException, DataFrameParser
+from chameleon_enum import (ButtonPressFunction, ButtonType, Command, MifareClassicPrngType, MfcKeyType, Status,
+                            TagSenseType, TagSpecificType)
+from crypto1 import Crypto1, get_bit, odd_parity_u8
+
+APP_VERSION = (2, 0)
+GIT_VERSION = 'v2.0.0-sim'
+SETTINGS_VERSION = 5
+REQUEST_QUEUE_SIZE = 1024
+SLOT_COUNT = 8
+
+MF1_BLOCK_COUNTS = {
+    TagSpecificType.MIFARE_Mini: 20,
+    TagSpecificType.MIFARE_1024: 64,
+    TagSpecificType.MIFARE_2048: 128,
+    TagSpecificType.MIFARE_4096: 256,
+}
+# factory content of the emulator, tag_emulation.c
+MF1_FACTORY_BLOCK0 = bytes.fromhex('DEADBEEF220804000177A2CC35AFA51D')
+MF1_FACTORY_TRAILER = bytes.fromhex('FFFFFFFFFFFFFF078069FFFFFFFFFFFF')
+MF1_FACTORY_ANTI_COLL = (bytes.fromhex('DEADBEEF'), bytes.fromhex('0400'), bytes.fromhex('08'), b'')
+# first nonce of static PRNG cards, each nested authentication steps it 160 states further
+MF1_STATIC_NONCE = 0x01200145
+MF1_HARDNESTED_PAIRS = 55
+DETECTION_RECORD_SIZE = 18
+
+
+def mf1_trailer(block: int) -> int:
+    """Sector trailer of block"""
+    return block | 3 if block < 128 else block | 15
+
+
+def mf1_sector_trailer(sector: int) -> int:
+    return sector * 4 + 3 if sector < 32 else sector * 16 - 369
+
+
+def mf1_factory_blocks(block_count: int) -> bytearray:
+    blocks = bytearray(16 * block_count)
+    blocks[:16] = MF1_FACTORY_BLOCK0
+    for block in range(block_count):
+        if mf1_trailer(block) == block:
+            blocks[16 * block:16 * block + 16] = MF1_FACTORY_TRAILER
+    return blocks
+
+
+def load_dump(path: str) -> bytes:
+    """MIFARE Classic card content from a .bin or .eml (hex lines) dump"""
+    with open(path, 'rb') as f:
+        content = f.read()
+    if path.endswith('.eml'):
+        content = bytes.fromhex(content.decode())
+    return content
+
+
+def crc_a(data: bytes) -> bytes:
+    crc = 0x6363
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return struct.pack('<H', crc)
+
+
+def anti_coll_bytes(uid: bytes, atqa: bytes, sak: bytes, ats: bytes) -> bytes:
+    # uidlen[1]|uid[uidlen]|atqa[2]|sak[1]|atslen[1]|ats[atslen]
+    return struct.pack(f'!B{len(uid)}s2s1sB{len(ats)}s', len(uid), uid, atqa, sak, len(ats), ats)
+
+
+_weak_nonces: list[int] = []
+
+
+def weak_nonces() -> list[int]:
+    """The 65535 nonces of the weak PRNG, in order"""
+    if not _weak_nonces:
+        nt = MF1_STATIC_NONCE
+        for _ in range(0xFFFF):
+            _weak_nonces.append(nt)
+            nt = Crypto1.prng_next(nt)
+    return _weak_nonces
+
+
+class MifareClassicCard:
+    """
+        MIFARE Classic in the reader field
+
+        Authentication compares the key with the sector trailer, reads hide key A and key B unless
+        the access bits let it be read, writes take any key of the sector and block 0 a magic card.
+        A weak PRNG steps dist states between two authentications of a session, a static one
+        starts every session at MF1_STATIC_NONCE and steps 160 states per nested authentication,
+        a hard one is random.
+    """
+
+    def __init__(self, blocks: Optional[bytes] = None, prng: MifareClassicPrngType = MifareClassicPrngType.WEAK,
+                 dist: int = 320, magic: bool = False, rng: Optional[random.Random] = None):
+        if blocks is None:
+            blocks = mf1_factory_blocks(MF1_BLOCK_COUNTS[TagSpecificType.MIFARE_1024])
+        if len(blocks) not in [16 * count for count in MF1_BLOCK_COUNTS.values()]:
+            raise ValueError(f"MIFARE Classic content must be 320, 1024, 2048 or 4096 bytes, not {len(blocks)}")
+        self.blocks = bytearray(blocks)
+        self.prng = prng
+        self.dist = dist
+        self.magic = magic
+        self.rng = rng if rng is not None else random.Random()
+        self.uid = bytes(self.blocks[0:4])
+        self.sak = bytes(self.blocks[5:6])
+        self.atqa = bytes(self.blocks[6:8])
+        self.ats = b''
+
+    @property
+    def block_count(self) -> int:
+        return len(self.blocks) // 16
+
+    @property
+    def cuid(self) -> int:
+        return int.from_bytes(self.uid[-4:], 'big')
+
+    def block(self, block: int) -> bytes:
+        return bytes(self.blocks[16 * block:16 * block + 16])
+
+    def key(self, block: int, key_type: int) -> bytes:
+        trailer = self.block(mf1_trailer(block))
+        return trailer[:6] if key_type == MfcKeyType.A else trailer[10:]
+
+    def set_keys(self, key_a: Optional[bytes] = None, key_b: Optional[bytes] = None):
+        """Set key A and/or key B of all sectors"""
+        for block in range(self.block_count):
+            if mf1_trailer(block) != block:
+                continue
+            if key_a is not None:
+                self.blocks[16 * block:16 * block + 6] = key_a
+            if key_b is not None:
+                self.blocks[16 * block + 10:16 * block + 16] = key_b
+
+    def auth(self, block: int, key_type: int, key: bytes) -> bool:
+        return block < self.block_count and key_type in (MfcKeyType.A, MfcKeyType.B) \
+            and self.key(block, key_type) == key
+
+    def key_b_readable(self, block: int) -> bool:
+        trailer = self.block(mf1_trailer(block))
+        access = (trailer[7] >> 7 & 1, trailer[8] >> 3 & 1, trailer[8] >> 7 & 1)  # C1, C2, C3 of the trailer
+        return access in [(0, 0, 0), (0, 1, 0), (0, 0, 1)]
+
+    def read(self, block: int) -> bytes:
+        data = bytearray(self.block(block))
+        if mf1_trailer(block) == block:
+            data[:6] = bytes(6)
+            if not self.key_b_readable(block):
+                data[10:] = bytes(6)
+        return bytes(data)
+
+    def write(self, block: int, data: bytes) -> bool:
+        if block == 0 and not self.magic:
+            return False
+        self.blocks[16 * block:16 * block + 16] = data
+        return True
+
+    def nonce(self) -> int:
+        """Nonce of the first authentication of a session"""
+        if self.prng == MifareClassicPrngType.STATIC:
+            return MF1_STATIC_NONCE
+        if self.prng == MifareClassicPrngType.WEAK:
+            return self.rng.choice(weak_nonces())
+        return self.rng.getrandbits(32)
+
+    def nested_nonce(self, nt: int, hops: int = 1) -> int:
+        """Nonce of the nested authentication hops authentications after the one that sent nt"""
+        if self.prng == MifareClassicPrngType.STATIC:
+            return Crypto1.prng_next(nt, 160 * hops)
+        if self.prng == MifareClassicPrngType.WEAK:
+            return Crypto1.prng_next(nt, self.dist * hops)
+        return self.rng.getrandbits(32)
+
+    def encrypt_nonce(self, nt: int, block: int, key_type: int) -> tuple[int, list[int]]:
+        """
+            nt as sent encrypted in a nested authentication to block, and its 4 parity bits as received
+        """
+        state = Crypto1()
+        state.key = self.key(block, key_type).hex()
+        ks = state.lfsr48_u32(self.cuid ^ nt)
+        # the parity bit after a byte is encrypted with the keystream bit of the first bit of the next one
+        par = [odd_parity_u8(nt >> 24) ^ get_bit(ks, 16), odd_parity_u8(nt >> 16) ^ get_bit(ks, 8),
+               odd_parity_u8(nt >> 8) ^ get_bit(ks, 0), odd_parity_u8(nt) ^ state.lfsr48_filter()]
+        return nt ^ ks, par
+
+    def command(self, frame: bytes) -> bytes:
+        # not authenticated, a MIFARE Classic NAKs everything
+        return b''
+
+
+class NtagCard:
+    """
+        NTAG215 in the reader field, answering READ, FAST_READ, WRITE, GET_VERSION, READ_SIG and
+        PWD_AUTH. Other commands get a NAK, which the client sees as an empty answer.
+    """
+    version = bytes.fromhex('0004040201001103')
+    page_count = 135
+    pwd_page = 133
+    pack_page = 134
+
+    def __init__(self, uid: bytes = bytes.fromhex('04689571FA5C64')):
+        self.uid = uid
+        self.atqa = bytes.fromhex('4400')
+        self.sak = bytes.fromhex('00')
+        self.ats = b''
+        bcc0 = 0x88 ^ uid[0] ^ uid[1] ^ uid[2]
+        bcc1 = uid[3] ^ uid[4] ^ uid[5] ^ uid[6]
+        self.pages = bytearray(4 * self.page_count)
+        self.pages[0:16] = uid[0:3] + bytes([bcc0]) + uid[3:7] + bytes([bcc1, 0x48, 0x00, 0x00]) \
+            + bytes.fromhex('E1103E00')
+        self.pages[4 * 130:4 * 135] = bytes.fromhex('000000BD' '040000FF' '00050000' 'FFFFFFFF' '00000000')
+
+    def page(self, page: int) -> bytes:
+        if page in (self.pwd_page, self.pack_page):
+            return bytes(4)
+        return bytes(self.pages[4 * page:4 * page + 4])
+
+    def command(self, frame: bytes) -> bytes:
+        """
+            Answer of the tag to a command frame, b'' for a NAK
+        """
+        if frame[0] == 0x30 and len(frame) >= 2 and frame[1] < self.page_count:
+            # READ wraps around at the last page
+            return b''.join(self.page((frame[1] + i) % self.page_count) for i in range(4))
+        if frame[0] == 0x3A and len(frame) >= 3 and frame[1] <= frame[2] < self.page_count:
+            return b''.join(self.page(page) for page in range(frame[1], frame[2] + 1))
+        if frame[0] == 0xA2 and len(frame) >= 6 and 3 <= frame[1] < self.page_count:
+            self.pages[4 * frame[1]:4 * frame[1] + 4] = frame[2:6]
+            return b'\x0a'
+        if frame[0] == 0x60:
+            return self.version
+        if frame[0] == 0x3C:
+            return bytes(32)
+        if frame[0] == 0x1B and frame[1:5] == self.pages[4 * self.pwd_page:4 * self.pwd_page + 4]:
+            return bytes(self.pages[4 * self.pack_page:4 * self.pack_page + 2])
+        return b''
+
+
+class SimSlot:
+    """
+        Slot of the simulated device, with the MIFARE Classic emulator data of its HF tag
+    """
+
+    def __init__(self, hf: TagSpecificType = TagSpecificType.UNDEFINED, lf: TagSpecificType = TagSpecificType.UNDEFINED,
+                 hf_enabled: bool = False, lf_enabled: bool = False):
+        self.tag_type = {TagSenseType.HF: hf, TagSenseType.LF: lf}
+        self.enabled = {TagSenseType.HF: hf_enabled, TagSenseType.LF: lf_enabled}
+        self.nick: dict[int, Optional[bytes]] = {TagSenseType.HF: None, TagSenseType.LF: None}
+        self.reset_hf()
+
+    def reset_hf(self):
+        # the emulator buffer always holds a 4k card
+        self.blocks = mf1_factory_blocks(MF1_BLOCK_COUNTS[TagSpecificType.MIFARE_4096])
+        block_count = MF1_BLOCK_COUNTS.get(self.tag_type[TagSenseType.HF], 256)
+        self.blocks[16 * block_count:] = bytes(16 * (256 - block_count))
+        self.anti_coll = MF1_FACTORY_ANTI_COLL
+        # detection, gen1a, gen2, block anti-collision, write mode
+        self.mf1_config = [0, 0, 0, 0, 0]
+
+
+_handlers: dict[int, tuple[Callable, bool]] = {}
+
+
+def handles(*cmds: Command, reader: bool = False):
+    """
+        Register a SimDevice method as the processor of cmds, reader ones only run in reader mode.
+    """
+    def register(method):
+        for cmd in cmds:
+            _handlers[cmd] = (method, reader)
+        return method
+    return register
+
+
+class SimDevice:
+    """
+        State and command processing of the simulated device, without the transport
+
+        process() answers a request as the firmware does: replayed exchanges first, then the
+        command map, INVALID_CMD for commands it has not, DEVICE_MODE_ERROR for reader commands
+        outside reader mode, and PAR_ERR for data of the wrong length.
+    """
+
+    def __init__(self, card: Union[MifareClassicCard, NtagCard, None] = None, seed: Optional[int] = None):
+        self.rng = random.Random(seed)
+        self.card = card
+        self.lock = threading.Lock()
+        self.replays: dict[int, list[tuple[bytes, int, bytes]]] = {}
+        self.replay_index: dict[int, int] = {}
+        self.command = 0
+        self.factory_reset()
+
+    def factory_reset(self):
+        self.reader_mode = False
+        self.active_slot = 0
+        self.slots = [SimSlot(TagSpecificType.MIFARE_1024, TagSpecificType.EM410X, True, True),
+                      SimSlot(TagSpecificType.MF0ICU1, hf_enabled=True),
+                      SimSlot(lf=TagSpecificType.EM410X, lf_enabled=True)] \
+            + [SimSlot() for _ in range(SLOT_COUNT - 3)]
+        self.reset_settings()
+        self.detection_log: list[bytes] = []
+        self.hf14a_config = bytes(4)
+
+    def reset_settings(self):
+        self.settings = bytearray([SETTINGS_VERSION, 0, ButtonPressFunction.NEXTSLOT, ButtonPressFunction.PREVSLOT,
+                                   ButtonPressFunction.CLONE, ButtonPressFunction.BATTERY, 0]) + b'123456'
+
+    @property
+    def slot(self) -> SimSlot:
+        return self.slots[self.active_slot]
+
+    def load_replay(self, path: str):
+        """
+            Answer the commands of a --record file from it. Each cmd gets its recorded answers in order,
+            the next one with the same request data first, and keeps the last one once they run out.
+        """
+        with open(path) as f:
+            for line in f:
+                if not line.strip():
+                    continue
+                entry = json.loads(line)
+                self.replays.setdefault(entry['cmd'], []).append(
+                    (bytes.fromhex(entry['data']), entry['status'], bytes.fromhex(entry['response'])))
+
+    def replay(self, cmd: int, data: bytes) -> Optional[tuple[int, bytes]]:
+        entries = self.replays.get(cmd)
+        if not entries:
+            return None
+        index = self.replay_index.get(cmd, 0)
+        for i in range(index, len(entries)):
+            if entries[i][0] == data:
+                index = i
+                break
+        self.replay_index[cmd] = index + 1
+        _, status, response = entries[min(index, len(entries) - 1)]
+        return status, response
+
+    def capabilities(self) -> list[int]:
+        return sorted(set(_handlers) | set(self.replays))
+
+    def process(self, cmd: int, data: bytes) -> Optional[tuple[int, bytes]]:
+        """
+            Answer a request.
+
+        :return: status, response data
+        """
+        with self.lock:
+            answer = self.replay(cmd, data)
+            if answer is not None:
+                return answer
+            if cmd not in _handlers:
+                return Status.INVALID_CMD, b''
+            method, reader = _handlers[cmd]
+            if reader and not self.reader_mode:
+                return Status.DEVICE_MODE_ERROR, b''
+            # handlers of several commands look at which one they run
+            self.command = cmd
+            try:
+                return method(self, data)
+            except (struct.error, IndexError, ValueError):
+                return Status.PAR_ERR, b''
+
+    def add_reader_auth(self, key: bytes, block: int = 0, key_type: int = MfcKeyType.A, nested: bool = False):
+        """
+            Log an authentication of a reader holding key to the emulated card, as detection mode does.
+        """
+        uid = int.from_bytes(self.slot.anti_coll[0][-4:], 'big')
+        nt, nr = self.rng.getrandbits(32), self.rng.getrandbits(32)
+        state = Crypto1()
+        state.key = key.hex()
+        state.lfsr48_u32(uid ^ nt)
+        nr_enc = nr ^ state.lfsr48_u32(nr)
+        ar_enc = Crypto1.prng_next(nt, 64) ^ state.lfsr48_u32(0)
+        bitfield = int(key_type == MfcKeyType.B) | int(nested) << 1
+        self.detection_log.append(struct.pack('!BBIIII', block, bitfield, uid, nt, nr_enc, ar_enc))
+
+    # device
+
+    @handles(Command.GET_APP_VERSION)
+    def get_app_version(self, data):
+        return Status.SUCCESS, struct.pack('!BB', *APP_VERSION)
+
+    @handles(Command.GET_GIT_VERSION)
+    def get_git_version(self, data):
+        return Status.SUCCESS, GIT_VERSION.encode()
+
+    @handles(Command.GET_DEVICE_MODEL)
+    def get_device_model(self, data):
+        return Status.SUCCESS, b'\x00'
+
+    @handles(Command.CHANGE_DEVICE_MODE)
+    def change_device_mode(self, data):
+        mode, = struct.unpack('!B', data)
+        if mode > 1:
+            return Status.PAR_ERR, b''
+        self.reader_mode = bool(mode)
+        return Status.SUCCESS, b''
+
+    @handles(Command.GET_DEVICE_MODE)
+    def get_device_mode(self, data):
+        return Status.SUCCESS, struct.pack('!B', self.reader_mode)
+
+    @handles(Command.GET_DEVICE_CHIP_ID)
+    def get_device_chip_id(self, data):
+        return Status.SUCCESS, bytes.fromhex('0123456789ABCDEF')
+
+    @handles(Command.GET_DEVICE_ADDRESS)
+    def get_device_address(self, data):
+        return Status.SUCCESS, bytes.fromhex('C0FFEE000001')
+
+    @handles(Command.GET_BATTERY_INFO)
+    def get_battery_info(self, data):
+        return Status.SUCCESS, struct.pack('!HB', 4100, 100)
+
+    @handles(Command.GET_DEVICE_CAPABILITIES)
+    def get_device_capabilities(self, data):
+        return Status.SUCCESS, b''.join(struct.pack('!H', cmd) for cmd in self.capabilities())
+
+    @handles(Command.GET_REQUEST_QUEUE_SIZE)
+    def get_request_queue_size(self, data):
+        return Status.SUCCESS, struct.pack('!H', REQUEST_QUEUE_SIZE)
+
+    @handles(Command.GET_DEVICE_SETTINGS)
+    def get_device_settings(self, data):
+        return Status.SUCCESS, bytes(self.settings)
+
+    @handles(Command.GET_ANIMATION_MODE)
+    def get_animation_mode(self, data):
+        return Status.SUCCESS, self.settings[1:2]
+
+    @handles(Command.SET_ANIMATION_MODE)
+    def set_animation_mode(self, data):
+        self.settings[1], = struct.unpack('!B', data)
+        return Status.SUCCESS, b''
+
+    def button_setting(self, button: int, long: bool) -> int:
+        if button not in (ButtonType.A, ButtonType.B):
+            raise ValueError(button)
+        return 2 + 2 * long + (button == ButtonType.B)
+
+    @handles(Command.GET_BUTTON_PRESS_CONFIG, Command.GET_LONG_BUTTON_PRESS_CONFIG)
+    def get_button_press_config(self, data):
+        button, = struct.unpack('!B', data)
+        index = self.button_setting(button, self.command == Command.GET_LONG_BUTTON_PRESS_CONFIG)
+        return Status.SUCCESS, self.settings[index:index + 1]
+
+    @handles(Command.SET_BUTTON_PRESS_CONFIG, Command.SET_LONG_BUTTON_PRESS_CONFIG)
+    def set_button_press_config(self, data):
+        button, function = struct.unpack('!BB', data)
+        self.settings[self.button_setting(button, self.command == Command.SET_LONG_BUTTON_PRESS_CONFIG)] = function
+        return Status.SUCCESS, b''
+
+    @handles(Command.GET_BLE_PAIRING_KEY)
+    def get_ble_pairing_key(self, data):
+        return Status.SUCCESS, bytes(self.settings[7:13])
+
+    @handles(Command.SET_BLE_PAIRING_KEY)
+    def set_ble_pairing_key(self, data):
+        if len(data) != 6 or not data.isdigit():
+            return Status.PAR_ERR, b''
+        self.settings[7:13] = data
+        return Status.SUCCESS, b''
+
+    @handles(Command.GET_BLE_PAIRING_ENABLE)
+    def get_ble_pairing_enable(self, data):
+        return Status.SUCCESS, self.settings[6:7]
+
+    @handles(Command.SET_BLE_PAIRING_ENABLE)
+    def set_ble_pairing_enable(self, data):
+        enable, = struct.unpack('!B', data)
+        if enable > 1:
+            return Status.PAR_ERR, b''
+        self.settings[6] = enable
+        return Status.SUCCESS, b''
+
+    @handles(Command.RESET_SETTINGS)
+    def reset_settings_cmd(self, data):
+        self.reset_settings()
+        return Status.SUCCESS, b''
+
+    @handles(Command.WIPE_FDS)
+    def wipe_fds(self, data):
+        self.factory_reset()
+        return Status.SUCCESS, b''
+
+    @handles(Command.SAVE_SETTINGS, Command.SLOT_DATA_CONFIG_SAVE, Command.DELETE_ALL_BLE_BONDS)
+    def nothing_to_do(self, data):
+        # nothing is persisted
+        return Status.SUCCESS, b''
+
+    @handles(Command.HF14A_GET_CONFIG)
+    def hf14a_get_config(self, data):
+        return Status.SUCCESS, self.hf14a_config
+
+    @handles(Command.HF14A_SET_CONFIG)
+    def hf14a_set_config(self, data):
+        if len(data) != 4:
+            return Status.PAR_ERR, b''
+        self.hf14a_config = bytes(data)
+        return Status.SUCCESS, b''
+
+    # slots
+
+    @handles(Command.SET_ACTIVE_SLOT)
+    def set_active_slot(self, data):
+        slot, = struct.unpack('!B', data)
+        if slot >= SLOT_COUNT:
+            return Status.PAR_ERR, b''
+        self.active_slot = slot
+        return Status.SUCCESS, b''
+
+    @handles(Command.GET_ACTIVE_SLOT)
+    def get_active_slot(self, data):
+        return Status.SUCCESS, struct.pack('!B', self.active_slot)
+
+    @handles(Command.GET_SLOT_INFO)
+    def get_slot_info(self, data):
+        return Status.SUCCESS, b''.join(struct.pack('!HH', slot.tag_type[TagSenseType.HF], slot.tag_type[TagSenseType.LF])
+                                        for slot in self.slots)
+
+    @handles(Command.GET_ENABLED_SLOTS)
+    def get_enabled_slots(self, data):
+        return Status.SUCCESS, b''.join(struct.pack('!BB', slot.enabled[TagSenseType.HF], slot.enabled[TagSenseType.LF])
+                                        for slot in self.slots)
+
+    @handles(Command.SET_SLOT_TAG_TYPE, Command.SET_SLOT_DATA_DEFAULT)
+    def set_slot_tag_type(self, data):
+        slot, tag_type = struct.unpack('!BH', data)
+        if slot >= SLOT_COUNT or tag_type not in TagSpecificType.list():
+            return Status.PAR_ERR, b''
+        sense = TagSenseType.HF if tag_type > TagSpecificType.TAG_TYPES_LF_END else TagSenseType.LF
+        self.slots[slot].tag_type[sense] = TagSpecificType(tag_type)
+        if sense == TagSenseType.HF:
+            self.slots[slot].reset_hf()
+        return Status.SUCCESS, b''
+
+    @handles(Command.SET_SLOT_ENABLE)
+    def set_slot_enable(self, data):
+        slot, sense, enabled = struct.unpack('!BBB', data)
+        if slot >= SLOT_COUNT or sense not in (TagSenseType.HF, TagSenseType.LF) or enabled > 1:
+            return Status.PAR_ERR, b''
+        self.slots[slot].enabled[sense] = bool(enabled)
+        return Status.SUCCESS, b''
+
+    @handles(Command.DELETE_SLOT_SENSE_TYPE)
+    def delete_slot_sense_type(self, data):
+        slot, sense = struct.unpack('!BB', data)
+        if slot >= SLOT_COUNT or sense not in (TagSenseType.HF, TagSenseType.LF):
+            return Status.PAR_ERR, b''
+        self.slots[slot].tag_type[sense] = TagSpecificType.UNDEFINED
+        self.slots[slot].enabled[sense] = False
+        return Status.SUCCESS, b''
+
+    def slot_sense(self, data: bytes) -> tuple[SimSlot, int]:
+        slot, sense = struct.unpack_from('!BB', data)
+        if slot >= SLOT_COUNT or sense not in (TagSenseType.HF, TagSenseType.LF):
+            raise ValueError(data)
+        return self.slots[slot], sense
+
+    @handles(Command.SET_SLOT_TAG_NICK)
+    def set_slot_tag_nick(self, data):
+        slot, sense = self.slot_sense(data)
+        if not 3 <= len(data) <= 34:
+            return Status.PAR_ERR, b''
+        slot.nick[sense] = bytes(data[2:])
+        return Status.SUCCESS, b''
+
+    @handles(Command.GET_SLOT_TAG_NICK)
+    def get_slot_tag_nick(self, data):
+        if len(data) != 2:
+            return Status.PAR_ERR, b''
+        slot, sense = self.slot_sense(data)
+        if slot.nick[sense] is None:
+            return Status.FLASH_READ_FAIL, b''
+        return Status.SUCCESS, slot.nick[sense]
+
+    @handles(Command.DELETE_SLOT_TAG_NICK)
+    def delete_slot_tag_nick(self, data):
+        if len(data) != 2:
+            return Status.PAR_ERR, b''
+        slot, sense = self.slot_sense(data)
+        slot.nick[sense] = None
+        return Status.SUCCESS, b''
+
+    @handles(Command.GET_ALL_SLOT_NICKS)
+    def get_all_slot_nicks(self, data):
+        response = bytearray()
+        for slot in self.slots:
+            for sense in (TagSenseType.HF, TagSenseType.LF):
+                nick = slot.nick[sense] or b''
+                response += struct.pack('!B', len(nick)) + nick
+        return Status.SUCCESS, bytes(response)
+
+    # MIFARE Classic emulator of the active slot
+
+    @handles(Command.MF1_WRITE_EMU_BLOCK_DATA)
+    def mf1_write_emu_block_data(self, data):
+        block, blocks = data[0], data[1:]
+        if not blocks or len(blocks) % 16 or block + len(blocks) // 16 > 256:
+            return Status.PAR_ERR, b''
+        self.slot.blocks[16 * block:16 * block + len(blocks)] = blocks
+        return Status.SUCCESS, b''
+
+    @handles(Command.MF1_READ_EMU_BLOCK_DATA)
+    def mf1_read_emu_block_data(self, data):
+        block, count = struct.unpack('!BB', data)
+        if not 1 <= count <= 32 or block + count > 256:
+            return Status.PAR_ERR, b''
+        return Status.SUCCESS, bytes(self.slot.blocks[16 * block:16 * (block + count)])
+
+    @handles(Command.HF14A_GET_ANTI_COLL_DATA)
+    def hf14a_get_anti_coll_data(self, data):
+        return Status.SUCCESS, anti_coll_bytes(*self.slot.anti_coll)
+
+    @handles(Command.HF14A_SET_ANTI_COLL_DATA)
+    def hf14a_set_anti_coll_data(self, data):
+        uidlen = data[0]
+        uid, atqa, sak, atslen = struct.unpack_from(f'!{uidlen}s2s1sB', data, 1)
+        ats = data[5 + uidlen:]
+        if uidlen not in (4, 7, 10) or len(ats) != atslen:
+            return Status.PAR_ERR, b''
+        self.slot.anti_coll = (uid, atqa, sak, bytes(ats))
+        return Status.SUCCESS, b''
+
+    @handles(Command.MF1_GET_EMULATOR_CONFIG)
+    def mf1_get_emulator_config(self, data):
+        return Status.SUCCESS, bytes(self.slot.mf1_config)
+
+    @handles(Command.MF1_SET_DETECTION_ENABLE, Command.MF1_SET_GEN1A_MODE, Command.MF1_SET_GEN2_MODE,
+             Command.MF1_SET_BLOCK_ANTI_COLL_MODE, Command.MF1_SET_WRITE_MODE)
+    def mf1_set_emulator_config(self, data):
+        value, = struct.unpack('!B', data)
+        index = [Command.MF1_SET_DETECTION_ENABLE, Command.MF1_SET_GEN1A_MODE, Command.MF1_SET_GEN2_MODE,
+                 Command.MF1_SET_BLOCK_ANTI_COLL_MODE, Command.MF1_SET_WRITE_MODE].index(self.command)
+        if value > (3 if self.command == Command.MF1_SET_WRITE_MODE else 1):
+            return Status.PAR_ERR, b''
+        self.slot.mf1_config[index] = value
+        if self.command == Command.MF1_SET_DETECTION_ENABLE:
+            self.detection_log.clear()
+        return Status.SUCCESS, b''
+
+    @handles(Command.MF1_GET_DETECTION_COUNT)
+    def mf1_get_detection_count(self, data):
+        return Status.SUCCESS, struct.pack('!I', len(self.detection_log))
+
+    @handles(Command.MF1_GET_DETECTION_LOG)
+    def mf1_get_detection_log(self, data):
+        index, = struct.unpack('!I', data)
+        if index >= len(self.detection_log):
+            return Status.PAR_ERR, b''
+        return Status.SUCCESS, b''.join(self.detection_log[index:index + 4096 // DETECTION_RECORD_SIZE])
+
+    # reader
+
+    def mf1_card(self) -> MifareClassicCard:
+        if not isinstance(self.card, MifareClassicCard):
+            raise LookupError("no MIFARE Classic in the field")
+        return self.card
+
+    def mf1_auth(self, block: int, key_type: int, key: bytes) -> int:
+        return Status.HF_TAG_OK if self.mf1_card().auth(block, key_type, key) else Status.MF_ERR_AUTH
+
+    @handles(Command.HF14A_SCAN, reader=True)
+    def hf14a_scan(self, data):
+        if self.card is None:
+            return Status.HF_TAG_NO, b''
+        return Status.HF_TAG_OK, anti_coll_bytes(self.card.uid, self.card.atqa, self.card.sak, self.card.ats)
+
+    @handles(Command.MF1_DETECT_SUPPORT, reader=True)
+    def mf1_detect_support(self, data):
+        self.mf1_card()
+        return Status.HF_TAG_OK, b''
+
+    @handles(Command.MF1_DETECT_PRNG, reader=True)
+    def mf1_detect_prng(self, data):
+        return Status.HF_TAG_OK, struct.pack('!B', self.mf1_card().prng)
+
+    @handles(Command.MF1_DETECT_NT_DIST, reader=True)
+    def mf1_detect_nt_dist(self, data):
+        type_known, block_known, key_known = struct.unpack('!BB6s', data)
+        card = self.mf1_card()
+        status = self.mf1_auth(block_known, type_known, key_known)
+        if status != Status.HF_TAG_OK:
+            return status, b''
+        if card.prng == MifareClassicPrngType.HARD:
+            return Status.HF_ERR_STAT, b''
+        dist = card.dist if card.prng == MifareClassicPrngType.WEAK else 0
+        return Status.HF_TAG_OK, struct.pack('!II', card.cuid, dist)
+
+    def nested_request(self, data: bytes) -> tuple[int, MifareClassicCard, int, int]:
+        type_known, block_known, key_known, type_target, block_target = struct.unpack('!BB6sBB', data)
+        card = self.mf1_card()
+        status = self.mf1_auth(block_known, type_known, key_known)
+        if status == Status.HF_TAG_OK and block_target >= card.block_count:
+            status = Status.HF_ERR_STAT
+        return status, card, block_target, type_target
+
+    @handles(Command.MF1_NESTED_ACQUIRE, reader=True)
+    def mf1_nested_acquire(self, data):
+        status, card, block_target, type_target = self.nested_request(data)
+        if status != Status.HF_TAG_OK:
+            return status, b''
+        response = bytearray()
+        for _ in range(2):
+            nt = card.nonce()
+            nt_enc, par = card.encrypt_nonce(card.nested_nonce(nt), block_target, type_target)
+            # bit i set when the parity received after byte i is not the parity of the encrypted byte
+            par_err = sum((odd_parity_u8(nt_enc >> (24 - 8 * i)) != par[i]) << i for i in range(3))
+            response += struct.pack('!IIB', nt, nt_enc, par_err)
+        return Status.HF_TAG_OK, bytes(response)
+
+    @handles(Command.MF1_STATIC_NESTED_ACQUIRE, reader=True)
+    def mf1_static_nested_acquire(self, data):
+        status, card, block_target, type_target = self.nested_request(data)
+        if status != Status.HF_TAG_OK:
+            return status, b''
+        response = bytearray(struct.pack('!I', card.cuid))
+        # the second nonce comes after one more nested authentication with the known key
+        for hops in (1, 2):
+            nt = card.nonce()
+            nt_enc, _ = card.encrypt_nonce(card.nested_nonce(nt, hops), block_target, type_target)
+            response += struct.pack('!II', nt, nt_enc)
+        return Status.HF_TAG_OK, bytes(response)
+
+    @handles(Command.MF1_HARDNESTED_ACQUIRE, reader=True)
+    def mf1_hardnested_acquire(self, data):
+        status, card, block_target, type_target = self.nested_request(data[1:])
+        if status != Status.HF_TAG_OK:
+            return status, b''
+        response = bytearray()
+        for _ in range(MF1_HARDNESTED_PAIRS):
+            pair = []
+            for _ in range(2):
+                nt_enc, par = card.encrypt_nonce(card.nested_nonce(card.nonce()), block_target, type_target)
+                pair.append((nt_enc, par[0] << 3 | par[1] << 2 | par[2] << 1 | par[3]))
+            (nt_enc1, par1), (nt_enc2, par2) = pair
+            response += struct.pack('!IIB', nt_enc1, nt_enc2, par1 << 4 | par2)
+        return Status.HF_TAG_OK, bytes(response)
+
+    @handles(Command.MF1_AUTH_ONE_KEY_BLOCK, reader=True)
+    def mf1_auth_one_key_block(self, data):
+        key_type, block, key = struct.unpack('!BB6s', data)
+        return self.mf1_auth(block, key_type, key), b''
+
+    @handles(Command.MF1_READ_ONE_BLOCK, reader=True)
+    def mf1_read_one_block(self, data):
+        key_type, block, key = struct.unpack('!BB6s', data)
+        status = self.mf1_auth(block, key_type, key)
+        if status != Status.HF_TAG_OK:
+            return status, b''
+        return Status.HF_TAG_OK, self.mf1_card().read(block)
+
+    @handles(Command.MF1_WRITE_ONE_BLOCK, reader=True)
+    def mf1_write_one_block(self, data):
+        key_type, block, key, block_data = struct.unpack('!BB6s16s', data)
+        status = self.mf1_auth(block, key_type, key)
+        if status != Status.HF_TAG_OK:
+            return status, b''
+        if not self.mf1_card().write(block, block_data):
+            return Status.HF_ERR_STAT, b''
+        return Status.HF_TAG_OK, b''
+
+    @handles(Command.MF1_CHECK_KEYS_OF_SECTORS, reader=True)
+    def mf1_check_keys_of_sectors(self, data):
+        if len(data) < 16 or (len(data) - 10) % 6:
+            return Status.PAR_ERR, b''
+        mask = data[:10]
+        keys = [data[i:i + 6] for i in range(10, len(data), 6)]
+        found = bytearray(10)
+        sector_keys = bytearray(40 * 2 * 6)
+        if not isinstance(self.card, MifareClassicCard):
+            return Status.HF_TAG_NO, bytes(found + sector_keys)
+        card = self.card
+        for sector in range(40):
+            shift = 6 - sector % 4 * 2
+            skip = mask[sector // 4] >> shift
+            trailer = mf1_sector_trailer(sector)
+            if trailer >= card.block_count:
+                continue
+            if not skip & 0b10:
+                key_a = next((key for key in keys if card.auth(trailer, MfcKeyType.A, key)), None)
+                if key_a is not None:
+                    found[sector // 4] |= 0b10 << shift
+                    sector_keys[12 * sector:12 * sector + 6] = key_a
+                    # key A reads key B from the trailer when the access bits allow it
+                    key_b = card.read(trailer)[10:]
+                    if not skip & 0b01 and any(key_b):
+                        found[sector // 4] |= 0b01 << shift
+                        sector_keys[12 * sector + 6:12 * sector + 12] = key_b
+                        continue
+            if not skip & 0b01 and not found[sector // 4] >> shift & 0b01:
+                key_b = next((key for key in keys if card.auth(trailer, MfcKeyType.B, key)), None)
+                if key_b is not None:
+                    found[sector // 4] |= 0b01 << shift
+                    sector_keys[12 * sector + 6:12 * sector + 12] = key_b
+        return Status.HF_TAG_OK, bytes(found + sector_keys)
+
+    @handles(Command.MF1_CHECK_KEYS_ON_BLOCK, reader=True)
+    def mf1_check_keys_on_block(self, data):
+        block, key_type, count = struct.unpack_from('!BBB', data)
+        if len(data) < 9 or len(data) != 3 + 6 * count:
+            return Status.PAR_ERR, b''
+        if not isinstance(self.card, MifareClassicCard):
+            return Status.HF_TAG_NO, bytes(7)
+        for i in range(3, len(data), 6):
+            if self.card.auth(block, key_type, data[i:i + 6]):
+                return Status.HF_TAG_OK, b'\x01' + data[i:i + 6]
+        return Status.MF_ERR_AUTH, bytes(7)
+
+    @handles(Command.HF14A_RAW, reader=True)
+    def hf14a_raw(self, data):
+        options, _, bitlen = struct.unpack_from('!BHH', data)
+        frame = data[5:]
+        if bitlen > 8 * len(frame):
+            return Status.PAR_ERR, b''
+        if self.card is None:
+            return Status.HF_TAG_NO, b''
+        # wait_response
+        if not frame or not options & 0x40:
+            return Status.HF_TAG_OK, b''
+        answer = self.card.command(frame)
+        # without check_response_crc the client gets the CRC of the tag, 4 bit ACKs have none
+        if len(answer) > 1 and not options & 0x04:
+            answer += crc_a(answer)
+        return Status.HF_TAG_OK, answer
+
+
+class RecordingProxy:
+    """
+        Forwards every request to a real device and appends the exchanges to a --replay file
+    """
+
+    def __init__(self, port: str, path: str, timeout: float = 60):
+        self.com = ChameleonCom().open(port)
+        self.out = open(path, 'a')
+        self.timeout = timeout
+        self.lock = threading.Lock()
+
+    def process(self, cmd: int, data: bytes) -> Optional[tuple[int, bytes]]:
+        with self.lock:
+            try:
+                resp = self.com.send_cmd_sync(cmd, data, timeout=self.timeout)
+                status, response = resp.status, resp.data
+            except CMDInvalidException:
+                status, response = Status.INVALID_CMD, b''
+            except TimeoutError:
+                # the client times out as well
+                return None
+            self.out.write(json.dumps({'cmd': cmd, 'data': data.hex(), 'status': status,
+                                       'response': response.hex()}) + '\n')
+            self.out.flush()
+            return status, response
+
+    def close(self):
+        self.com.close()
+        self.out.close()
+
+
+class SimServer:
+    """
+        Serves a SimDevice (or RecordingProxy) on a local TCP port or a pty
+
+        Each command takes latency seconds plus its request and response frames at link_rate bytes/s,
+        so benchmarks see the cost of the link instead of a free loopback.
+    """
+
+    def __init__(self, device: Union[SimDevice, RecordingProxy], latency: float = 0.0, link_rate: int = 0):
+        self.device = device
+        self.latency = latency
+        self.link_rate = link_rate
+        self.server: Optional[socket.socket] = None
+        self.pty_fds: tuple[int, ...] = ()
+
+    def respond(self, parser: DataFrameParser, received: bytes, send: Callable[[bytes], None]):
+        for cmd, _, data in parser.feed(received):
+            request_size = 10 + len(data)
+            cmd, tag, data = parser.untag(cmd, data)
+            answer = self.device.process(cmd, data)
+            if answer is None:
+                continue
+            status, response = answer
+            frame = parser.make(cmd, response, status, tag)
+            delay = self.latency
+            if self.link_rate:
+                delay += (request_size + len(frame)) / self.link_rate
+            if delay:
+                time.sleep(delay)
+            send(frame)
+
+    def listen(self, port: int = 0, host: str = '127.0.0.1') -> int:
+        """
+            Accept connections, one at a time, on a TCP port.
+
+        :return: the port, picked by the system when 0
+        """
+        self.server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server.bind((host, port))
+        self.server.listen(1)
+        threading.Thread(target=self.accept, daemon=True).start()
+        return self.server.getsockname()[1]
+
+    def accept(self):
+        while True:
+            try:
+                conn, _ = self.server.accept()
+            except OSError:
+                break
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            parser = DataFrameParser()
+            with conn:
+                while True:
+                    try:
+                        data = conn.recv(65536)
+                        if not data:
+                            break
+                        self.respond(parser, data, conn.sendall)
+                    except OSError:
+                        break
+
+    def open_pty(self) -> str:
+        """
+            Serve on a pseudo terminal, POSIX only.
+
+        :return: path of the terminal to open as serial port
+        """
+        import tty
+        master, slave = os.openpty()
+        tty.setraw(slave)
+        # holding the slave open keeps the master readable between clients
+        self.pty_fds = (master, slave)
+        threading.Thread(target=self.serve_pty, args=(master,), daemon=True).start()
+        return os.ttyname(slave)
+
+    def serve_pty(self, master: int):
+        parser = DataFrameParser()
+
+        def send(frame: bytes):
+            while frame:
+                frame = frame[os.write(master, frame):]
+
+        while True:
+            try:
+                data = os.read(master, 65536)
+            except OSError:
+                break
+            if not data:
+                break
+            self.respond(parser, data, send)
+
+    def close(self):
+        if self.server is not None:
+            self.server.close()
+        for fd in self.pty_fds:
+            os.close(fd)
+        self.pty_fds = ()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    transport = parser.add_mutually_exclusive_group()
+    transport.add_argument('--port', type=int, default=0, help="TCP port on 127.0.0.1, 0 picks a free one")
+    transport.add_argument('--pty', action='store_true', help="serve on a pseudo terminal instead")
+    parser.add_argument('--latency', type=float, default=0, help="device time per command, in ms")
+    parser.add_argument('--link-rate', type=int, default=0, metavar='BYTES_PER_S',
+                        help="emulated link speed, 0 for none")
+    parser.add_argument('--card', choices=['mf1', 'ntag215', 'none'], default='mf1', help="tag in the reader field")
+    parser.add_argument('--dump', help="MIFARE Classic content, .bin or .eml (default: factory 1k)")
+    parser.add_argument('--key-a', type=bytes.fromhex, metavar='<hex>', help="key A of all sectors")
+    parser.add_argument('--key-b', type=bytes.fromhex, metavar='<hex>', help="key B of all sectors")
+    parser.add_argument('--prng', choices=[t.name.lower() for t in MifareClassicPrngType], default='weak')
+    parser.add_argument('--dist', type=int, default=320, help="nonce distance of the weak PRNG")
+    parser.add_argument('--magic', action='store_true', help="block 0 of the MIFARE Classic is writable")
+    parser.add_argument('--seed', type=int, help="seed of the nonces, for repeatable runs")
+    parser.add_argument('--reader', action='store_true', help="start in reader mode")
+    parser.add_argument('--elog', type=bytes.fromhex, metavar='<hex>',
+                        help="enable detection and log reader authentications with this key")
+    parser.add_argument('--elog-records', type=int, default=4, help="number of reader authentications to log")
+    parser.add_argument('--replay', help="answer the commands recorded in this file from it")
+    parser.add_argument('--record', help="append the exchanges with --device to this file")
+    parser.add_argument('--device', help="port of the real device to record")
+    args = parser.parse_args()
+
+    if args.record is not None:
+        if args.device is None:
+            parser.error("--record needs --device")
+        device = RecordingProxy(args.device, args.record)
+    else:
+        rng = random.Random(args.seed)
+        card = None
+        if args.card == 'mf1':
+            card = MifareClassicCard(load_dump(args.dump) if args.dump else None,
+                                     MifareClassicPrngType[args.prng.upper()], args.dist, args.magic, rng)
+            card.set_keys(args.key_a, args.key_b)
+        elif args.card == 'ntag215':
+            card = NtagCard()
+        device = SimDevice(card, args.seed)
+        device.reader_mode = args.reader
+        if args.replay is not None:
+            device.load_replay(args.replay)
+        if args.elog is not None:
+            device.slot.mf1_config[0] = 1
+            for i in range(args.elog_records):
+                device.add_reader_auth(args.elog)
+
+    server = SimServer(device, args.latency / 1000, args.link_rate)
+    if args.pty:
+        print(f"Chameleon simulator on {server.open_pty()}", flush=True)
+    else:
+        print(f"Chameleon simulator on tcp:127.0.0.1:{server.listen(args.port)}", flush=True)
+    try:
+        while True:
+            time.sleep(3600)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.close()
+        if isinstance(device, RecordingProxy):
+            device.close()
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,7 +1,9 @@
 import argparse
+import inspect
 import subprocess
 import sys
 import tempfile
+import threading
 import os.path
 from pathlib import Path
 
@@ -180,14 +182,17 @@ def parity_to_str(nt_par_err):
     )
 
 
-def execute_tool(tool_name, args):
+def get_tool_path(tool_name):
     if sys.platform == "win32":
         tool_executable = f"{tool_name}.exe"
     else:
         tool_executable = f"./{tool_name}"
 
-    tool_path = os.path.join(default_cwd, tool_executable)
-    cmd_recover_list = [tool_path]
+    return os.path.join(default_cwd, tool_executable)
+
+
+def execute_tool(tool_name, args):
+    cmd_recover_list = [get_tool_path(tool_name)]
     cmd_recover_list.extend(args)
 
     # print(f"Executing: {' '.join(cmd_recover_list)}")
@@ -213,6 +218,109 @@ def execute_tool(tool_name, args):
     return temp_output_file.read()
 
 
+KEY_DIC_MAGIC = b'MFKEYDIC'
+KEY_DIC_HEADER_SIZE = 32
+
+
+def read_key_dic(path):
+    """
+    Read a key candidate dictionary written by the nested tools, binary or text.
+
+    Returns the keys as 6 byte values.
+    """
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data.startswith(KEY_DIC_MAGIC):
+        count = int.from_bytes(data[24:28], 'little')
+        body = data[KEY_DIC_HEADER_SIZE:KEY_DIC_HEADER_SIZE + count * 6]
+        return [body[i:i + 6] for i in range(0, len(body), 6)]
+    return [bytes.fromhex(line.strip().zfill(12)) for line in data.decode('ascii').split() if line.strip()]
+
+
+class HardnestedStream:
+    """
+    Long-lived `hardnested --stream` process fed with nonce batches while they are acquired.
+
+    The tool reduces the key space after every batch and answers with a
+    "Stream: nonces=<n> states=<n> done=<0|1>" line; done means enough nonces are in.
+    The reduction runs while the next batches are acquired, status() reports the latest answer.
+    """
+    MAX_BATCH_CHUNKS = 0xFFFF
+
+    def __init__(self, header: bytes):
+        self.output = []
+        self.nonces = 0
+        self.states = float(1 << 47)
+        self.done = False
+        self.batches_sent = 0
+        self.batches_reduced = 0
+        self._lock = threading.Lock()
+        self.process = subprocess.Popen(
+            [get_tool_path('hardnested'), '--stream'],
+            cwd=tempfile.gettempdir(),
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+        )
+        self._reader = threading.Thread(target=self._read_output, daemon=True)
+        self._reader.start()
+        self._write(header)
+
+    def _read_output(self):
+        for raw_line in self.process.stdout:
+            line = raw_line.decode('utf-8', errors='replace')
+            with self._lock:
+                self.output.append(line)
+            if line.startswith('Stream: '):
+                fields = dict(field.split('=', 1) for field in line.split()[1:])
+                with self._lock:
+                    self.nonces = int(fields['nonces'])
+                    self.states = float(fields['states'])
+                    self.done = fields['done'] == '1'
+                    self.batches_reduced += 1
+
+    def _write(self, data: bytes):
+        try:
+            self.process.stdin.write(data)
+            self.process.stdin.flush()
+        except (BrokenPipeError, OSError):
+            pass  # the tool gave up already, alive() reports it
+
+    def alive(self):
+        return self.process.poll() is None
+
+    def send_batch(self, raw_nonces: bytes):
+        """Send whole 9 byte chunks (nt_enc1, nt_enc2, packed parity) as acquired from the device"""
+        num_chunks = len(raw_nonces) // 9
+        for start in range(0, num_chunks, self.MAX_BATCH_CHUNKS):
+            count = min(self.MAX_BATCH_CHUNKS, num_chunks - start)
+            with self._lock:
+                self.batches_sent += 1
+            self._write(count.to_bytes(2, 'big') + raw_nonces[start * 9:(start + count) * 9])
+
+    def status(self):
+        """Latest answer without waiting: nonces and states after the batches reduced so far, done"""
+        with self._lock:
+            return self.nonces, self.states, self.done, self.batches_reduced, self.batches_sent
+
+    def finish(self):
+        """End the input and wait for the brute force, returns the whole tool output"""
+        self._write(b'\x00\x00')
+        try:
+            self.process.stdin.close()
+        except OSError:
+            pass
+        self.process.wait()
+        self._reader.join()
+        with self._lock:
+            return ''.join(self.output)
+
+    def close(self):
+        if self.alive():
+            self.process.kill()
+            self.process.wait()
+
+
 def tqdm_if_exists(iterator):
     try:
         import tqdm
@@ -224,23 +332,33 @@ def tqdm_if_exists(iterator):
 def expect_response(accepted_responses: Union[int, list[int]]) -> Callable[..., Any]:
     """
     Decorator for wrapping a Chameleon CMD function to check its response
-    for expected return codes and throwing an exception otherwise
+    for expected return codes and throwing an exception otherwise.
+    Coroutine functions are wrapped by a coroutine function.
     """
     if isinstance(accepted_responses, int):
         accepted_responses = [accepted_responses]
 
+    def check(ret):
+        if ret.status not in accepted_responses:
+            try:
+                status_string = str(Status(ret.status))
+            except ValueError:
+                status_string = f"Unexpected response and unknown status {ret.status}"
+            raise UnexpectedResponseError(status_string)
+
+        return ret.parsed
+
     def decorator(func):
+        if inspect.iscoroutinefunction(func):
+            @wraps(func)
+            async def async_error_throwing_func(*args, **kwargs):
+                return check(await func(*args, **kwargs))
+
+            return async_error_throwing_func
+
         @wraps(func)
         def error_throwing_func(*args, **kwargs):
-            ret = func(*args, **kwargs)
-            if ret.status not in accepted_responses:
-                try:
-                    status_string = str(Status(ret.status))
-                except ValueError:
-                    status_string = f"Unexpected response and unknown status {ret.status}"
-                raise UnexpectedResponseError(status_string)
-
-            return ret.parsed
+            return check(func(*args, **kwargs))
 
         return error_throwing_func
 
@@ -0,0 +1,430 @@
+"""
+ctypes binding of the mfcrack library (software/src/mfcrack.h), built next to the recovery tools.
+
+Every recovery returns the candidate keys as ints instead of printed text. When the mfcrackd
+daemon (software/src/mfcrackd.c) is running, the recoveries are sent to it instead, so they
+find its tables already warm. When neither the daemon nor a library of this API version is
+there, available() is False and callers keep using the tools.
+"""
+import ctypes
+import os
+import socket
+import stat
+import struct
+import sys
+from pathlib import Path
+from typing import Optional
+
+MFCRACK_API_VERSION = 6
+
+MFCRACKD_VERSION = 1
+MFCRACKD_OP_PING = 0
+MFCRACKD_OP_NESTED = 1
+MFCRACKD_OP_STATICNESTED = 2
+MFCRACKD_OP_DARKSIDE = 3
+MFCRACKD_OP_MFKEY32V2 = 4
+MFCRACKD_OP_MFKEY32_LOG = 5
+MFCRACKD_OP_TEST_KEYS = 6
+MFCRACKD_OP_RF08S_FILTER = 7
+MFCRACKD_OP_RF08S_1KEY = 8
+MFCRACKD_OP_MFULC = 9
+_MFCRACKD_HEADER = struct.Struct('<4sHHIHHI')
+_MFCRACKD_RESPONSE = struct.Struct('<4sHHIiI')
+
+
+class NestedNonce(ctypes.Structure):
+    _fields_ = [('nt', ctypes.c_uint32), ('nt_enc', ctypes.c_uint32), ('par', ctypes.c_uint8)]
+
+
+class StaticNonce(ctypes.Structure):
+    _fields_ = [('nt', ctypes.c_uint32), ('nt_enc', ctypes.c_uint32)]
+
+
+class DarksideParam(ctypes.Structure):
+    _fields_ = [('nt', ctypes.c_uint32), ('ks_list', ctypes.c_uint64), ('par_list', ctypes.c_uint64),
+                ('nr', ctypes.c_uint32), ('ar', ctypes.c_uint32)]
+
+
+class AuthRecord(ctypes.Structure):
+    _fields_ = [('uid', ctypes.c_uint32), ('nt', ctypes.c_uint32), ('nr_enc', ctypes.c_uint32),
+                ('ar_enc', ctypes.c_uint32), ('block', ctypes.c_uint8), ('key_type', ctypes.c_uint8)]
+
+
+class LogKey(ctypes.Structure):
+    _fields_ = [('uid', ctypes.c_uint32), ('block', ctypes.c_uint8), ('key_type', ctypes.c_uint8),
+                ('key', ctypes.c_uint64)]
+
+
+_KEYS_OUT = ctypes.POINTER(ctypes.POINTER(ctypes.c_uint64))
+_lib = None
+_lib_loaded = False
+_daemon = None
+# thread budget of each recovery, 0 for all cores
+_max_threads = 0
+
+
+def _library_names():
+    if sys.platform == "win32":
+        return ["mfcrack.dll", "libmfcrack.dll"]
+    if sys.platform == "darwin":
+        return ["libmfcrack.dylib"]
+    return ["libmfcrack.so"]
+
+
+def load(bin_dir: Optional[Path] = None):
+    """Load the library once, returns None if it cannot be used"""
+    global _lib, _lib_loaded
+    if _lib_loaded and bin_dir is None:
+        return _lib
+    _lib_loaded = True
+    _lib = None
+    if bin_dir is None:
+        bin_dir = Path.cwd() / Path(__file__).with_name("bin")
+    for name in _library_names():
+        path = Path(bin_dir) / name
+        if not path.exists():
+            continue
+        try:
+            lib = ctypes.CDLL(str(path))
+        except OSError:
+            continue
+        lib.mfcrack_api_version.restype = ctypes.c_int
+        if lib.mfcrack_api_version() != MFCRACK_API_VERSION:
+            continue
+        lib.mfcrack_free.argtypes = [ctypes.c_void_p]
+        lib.mfcrack_free.restype = None
+        lib.mfcrack_set_max_threads.argtypes = [ctypes.c_uint32]
+        lib.mfcrack_set_max_threads.restype = None
+        lib.mfcrack_nested.argtypes = [ctypes.c_uint32, ctypes.c_uint32, ctypes.POINTER(NestedNonce),
+                                       ctypes.c_uint32, _KEYS_OUT]
+        lib.mfcrack_nested.restype = ctypes.c_int32
+        lib.mfcrack_staticnested.argtypes = [ctypes.c_uint32, ctypes.c_uint8, ctypes.POINTER(StaticNonce),
+                                             ctypes.c_uint32, _KEYS_OUT]
+        lib.mfcrack_staticnested.restype = ctypes.c_int32
+        lib.mfcrack_darkside.argtypes = [ctypes.c_uint32, ctypes.POINTER(DarksideParam), ctypes.c_uint32, _KEYS_OUT,
+                                         ctypes.POINTER(ctypes.c_uint32)]
+        lib.mfcrack_darkside.restype = ctypes.c_int32
+        lib.mfcrack_mfkey32v2.argtypes = [ctypes.c_uint32] * 7 + [ctypes.POINTER(ctypes.c_uint64)]
+        lib.mfcrack_mfkey32v2.restype = ctypes.c_bool
+        lib.mfcrack_mfkey32_log.argtypes = [ctypes.POINTER(AuthRecord), ctypes.c_uint32,
+                                            ctypes.POINTER(ctypes.POINTER(LogKey))]
+        lib.mfcrack_mfkey32_log.restype = ctypes.c_int32
+        lib.mfcrack_test_keys.argtypes = [ctypes.POINTER(AuthRecord), ctypes.c_uint32,
+                                          ctypes.POINTER(ctypes.c_uint64), ctypes.c_uint32,
+                                          ctypes.POINTER(ctypes.c_uint8)]
+        lib.mfcrack_test_keys.restype = ctypes.c_int32
+        lib.mfcrack_rf08s_filter.argtypes = [ctypes.c_uint32, ctypes.POINTER(ctypes.c_uint64), ctypes.c_uint32,
+                                             ctypes.POINTER(ctypes.c_uint8)] * 2
+        lib.mfcrack_rf08s_filter.restype = ctypes.c_int32
+        lib.mfcrack_rf08s_1key.argtypes = [ctypes.c_uint32, ctypes.c_uint64, ctypes.c_uint32,
+                                           ctypes.POINTER(ctypes.c_uint64), ctypes.c_uint32, _KEYS_OUT]
+        lib.mfcrack_rf08s_1key.restype = ctypes.c_int32
+        lib.mfcrack_mfulc_segments.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p]
+        lib.mfcrack_mfulc_segments.restype = ctypes.c_int32
+        _lib = lib
+        break
+    return _lib
+
+
+def daemon_socket_path() -> Optional[str]:
+    """Where mfcrackd listens by default, None on platforms without it"""
+    if sys.platform == "win32":
+        return None
+    if os.environ.get("MFCRACKD_SOCKET"):
+        return os.environ["MFCRACKD_SOCKET"]
+    if os.environ.get("XDG_RUNTIME_DIR"):
+        return os.path.join(os.environ["XDG_RUNTIME_DIR"], "mfcrackd.sock")
+    return f"/tmp/mfcrackd-{os.getuid()}/mfcrackd.sock"
+
+
+def _trusted_socket(path: str) -> bool:
+    """
+    The socket belongs to this user and sits in a directory nobody else can replace it in,
+    so the nonces and keys of the jobs go to our own daemon
+    """
+    try:
+        st = os.lstat(path)
+        parent = os.stat(os.path.dirname(os.path.abspath(path)))
+    except OSError:
+        return False
+    if not stat.S_ISSOCK(st.st_mode) or st.st_uid != os.getuid():
+        return False
+    # writable by others only if sticky, as /tmp, where they can't remove our files
+    return parent.st_uid in (0, os.getuid()) and (not parent.st_mode & 0o022 or bool(parent.st_mode & stat.S_ISVTX))
+
+
+class Daemon:
+    """Connection to a running mfcrackd, requests are answered in order"""
+
+    def __init__(self, path: str):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            self.sock.connect(path)
+            if hasattr(socket, 'SO_PEERCRED'):
+                _, uid, _ = struct.unpack('3i', self.sock.getsockopt(socket.SOL_SOCKET, socket.SO_PEERCRED,
+                                                                     struct.calcsize('3i')))
+                if uid != os.getuid():
+                    raise ConnectionError(f"mfcrackd on {path} runs as another user")
+        except (OSError, ConnectionError):
+            self.sock.close()
+            raise
+        self.job_id = 0
+
+    def close(self):
+        self.sock.close()
+
+    def _recv(self, length: int) -> bytes:
+        data = bytearray()
+        while len(data) < length:
+            chunk = self.sock.recv(length - len(data))
+            if not chunk:
+                raise ConnectionError("mfcrackd closed the connection")
+            data += chunk
+        return bytes(data)
+
+    def request(self, op: int, payload: bytes = b'', threads: int = 0) -> tuple[int, bytes]:
+        """Runs one job, returns its status (result count, negative on error) and response payload"""
+        self.job_id = (self.job_id + 1) & 0xFFFFFFFF
+        self.sock.sendall(_MFCRACKD_HEADER.pack(b'MFCQ', MFCRACKD_VERSION, op, self.job_id, threads, 0,
+                                                len(payload)) + payload)
+        magic, version, _, job_id, status, length = _MFCRACKD_RESPONSE.unpack(self._recv(_MFCRACKD_RESPONSE.size))
+        if magic != b'MFCR' or version != MFCRACKD_VERSION or job_id != self.job_id:
+            raise ConnectionError("unexpected mfcrackd response")
+        return status, self._recv(length)
+
+    def ping(self) -> dict:
+        status, payload = self.request(MFCRACKD_OP_PING)
+        api_version, threads, queued, done = struct.unpack('<4I', payload)
+        return {'api_version': api_version, 'threads': threads, 'queued': queued, 'done': done}
+
+
+def daemon() -> Optional[Daemon]:
+    """The connection to mfcrackd, None when it is not running or speaks another API version"""
+    global _daemon
+    if _daemon is None:
+        path = daemon_socket_path()
+        if path is None or not _trusted_socket(path):
+            return None
+        try:
+            _daemon = Daemon(path)
+            if _daemon.ping()['api_version'] != MFCRACK_API_VERSION:
+                raise ConnectionError("mfcrackd API version mismatch")
+        except (OSError, ConnectionError, struct.error):
+            if _daemon is not None:
+                _daemon.close()
+            _daemon = None
+    return _daemon
+
+
+def _daemon_request(op: int, payload: bytes) -> Optional[tuple[int, bytes]]:
+    """Sends a job to mfcrackd if it is running, None to fall back on the library"""
+    global _daemon
+    d = daemon()
+    if d is None:
+        return None
+    try:
+        status, data = d.request(op, payload, _max_threads)
+    except (OSError, ConnectionError, struct.error):
+        d.close()
+        _daemon = None
+        if load() is None:
+            raise
+        return None
+    if status < 0:
+        raise ValueError(f"mfcrackd: job failed ({status})")
+    return status, data
+
+
+def available() -> bool:
+    return daemon() is not None or load() is not None
+
+
+def set_max_threads(threads: int):
+    """Thread budget of the next recoveries, 0 for all cores"""
+    global _max_threads
+    _max_threads = threads
+    lib = load()
+    if lib is not None:
+        lib.mfcrack_set_max_threads(threads)
+
+
+def _unpack_keys(count: int, data: bytes) -> list[int]:
+    return list(struct.unpack_from(f'<{count}Q', data))
+
+
+def _collect_keys(lib, count, keys_ptr) -> list[int]:
+    try:
+        if count < 0:
+            raise ValueError("mfcrack: invalid input or out of memory")
+        return keys_ptr[:count] if count else []
+    finally:
+        lib.mfcrack_free(keys_ptr)
+
+
+def nested(uid: int, dist: int, nonces: list[tuple[int, int, int]]) -> list[int]:
+    """Candidate keys from (nt, nt_enc, par) nested nonces, most likely first"""
+    payload = struct.pack('<3I', uid, dist, len(nonces)) + b''.join(
+        struct.pack('<2IB', nt, nt_enc, par) for nt, nt_enc, par in nonces)
+    response = _daemon_request(MFCRACKD_OP_NESTED, payload)
+    if response is not None:
+        return _unpack_keys(*response)
+    lib = load()
+    arr = (NestedNonce * len(nonces))(*[NestedNonce(nt, nt_enc, par) for nt, nt_enc, par in nonces])
+    keys_ptr = ctypes.POINTER(ctypes.c_uint64)()
+    count = lib.mfcrack_nested(uid, dist, arr, len(nonces), ctypes.byref(keys_ptr))
+    return _collect_keys(lib, count, keys_ptr)
+
+
+def staticnested(uid: int, key_type: int, nonces: list[tuple[int, int]]) -> list[int]:
+    """Candidate keys from (nt, nt_enc) static nested nonces, most likely first"""
+    payload = struct.pack('<3I', uid, key_type, len(nonces)) + b''.join(
+        struct.pack('<2I', nt, nt_enc) for nt, nt_enc in nonces)
+    response = _daemon_request(MFCRACKD_OP_STATICNESTED, payload)
+    if response is not None:
+        return _unpack_keys(*response)
+    lib = load()
+    arr = (StaticNonce * len(nonces))(*[StaticNonce(nt, nt_enc) for nt, nt_enc in nonces])
+    keys_ptr = ctypes.POINTER(ctypes.c_uint64)()
+    count = lib.mfcrack_staticnested(uid, key_type, arr, len(nonces), ctypes.byref(keys_ptr))
+    return _collect_keys(lib, count, keys_ptr)
+
+
+def darkside(uid: int, items: list[dict]) -> tuple[list[int], list[int]]:
+    """
+    Candidate keys left after the last of the darkside acquisitions (dicts with nt1, ks1, par, nr, ar as
+    sent by the device), and the number of candidates left after each acquisition
+    """
+    payload = struct.pack('<2I', uid, len(items)) + b''.join(
+        struct.pack('<I2Q2I', item['nt1'], item['ks1'], item['par'], item['nr'], item['ar']) for item in items)
+    response = _daemon_request(MFCRACKD_OP_DARKSIDE, payload)
+    if response is not None:
+        count, data = response
+        remaining = list(struct.unpack_from(f'<{len(items)}I', data))
+        return _unpack_keys(count, data[4 * len(items):]), remaining
+    lib = load()
+    arr = (DarksideParam * len(items))(*[
+        DarksideParam(item['nt1'], item['ks1'], item['par'], item['nr'], item['ar']) for item in items
+    ])
+    remaining = (ctypes.c_uint32 * max(len(items), 1))()
+    keys_ptr = ctypes.POINTER(ctypes.c_uint64)()
+    count = lib.mfcrack_darkside(uid, arr, len(items), ctypes.byref(keys_ptr), remaining)
+    return _collect_keys(lib, count, keys_ptr), list(remaining[:len(items)])
+
+
+def mfkey32v2(uid: int, nt0: int, nr0_enc: int, ar0_enc: int, nt1: int, nr1_enc: int, ar1_enc: int) -> Optional[int]:
+    """Key from two reader authentications, None if they do not share one"""
+    response = _daemon_request(MFCRACKD_OP_MFKEY32V2, struct.pack('<7I', uid, nt0, nr0_enc, ar0_enc,
+                                                                  nt1, nr1_enc, ar1_enc))
+    if response is not None:
+        count, data = response
+        return _unpack_keys(count, data)[0] if count else None
+    lib = load()
+    key = ctypes.c_uint64()
+    if lib.mfcrack_mfkey32v2(uid, nt0, nr0_enc, ar0_enc, nt1, nr1_enc, ar1_enc, ctypes.byref(key)):
+        return key.value
+    return None
+
+
+def mfkey32_log(records: list[dict]) -> list[tuple[str, int, str, str]]:
+    """
+    Keys of a whole detection log, as (uid, block, 'A' or 'B', key) with uid and key in hex.
+    records are the decoded log entries: dicts with uid, nt, nr, ar as hex strings, block and type.
+    """
+    payload = struct.pack('<I', len(records)) + b''.join(
+        struct.pack('<4I2B', int(r['uid'], 16), int(r['nt'], 16), int(r['nr'], 16), int(r['ar'], 16),
+                    r['block'], 1 if r['type'] == 'B' else 0) for r in records)
+    response = _daemon_request(MFCRACKD_OP_MFKEY32_LOG, payload)
+    if response is not None:
+        count, data = response
+        return [(f"{uid:08x}", block, 'B' if key_type else 'A', f"{key:012x}")
+                for uid, block, key_type, key in struct.iter_unpack('<I2BQ', data[:14 * count])]
+    lib = load()
+    arr = (AuthRecord * len(records))(*[
+        AuthRecord(int(r['uid'], 16), int(r['nt'], 16), int(r['nr'], 16), int(r['ar'], 16),
+                   r['block'], 1 if r['type'] == 'B' else 0) for r in records
+    ])
+    keys_ptr = ctypes.POINTER(LogKey)()
+    count = lib.mfcrack_mfkey32_log(arr, len(records), ctypes.byref(keys_ptr))
+    try:
+        if count < 0:
+            raise ValueError("mfcrack: invalid input or out of memory")
+        return [(f"{k.uid:08x}", k.block, 'B' if k.key_type else 'A', f"{k.key:012x}")
+                for k in keys_ptr[:count]]
+    finally:
+        lib.mfcrack_free(keys_ptr)
+
+
+def test_keys(auths: list[tuple[int, int, int, int]], keys: list[int]) -> list[bytes]:
+    """
+    Match matrix of keys against (uid, nt, nr_enc, ar_enc) reader authentications:
+    result[k][i] is 1 when keys[k] is the key used by auths[i], 0 otherwise.
+    """
+    payload = struct.pack('<2I', len(auths), len(keys)) + b''.join(
+        struct.pack('<4I', *auth) for auth in auths) + struct.pack(f'<{len(keys)}Q', *keys)
+    response = _daemon_request(MFCRACKD_OP_TEST_KEYS, payload)
+    if response is not None:
+        raw = response[1]
+        return [raw[k * len(auths):(k + 1) * len(auths)] for k in range(len(keys))]
+    lib = load()
+    arr = (AuthRecord * len(auths))(*[AuthRecord(uid, nt, nr, ar, 0, 0) for uid, nt, nr, ar in auths])
+    key_arr = (ctypes.c_uint64 * len(keys))(*keys)
+    matches = (ctypes.c_uint8 * (len(keys) * len(auths)))()
+    if lib.mfcrack_test_keys(arr, len(auths), key_arr, len(keys), matches) < 0:
+        raise ValueError("mfcrack: invalid input or out of memory")
+    raw = bytes(matches)
+    return [raw[k * len(auths):(k + 1) * len(auths)] for k in range(len(keys))]
+
+
+def rf08s_filter(nt1: int, keys1: list[int], nt2: int, keys2: list[int]) -> tuple[list[int], list[int]]:
+    """
+    FM11RF08S backdoor: the static nested candidates of keys1 (for nt1) and keys2 (for nt2) of the two
+    keys of a sector that can go with a candidate of the other list
+    """
+    payload = struct.pack(f'<4I{len(keys1) + len(keys2)}Q', nt1, len(keys1), nt2, len(keys2), *keys1, *keys2)
+    response = _daemon_request(MFCRACKD_OP_RF08S_FILTER, payload)
+    if response is not None:
+        keep = response[1]
+    else:
+        lib = load()
+        arr1 = (ctypes.c_uint64 * max(len(keys1), 1))(*keys1)
+        arr2 = (ctypes.c_uint64 * max(len(keys2), 1))(*keys2)
+        keep1 = (ctypes.c_uint8 * max(len(keys1), 1))()
+        keep2 = (ctypes.c_uint8 * max(len(keys2), 1))()
+        if lib.mfcrack_rf08s_filter(nt1, arr1, len(keys1), keep1, nt2, arr2, len(keys2), keep2) < 0:
+            raise ValueError("mfcrack: invalid input or out of memory")
+        keep = bytes(keep1)[:len(keys1)] + bytes(keep2)[:len(keys2)]
+    return ([key for key, kept in zip(keys1, keep) if kept],
+            [key for key, kept in zip(keys2, keep[len(keys1):]) if kept])
+
+
+def rf08s_1key(nt1: int, key1: int, nt2: int, keys2: list[int]) -> list[int]:
+    """FM11RF08S backdoor: the candidates of keys2 (for nt2) that can go with key1, the key of nt1"""
+    payload = struct.pack(f'<IQ2I{len(keys2)}Q', nt1, key1, nt2, len(keys2), *keys2)
+    response = _daemon_request(MFCRACKD_OP_RF08S_1KEY, payload)
+    if response is not None:
+        return _unpack_keys(*response)
+    lib = load()
+    arr = (ctypes.c_uint64 * max(len(keys2), 1))(*keys2)
+    keys_ptr = ctypes.POINTER(ctypes.c_uint64)()
+    count = lib.mfcrack_rf08s_1key(nt1, key1, nt2, arr, len(keys2), ctypes.byref(keys_ptr))
+    return _collect_keys(lib, count, keys_ptr)
+
+
+def mfulc_segments(null_erndb: bytes, erndb: list[bytes]) -> Optional[bytes]:
+    """
+    MIFARE Ultralight C counterfeit key recovery, as mfulc_des_brute -a: the 16 byte key from ERndB
+    under the null key and the ERndB of segments 1-4, None if the LFSR is unknown or a segment has no match
+    """
+    if len(null_erndb) != 8 or len(erndb) != 4 or any(len(block) != 8 for block in erndb):
+        raise ValueError("mfcrack: ERndB blocks are 8 bytes, one per segment")
+    payload = null_erndb + b''.join(erndb)
+    response = _daemon_request(MFCRACKD_OP_MFULC, payload)
+    if response is not None:
+        count, data = response
+        return data[:16] if count else None
+    lib = load()
+    key = ctypes.create_string_buffer(16)
+    found = lib.mfcrack_mfulc_segments(null_erndb, b''.join(erndb), key)
+    if found < 0:
+        raise ValueError("mfcrack: out of memory")
+    return key.raw if found else None
@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""
+    Commands per second of the client against LoopbackDevice, for sync and pipelined commands.
+
+    python3 tests/bench_com.py [-n COMMANDS] [-l DEVICE_LATENCY_MS]
+"""
+import argparse
+import contextlib
+import io
+import os
+import sys
+import time
+
+CURRENT_DIR = os.path.split(os.path.abspath(__file__))[0]
+sys.path.append(CURRENT_DIR)
+
+from loopback_device import LoopbackDevice  # noqa: E402
+
+
+def bench(com, n, pipelined):
+    requests = [(1000, bytes([i & 0xff, 0x30])) for i in range(n)]
+    start = time.perf_counter()
+    if pipelined:
+        for _ in com.send_cmds_pipelined(requests):
+            pass
+    else:
+        for cmd, data in requests:
+            com.send_cmd_sync(cmd, data)
+    return n / (time.perf_counter() - start)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-n', '--commands', type=int, default=2000)
+    parser.add_argument('-l', '--latency', type=float, default=0, help="device time per command, in ms")
+    args = parser.parse_args()
+
+    device = LoopbackDevice(args.latency / 1000)
+    with contextlib.redirect_stdout(io.StringIO()):
+        com = device.open()
+    try:
+        print(f"sync:      {bench(com, args.commands, False):8.0f} commands/s")
+        com.request_queue_size = 512
+        print(f"pipelined: {bench(com, args.commands, True):8.0f} commands/s")
+    finally:
+        with contextlib.redirect_stdout(io.StringIO()):
+            com.close()
+        device.close()
+
+
+if __name__ == '__main__':
+    main()
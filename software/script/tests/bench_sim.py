@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+    Time of CLI flows end to end against the device simulator: the CLI commands run as typed,
+    over TCP, against a MIFARE Classic with keys to find and a detection log to decrypt.
+
+    Each flow's result is checked against the card: the keys recovered or found, the dump
+    contents. A wrong result is reported as FAILED instead of a time, and the exit status is 1.
+    Flows whose recovery tool is not built (mfcrack library or bin/ tools) are skipped.
+
+    python3 tests/bench_sim.py [-l DEVICE_LATENCY_MS] [-r LINK_BYTES_PER_S] [--seed SEED] [-v]
+"""
+import argparse
+import contextlib
+import io
+import os
+import random
+import re
+import sys
+import tempfile
+import time
+
+CURRENT_DIR = os.path.split(os.path.abspath(__file__))[0]
+sys.path.append(CURRENT_DIR.rsplit(os.sep, 1)[0])
+
+import chameleon_cli_unit  # noqa: E402
+import mfcrack  # noqa: E402
+from chameleon_cli_main import ChameleonCLI  # noqa: E402
+from chameleon_enum import MfcKeyType, MifareClassicPrngType  # noqa: E402
+from chameleon_sim import MifareClassicCard, SimDevice, SimServer, mf1_trailer  # noqa: E402
+
+KEY_A = 'A0A1A2A3A4A5'
+KEY_B = 'B0B1B2B3B4B5'
+DEFAULT_KEY = 'FFFFFFFFFFFF'
+# colours of the CLI output, the checks see the plain text
+ANSI_ESCAPE = re.compile(r'\x1b\[[0-9;?]*[A-Za-z]')
+
+
+def has_tool(name):
+    return any(chameleon_cli_unit.default_cwd.glob(f"{name}*"))
+
+
+# checks of the flow results, given the CLI output without colours they return None or what is wrong
+
+def expect_text(text):
+    def check(output):
+        return None if text.lower() in output.lower() else f"no '{text}' in the output"
+    return check
+
+
+def expect_key_table(card):
+    def check(output):
+        for block in range(card.block_count):
+            if mf1_trailer(block) != block:
+                continue
+            row = f"| {block:03d} | {card.key(block, MfcKeyType.A).hex().upper()} | 1 " \
+                  f"| {card.key(block, MfcKeyType.B).hex().upper()} | 1"
+            if row not in output:
+                return f"keys of block {block} wrong or missing"
+        return None
+    return check
+
+
+def expect_dump(card, path):
+    def check(output):
+        with open(path, 'rb') as f:
+            dump = f.read()
+        if len(dump) != 16 * card.block_count:
+            return f"dump is {len(dump)} bytes, the card {16 * card.block_count}"
+        for block in range(card.block_count):
+            if dump[16 * block:16 * block + 16] != card.read(block):
+                return f"block {block} of the dump differs from the card"
+        return None
+    return check
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-l', '--latency', type=float, default=0, help="device time per command, in ms")
+    parser.add_argument('-r', '--link-rate', type=int, default=0, help="emulated link speed, in bytes/s")
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('-v', '--verbose', action='store_true', help="show the CLI output")
+    args = parser.parse_args()
+
+    card = MifareClassicCard(rng=random.Random(args.seed))
+    card.set_keys(bytes.fromhex(KEY_A), bytes.fromhex(KEY_B))
+    # sector 1 keeps the factory key A, the known key of nested and hardnested
+    card.blocks[16 * 7:16 * 7 + 6] = bytes.fromhex(DEFAULT_KEY)
+    device = SimDevice(card, args.seed)
+    device.slot.mf1_config[0] = 1
+    # mfkey32 needs two authentications of the reader per key
+    for block in [0, 0, 4, 4]:
+        device.add_reader_auth(bytes.fromhex(KEY_A), block)
+    server = SimServer(device, args.latency / 1000, args.link_rate)
+    port = server.listen()
+
+    cli = ChameleonCLI()
+    with tempfile.TemporaryDirectory() as tmp:
+        dic = os.path.join(tmp, 'keys.dic')
+        with open(dic, 'w') as f:
+            f.write('\n'.join([DEFAULT_KEY, '000000000000', KEY_B, KEY_A]) + '\n')
+        dump = os.path.join(tmp, 'dump.bin')
+        # name, CLI line, PRNG of the card, recovery tool built, check of the result
+        flows = [
+            ('hw connect', f'hw connect -p tcp:127.0.0.1:{port}', None, True, expect_text('connected')),
+            ('fchk', f'hf mf fchk {DEFAULT_KEY} 000000000000 {KEY_A} {KEY_B}', None, True,
+             expect_key_table(card)),
+            ('dump', f'hf mf dump -d {dic} -f {dump}', None, True, expect_dump(card, dump)),
+            ('nested', f'hf mf nested --blk 7 -k {DEFAULT_KEY} --tblk 0', MifareClassicPrngType.WEAK,
+             mfcrack.available() or has_tool('nested'), expect_text(f'Key Found: {KEY_A}')),
+            ('elog --decrypt', 'hf mf elog --decrypt', None, mfcrack.available() or has_tool('mfkey32v2'),
+             expect_text(f"Block 0, A key result: {{'{KEY_A.lower()}'}}")),
+            ('hardnested', f'hf mf hardnested --blk 7 -k {DEFAULT_KEY} --tblk 0', MifareClassicPrngType.HARD,
+             has_tool('hardnested'), expect_text(KEY_A)),
+        ]
+        failed = False
+        try:
+            for name, line, prng, available, check in flows:
+                if not available:
+                    print(f"{name:16} skipped, tool not built")
+                    continue
+                if prng is not None:
+                    card.prng = prng
+                out = io.StringIO()
+                start = time.perf_counter()
+                with contextlib.redirect_stdout(out):
+                    cli.exec_cmd(line)
+                elapsed = time.perf_counter() - start
+                error = check(ANSI_ESCAPE.sub('', out.getvalue()))
+                if error is None:
+                    print(f"{name:16} {elapsed * 1000:10.1f} ms")
+                else:
+                    print(f"{name:16} FAILED, {error}")
+                    failed = True
+                if args.verbose or error is not None:
+                    print(out.getvalue())
+        finally:
+            with contextlib.redirect_stdout(io.StringIO()):
+                cli.device_com.close()
+            server.close()
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
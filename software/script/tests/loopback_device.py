@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+import os
+import socket
+import sys
+import threading
+import time
+
+CURRENT_DIR = os.path.split(os.path.abspath(__file__))[0]
+sys.path.append(CURRENT_DIR.rsplit(os.sep, 1)[0])
+
+from chameleon_com import ChameleonCom, DataFrameParser  # noqa: E402
+
+
+class LoopbackDevice:
+    """
+        Minimal device on a local TCP port: answers every request with its data reversed,
+        echoing the tag of tagged requests. Requests with a cmd in silent get no answer.
+    """
+
+    def __init__(self, latency=0.0, silent=()):
+        self.latency = latency
+        self.silent = set(silent)
+        self.server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server.bind(('127.0.0.1', 0))
+        self.server.listen(1)
+        self.port = self.server.getsockname()[1]
+        threading.Thread(target=self.serve, daemon=True).start()
+
+    def serve(self):
+        conn, _ = self.server.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        parser = DataFrameParser()
+        maker = ChameleonCom()
+        with conn:
+            while True:
+                try:
+                    data = conn.recv(65536)
+                except OSError:
+                    break
+                if not data:
+                    break
+                for cmd, _, frame_data in parser.feed(data):
+                    cmd, tag, frame_data = parser.untag(cmd, frame_data)
+                    if cmd in self.silent:
+                        continue
+                    if self.latency:
+                        time.sleep(self.latency)
+                    conn.sendall(maker.make_data_frame_bytes(cmd, frame_data[::-1], 0, tag))
+
+    def open(self) -> ChameleonCom:
+        return ChameleonCom().open(f'tcp:127.0.0.1:{self.port}')
+
+    def close(self):
+        self.server.close()
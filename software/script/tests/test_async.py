@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+import asyncio
+import contextlib
+import io
+import os
+import sys
+import time
+import unittest
+
+CURRENT_DIR = os.path.split(os.path.abspath(__file__))[0]
+sys.path.append(CURRENT_DIR)
+sys.path.append(CURRENT_DIR.rsplit(os.sep, 1)[0])
+
+from chameleon_async import AsyncChameleonCMD, AsyncChameleonCom  # noqa: E402
+from chameleon_cmd import ChameleonCMD  # noqa: E402
+from chameleon_enum import Command, MfcKeyType, SlotNumber, Status, TagSenseType, TagSpecificType  # noqa: E402
+from chameleon_sim import MifareClassicCard, SimDevice, SimServer  # noqa: E402
+from chameleon_utils import UnexpectedResponseError  # noqa: E402
+from loopback_device import LoopbackDevice  # noqa: E402
+
+OPTIONS = {
+    'activate_rf_field': 1,
+    'wait_response': 1,
+    'append_crc': 1,
+    'auto_select': 1,
+    'keep_rf_field': 0,
+    'check_response_crc': 1,
+}
+
+
+def raw_request(page):
+    # the loopback answers with the request data reversed
+    return ChameleonCMD.hf14a_raw_request(OPTIONS, 100, [0x30, page])
+
+
+class TestAsync(unittest.IsolatedAsyncioTestCase):
+
+    async def asyncSetUp(self):
+        self.devices = [LoopbackDevice(latency=0.05, silent={1002}) for _ in range(3)]
+        self.coms = [await AsyncChameleonCom().open(f'tcp:127.0.0.1:{device.port}') for device in self.devices]
+
+    async def asyncTearDown(self):
+        for com in self.coms:
+            await com.close()
+        for device in self.devices:
+            device.close()
+
+    async def test_devices_concurrently(self):
+        async def raw_reads(com):
+            cmd = AsyncChameleonCMD(com)
+            return [await cmd.hf14a_raw(options=OPTIONS, data=[0x30, page]) for page in range(3)]
+
+        start = time.monotonic()
+        results = await asyncio.gather(*(raw_reads(com) for com in self.coms))
+        # 9 commands of 50 ms, 3 at a time
+        self.assertLess(time.monotonic() - start, 0.3)
+        for result in results:
+            self.assertEqual(result, [raw_request(page)[::-1] for page in range(3)])
+
+    async def test_commands_on_one_device_take_turns(self):
+        cmd = AsyncChameleonCMD(self.coms[0])
+        results = await asyncio.gather(*(cmd.hf14a_raw(options=OPTIONS, data=[0x30, page]) for page in range(4)))
+        self.assertEqual(results, [raw_request(page)[::-1] for page in range(4)])
+
+    async def test_status_and_exceptions(self):
+        cmd = AsyncChameleonCMD(self.coms[0])
+        # the loopback answers with status 0, not SUCCESS
+        with self.assertRaises(UnexpectedResponseError):
+            await cmd.get_app_version()
+        # raised by send_cmd and caught inside get_device_capabilities
+        self.coms[0].commands = [Command.GET_APP_VERSION]
+        with contextlib.redirect_stdout(io.StringIO()) as out:
+            with self.assertRaisesRegex(UnexpectedResponseError, str(Status.NOT_IMPLEMENTED)):
+                await cmd.get_device_capabilities()
+        self.assertIn("does not understand", out.getvalue())
+
+    async def test_timeout(self):
+        start = time.monotonic()
+        with self.assertRaises(TimeoutError):
+            await self.coms[0].send_cmd(1002, timeout=0.1)
+        self.assertLess(time.monotonic() - start, 0.3)
+        self.assertEqual((await self.coms[0].send_cmd(1000, b'ab')).data, b'ba')
+
+    async def test_pipelined(self):
+        self.coms[1].request_queue_size = 512
+        cmd = AsyncChameleonCMD(self.coms[1])
+        requests = [(OPTIONS, 100, [0x30, page]) for page in range(10)]
+        results = [resp async for resp in cmd.hf14a_raw_pipelined(requests)]
+        self.assertEqual(results, [raw_request(page)[::-1] for page in range(10)])
+
+
+class TestAsyncSim(unittest.IsolatedAsyncioTestCase):
+
+    async def asyncSetUp(self):
+        self.device = SimDevice(MifareClassicCard(), seed=1)
+        self.server = SimServer(self.device)
+        self.com = await AsyncChameleonCom().open(f'tcp:127.0.0.1:{self.server.listen()}')
+        self.cmd = AsyncChameleonCMD(self.com)
+
+    async def asyncTearDown(self):
+        await self.com.close()
+        self.server.close()
+
+    async def test_reader_session(self):
+        self.assertEqual(await self.cmd.get_app_version(), (2, 0))
+        self.assertIn(Command.HF14A_SCAN, await self.cmd.get_device_capabilities())
+        await self.cmd.set_device_reader_mode(True)
+        self.assertTrue(await self.cmd.is_device_reader_mode())
+        self.assertEqual((await self.cmd.hf14a_scan())[0]['uid'], bytes.fromhex('DEADBEEF'))
+        key = bytes.fromhex('FFFFFFFFFFFF')
+        self.assertFalse(await self.cmd.mf1_auth_one_key_block(4, MfcKeyType.A, bytes(6)))
+        self.assertTrue(await self.cmd.mf1_auth_one_key_block(4, MfcKeyType.A, key))
+        data = bytes(range(16))
+        self.assertTrue(await self.cmd.mf1_write_one_block(5, MfcKeyType.A, key, data))
+        self.assertEqual(await self.cmd.mf1_read_one_block(5, MfcKeyType.A, key), data)
+
+    async def test_emulator_setup(self):
+        await self.cmd.set_active_slot(SlotNumber(2))
+        self.assertEqual(SlotNumber.from_fw(await self.cmd.get_active_slot()), 2)
+        await self.cmd.set_slot_tag_type(SlotNumber(2), TagSpecificType.MIFARE_4096)
+        self.assertEqual((await self.cmd.get_slot_info())[1]['hf'], TagSpecificType.MIFARE_4096)
+        await self.cmd.set_slot_tag_nick(SlotNumber(2), TagSenseType.HF, 'front door')
+        self.assertEqual(await self.cmd.get_slot_tag_nick(SlotNumber(2), TagSenseType.HF), 'front door')
+        data = bytes(range(32))
+        await self.cmd.mf1_write_emu_block_data(1, data)
+        self.assertEqual(await self.cmd.mf1_read_emu_block_data(1, 2), data)
+        await self.cmd.hf14a_set_anti_coll_data(bytes.fromhex('01020304'), b'\x04\x00', b'\x08')
+        self.assertEqual((await self.cmd.hf14a_get_anti_coll_data())['uid'], bytes.fromhex('01020304'))
+        await self.cmd.mf1_set_detection_enable(True)
+        self.assertTrue((await self.cmd.mf1_get_emulator_config())['detection'])
+        self.device.add_reader_auth(bytes(6), 4)
+        self.assertEqual(await self.cmd.mf1_get_detection_count(), 1)
+        self.assertEqual((await self.cmd.mf1_get_detection_log(0))[0]['block'], 4)
+        self.assertEqual((await self.cmd.get_device_settings())['settings_version'], 5)
+        self.assertTrue(await self.cmd.save_settings())
+
+
+if __name__ == '__main__':
+    unittest.main()
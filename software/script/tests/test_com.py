@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+import contextlib
+import io
+import os
+import sys
+import threading
+import time
+import unittest
+
+CURRENT_DIR = os.path.split(os.path.abspath(__file__))[0]
+sys.path.append(CURRENT_DIR)
+sys.path.append(CURRENT_DIR.rsplit(os.sep, 1)[0])
+
+from chameleon_com import NotOpenException  # noqa: E402
+from loopback_device import LoopbackDevice  # noqa: E402
+
+
+class TestCom(unittest.TestCase):
+
+    def setUp(self):
+        self.device = LoopbackDevice(silent={1002})
+        with contextlib.redirect_stdout(io.StringIO()):
+            self.com = self.device.open()
+
+    def tearDown(self):
+        with contextlib.redirect_stdout(io.StringIO()):
+            self.com.close()
+        self.device.close()
+
+    def test_sync(self):
+        for i in range(100):
+            resp = self.com.send_cmd_sync(1000, bytes([i, 1, 2]))
+            self.assertEqual((resp.cmd, resp.status, resp.data), (1000, 0, bytes([2, 1, i])))
+
+    def test_timeout(self):
+        start = time.monotonic()
+        with self.assertRaises(TimeoutError):
+            self.com.send_cmd_sync(1002, b'', timeout=0.2)
+        self.assertLess(time.monotonic() - start, 0.5)
+        # the device still answers the next one
+        self.assertEqual(self.com.send_cmd_sync(1000, b'ab').data, b'ba')
+
+    def test_callback_timeout_once(self):
+        calls = []
+        done = threading.Event()
+        self.com.send_cmd_auto(1002, callback=lambda *args: (calls.append(args), done.set()), timeout=0.1)
+        self.assertTrue(done.wait(1))
+        time.sleep(0.2)
+        self.assertEqual(calls, [(1002, None, None)])
+
+    def test_pipelined(self):
+        self.com.request_queue_size = 512
+        requests = [(1000 + i % 2, bytes([i & 0xff, 1])) for i in range(300)]
+        self.assertEqual([(resp.cmd, resp.data) for resp in self.com.send_cmds_pipelined(requests)],
+                         [(cmd, data[::-1]) for cmd, data in requests])
+
+    def test_close_wakes_waiter(self):
+        threading.Timer(0.1, self.com.close).start()
+        with contextlib.redirect_stdout(io.StringIO()):
+            with self.assertRaises(NotOpenException):
+                self.com.send_cmd_sync(1002, b'', timeout=10)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -3,6 +3,7 @@ import os
 import sys
 import unittest
 from crypto1 import Crypto1
+import mfcrack
 
 CURRENT_DIR = os.path.split(os.path.abspath(__file__))[0]
 config_path = CURRENT_DIR.rsplit(os.sep, 1)[0]
@@ -80,5 +81,36 @@ class TestCrypto1(unittest.TestCase):
             key = 'FFFFFFFFFFFF'
         ))
 
+    @unittest.skipUnless(mfcrack.available(), 'mfcrack library not built')
+    def test_mfcrack_test_keys_matches_python(self):
+        auths = [(0x65535D33, 0x2C198BE4, 0xFEDAC6D2, 0xCF0A3C7E), (0x65535D33, 0x2C198BE4, 0xFEDAC6D2, 0xCF0A3C7F)]
+        keys = ['A9AC67832330', 'FFFFFFFFFFFF']
+        matrix = mfcrack.test_keys(auths, [int(key, 16) for key in keys])
+        for k, key in enumerate(keys):
+            for i, auth in enumerate(auths):
+                self.assertEqual(bool(matrix[k][i]), Crypto1.mfkey32_is_reader_has_key(*auth, key))
+        self.assertEqual(matrix[0][0], 1)
+
+    @unittest.skipUnless(mfcrack.available(), 'mfcrack library not built')
+    def test_mfcrack_rf08s_filter(self):
+        kept1, kept2 = mfcrack.rf08s_filter(0xBB66F7E8, [0x4BE15F2053E7, 0x112233445566],
+                                            0xECDE7DFC, [0x665544332211, 0xFDAC986BB65C])
+        self.assertEqual(kept1, [0x4BE15F2053E7])
+        self.assertEqual(kept2, [0xFDAC986BB65C])
+
+    @unittest.skipUnless(mfcrack.available(), 'mfcrack library not built')
+    def test_mfcrack_rf08s_1key(self):
+        keys = mfcrack.rf08s_1key(0xBB66F7E8, 0x4BE15F2053E7, 0xECDE7DFC, [0x665544332211, 0xFDAC986BB65C])
+        self.assertEqual(keys, [0xFDAC986BB65C])
+
+    @unittest.skipUnless(mfcrack.available(), 'mfcrack library not built')
+    def test_mfcrack_mfulc_segments(self):
+        # counterfeit card with small segment indexes, so the search ends right away
+        erndb = [bytes.fromhex(block) for block in ('9CA28D1E902A3A64', '034393DF3E8B96B8',
+                                                     '376D31D854558C48', 'B6402E9FAD61A43A')]
+        key = mfcrack.mfulc_segments(bytes.fromhex('8F44E6A907FEF9C2'), erndb)
+        self.assertEqual(key, bytes.fromhex('8A8C08008A8C0000B8FA0600420C2A00'))
+        self.assertIsNone(mfcrack.mfulc_segments(bytes(8), erndb))
+
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+import os
+import sys
+import unittest
+
+CURRENT_DIR = os.path.split(os.path.abspath(__file__))[0]
+sys.path.append(CURRENT_DIR.rsplit(os.sep, 1)[0])
+
+from chameleon_com import ChameleonCom, DataFrameParser  # noqa: E402
+
+
+class QuietParser(DataFrameParser):
+    def __init__(self):
+        super().__init__()
+        self.errors = []
+
+    def error(self, message):
+        self.errors.append(message)
+
+
+def frame(cmd, status=0, data=b''):
+    return ChameleonCom().make_data_frame_bytes(cmd, data, status)
+
+
+class TestFrameParser(unittest.TestCase):
+
+    # GET_APP_VERSION and MF1_READ_ONE_BLOCK responses as sent by the device
+    recorded = bytes.fromhex('11ef03e800000002130201fd'
+                             '11ef07d200000010171f000000000000000000000000000000e1')
+
+    def test_recorded_stream(self):
+        parser = QuietParser()
+        self.assertEqual(parser.feed(self.recorded), [
+            (1000, 0, b'\x02\x01'),
+            (2002, 0, bytes.fromhex('1f000000000000000000000000000000')),
+        ])
+        self.assertEqual(parser.errors, [])
+        self.assertEqual(parser.buffer, b'')
+
+    def test_byte_by_byte(self):
+        parser = QuietParser()
+        frames = []
+        for i in range(len(self.recorded)):
+            frames += parser.feed(self.recorded[i:i + 1])
+        self.assertEqual(frames, QuietParser().feed(self.recorded))
+        self.assertEqual(parser.errors, [])
+
+    def test_matches_frame_builder(self):
+        stream = b''.join(frame(cmd, cmd & 0xff, bytes(range(cmd % 200))) for cmd in range(1000, 1400, 7))
+        parser = QuietParser()
+        frames = []
+        for i in range(0, len(stream), 61):
+            frames += parser.feed(stream[i:i + 61])
+        self.assertEqual(frames, [(cmd, cmd & 0xff, bytes(range(cmd % 200))) for cmd in range(1000, 1400, 7)])
+        self.assertEqual(parser.errors, [])
+
+    def test_empty_and_max_data(self):
+        parser = QuietParser()
+        data = bytes(i & 0xff for i in range(4096))
+        self.assertEqual(parser.feed(frame(1, 0) + frame(2, 0, data)), [(1, 0, b''), (2, 0, data)])
+        too_long = bytearray(frame(3, 0, data + b'\x00'))
+        self.assertEqual(parser.feed(too_long + frame(4, 0, b'ok')), [(4, 0, b'ok')])
+        self.assertIn("Data frame data length larger than max.", parser.errors)
+
+    def test_resync_after_garbage(self):
+        parser = QuietParser()
+        frames = parser.feed(b'\x00\x42' + frame(1000, 0, b'a') + b'\x11\x00' + frame(1001, 0, b'b'))
+        self.assertEqual(frames, [(1000, 0, b'a'), (1001, 0, b'b')])
+        self.assertEqual(parser.errors, ["Data frame no sof byte.", "Data frame sof lrc error.", "Data frame no sof byte."])
+
+    def test_corrupted_lrc(self):
+        good = frame(1000, 0, b'\x11\xef\x11')
+        bad_head = bytearray(good)
+        bad_head[8] ^= 1
+        bad_data = bytearray(good)
+        bad_data[-2] ^= 1
+        parser = QuietParser()
+        self.assertEqual(parser.feed(bad_head + bad_data + good), [(1000, 0, b'\x11\xef\x11')])
+        self.assertEqual(parser.errors[0], "Data frame head lrc error.")
+        self.assertIn("Data frame global lrc error.", parser.errors)
+
+    def test_partial_frame_kept(self):
+        parser = QuietParser()
+        data = frame(1000, 0, b'abcdef')
+        self.assertEqual(parser.feed(data[:5]), [])
+        self.assertEqual(parser.feed(data[5:-1]), [])
+        self.assertEqual(parser.feed(data[-1:]), [(1000, 0, b'abcdef')])
+        self.assertEqual(parser.errors, [])
+
+    def test_tagged_frame(self):
+        parser = QuietParser()
+        data = bytes(i & 0xff for i in range(4096))
+        tagged = ChameleonCom().make_data_frame_bytes(2002, data, 0, tag=0xbeef)
+        frames = parser.feed(tagged + frame(2002, 0, b'x'))
+        self.assertEqual(frames, [(2002 | 0x8000, 0, b'\xbe\xef' + data), (2002, 0, b'x')])
+        self.assertEqual(parser.untag(*frames[0][::2]), (2002, 0xbeef, data))
+        self.assertEqual(parser.untag(*frames[1][::2]), (2002, None, b'x'))
+        self.assertEqual(parser.errors, [])
+
+    def test_lrc_calc(self):
+        for data in (b'', b'\x11', bytes(range(256)), b'\xff' * 1000):
+            ret = 0
+            for b in data:
+                ret = (ret + b) & 0xFF
+            self.assertEqual(ChameleonCom.lrc_calc(data), (0x100 - ret) & 0xFF)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+import contextlib
+import io
+import json
+import os
+import struct
+import sys
+import tempfile
+import unittest
+
+CURRENT_DIR = os.path.split(os.path.abspath(__file__))[0]
+sys.path.append(CURRENT_DIR)
+sys.path.append(CURRENT_DIR.rsplit(os.sep, 1)[0])
+
+import hardnested_utils  # noqa: E402
+import mfcrack  # noqa: E402
+from chameleon_cmd import ChameleonCMD  # noqa: E402
+from chameleon_com import ChameleonCom  # noqa: E402
+from chameleon_enum import Command, MfcKeyType, MifareClassicPrngType, Status  # noqa: E402
+from chameleon_sim import MifareClassicCard, NtagCard, SimDevice, SimServer  # noqa: E402
+from chameleon_utils import UnexpectedResponseError  # noqa: E402
+from crypto1 import Crypto1  # noqa: E402
+
+KEY_A = bytes.fromhex('A0A1A2A3A4A5')
+KEY_B = bytes.fromhex('B0B1B2B3B4B5')
+DEFAULT_KEY = bytes.fromhex('FFFFFFFFFFFF')
+
+OPTIONS = {
+    'activate_rf_field': 1,
+    'wait_response': 1,
+    'append_crc': 1,
+    'auto_select': 1,
+    'keep_rf_field': 1,
+    'check_response_crc': 1,
+}
+
+
+class SimTestCase(unittest.TestCase):
+    card = None
+
+    def setUp(self):
+        self.device = SimDevice(self.card, seed=1)
+        self.device.reader_mode = True
+        self.server = SimServer(self.device)
+        port = self.server.listen()
+        with contextlib.redirect_stdout(io.StringIO()):
+            self.com = ChameleonCom().open(f'tcp:127.0.0.1:{port}')
+        self.cmd = ChameleonCMD(self.com)
+
+    def tearDown(self):
+        with contextlib.redirect_stdout(io.StringIO()):
+            self.com.close()
+        self.server.close()
+
+
+class TestSimMifareClassic(SimTestCase):
+
+    def setUp(self):
+        self.card = MifareClassicCard(prng=MifareClassicPrngType.WEAK)
+        self.card.set_keys(KEY_A, KEY_B)
+        # sector 1 keeps key A of the factory and lets key A read key B
+        self.card.blocks[16 * 7:16 * 8] = DEFAULT_KEY + bytes.fromhex('FF078069') + KEY_B
+        super().setUp()
+
+    def test_device(self):
+        self.assertIn(Command.MF1_HARDNESTED_ACQUIRE, self.cmd.get_device_capabilities())
+        self.assertEqual(self.cmd.get_app_version(), (2, 0))
+        self.assertEqual(self.cmd.get_device_settings()['settings_version'], 5)
+        self.assertEqual(self.com.send_cmd_sync(Command.GET_REQUEST_QUEUE_SIZE).data, struct.pack('!H', 1024))
+        self.cmd.set_device_reader_mode(False)
+        # reader commands need reader mode
+        self.assertEqual(self.com.send_cmd_sync(Command.HF14A_SCAN).status, Status.DEVICE_MODE_ERROR)
+
+    def test_scan(self):
+        tag = self.cmd.hf14a_scan()[0]
+        self.assertEqual((tag['uid'], tag['atqa'], tag['sak']), (bytes.fromhex('DEADBEEF'), b'\x04\x00', b'\x08'))
+        self.assertEqual(self.cmd.mf1_detect_prng(), MifareClassicPrngType.WEAK)
+        self.assertEqual(self.cmd.mf1_detect_nt_dist(0, MfcKeyType.A, KEY_A), {'uid': 0xDEADBEEF, 'dist': 320})
+
+    def test_read_write(self):
+        self.assertFalse(self.cmd.mf1_auth_one_key_block(4, MfcKeyType.A, KEY_A))
+        self.assertTrue(self.cmd.mf1_auth_one_key_block(4, MfcKeyType.A, DEFAULT_KEY))
+        data = bytes(range(16))
+        self.assertTrue(self.cmd.mf1_write_one_block(5, MfcKeyType.B, KEY_B, data))
+        self.assertEqual(self.cmd.mf1_read_one_block(5, MfcKeyType.A, DEFAULT_KEY), data)
+        # key A is never read, key B is with these access bits
+        self.assertEqual(self.cmd.mf1_read_one_block(7, MfcKeyType.A, DEFAULT_KEY),
+                         bytes(6) + bytes.fromhex('FF078069') + KEY_B)
+        # block 0 of a card that is not magic
+        with self.assertRaises(UnexpectedResponseError):
+            self.cmd.mf1_write_one_block(0, MfcKeyType.A, KEY_A, data)
+
+    def test_check_keys(self):
+        keys = self.cmd.mf1_check_keys_of_sectors(bytes(10), [DEFAULT_KEY, KEY_A])['sectorKeys']
+        self.assertEqual(len(keys), 32)
+        self.assertEqual((keys[0], keys[1], keys[2], keys[3]), (KEY_A, KEY_B, DEFAULT_KEY, KEY_B))
+        self.assertEqual(self.cmd.mf1_check_keys_on_block(4, MfcKeyType.B, [KEY_A, KEY_B]), KEY_B)
+        self.assertIsNone(self.cmd.mf1_check_keys_on_block(4, MfcKeyType.B, [KEY_A]))
+
+    def test_nested(self):
+        nonces = self.cmd.mf1_nested_acquire(4, MfcKeyType.A, DEFAULT_KEY, 0, MfcKeyType.B)
+        self.assertEqual(len(nonces), 2)
+        if not mfcrack.available():
+            self.skipTest("mfcrack library not built")
+        keys = mfcrack.nested(0xDEADBEEF, 320, [(n['nt'], n['nt_enc'], n['par']) for n in nonces])
+        self.assertIn(int.from_bytes(KEY_B, 'big'), keys)
+
+    def test_detection_log(self):
+        for block in (0, 4):
+            self.device.add_reader_auth(KEY_A, block)
+        self.assertEqual(self.cmd.mf1_get_detection_count(), 2)
+        records = self.cmd.mf1_get_detection_log(0)
+        for record in records:
+            self.assertTrue(Crypto1.mfkey32_is_reader_has_key(int(record['uid'], 16), int(record['nt'], 16),
+                                                              int(record['nr'], 16), int(record['ar'], 16),
+                                                              KEY_A.hex()))
+
+    def test_replay(self):
+        with tempfile.NamedTemporaryFile('w', suffix='.jsonl', delete=False) as f:
+            for response in ('0011', '0022'):
+                f.write(json.dumps({'cmd': Command.MF1_DARKSIDE_ACQUIRE, 'data': '', 'status': 0,
+                                    'response': response}) + '\n')
+        try:
+            self.device.load_replay(f.name)
+        finally:
+            os.unlink(f.name)
+        # recorded answers in order, then the last one again
+        self.assertEqual([self.com.send_cmd_sync(Command.MF1_DARKSIDE_ACQUIRE).data for _ in range(3)],
+                         [b'\x00\x11', b'\x00\x22', b'\x00\x22'])
+
+
+class TestSimStaticNested(SimTestCase):
+    card = MifareClassicCard(prng=MifareClassicPrngType.STATIC)
+
+    def test_static_nested(self):
+        self.card.set_keys(key_b=KEY_B)
+        resp = self.cmd.mf1_static_nested_acquire(0, MfcKeyType.A, DEFAULT_KEY, 4, MfcKeyType.B)
+        self.assertEqual([nonce['nt'] for nonce in resp['nts']], [0x01200145] * 2)
+        if not mfcrack.available():
+            self.skipTest("mfcrack library not built")
+        keys = mfcrack.staticnested(resp['uid'], MfcKeyType.B, [(n['nt'], n['nt_enc']) for n in resp['nts']])
+        self.assertIn(int.from_bytes(KEY_B, 'big'), keys)
+
+
+class TestSimHardNested(SimTestCase):
+    card = MifareClassicCard(prng=MifareClassicPrngType.HARD)
+
+    def test_first_byte_sum(self):
+        self.assertEqual(self.cmd.mf1_detect_prng(), MifareClassicPrngType.HARD)
+        hardnested_utils.reset()
+        for _ in range(40):
+            nonces = self.cmd.mf1_hard_nested_acquire(0, 0, MfcKeyType.A, DEFAULT_KEY, 4, MfcKeyType.A)
+            self.assertEqual(len(nonces), 55 * 9)
+            for nt_enc1, nt_enc2, par in struct.iter_unpack('!IIB', nonces):
+                hardnested_utils.check_nonce_unique_sum(nt_enc1, par >> 4)
+                hardnested_utils.check_nonce_unique_sum(nt_enc2, par & 0x0F)
+            if hardnested_utils.hardnested_first_byte_num == 256:
+                break
+        self.assertEqual(hardnested_utils.hardnested_first_byte_num, 256)
+        # the parity bits are those of the key, so the sum is one a real card can have
+        self.assertIn(hardnested_utils.hardnested_first_byte_sum, hardnested_utils.hardnested_sums)
+
+
+class TestSimNtag(SimTestCase):
+    card = NtagCard()
+
+    def test_pipelined_read(self):
+        self.com.request_queue_size = self.cmd.get_request_queue_size()
+        self.assertEqual(self.cmd.hf14a_raw(options=OPTIONS, data=[0x60]), NtagCard.version)
+        requests = [(OPTIONS, 100, [0x30, page]) for page in range(0, 135, 4)]
+        pages = b''.join(resp[:16] for resp in self.cmd.hf14a_raw_pipelined(requests))
+        self.assertEqual(pages[:135 * 4], bytes(self.card.pages[:133 * 4]) + bytes(8))
+        # PWD_AUTH with the default password answers PACK, a bad one is NAKed
+        self.assertEqual(self.cmd.hf14a_raw(options=OPTIONS, data=[0x1B, 0xFF, 0xFF, 0xFF, 0xFF]), b'\x00\x00')
+        self.assertEqual(self.cmd.hf14a_raw(options=OPTIONS, data=[0x1B, 0, 0, 0, 0]), b'')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -42,6 +42,7 @@
 #include "pm3/commonutil.h"
 #include "pm3/util_posix.h"
 #include "hardnested/tables.h"
+#include "hardnested/hardnested_tables_cache.h"
 #include <lzma.h>
 
 #define NUM_CHECK_BITFLIPS_THREADS      (num_CPUs())
@@ -123,7 +124,9 @@ static void print_progress_header(void) {
     get_SIMD_instruction_set(instr_set);
     snprintf(progress_text, sizeof(progress_text), "Start using "
              _YELLOW_("%d")
-                                                   " threads", num_CPUs());
+             " threads and "
+             _YELLOW_("%s")
+             " SIMD core", num_CPUs(), instr_set);
 
     PrintAndLogEx(INFO, "Hardnested attack starting...");
     PrintAndLogEx(INFO,
@@ -247,38 +250,58 @@ static int compare_count_bitflip_bitarrays(const void *b1, const void *b2) {
 // Initialize decompression of the respective bitflip_bitarray stream
 //----------------------------------------------------------------------------
 
+static bool bitflip_bitarrays_mapped = false;
+
 static void init_bitflip_bitarrays(void) {
 
     //	z_stream compressed_stream;
     lzma_stream strm = LZMA_STREAM_INIT;
 
     for (odd_even_t odd_even = EVEN_STATE; odd_even <= ODD_STATE; odd_even++) {
-        num_effective_bitflips[odd_even] = 0;
         for (uint16_t bitflip = 0x001; bitflip < 0x400; bitflip++) {
             bitflip_bitarrays[odd_even][bitflip] = NULL;
             count_bitflip_bitarrays[odd_even][bitflip] = 1 << 24;
-            bitflip_info p = get_bitflip(odd_even, bitflip);
-            if (p.input_buffer != NULL) {
-                uint32_t count = 0;
-
-                lzma_init_inflate(&strm, p.input_buffer, p.len, (uint8_t*)&count, sizeof(count));
-                if ((float)count / (1 << 24) < IGNORE_BITFLIP_THRESHOLD) {
-                    uint32_t *bitset = (uint32_t *)malloc_bitarray(sizeof(uint32_t) * (1 << 19));
-                    if (bitset == NULL) {
-                        printf("Out of memory error in init_bitflip_statelists(). Aborting...\n");
-                        lzma_end(&strm);
-                        exit(4);
-                    }
+        }
+    }
+
+    uint64_t tables_hash = bitflip_tables_hash(IGNORE_BITFLIP_THRESHOLD);
+    bitflip_bitarrays_mapped = load_bitflip_cache(tables_hash, bitflip_bitarrays, count_bitflip_bitarrays);
 
-                    strm.next_out = (uint8_t *)bitset;
-                    strm.avail_out = sizeof(uint32_t) * (1 << 19);
-                    decompress(&strm);
+    if (!bitflip_bitarrays_mapped) {
+        for (odd_even_t odd_even = EVEN_STATE; odd_even <= ODD_STATE; odd_even++) {
+            for (uint16_t bitflip = 0x001; bitflip < 0x400; bitflip++) {
+                bitflip_info p = get_bitflip(odd_even, bitflip);
+                if (p.input_buffer != NULL) {
+                    uint32_t count = 0;
+
+                    lzma_init_inflate(&strm, p.input_buffer, p.len, (uint8_t*)&count, sizeof(count));
+                    if ((float)count / (1 << 24) < IGNORE_BITFLIP_THRESHOLD) {
+                        uint32_t *bitset = (uint32_t *)malloc_bitarray(sizeof(uint32_t) * (1 << 19));
+                        if (bitset == NULL) {
+                            printf("Out of memory error in init_bitflip_statelists(). Aborting...\n");
+                            lzma_end(&strm);
+                            exit(4);
+                        }
 
-                    effective_bitflip[odd_even][num_effective_bitflips[odd_even]++] = bitflip;
-                    bitflip_bitarrays[odd_even][bitflip] = bitset;
-                    count_bitflip_bitarrays[odd_even][bitflip] = count;
+                        strm.next_out = (uint8_t *)bitset;
+                        strm.avail_out = sizeof(uint32_t) * (1 << 19);
+                        decompress(&strm);
+
+                        bitflip_bitarrays[odd_even][bitflip] = bitset;
+                        count_bitflip_bitarrays[odd_even][bitflip] = count;
+                    }
+                    lzma_end(&strm);
                 }
-                lzma_end(&strm);
+            }
+        }
+        save_bitflip_cache(tables_hash, bitflip_bitarrays, count_bitflip_bitarrays);
+    }
+
+    for (odd_even_t odd_even = EVEN_STATE; odd_even <= ODD_STATE; odd_even++) {
+        num_effective_bitflips[odd_even] = 0;
+        for (uint16_t bitflip = 0x001; bitflip < 0x400; bitflip++) {
+            if (bitflip_bitarrays[odd_even][bitflip] != NULL) {
+                effective_bitflip[odd_even][num_effective_bitflips[odd_even]++] = bitflip;
             }
         }
         effective_bitflip[odd_even][num_effective_bitflips[odd_even]] = 0x400; // EndOfList marker
@@ -306,11 +329,17 @@ static void init_bitflip_bitarrays(void) {
     qsort(all_effective_bitflip, num_1st_byte_effective_bitflips, sizeof(uint16_t), compare_count_bitflip_bitarrays);
     qsort(all_effective_bitflip + num_1st_byte_effective_bitflips, num_all_effective_bitflips - num_1st_byte_effective_bitflips, sizeof(uint16_t), compare_count_bitflip_bitarrays);
     char progress_text[80];
-    sprintf(progress_text, "Using %d precalculated bitflip state tables", num_all_effective_bitflips);
+    sprintf(progress_text, "Using %d precalculated bitflip state tables%s", num_all_effective_bitflips,
+            bitflip_bitarrays_mapped ? " (cached)" : "");
     hardnested_print_progress(0, progress_text, (float)(1LL << 47), 0);
 }
 
 static void free_bitflip_bitarrays(void) {
+    if (bitflip_bitarrays_mapped) {
+        unmap_bitflip_cache();
+        bitflip_bitarrays_mapped = false;
+        return;
+    }
     for (int16_t bitflip = 0x3ff; bitflip > 0x000; bitflip--) {
         free_bitarray(bitflip_bitarrays[ODD_STATE][bitflip]);
     }
@@ -775,6 +804,21 @@ static int compare_sum_a8_guess(const void *b1, const void *b2) {
 
 }
 
+static int compare_sum_a8_guess_density(const void *b1, const void *b2) {
+    // probability per state to brute force. Guesses without any states are free to try.
+    const guess_sum_a8_t *g1 = (const guess_sum_a8_t *) b1;
+    const guess_sum_a8_t *g2 = (const guess_sum_a8_t *) b2;
+    float density1 = g1->prob > 0.0 ? (g1->num_states ? g1->prob / (float) g1->num_states : INFINITY) : 0.0;
+    float density2 = g2->prob > 0.0 ? (g2->num_states ? g2->prob / (float) g2->num_states : INFINITY) : 0.0;
+    return (density1 < density2) - (density1 > density2);
+}
+
+// Brute force the Sum(a8) guesses in order of their probability per state. This minimizes the expected
+// number of states to test before the key is found, a likely but large guess can wait for a small one.
+static void sort_sum_a8_guesses(uint8_t first_byte) {
+    qsort(nonces[first_byte].sum_a8_guess, NUM_SUMS, sizeof(guess_sum_a8_t), compare_sum_a8_guess_density);
+}
+
 static float check_smallest_bitflip_bitarrays(void) {
     uint64_t smallest = 1LL << 48;
     // initialize best_first_bytes, do a rough estimation on remaining states
@@ -844,10 +888,14 @@ static float sort_best_first_bytes(void) {
     for (uint16_t i = 0; i < NUM_REFINES; i++) {
         // PrintAndLogEx(INFO, "%d...", i);
         uint16_t first_byte = best_first_bytes[i];
-        for (uint8_t j = 0; j < NUM_SUMS && nonces[first_byte].sum_a8_guess[j].prob > 0.05; j++) {
-            nonces[first_byte].sum_a8_guess[j].num_states = estimated_num_states(first_byte, sums[first_byte_Sum],
-                sums[nonces[first_byte].sum_a8_guess[j].sum_a8_idx]);
+        // every guess that can be tried, the density sort must not weigh refined against coarse estimates
+        for (uint8_t j = 0; j < NUM_SUMS; j++) {
+            if (nonces[first_byte].sum_a8_guess[j].prob > 0.0) {
+                nonces[first_byte].sum_a8_guess[j].num_states = estimated_num_states(first_byte, sums[first_byte_Sum],
+                    sums[nonces[first_byte].sum_a8_guess[j].sum_a8_idx]);
+            }
         }
+        sort_sum_a8_guesses(first_byte);
         // while (nonces[first_byte].sum_a8_guess[0].num_states == 0
         // || nonces[first_byte].sum_a8_guess[1].num_states == 0
         // || nonces[first_byte].sum_a8_guess[2].num_states == 0) {
@@ -1168,109 +1216,226 @@ static void apply_sum_a0(void) {
     }
 }
 
-static int simulate_acquire_nonces(uint32_t uid, char* path) {
-    time_t time1 = time(NULL);
-    last_sample_clock = 0;
-    sample_period = 1000; // for emulation
-    hardnested_stage = CHECK_1ST_BYTES;
-    bool acquisition_completed = false;
-    uint32_t total_num_nonces = 0;
+typedef struct {
+    uint32_t next_nonce;
     float brute_force_depth;
-    bool reported_suma8 = false;
-    bool got_invalid = false;
+    bool reported_suma8;
+    bool got_invalid;
+} acquire_state_t;
+
+static void init_acquire_state(acquire_state_t *st, uint32_t uid) {
+    last_sample_clock = msclock();
+    hardnested_stage = CHECK_1ST_BYTES;
+    st->next_nonce = 0;
+    st->brute_force_depth = (float)(1LL << 47);
+    st->reported_suma8 = false;
+    st->got_invalid = false;
 
     cuid = uid;
 
     num_acquired_nonces = 0;
+}
 
-    FILE *fp;
-    char line[100];
-    fp = fopen(path, "r");
-    if (fp == NULL) {
-        perror("Error opening file");
-        exit(EXIT_FAILURE);
+// Starts the nonce memory over with nonce_list[0 .. count), leaving out nonce_list[skip].
+static void reload_nonces(const hardnested_nonce_t *nonce_list, uint32_t count, uint32_t skip) {
+    free_nonces_memory();
+    init_nonce_memory();
+    num_acquired_nonces = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (i != skip) {
+            num_acquired_nonces += add_nonce(nonce_list[i].nonce_enc, nonce_list[i].par_enc);
+        }
     }
+}
 
-    do {
-        uint32_t nt_enc = 0;
-        uint8_t par_enc = 0;
-
-        if (fgets(line, sizeof(line), fp) != NULL) {
-            sscanf(line, "%u|%hhu", &nt_enc, &par_enc);
-            num_acquired_nonces += add_nonce(nt_enc, par_enc);
-            total_num_nonces++;
+// The nonces of the last step, nonce_list[first .. next_nonce), left no state for some first byte.
+// Adds them back one at a time onto the nonces before them, with complete bit flip checks, to find the
+// one that does, and drops it. Returns false if none of them does on its own.
+static bool drop_invalid_nonce(acquire_state_t *st, const hardnested_nonce_t *nonce_list, uint32_t first) {
+    reload_nonces(nonce_list, first, first);
+    for (uint32_t i = first; i < st->next_nonce; i++) {
+        num_acquired_nonces += add_nonce(nonce_list[i].nonce_enc, nonce_list[i].par_enc);
+        update_nonce_data(false);
+        shrink_key_space(&st->brute_force_depth);
+        if (st->brute_force_depth == 0) {
+            reload_nonces(nonce_list, st->next_nonce, i);
+            return true;
         }
+    }
+    return false;
+}
+
+// Adds nonce_list[next_nonce .. available) and reduces the key space once.
+// Returns 1 when enough nonces are collected, 0 when more are needed, -1 on failure.
+static int acquire_nonces_step(acquire_state_t *st, const hardnested_nonce_t *nonce_list, uint32_t available) {
+    uint32_t first = st->next_nonce;
+    while (st->next_nonce < available) {
+        num_acquired_nonces += add_nonce(nonce_list[st->next_nonce].nonce_enc, nonce_list[st->next_nonce].par_enc);
+        st->next_nonce++;
 
         if (num_acquired_nonces % 256 == 0) {
-            hardnested_print_progress(num_acquired_nonces, "Loading nonces from file", brute_force_depth, 0);
+            hardnested_print_progress(num_acquired_nonces, "Loading nonces", st->brute_force_depth, 0);
         }
+    }
 
-        last_sample_clock = msclock();
-
-        if (first_byte_num == 256) {
-            if (hardnested_stage == CHECK_1ST_BYTES) {
+    bool acquisition_completed = false;
+    if (first_byte_num == 256) {
+        if (hardnested_stage == CHECK_1ST_BYTES) {
 
-                bool got_match = false;
-                for (uint8_t i = 0; i < NUM_SUMS; i++) {
-                    if (first_byte_Sum == sums[i]) {
-                        first_byte_Sum = i;
-                        got_match = true;
-                        break;
-                    }
+            bool got_match = false;
+            for (uint8_t i = 0; i < NUM_SUMS; i++) {
+                if (first_byte_Sum == sums[i]) {
+                    first_byte_Sum = i;
+                    got_match = true;
+                    break;
                 }
+            }
 
-                if (got_match == false) {
-                    PrintAndLogEx(FAILED, "No match for the First_Byte_Sum (%u), is the card a genuine MFC Ev1? ",
-                                  first_byte_Sum);
-                    return -1;
-                }
+            if (got_match == false) {
+                PrintAndLogEx(FAILED, "No match for the First_Byte_Sum (%u), is the card a genuine MFC Ev1? ",
+                              first_byte_Sum);
+                return -1;
+            }
 
-                hardnested_stage |= CHECK_2ND_BYTES;
-                apply_sum_a0();
+            hardnested_stage |= CHECK_2ND_BYTES;
+            apply_sum_a0();
+        }
+        update_nonce_data(true);
+        acquisition_completed = shrink_key_space(&st->brute_force_depth);
+        if (!st->reported_suma8) {
+            char progress_string[80];
+            snprintf(progress_string, sizeof(progress_string), "Apply Sum property. Sum(a0) = %d",
+                     sums[first_byte_Sum]);
+            hardnested_print_progress(num_acquired_nonces, progress_string, st->brute_force_depth, 0);
+            st->reported_suma8 = true;
+        } else {
+            hardnested_print_progress(num_acquired_nonces, "Apply bit flip properties", st->brute_force_depth, 0);
+        }
+    } else {
+        update_nonce_data(true);
+        acquisition_completed = shrink_key_space(&st->brute_force_depth);
+        if (st->brute_force_depth == 0) {
+            // something went wrong, wipe nonce memory and skip the invalid nonce
+            if (st->got_invalid) {
+                hardnested_print_progress(num_acquired_nonces, "Too many invalid nonces", st->brute_force_depth, 0);
+                return -1;
             }
-            update_nonce_data(true);
-            acquisition_completed = shrink_key_space(&brute_force_depth);
-            if (!reported_suma8) {
-                char progress_string[80];
-                snprintf(progress_string, sizeof(progress_string), "Apply Sum property. Sum(a0) = %d",
-                         sums[first_byte_Sum]);
-                hardnested_print_progress(num_acquired_nonces, progress_string, brute_force_depth, 0);
-                reported_suma8 = true;
-            } else {
-                hardnested_print_progress(num_acquired_nonces, "Apply bit flip properties", brute_force_depth, 0);
+            hardnested_print_progress(num_acquired_nonces, "Found invalid nonce! Trying without it...", st->brute_force_depth, 0);
+            st->got_invalid = true;
+            if (!drop_invalid_nonce(st, nonce_list, first)) {
+                hardnested_print_progress(num_acquired_nonces, "Invalid nonce not found in the last batch", st->brute_force_depth, 0);
+                return -1;
             }
-        } else {
-            update_nonce_data(true);
-            acquisition_completed = shrink_key_space(&brute_force_depth);
-            if (brute_force_depth == 0) {
-                // something went wrong, wipe nonce memory and skip this nonce
-                if (got_invalid) {
-                    hardnested_print_progress(num_acquired_nonces, "Too many invalid nonces", brute_force_depth, 0);
-                    return -1;
-                }
-                hardnested_print_progress(num_acquired_nonces, "Found invalid nonce! Trying without it...", brute_force_depth, 0);
-                got_invalid = true;
-                fclose(fp);
-                fp = fopen(path, "r");
-                init_nonce_memory();
-                uint32_t to = total_num_nonces - 1;
-                num_acquired_nonces = 0;
-                total_num_nonces = 0;
-                for (uint32_t i = 0; i < to; i++) {
-                    if (fgets(line, sizeof(line), fp) != NULL) {
-                        sscanf(line, "%u|%hhu", &nt_enc, &par_enc);
-                        num_acquired_nonces += add_nonce(nt_enc, par_enc);
-                        total_num_nonces++;
-                    }
-                }
-                fgets(line, sizeof(line), fp); // skip line
+        }
+    }
+
+    return acquisition_completed ? 1 : 0;
+}
+
+// The nonce list is exhausted. Keep reducing the key space with what was added, as long as that still
+// gets somewhere: check_for_BitFlipProperties() works on a time budget and leaves bit flips for later rounds.
+// Fails once the estimate stayed put for longer than update_reduction_rate() looks back, as by then
+// shrink_key_space() would have reported completion if it ever could.
+static int reduce_without_new_nonces(acquire_state_t *st, const hardnested_nonce_t *nonce_list, uint32_t num_nonces) {
+    sample_period = 1000;
+    float last_depth = st->brute_force_depth;
+    uint32_t idle_rounds = 0;
+    int res = 0;
+    while (res == 0) {
+        last_sample_clock = msclock();
+        res = acquire_nonces_step(st, nonce_list, num_nonces);
+        if (st->brute_force_depth < last_depth) {
+            last_depth = st->brute_force_depth;
+            idle_rounds = 0;
+        } else if (res == 0 && ++idle_rounds > QUEUE_LEN) {
+            hardnested_print_progress(num_acquired_nonces, "Not enough nonces to reduce the key space", st->brute_force_depth, 0);
+            return -1;
+        }
+    }
+    return res;
+}
+
+static int simulate_acquire_nonces(uint32_t uid, const hardnested_nonce_t *nonce_list, uint32_t num_nonces) {
+    acquire_state_t st;
+    init_acquire_state(&st, uid);
+    sample_period = 1000; // for emulation
+
+    int res = 0;
+    while (res == 0 && st.next_nonce < num_nonces) {
+        // one nonce per sample
+        last_sample_clock = msclock();
+        res = acquire_nonces_step(&st, nonce_list, st.next_nonce + 1);
+    }
+    if (res == 0) {
+        res = reduce_without_new_nonces(&st, nonce_list, num_nonces);
+    }
+
+    return (res == 1) ? 0 : -1;
+}
+
+static int stream_acquire_nonces(uint32_t uid, FILE *in) {
+    acquire_state_t st;
+    init_acquire_state(&st, uid);
+
+    uint32_t num_nonces = 0;
+    uint32_t capacity = 0;
+    hardnested_nonce_t *nonce_list = NULL;
+
+    int res = 0;
+    while (res == 0) {
+        uint8_t count_be[2];
+        if (fread(count_be, 1, sizeof(count_be), in) != sizeof(count_be)) {
+            break;
+        }
+        uint16_t num_chunks = (count_be[0] << 8) | count_be[1];
+        if (num_chunks == 0) {
+            break;
+        }
+
+        if (num_nonces + 2 * num_chunks > capacity) {
+            capacity = MAX(2 * capacity, num_nonces + 2 * num_chunks);
+            hardnested_nonce_t *grown = realloc(nonce_list, capacity * sizeof(hardnested_nonce_t));
+            if (grown == NULL) {
+                PrintAndLogEx(ERR, "Out of memory error in stream_acquire_nonces(). Aborting...\n");
+                free(nonce_list);
+                exit(4);
+            }
+            nonce_list = grown;
+        }
+
+        uint16_t i;
+        for (i = 0; i < num_chunks; i++) {
+            uint8_t chunk[9];
+            if (fread(chunk, 1, sizeof(chunk), in) != sizeof(chunk)) {
+                break;
             }
+            nonce_list[num_nonces].nonce_enc = bytes_to_num(chunk, 4);
+            nonce_list[num_nonces++].par_enc = chunk[8] >> 4;
+            nonce_list[num_nonces].nonce_enc = bytes_to_num(chunk + 4, 4);
+            nonce_list[num_nonces++].par_enc = chunk[8] & 0x0f;
         }
-    } while (!acquisition_completed);
 
-    time_t end_time = time(NULL);
+        // a batch is one sample, its period is the time the reader spent acquiring it
+        uint64_t now = msclock();
+        sample_period = MAX(now - last_sample_clock, 1);
+        last_sample_clock = now;
+
+        res = acquire_nonces_step(&st, nonce_list, num_nonces);
+        printf("Stream: nonces=%u states=%1.0f done=%d\n", num_acquired_nonces, st.brute_force_depth, (res == 1) ? 1 : 0);
+        fflush(stdout);
 
-    return 0;
+        if (i != num_chunks) {
+            break; // truncated batch, input is gone
+        }
+    }
+
+    // input ended before the key space shrank far enough: squeeze out what we have
+    if (res == 0) {
+        res = reduce_without_new_nonces(&st, nonce_list, num_nonces);
+    }
+
+    free(nonce_list);
+    return (res == 1) ? 0 : -1;
 }
 
 static inline bool invariant_holds(uint_fast8_t byte_diff, uint_fast32_t state1, uint_fast32_t state2, uint_fast8_t bit,
@@ -1861,13 +2026,12 @@ static void init_it_all(void) {
     memset(sum_a0_bitarrays, 0, sizeof(sum_a0_bitarrays));
 }
 
-int
-mfnestedhard(uint8_t blockNo, uint8_t keyType, uint8_t *key, uint8_t trgBlockNo, uint8_t trgKeyType, uint8_t *trgkey,
-             bool nonce_file_read, bool nonce_file_write, bool slow, uint64_t *foundkey, char *filename, uint32_t uid, char *path) {
+static void hardnested_prepare(uint8_t *trgkey) {
     char progress_text[80];
     char instr_set[12] = {0};
 
     get_SIMD_instruction_set(instr_set);
+    init_bitarray_core();
 
     // initialize static arrays
     memset(part_sum_count, 0, sizeof(part_sum_count));
@@ -1897,11 +2061,10 @@ mfnestedhard(uint8_t blockNo, uint8_t keyType, uint8_t *key, uint8_t trgBlockNo,
     init_allbitflips_array();
     init_nonce_memory();
     update_reduction_rate(0.0, true);
+}
 
-    int res = simulate_acquire_nonces(uid, path);
-    if (res != 0) {
-        return -1;
-    }
+static int hardnested_crack(uint64_t *foundkey) {
+    char progress_text[80];
 
     set_test_state(best_first_bytes[0]);
 
@@ -1936,6 +2099,8 @@ mfnestedhard(uint8_t blockNo, uint8_t keyType, uint8_t *key, uint8_t trgBlockNo,
     } else {
         pre_XOR_nonces();
         prepare_bf_test_nonces(nonces, best_first_bytes[0]);
+        sort_sum_a8_guesses(best_first_bytes[0]);
+        update_expected_brute_force(best_first_bytes[0]);
         for (uint8_t j = 0; j < NUM_SUMS && !key_found; j++) {
             float expected_brute_force = nonces[best_first_bytes[0]].expected_num_brute_force;
             snprintf(progress_text, sizeof(progress_text), "(%d. guess: Sum(a8) = %" PRIu16 ")", j + 1,
@@ -1971,9 +2136,32 @@ mfnestedhard(uint8_t blockNo, uint8_t keyType, uint8_t *key, uint8_t trgBlockNo,
     return key_found;
 }
 
-char *run_hardnested(uint32_t uid, char* path) {
+int
+mfnestedhard(uint8_t blockNo, uint8_t keyType, uint8_t *key, uint8_t trgBlockNo, uint8_t trgKeyType, uint8_t *trgkey,
+             bool nonce_file_read, bool nonce_file_write, bool slow, uint64_t *foundkey, char *filename, uint32_t uid,
+             const hardnested_nonce_t *nonce_list, uint32_t num_nonces) {
+    hardnested_prepare(trgkey);
+
+    if (simulate_acquire_nonces(uid, nonce_list, num_nonces) != 0) {
+        return -1;
+    }
+
+    return hardnested_crack(foundkey);
+}
+
+int mfnestedhard_stream(uint32_t uid, FILE *in, uint64_t *foundkey) {
+    hardnested_prepare(NULL);
+
+    if (stream_acquire_nonces(uid, in) != 0) {
+        return -1;
+    }
+
+    return hardnested_crack(foundkey);
+}
+
+char *run_hardnested(uint32_t uid, const hardnested_nonce_t *nonce_list, uint32_t num_nonces) {
     uint64_t foundkey = 0;
-    if (mfnestedhard(0, 0, NULL, 0, 0, NULL, false, false, false, &foundkey, NULL, uid, path) == 1) {
+    if (mfnestedhard(0, 0, NULL, 0, 0, NULL, false, false, false, &foundkey, NULL, uid, nonce_list, num_nonces) == 1) {
         char *keystr = malloc(14);
         snprintf(keystr, 14, "%012" PRIx64 ";", foundkey);
         return keystr;
@@ -19,11 +19,25 @@
 #ifndef CMDHFMFHARD_H__
 #define CMDHFMFHARD_H__
 
+#include <stdio.h>
 #include "pm3/common.h"
 
+// one encrypted nonce as sent by the card, with its 4 encrypted parity bits
+typedef struct {
+    uint32_t nonce_enc;
+    uint8_t par_enc;
+} hardnested_nonce_t;
+
 int
 mfnestedhard(uint8_t blockNo, uint8_t keyType, uint8_t *key, uint8_t trgBlockNo, uint8_t trgKeyType, uint8_t *trgkey,
-             bool nonce_file_read, bool nonce_file_write, bool slow, uint64_t *foundkey, char *filename, uint32_t uid, char *path);
+             bool nonce_file_read, bool nonce_file_write, bool slow, uint64_t *foundkey, char *filename, uint32_t uid,
+             const hardnested_nonce_t *nonce_list, uint32_t num_nonces);
+// Like mfnestedhard() with the nonces arriving on a stream while the reader is still acquiring them.
+// After the 6 byte nonce file header (already consumed by the caller) each batch is a big endian
+// uint16 number of 9 byte chunks followed by the chunks; a zero count or EOF ends the input.
+// Every batch is answered with a "Stream: nonces=<n> states=<n> done=<0|1>" line on stdout,
+// done=1 means enough nonces are in and the reader can stop.
+int mfnestedhard_stream(uint32_t uid, FILE *in, uint64_t *foundkey);
 void hardnested_print_progress(uint32_t nonces, const char *activity, float brute_force, uint64_t min_diff_print_time);
 
 #endif
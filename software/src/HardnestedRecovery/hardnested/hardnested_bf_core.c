@@ -66,20 +66,19 @@ THE SOFTWARE.
 // while AVX supports 256 bit vector floating point operations, we need integer operations for boolean logic
 // same for AVX2 and 512 bit vectors
 // using larger vectors works but seems to generate more register pressure
-//#if defined(__AVX512F__)
-//#define MAX_BITSLICES 512
-//#elif defined(__AVX2__)
-//#define MAX_BITSLICES 256
-//#elif defined(__AVX__)
-//#define MAX_BITSLICES 128
-//#elif defined(__SSE2__)
-//#define MAX_BITSLICES 128
-//#elif defined(__ARM_NEON) && !defined(NOSIMD_BUILD)
-//#define MAX_BITSLICES 128
-//#else // MMX or SSE or NOSIMD
-//#define MAX_BITSLICES 64
-//#endif
+#if defined(__AVX512F__)
+#define MAX_BITSLICES 512
+#elif defined(__AVX2__)
+#define MAX_BITSLICES 256
+#elif defined(__AVX__)
+#define MAX_BITSLICES 128
+#elif defined(__SSE2__)
+#define MAX_BITSLICES 128
+#elif defined(__ARM_NEON) && !defined(NOSIMD_BUILD)
+#define MAX_BITSLICES 128
+#else // MMX or SSE or NOSIMD
 #define MAX_BITSLICES 64
+#endif
 
 #define VECTOR_SIZE (MAX_BITSLICES/8)
 
@@ -118,31 +117,29 @@ typedef union {
 
 // this needs to be compiled several times for each instruction set.
 // For each instruction set, define a dedicated function name:
-//#if defined (__AVX512F__)
-//#define BITSLICE_TEST_NONCES bitslice_test_nonces_AVX512
-//#define CRACK_STATES_BITSLICED crack_states_bitsliced_AVX512
-//#elif defined (__AVX2__)
-//#define BITSLICE_TEST_NONCES bitslice_test_nonces_AVX2
-//#define CRACK_STATES_BITSLICED crack_states_bitsliced_AVX2
-//#elif defined (__AVX__)
-//#define BITSLICE_TEST_NONCES bitslice_test_nonces_AVX
-//#define CRACK_STATES_BITSLICED crack_states_bitsliced_AVX
-//#elif defined (__SSE2__)
-//#define BITSLICE_TEST_NONCES bitslice_test_nonces_SSE2
-//#define CRACK_STATES_BITSLICED crack_states_bitsliced_SSE2
-//#elif defined (__MMX__)
-//#define BITSLICE_TEST_NONCES bitslice_test_nonces_MMX
-//#define CRACK_STATES_BITSLICED crack_states_bitsliced_MMX
-//#elif defined (__ARM_NEON) && !defined(NOSIMD_BUILD)
-//#define BITSLICE_TEST_NONCES bitslice_test_nonces_NEON
-//#define CRACK_STATES_BITSLICED crack_states_bitsliced_NEON
-//#else
-//#define BITSLICE_TEST_NONCES bitslice_test_nonces_NOSIMD
-//#define CRACK_STATES_BITSLICED crack_states_bitsliced_NOSIMD
-//#endif
-
-#define CRACK_STATES_BITSLICED crack_states_bitsliced_NOSIMD
+#if defined (__AVX512F__)
+#define BITSLICE_TEST_NONCES bitslice_test_nonces_AVX512
+#define CRACK_STATES_BITSLICED crack_states_bitsliced_AVX512
+#elif defined (__AVX2__)
+#define BITSLICE_TEST_NONCES bitslice_test_nonces_AVX2
+#define CRACK_STATES_BITSLICED crack_states_bitsliced_AVX2
+#elif defined (__AVX__)
+#define BITSLICE_TEST_NONCES bitslice_test_nonces_AVX
+#define CRACK_STATES_BITSLICED crack_states_bitsliced_AVX
+#elif defined (__SSE2__)
+#define BITSLICE_TEST_NONCES bitslice_test_nonces_SSE2
+#define CRACK_STATES_BITSLICED crack_states_bitsliced_SSE2
+#elif defined (__MMX__)
+#define BITSLICE_TEST_NONCES bitslice_test_nonces_MMX
+#define CRACK_STATES_BITSLICED crack_states_bitsliced_MMX
+#elif defined (__ARM_NEON) && !defined(NOSIMD_BUILD)
+#define BITSLICE_TEST_NONCES bitslice_test_nonces_NEON
+#define CRACK_STATES_BITSLICED crack_states_bitsliced_NEON
+#else
 #define BITSLICE_TEST_NONCES bitslice_test_nonces_NOSIMD
+#define CRACK_STATES_BITSLICED crack_states_bitsliced_NOSIMD
+#endif
+
 // typedefs and declaration of functions:
 typedef uint64_t crack_states_bitsliced_t(uint32_t, uint8_t *, statelist_t *, uint32_t *, uint64_t *, uint32_t, const uint8_t *, noncelist_t *);
 crack_states_bitsliced_t crack_states_bitsliced_AVX512;
@@ -571,7 +568,7 @@ out:
 
 
 
-//#ifdef NOSIMD_BUILD
+#ifdef NOSIMD_BUILD
 
 // pointers to functions:
 crack_states_bitsliced_t *crack_states_bitsliced_function_p = &crack_states_bitsliced_dispatch;
@@ -632,73 +629,71 @@ uint64_t crack_states_bitsliced_dispatch(uint32_t cuid, uint8_t *best_first_byte
         uint32_t *keys_found, uint64_t *num_keys_tested,
         uint32_t nonces_to_bruteforce, const uint8_t *bf_test_nonce_2nd_byte,
         noncelist_t *nonces) {
-//    switch (GetSIMDInstrAuto()) {
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        case SIMD_AVX512:
-//            crack_states_bitsliced_function_p = &crack_states_bitsliced_AVX512;
-//            break;
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//        case SIMD_AVX2:
-//            crack_states_bitsliced_function_p = &crack_states_bitsliced_AVX2;
-//            break;
-//        case SIMD_AVX:
-//            crack_states_bitsliced_function_p = &crack_states_bitsliced_AVX;
-//            break;
-//        case SIMD_SSE2:
-//            crack_states_bitsliced_function_p = &crack_states_bitsliced_SSE2;
-//            break;
-//        case SIMD_MMX:
-//            crack_states_bitsliced_function_p = &crack_states_bitsliced_MMX;
-//            break;
-//#endif
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//        case SIMD_NEON:
-//            crack_states_bitsliced_function_p = &crack_states_bitsliced_NEON;
-//            break;
-//#endif
-//        case SIMD_AUTO:
-//        case SIMD_NONE:
-//            crack_states_bitsliced_function_p = &crack_states_bitsliced_NOSIMD;
-//            break;
-//    }
-    crack_states_bitsliced_function_p = &crack_states_bitsliced_NOSIMD;
+    switch (GetSIMDInstrAuto()) {
+#if defined(COMPILER_HAS_SIMD_AVX512)
+        case SIMD_AVX512:
+            crack_states_bitsliced_function_p = &crack_states_bitsliced_AVX512;
+            break;
+#endif
+#if defined(COMPILER_HAS_SIMD_X86)
+        case SIMD_AVX2:
+            crack_states_bitsliced_function_p = &crack_states_bitsliced_AVX2;
+            break;
+        case SIMD_AVX:
+            crack_states_bitsliced_function_p = &crack_states_bitsliced_AVX;
+            break;
+        case SIMD_SSE2:
+            crack_states_bitsliced_function_p = &crack_states_bitsliced_SSE2;
+            break;
+        case SIMD_MMX:
+            crack_states_bitsliced_function_p = &crack_states_bitsliced_MMX;
+            break;
+#endif
+#if defined(COMPILER_HAS_SIMD_NEON)
+        case SIMD_NEON:
+            crack_states_bitsliced_function_p = &crack_states_bitsliced_NEON;
+            break;
+#endif
+        case SIMD_AUTO:
+        case SIMD_NONE:
+            crack_states_bitsliced_function_p = &crack_states_bitsliced_NOSIMD;
+            break;
+    }
     // call the most optimized function for this CPU
     return (*crack_states_bitsliced_function_p)(cuid, best_first_bytes, p, keys_found, num_keys_tested, nonces_to_bruteforce, bf_test_nonce_2nd_byte, nonces);
 }
 
 void bitslice_test_nonces_dispatch(uint32_t nonces_to_bruteforce, const uint32_t *bf_test_nonce, const uint8_t *bf_test_nonce_par) {
-//    switch (GetSIMDInstrAuto()) {
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        case SIMD_AVX512:
-//            bitslice_test_nonces_function_p = &bitslice_test_nonces_AVX512;
-//            break;
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//        case SIMD_AVX2:
-//            bitslice_test_nonces_function_p = &bitslice_test_nonces_AVX2;
-//            break;
-//        case SIMD_AVX:
-//            bitslice_test_nonces_function_p = &bitslice_test_nonces_AVX;
-//            break;
-//        case SIMD_SSE2:
-//            bitslice_test_nonces_function_p = &bitslice_test_nonces_SSE2;
-//            break;
-//        case SIMD_MMX:
-//            bitslice_test_nonces_function_p = &bitslice_test_nonces_MMX;
-//            break;
-//#endif
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//        case SIMD_NEON:
-//            bitslice_test_nonces_function_p = &bitslice_test_nonces_NEON;
-//            break;
-//#endif
-//        case SIMD_AUTO:
-//        case SIMD_NONE:
-//            bitslice_test_nonces_function_p = &bitslice_test_nonces_NOSIMD;
-//            break;
-//    }
-    bitslice_test_nonces_function_p = &bitslice_test_nonces_NOSIMD;
+    switch (GetSIMDInstrAuto()) {
+#if defined(COMPILER_HAS_SIMD_AVX512)
+        case SIMD_AVX512:
+            bitslice_test_nonces_function_p = &bitslice_test_nonces_AVX512;
+            break;
+#endif
+#if defined(COMPILER_HAS_SIMD_X86)
+        case SIMD_AVX2:
+            bitslice_test_nonces_function_p = &bitslice_test_nonces_AVX2;
+            break;
+        case SIMD_AVX:
+            bitslice_test_nonces_function_p = &bitslice_test_nonces_AVX;
+            break;
+        case SIMD_SSE2:
+            bitslice_test_nonces_function_p = &bitslice_test_nonces_SSE2;
+            break;
+        case SIMD_MMX:
+            bitslice_test_nonces_function_p = &bitslice_test_nonces_MMX;
+            break;
+#endif
+#if defined(COMPILER_HAS_SIMD_NEON)
+        case SIMD_NEON:
+            bitslice_test_nonces_function_p = &bitslice_test_nonces_NEON;
+            break;
+#endif
+        case SIMD_AUTO:
+        case SIMD_NONE:
+            bitslice_test_nonces_function_p = &bitslice_test_nonces_NOSIMD;
+            break;
+    }
     // call the most optimized function for this CPU
     (*bitslice_test_nonces_function_p)(nonces_to_bruteforce, bf_test_nonce, bf_test_nonce_par);
 }
@@ -712,4 +707,4 @@ void bitslice_test_nonces(uint32_t nonces_to_bruteforce, uint32_t *bf_test_nonce
     (*bitslice_test_nonces_function_p)(nonces_to_bruteforce, bf_test_nonce, bf_test_nonce_par);
 }
 
-//#endif
+#endif
@@ -25,108 +25,109 @@
 #ifndef __APPLE__
 #include <malloc.h>
 #endif
-
-//// this needs to be compiled several times for each instruction set.
-//// For each instruction set, define a dedicated function name:
-//#if defined (__AVX512F__)
-//#define MALLOC_BITARRAY malloc_bitarray_AVX512
-//#define FREE_BITARRAY free_bitarray_AVX512
-//#define BITCOUNT bitcount_AVX512
-//#define COUNT_STATES count_states_AVX512
-//#define BITARRAY_AND bitarray_AND_AVX512
-//#define BITARRAY_LOW20_AND bitarray_low20_AND_AVX512
-//#define COUNT_BITARRAY_AND count_bitarray_AND_AVX512
-//#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_AVX512
-//#define BITARRAY_AND4 bitarray_AND4_AVX512
-//#define BITARRAY_OR bitarray_OR_AVX512
-//#define COUNT_BITARRAY_AND2 count_bitarray_AND2_AVX512
-//#define COUNT_BITARRAY_AND3 count_bitarray_AND3_AVX512
-//#define COUNT_BITARRAY_AND4 count_bitarray_AND4_AVX512
-//#elif defined (__AVX2__)
-//#define MALLOC_BITARRAY malloc_bitarray_AVX2
-//#define FREE_BITARRAY free_bitarray_AVX2
-//#define BITCOUNT bitcount_AVX2
-//#define COUNT_STATES count_states_AVX2
-//#define BITARRAY_AND bitarray_AND_AVX2
-//#define BITARRAY_LOW20_AND bitarray_low20_AND_AVX2
-//#define COUNT_BITARRAY_AND count_bitarray_AND_AVX2
-//#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_AVX2
-//#define BITARRAY_AND4 bitarray_AND4_AVX2
-//#define BITARRAY_OR bitarray_OR_AVX2
-//#define COUNT_BITARRAY_AND2 count_bitarray_AND2_AVX2
-//#define COUNT_BITARRAY_AND3 count_bitarray_AND3_AVX2
-//#define COUNT_BITARRAY_AND4 count_bitarray_AND4_AVX2
-//#elif defined (__AVX__)
-//#define MALLOC_BITARRAY malloc_bitarray_AVX
-//#define FREE_BITARRAY free_bitarray_AVX
-//#define BITCOUNT bitcount_AVX
-//#define COUNT_STATES count_states_AVX
-//#define BITARRAY_AND bitarray_AND_AVX
-//#define BITARRAY_LOW20_AND bitarray_low20_AND_AVX
-//#define COUNT_BITARRAY_AND count_bitarray_AND_AVX
-//#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_AVX
-//#define BITARRAY_AND4 bitarray_AND4_AVX
-//#define BITARRAY_OR bitarray_OR_AVX
-//#define COUNT_BITARRAY_AND2 count_bitarray_AND2_AVX
-//#define COUNT_BITARRAY_AND3 count_bitarray_AND3_AVX
-//#define COUNT_BITARRAY_AND4 count_bitarray_AND4_AVX
-//#elif defined (__SSE2__)
-//#define MALLOC_BITARRAY malloc_bitarray_SSE2
-//#define FREE_BITARRAY free_bitarray_SSE2
-//#define BITCOUNT bitcount_SSE2
-//#define COUNT_STATES count_states_SSE2
-//#define BITARRAY_AND bitarray_AND_SSE2
-//#define BITARRAY_LOW20_AND bitarray_low20_AND_SSE2
-//#define COUNT_BITARRAY_AND count_bitarray_AND_SSE2
-//#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_SSE2
-//#define BITARRAY_AND4 bitarray_AND4_SSE2
-//#define BITARRAY_OR bitarray_OR_SSE2
-//#define COUNT_BITARRAY_AND2 count_bitarray_AND2_SSE2
-//#define COUNT_BITARRAY_AND3 count_bitarray_AND3_SSE2
-//#define COUNT_BITARRAY_AND4 count_bitarray_AND4_SSE2
-//#elif defined (__MMX__)
-//#define MALLOC_BITARRAY malloc_bitarray_MMX
-//#define FREE_BITARRAY free_bitarray_MMX
-//#define BITCOUNT bitcount_MMX
-//#define COUNT_STATES count_states_MMX
-//#define BITARRAY_AND bitarray_AND_MMX
-//#define BITARRAY_LOW20_AND bitarray_low20_AND_MMX
-//#define COUNT_BITARRAY_AND count_bitarray_AND_MMX
-//#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_MMX
-//#define BITARRAY_AND4 bitarray_AND4_MMX
-//#define BITARRAY_OR bitarray_OR_MMX
-//#define COUNT_BITARRAY_AND2 count_bitarray_AND2_MMX
-//#define COUNT_BITARRAY_AND3 count_bitarray_AND3_MMX
-//#define COUNT_BITARRAY_AND4 count_bitarray_AND4_MMX
-//#elif defined (__ARM_NEON) && !defined (NOSIMD_BUILD)
-//#define MALLOC_BITARRAY malloc_bitarray_NEON
-//#define FREE_BITARRAY free_bitarray_NEON
-//#define BITCOUNT bitcount_NEON
-//#define COUNT_STATES count_states_NEON
-//#define BITARRAY_AND bitarray_AND_NEON
-//#define BITARRAY_LOW20_AND bitarray_low20_AND_NEON
-//#define COUNT_BITARRAY_AND count_bitarray_AND_NEON
-//#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_NEON
-//#define BITARRAY_AND4 bitarray_AND4_NEON
-//#define BITARRAY_OR bitarray_OR_NEON
-//#define COUNT_BITARRAY_AND2 count_bitarray_AND2_NEON
-//#define COUNT_BITARRAY_AND3 count_bitarray_AND3_NEON
-//#define COUNT_BITARRAY_AND4 count_bitarray_AND4_NEON
-//#else
-//#define MALLOC_BITARRAY malloc_bitarray_NOSIMD
-//#define FREE_BITARRAY free_bitarray_NOSIMD
-//#define BITCOUNT bitcount_NOSIMD
-//#define COUNT_STATES count_states_NOSIMD
-//#define BITARRAY_AND bitarray_AND_NOSIMD
-//#define BITARRAY_LOW20_AND bitarray_low20_AND_NOSIMD
-//#define COUNT_BITARRAY_AND count_bitarray_AND_NOSIMD
-//#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_NOSIMD
-//#define BITARRAY_AND4 bitarray_AND4_NOSIMD
-//#define BITARRAY_OR bitarray_OR_NOSIMD
-//#define COUNT_BITARRAY_AND2 count_bitarray_AND2_NOSIMD
-//#define COUNT_BITARRAY_AND3 count_bitarray_AND3_NOSIMD
-//#define COUNT_BITARRAY_AND4 count_bitarray_AND4_NOSIMD
-//#endif
+#include "../pm3/util_posix.h"  // msclock
+
+// this needs to be compiled several times for each instruction set.
+// For each instruction set, define a dedicated function name:
+#if defined (__AVX512F__)
+#define MALLOC_BITARRAY malloc_bitarray_AVX512
+#define FREE_BITARRAY free_bitarray_AVX512
+#define BITCOUNT bitcount_AVX512
+#define COUNT_STATES count_states_AVX512
+#define BITARRAY_AND bitarray_AND_AVX512
+#define BITARRAY_LOW20_AND bitarray_low20_AND_AVX512
+#define COUNT_BITARRAY_AND count_bitarray_AND_AVX512
+#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_AVX512
+#define BITARRAY_AND4 bitarray_AND4_AVX512
+#define BITARRAY_OR bitarray_OR_AVX512
+#define COUNT_BITARRAY_AND2 count_bitarray_AND2_AVX512
+#define COUNT_BITARRAY_AND3 count_bitarray_AND3_AVX512
+#define COUNT_BITARRAY_AND4 count_bitarray_AND4_AVX512
+#elif defined (__AVX2__)
+#define MALLOC_BITARRAY malloc_bitarray_AVX2
+#define FREE_BITARRAY free_bitarray_AVX2
+#define BITCOUNT bitcount_AVX2
+#define COUNT_STATES count_states_AVX2
+#define BITARRAY_AND bitarray_AND_AVX2
+#define BITARRAY_LOW20_AND bitarray_low20_AND_AVX2
+#define COUNT_BITARRAY_AND count_bitarray_AND_AVX2
+#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_AVX2
+#define BITARRAY_AND4 bitarray_AND4_AVX2
+#define BITARRAY_OR bitarray_OR_AVX2
+#define COUNT_BITARRAY_AND2 count_bitarray_AND2_AVX2
+#define COUNT_BITARRAY_AND3 count_bitarray_AND3_AVX2
+#define COUNT_BITARRAY_AND4 count_bitarray_AND4_AVX2
+#elif defined (__AVX__)
+#define MALLOC_BITARRAY malloc_bitarray_AVX
+#define FREE_BITARRAY free_bitarray_AVX
+#define BITCOUNT bitcount_AVX
+#define COUNT_STATES count_states_AVX
+#define BITARRAY_AND bitarray_AND_AVX
+#define BITARRAY_LOW20_AND bitarray_low20_AND_AVX
+#define COUNT_BITARRAY_AND count_bitarray_AND_AVX
+#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_AVX
+#define BITARRAY_AND4 bitarray_AND4_AVX
+#define BITARRAY_OR bitarray_OR_AVX
+#define COUNT_BITARRAY_AND2 count_bitarray_AND2_AVX
+#define COUNT_BITARRAY_AND3 count_bitarray_AND3_AVX
+#define COUNT_BITARRAY_AND4 count_bitarray_AND4_AVX
+#elif defined (__SSE2__)
+#define MALLOC_BITARRAY malloc_bitarray_SSE2
+#define FREE_BITARRAY free_bitarray_SSE2
+#define BITCOUNT bitcount_SSE2
+#define COUNT_STATES count_states_SSE2
+#define BITARRAY_AND bitarray_AND_SSE2
+#define BITARRAY_LOW20_AND bitarray_low20_AND_SSE2
+#define COUNT_BITARRAY_AND count_bitarray_AND_SSE2
+#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_SSE2
+#define BITARRAY_AND4 bitarray_AND4_SSE2
+#define BITARRAY_OR bitarray_OR_SSE2
+#define COUNT_BITARRAY_AND2 count_bitarray_AND2_SSE2
+#define COUNT_BITARRAY_AND3 count_bitarray_AND3_SSE2
+#define COUNT_BITARRAY_AND4 count_bitarray_AND4_SSE2
+#elif defined (__MMX__)
+#define MALLOC_BITARRAY malloc_bitarray_MMX
+#define FREE_BITARRAY free_bitarray_MMX
+#define BITCOUNT bitcount_MMX
+#define COUNT_STATES count_states_MMX
+#define BITARRAY_AND bitarray_AND_MMX
+#define BITARRAY_LOW20_AND bitarray_low20_AND_MMX
+#define COUNT_BITARRAY_AND count_bitarray_AND_MMX
+#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_MMX
+#define BITARRAY_AND4 bitarray_AND4_MMX
+#define BITARRAY_OR bitarray_OR_MMX
+#define COUNT_BITARRAY_AND2 count_bitarray_AND2_MMX
+#define COUNT_BITARRAY_AND3 count_bitarray_AND3_MMX
+#define COUNT_BITARRAY_AND4 count_bitarray_AND4_MMX
+#elif defined (__ARM_NEON) && !defined (NOSIMD_BUILD)
+#define MALLOC_BITARRAY malloc_bitarray_NEON
+#define FREE_BITARRAY free_bitarray_NEON
+#define BITCOUNT bitcount_NEON
+#define COUNT_STATES count_states_NEON
+#define BITARRAY_AND bitarray_AND_NEON
+#define BITARRAY_LOW20_AND bitarray_low20_AND_NEON
+#define COUNT_BITARRAY_AND count_bitarray_AND_NEON
+#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_NEON
+#define BITARRAY_AND4 bitarray_AND4_NEON
+#define BITARRAY_OR bitarray_OR_NEON
+#define COUNT_BITARRAY_AND2 count_bitarray_AND2_NEON
+#define COUNT_BITARRAY_AND3 count_bitarray_AND3_NEON
+#define COUNT_BITARRAY_AND4 count_bitarray_AND4_NEON
+#else
+#define MALLOC_BITARRAY malloc_bitarray_NOSIMD
+#define FREE_BITARRAY free_bitarray_NOSIMD
+#define BITCOUNT bitcount_NOSIMD
+#define COUNT_STATES count_states_NOSIMD
+#define BITARRAY_AND bitarray_AND_NOSIMD
+#define BITARRAY_LOW20_AND bitarray_low20_AND_NOSIMD
+#define COUNT_BITARRAY_AND count_bitarray_AND_NOSIMD
+#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_NOSIMD
+#define BITARRAY_AND4 bitarray_AND4_NOSIMD
+#define BITARRAY_OR bitarray_OR_NOSIMD
+#define COUNT_BITARRAY_AND2 count_bitarray_AND2_NOSIMD
+#define COUNT_BITARRAY_AND3 count_bitarray_AND3_NOSIMD
+#define COUNT_BITARRAY_AND4 count_bitarray_AND4_NOSIMD
+#endif
 
 
 #ifndef __BIGGEST_ALIGNMENT__
@@ -148,20 +149,6 @@ unsigned int __builtin_popcountl(unsigned long long x) {
 #define atomic_add __sync_fetch_and_add
 #endif
 
-#define MALLOC_BITARRAY malloc_bitarray_NOSIMD
-#define FREE_BITARRAY free_bitarray_NOSIMD
-#define BITCOUNT bitcount_NOSIMD
-#define COUNT_STATES count_states_NOSIMD
-#define BITARRAY_AND bitarray_AND_NOSIMD
-#define BITARRAY_LOW20_AND bitarray_low20_AND_NOSIMD
-#define COUNT_BITARRAY_AND count_bitarray_AND_NOSIMD
-#define COUNT_BITARRAY_LOW20_AND count_bitarray_low20_AND_NOSIMD
-#define BITARRAY_AND4 bitarray_AND4_NOSIMD
-#define BITARRAY_OR bitarray_OR_NOSIMD
-#define COUNT_BITARRAY_AND2 count_bitarray_AND2_NOSIMD
-#define COUNT_BITARRAY_AND3 count_bitarray_AND3_NOSIMD
-#define COUNT_BITARRAY_AND4 count_bitarray_AND4_NOSIMD
-
 // typedefs and declaration of functions:
 typedef uint32_t *malloc_bitarray_t(uint32_t);
 malloc_bitarray_t malloc_bitarray_AVX512, malloc_bitarray_AVX2, malloc_bitarray_AVX, malloc_bitarray_SSE2, malloc_bitarray_MMX, malloc_bitarray_NOSIMD, malloc_bitarray_NEON, malloc_bitarray_dispatch;
@@ -334,7 +321,7 @@ inline uint32_t COUNT_BITARRAY_AND4(uint32_t *restrict A, uint32_t *restrict B,
 }
 
 
-//#ifdef NOSIMD_BUILD
+#ifdef NOSIMD_BUILD
 
 // pointers to functions:
 malloc_bitarray_t *malloc_bitarray_function_p = &malloc_bitarray_dispatch;
@@ -351,306 +338,213 @@ count_bitarray_AND2_t *count_bitarray_AND2_function_p = &count_bitarray_AND2_dis
 count_bitarray_AND3_t *count_bitarray_AND3_function_p = &count_bitarray_AND3_dispatch;
 count_bitarray_AND4_t *count_bitarray_AND4_function_p = &count_bitarray_AND4_dispatch;
 
-// determine the available instruction set at runtime and call the correct function
+// one row per compiled instruction set, widest first
+typedef struct {
+    SIMDExecInstr instr;
+    const char *name;
+    malloc_bitarray_t *malloc_bitarray;
+    free_bitarray_t *free_bitarray;
+    bitcount_t *bitcount;
+    count_states_t *count_states;
+    bitarray_AND_t *bitarray_AND;
+    bitarray_low20_AND_t *bitarray_low20_AND;
+    count_bitarray_AND_t *count_bitarray_AND;
+    count_bitarray_low20_AND_t *count_bitarray_low20_AND;
+    bitarray_AND4_t *bitarray_AND4;
+    bitarray_OR_t *bitarray_OR;
+    count_bitarray_AND2_t *count_bitarray_AND2;
+    count_bitarray_AND3_t *count_bitarray_AND3;
+    count_bitarray_AND4_t *count_bitarray_AND4;
+} bitarray_functions_t;
+
+#define BITARRAY_FUNCTIONS(instr, suffix) { instr, #suffix, \
+        malloc_bitarray_##suffix, free_bitarray_##suffix, bitcount_##suffix, count_states_##suffix, \
+        bitarray_AND_##suffix, bitarray_low20_AND_##suffix, count_bitarray_AND_##suffix, \
+        count_bitarray_low20_AND_##suffix, bitarray_AND4_##suffix, bitarray_OR_##suffix, \
+        count_bitarray_AND2_##suffix, count_bitarray_AND3_##suffix, count_bitarray_AND4_##suffix }
+
+static const bitarray_functions_t bitarray_functions[] = {
+#if defined(COMPILER_HAS_SIMD_AVX512)
+    BITARRAY_FUNCTIONS(SIMD_AVX512, AVX512),
+#endif
+#if defined(COMPILER_HAS_SIMD_X86)
+    BITARRAY_FUNCTIONS(SIMD_AVX2, AVX2),
+    BITARRAY_FUNCTIONS(SIMD_AVX, AVX),
+    BITARRAY_FUNCTIONS(SIMD_SSE2, SSE2),
+    BITARRAY_FUNCTIONS(SIMD_MMX, MMX),
+#endif
+#if defined(COMPILER_HAS_SIMD_NEON)
+    BITARRAY_FUNCTIONS(SIMD_NEON, NEON),
+#endif
+    BITARRAY_FUNCTIONS(SIMD_NONE, NOSIMD),
+};
+
+#define NUM_BITARRAY_FUNCTIONS (sizeof(bitarray_functions) / sizeof(bitarray_functions[0]))
+
+static const bitarray_functions_t *bitarray_functions_selected = NULL;
+
+static const bitarray_functions_t *get_bitarray_functions(SIMDExecInstr instr) {
+    for (uint32_t i = 0; i < NUM_BITARRAY_FUNCTIONS; i++) {
+        if (bitarray_functions[i].instr == instr) {
+            return &bitarray_functions[i];
+        }
+    }
+    return &bitarray_functions[NUM_BITARRAY_FUNCTIONS - 1];
+}
+
+// Fill the function pointers for the instruction set chosen by GetSIMDInstrAuto().
+// This is done only once: bitarrays allocated by one variant are aligned for that
+// variant only and must not be handed to a wider one later.
+void init_bitarray_core(void) {
+    if (bitarray_functions_selected != NULL) {
+        return;
+    }
+    const bitarray_functions_t *f = get_bitarray_functions(GetSIMDInstrAuto());
+    malloc_bitarray_function_p = f->malloc_bitarray;
+    free_bitarray_function_p = f->free_bitarray;
+    bitcount_function_p = f->bitcount;
+    count_states_function_p = f->count_states;
+    bitarray_AND_function_p = f->bitarray_AND;
+    bitarray_low20_AND_function_p = f->bitarray_low20_AND;
+    count_bitarray_AND_function_p = f->count_bitarray_AND;
+    count_bitarray_low20_AND_function_p = f->count_bitarray_low20_AND;
+    bitarray_AND4_function_p = f->bitarray_AND4;
+    bitarray_OR_function_p = f->bitarray_OR;
+    count_bitarray_AND2_function_p = f->count_bitarray_AND2;
+    count_bitarray_AND3_function_p = f->count_bitarray_AND3;
+    count_bitarray_AND4_function_p = f->count_bitarray_AND4;
+    bitarray_functions_selected = f;
+}
+
+const char *get_bitarray_core_name(void) {
+    init_bitarray_core();
+    return bitarray_functions_selected->name;
+}
+
+// first call of any bitarray function selects the table for this CPU and forwards the call
 uint32_t *malloc_bitarray_dispatch(uint32_t x) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) malloc_bitarray_function_p = &malloc_bitarray_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) malloc_bitarray_function_p = &malloc_bitarray_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) malloc_bitarray_function_p = &malloc_bitarray_AVX2;
-//            else if (__builtin_cpu_supports("avx")) malloc_bitarray_function_p = &malloc_bitarray_AVX;
-//            else if (__builtin_cpu_supports("sse2")) malloc_bitarray_function_p = &malloc_bitarray_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) malloc_bitarray_function_p = &malloc_bitarray_MMX;
-//            else
-//#endif
-//                malloc_bitarray_function_p = &malloc_bitarray_NOSIMD;
-    malloc_bitarray_function_p = &malloc_bitarray_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     return (*malloc_bitarray_function_p)(x);
 }
 
 void free_bitarray_dispatch(uint32_t *x) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) free_bitarray_function_p = &free_bitarray_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) free_bitarray_function_p = &free_bitarray_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) free_bitarray_function_p = &free_bitarray_AVX2;
-//            else if (__builtin_cpu_supports("avx")) free_bitarray_function_p = &free_bitarray_AVX;
-//            else if (__builtin_cpu_supports("sse2")) free_bitarray_function_p = &free_bitarray_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) free_bitarray_function_p = &free_bitarray_MMX;
-//            else
-//#endif
-//                free_bitarray_function_p = &free_bitarray_NOSIMD;
-    free_bitarray_function_p = &free_bitarray_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     (*free_bitarray_function_p)(x);
 }
 
 uint32_t bitcount_dispatch(uint32_t a) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) bitcount_function_p = &bitcount_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) bitcount_function_p = &bitcount_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) bitcount_function_p = &bitcount_AVX2;
-//            else if (__builtin_cpu_supports("avx")) bitcount_function_p = &bitcount_AVX;
-//            else if (__builtin_cpu_supports("sse2")) bitcount_function_p = &bitcount_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) bitcount_function_p = &bitcount_MMX;
-//            else
-//#endif
-//                bitcount_function_p = &bitcount_NOSIMD;
-    bitcount_function_p = &bitcount_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     return (*bitcount_function_p)(a);
 }
 
-uint32_t count_states_dispatch(uint32_t *bitarray) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) count_states_function_p = &count_states_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) count_states_function_p = &count_states_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) count_states_function_p = &count_states_AVX2;
-//            else if (__builtin_cpu_supports("avx")) count_states_function_p = &count_states_AVX;
-//            else if (__builtin_cpu_supports("sse2")) count_states_function_p = &count_states_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) count_states_function_p = &count_states_MMX;
-//            else
-//#endif
-//                count_states_function_p = &count_states_NOSIMD;
-    count_states_function_p = &count_states_NOSIMD;
-    // call the most optimized function for this CPU
-    return (*count_states_function_p)(bitarray);
+uint32_t count_states_dispatch(uint32_t *A) {
+    init_bitarray_core();
+    return (*count_states_function_p)(A);
 }
 
 void bitarray_AND_dispatch(uint32_t *A, uint32_t *B) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) bitarray_AND_function_p = &bitarray_AND_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) bitarray_AND_function_p = &bitarray_AND_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) bitarray_AND_function_p = &bitarray_AND_AVX2;
-//            else if (__builtin_cpu_supports("avx")) bitarray_AND_function_p = &bitarray_AND_AVX;
-//            else if (__builtin_cpu_supports("sse2")) bitarray_AND_function_p = &bitarray_AND_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) bitarray_AND_function_p = &bitarray_AND_MMX;
-//            else
-//#endif
-//                bitarray_AND_function_p = &bitarray_AND_NOSIMD;
-    bitarray_AND_function_p = &bitarray_AND_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     (*bitarray_AND_function_p)(A, B);
 }
 
 void bitarray_low20_AND_dispatch(uint32_t *A, uint32_t *B) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) bitarray_low20_AND_function_p = &bitarray_low20_AND_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) bitarray_low20_AND_function_p = &bitarray_low20_AND_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) bitarray_low20_AND_function_p = &bitarray_low20_AND_AVX2;
-//            else if (__builtin_cpu_supports("avx")) bitarray_low20_AND_function_p = &bitarray_low20_AND_AVX;
-//            else if (__builtin_cpu_supports("sse2")) bitarray_low20_AND_function_p = &bitarray_low20_AND_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) bitarray_low20_AND_function_p = &bitarray_low20_AND_MMX;
-//            else
-//#endif
-//                bitarray_low20_AND_function_p = &bitarray_low20_AND_NOSIMD;
-    bitarray_low20_AND_function_p = &bitarray_low20_AND_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     (*bitarray_low20_AND_function_p)(A, B);
 }
 
 uint32_t count_bitarray_AND_dispatch(uint32_t *A, uint32_t *B) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) count_bitarray_AND_function_p = &count_bitarray_AND_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) count_bitarray_AND_function_p = &count_bitarray_AND_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) count_bitarray_AND_function_p = &count_bitarray_AND_AVX2;
-//            else if (__builtin_cpu_supports("avx")) count_bitarray_AND_function_p = &count_bitarray_AND_AVX;
-//            else if (__builtin_cpu_supports("sse2")) count_bitarray_AND_function_p = &count_bitarray_AND_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) count_bitarray_AND_function_p = &count_bitarray_AND_MMX;
-//            else
-//#endif
-//                count_bitarray_AND_function_p = &count_bitarray_AND_NOSIMD;
-    count_bitarray_AND_function_p = &count_bitarray_AND_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     return (*count_bitarray_AND_function_p)(A, B);
 }
 
 uint32_t count_bitarray_low20_AND_dispatch(uint32_t *A, uint32_t *B) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) count_bitarray_low20_AND_function_p = &count_bitarray_low20_AND_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) count_bitarray_low20_AND_function_p = &count_bitarray_low20_AND_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) count_bitarray_low20_AND_function_p = &count_bitarray_low20_AND_AVX2;
-//            else if (__builtin_cpu_supports("avx")) count_bitarray_low20_AND_function_p = &count_bitarray_low20_AND_AVX;
-//            else if (__builtin_cpu_supports("sse2")) count_bitarray_low20_AND_function_p = &count_bitarray_low20_AND_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) count_bitarray_low20_AND_function_p = &count_bitarray_low20_AND_MMX;
-//            else
-//#endif
-//                count_bitarray_low20_AND_function_p = &count_bitarray_low20_AND_NOSIMD;
-    count_bitarray_low20_AND_function_p = &count_bitarray_low20_AND_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     return (*count_bitarray_low20_AND_function_p)(A, B);
 }
 
 void bitarray_AND4_dispatch(uint32_t *A, uint32_t *B, uint32_t *C, uint32_t *D) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) bitarray_AND4_function_p = &bitarray_AND4_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) bitarray_AND4_function_p = &bitarray_AND4_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) bitarray_AND4_function_p = &bitarray_AND4_AVX2;
-//            else if (__builtin_cpu_supports("avx")) bitarray_AND4_function_p = &bitarray_AND4_AVX;
-//            else if (__builtin_cpu_supports("sse2")) bitarray_AND4_function_p = &bitarray_AND4_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) bitarray_AND4_function_p = &bitarray_AND4_MMX;
-//            else
-//#endif
-//                bitarray_AND4_function_p = &bitarray_AND4_NOSIMD;
-    bitarray_AND4_function_p = &bitarray_AND4_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     (*bitarray_AND4_function_p)(A, B, C, D);
 }
 
 void bitarray_OR_dispatch(uint32_t *A, uint32_t *B) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) bitarray_OR_function_p = &bitarray_OR_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) bitarray_OR_function_p = &bitarray_OR_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) bitarray_OR_function_p = &bitarray_OR_AVX2;
-//            else if (__builtin_cpu_supports("avx")) bitarray_OR_function_p = &bitarray_OR_AVX;
-//            else if (__builtin_cpu_supports("sse2")) bitarray_OR_function_p = &bitarray_OR_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) bitarray_OR_function_p = &bitarray_OR_MMX;
-//            else
-//#endif
-//                bitarray_OR_function_p = &bitarray_OR_NOSIMD;
-    bitarray_OR_function_p = &bitarray_OR_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     (*bitarray_OR_function_p)(A, B);
 }
 
 uint32_t count_bitarray_AND2_dispatch(uint32_t *A, uint32_t *B) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) count_bitarray_AND2_function_p = &count_bitarray_AND2_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) count_bitarray_AND2_function_p = &count_bitarray_AND2_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) count_bitarray_AND2_function_p = &count_bitarray_AND2_AVX2;
-//            else if (__builtin_cpu_supports("avx")) count_bitarray_AND2_function_p = &count_bitarray_AND2_AVX;
-//            else if (__builtin_cpu_supports("sse2")) count_bitarray_AND2_function_p = &count_bitarray_AND2_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) count_bitarray_AND2_function_p = &count_bitarray_AND2_MMX;
-//            else
-//#endif
-//                count_bitarray_AND2_function_p = &count_bitarray_AND2_NOSIMD;
-    count_bitarray_AND2_function_p = &count_bitarray_AND2_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     return (*count_bitarray_AND2_function_p)(A, B);
 }
 
 uint32_t count_bitarray_AND3_dispatch(uint32_t *A, uint32_t *B, uint32_t *C) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) count_bitarray_AND3_function_p = &count_bitarray_AND3_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) count_bitarray_AND3_function_p = &count_bitarray_AND3_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) count_bitarray_AND3_function_p = &count_bitarray_AND3_AVX2;
-//            else if (__builtin_cpu_supports("avx")) count_bitarray_AND3_function_p = &count_bitarray_AND3_AVX;
-//            else if (__builtin_cpu_supports("sse2")) count_bitarray_AND3_function_p = &count_bitarray_AND3_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) count_bitarray_AND3_function_p = &count_bitarray_AND3_MMX;
-//            else
-//#endif
-//                count_bitarray_AND3_function_p = &count_bitarray_AND3_NOSIMD;
-    count_bitarray_AND3_function_p = &count_bitarray_AND3_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     return (*count_bitarray_AND3_function_p)(A, B, C);
 }
 
 uint32_t count_bitarray_AND4_dispatch(uint32_t *A, uint32_t *B, uint32_t *C, uint32_t *D) {
-//#if defined(COMPILER_HAS_SIMD_NEON)
-//    if (arm_has_neon()) count_bitarray_AND4_function_p = &count_bitarray_AND4_NEON;
-//    else
-//#endif
-//
-//#if defined(COMPILER_HAS_SIMD_AVX512)
-//        if (__builtin_cpu_supports("avx512f")) count_bitarray_AND4_function_p = &count_bitarray_AND4_AVX512;
-//        else
-//#endif
-//#if defined(COMPILER_HAS_SIMD_X86)
-//            if (__builtin_cpu_supports("avx2")) count_bitarray_AND4_function_p = &count_bitarray_AND4_AVX2;
-//            else if (__builtin_cpu_supports("avx")) count_bitarray_AND4_function_p = &count_bitarray_AND4_AVX;
-//            else if (__builtin_cpu_supports("sse2")) count_bitarray_AND4_function_p = &count_bitarray_AND4_SSE2;
-//            else if (__builtin_cpu_supports("mmx")) count_bitarray_AND4_function_p = &count_bitarray_AND4_MMX;
-//            else
-//#endif
-//                count_bitarray_AND4_function_p = &count_bitarray_AND4_NOSIMD;
-    count_bitarray_AND4_function_p = &count_bitarray_AND4_NOSIMD;
-    // call the most optimized function for this CPU
+    init_bitarray_core();
     return (*count_bitarray_AND4_function_p)(A, B, C, D);
 }
 
+// Measure the throughput of every bitarray primitive for each instruction set the
+// CPU supports. Traffic is counted as all bitarrays read plus the one written.
+#define BITARRAY_BENCH_SIZE   (sizeof(uint32_t) * (1 << 19))
+#define BITARRAY_BENCH_ROUNDS 200
+
+static void print_bitarray_rate(const char *core, const char *primitive, uint32_t arrays, uint64_t elapsed_ms) {
+    double bytes = (double)arrays * BITARRAY_BENCH_SIZE * BITARRAY_BENCH_ROUNDS;
+    double rate = elapsed_ms ? bytes / ((double)elapsed_ms / 1000.0) / 1e9 : 0.0;
+    printf("%-8s %-26s %8.2f GB/s\n", core, primitive, rate);
+}
+
+#define BENCH_BITARRAY(core, primitive, arrays, call) do { \
+        uint64_t start = msclock(); \
+        for (uint32_t round = 0; round < BITARRAY_BENCH_ROUNDS; round++) { \
+            sink += (uint32_t)(call); \
+        } \
+        print_bitarray_rate(core, primitive, arrays, msclock() - start); \
+    } while (0)
+
+void bitarray_benchmark(void) {
+    SIMDExecInstr best = GetSIMDInstrAuto();
+    volatile uint32_t sink = 0;
+
+    for (uint32_t i = 0; i < NUM_BITARRAY_FUNCTIONS; i++) {
+        const bitarray_functions_t *f = &bitarray_functions[i];
+        if (f->instr < best) {
+            continue; // not supported by this CPU
+        }
+        uint32_t *A = f->malloc_bitarray(BITARRAY_BENCH_SIZE);
+        uint32_t *B = f->malloc_bitarray(BITARRAY_BENCH_SIZE);
+        uint32_t *C = f->malloc_bitarray(BITARRAY_BENCH_SIZE);
+        uint32_t *D = f->malloc_bitarray(BITARRAY_BENCH_SIZE);
+        if (A == NULL || B == NULL || C == NULL || D == NULL) {
+            printf("Out of memory error in bitarray_benchmark(). Aborting...\n");
+            exit(4);
+        }
+        for (uint32_t j = 0; j < (1 << 19); j++) {
+            A[j] = 0xffffffff;
+            B[j] = rand() | 0x00010001;
+            C[j] = rand();
+            D[j] = rand();
+        }
+        BENCH_BITARRAY(f->name, "count_states", 1, f->count_states(B));
+        BENCH_BITARRAY(f->name, "bitarray_AND", 3, (f->bitarray_AND(A, B), 0));
+        BENCH_BITARRAY(f->name, "bitarray_low20_AND", 3, (f->bitarray_low20_AND(A, B), 0));
+        BENCH_BITARRAY(f->name, "count_bitarray_AND", 3, f->count_bitarray_AND(A, B));
+        BENCH_BITARRAY(f->name, "count_bitarray_low20_AND", 3, f->count_bitarray_low20_AND(A, B));
+        BENCH_BITARRAY(f->name, "bitarray_AND4", 4, (f->bitarray_AND4(A, B, C, D), 0));
+        BENCH_BITARRAY(f->name, "bitarray_OR", 3, (f->bitarray_OR(A, B), 0));
+        BENCH_BITARRAY(f->name, "count_bitarray_AND2", 2, f->count_bitarray_AND2(B, C));
+        BENCH_BITARRAY(f->name, "count_bitarray_AND3", 3, f->count_bitarray_AND3(B, C, D));
+        BENCH_BITARRAY(f->name, "count_bitarray_AND4", 4, f->count_bitarray_AND4(A, B, C, D));
+        f->free_bitarray(A);
+        f->free_bitarray(B);
+        f->free_bitarray(C);
+        f->free_bitarray(D);
+    }
+}
 
 ///////////////////////////////////////////////77
 // Entries to dispatched function calls
@@ -707,5 +601,5 @@ uint32_t count_bitarray_AND4(uint32_t *A, uint32_t *B, uint32_t *C, uint32_t *D)
     return (*count_bitarray_AND4_function_p)(A, B, C, D);
 }
 
-//#endif
-//
+#endif
+
@@ -65,5 +65,8 @@ void bitarray_OR(uint32_t *A, uint32_t *B);
 uint32_t count_bitarray_AND2(uint32_t *A, uint32_t *B);
 uint32_t count_bitarray_AND3(uint32_t *A, uint32_t *B, uint32_t *C);
 uint32_t count_bitarray_AND4(uint32_t *A, uint32_t *B, uint32_t *C, uint32_t *D);
+void init_bitarray_core(void);
+const char *get_bitarray_core_name(void);
+void bitarray_benchmark(void);
 
 #endif
@@ -79,6 +79,8 @@ THE SOFTWARE.
 #include <fcntl.h>
 #include <sys/stat.h>
 #define atomic_add(num, val) (InterlockedExchangeAdd64(num, val) + val)
+#define fetch_and_add(num, val) InterlockedExchangeAdd64(num, val)
+#define claim_flag(flag) (InterlockedCompareExchange((volatile LONG *)(flag), 1, 0) == 0)
 FILE *fmemopen(void *buf, size_t len, const char *type) {
     int fd;
     FILE *fp;
@@ -108,6 +110,8 @@ FILE *fmemopen(void *buf, size_t len, const char *type) {
 }
 #else
 #define atomic_add __sync_fetch_and_add
+#define fetch_and_add __sync_fetch_and_add
+#define claim_flag(flag) __sync_bool_compare_and_swap(flag, 0, 1)
 #ifdef _WIN32 // Non-MSVC Windows (MinGW, etc.)
 // Include the compatibility header provided via CMake
 #include "../../compat/fmemopen/libfmemopen.h"
@@ -129,9 +133,11 @@ static uint8_t bf_test_nonce_2nd_byte[256];
 static uint8_t bf_test_nonce_par[256];
 static uint32_t bucket_count = 0;
 static statelist_t *buckets[128];
+static int64_t next_bucket = 0;
 static uint32_t keys_found = 0;
 static uint64_t num_keys_tested;
 static uint64_t found_bs_key = 0;
+static uint64_t bf_start_time = 0;
 
 uint8_t trailing_zeros(uint8_t byte) {
     static const uint8_t trailing_zeros_LUT[256] = {
@@ -201,9 +207,13 @@ crack_states_thread(void *x) {
     } *thread_arg;
 
     thread_arg = (struct arg *)x;
+#if defined (DEBUG_BRUTE_FORCE)
     const int thread_id = thread_arg->thread_ID;
-    uint32_t current_bucket = thread_id;
-    while (current_bucket < bucket_count) {
+#endif
+    // buckets are handed out one at a time, largest first, so no thread sits idle while another
+    // still has a queue of buckets of its own
+    uint32_t current_bucket;
+    while ((current_bucket = fetch_and_add(&next_bucket, 1)) < bucket_count) {
         statelist_t *bucket = buckets[current_bucket];
         if (bucket) {
 #if defined (DEBUG_BRUTE_FORCE)
@@ -211,31 +221,44 @@ crack_states_thread(void *x) {
 #endif
             const uint64_t key = crack_states_bitsliced(thread_arg->cuid, thread_arg->best_first_bytes, bucket, &keys_found, &num_keys_tested, nonces_to_bruteforce, bf_test_nonce_2nd_byte, thread_arg->nonces);
             if (key != -1) {
-                atomic_add(&keys_found, 1);
-                atomic_add(&found_bs_key, key);
-
-                char progress_text[80];
-                char keystr[19];
-                snprintf(keystr, sizeof(keystr), "%012" PRIX64 "  ", key);
-                snprintf(progress_text, sizeof(progress_text), "Brute force phase completed.  Key found: " _GREEN_("%s"), keystr);
-                hardnested_print_progress(thread_arg->num_acquired_nonces, progress_text, 0.0, 0);
+                // the key has passed verify_key(). Only the first thread to get here reports it,
+                // the others stop at their next early abort check.
+                if (claim_flag(&keys_found)) {
+                    found_bs_key = key;
+
+                    char progress_text[80];
+                    char keystr[19];
+                    snprintf(keystr, sizeof(keystr), "%012" PRIX64 "  ", key);
+                    snprintf(progress_text, sizeof(progress_text), "Brute force phase completed.  Key found: " _GREEN_("%s"), keystr);
+                    hardnested_print_progress(thread_arg->num_acquired_nonces, progress_text, 0.0, 0);
+                }
                 break;
             } else if (keys_found) {
                 break;
             } else {
                 if (!thread_arg->silent) {
                     char progress_text[80];
-                    snprintf(progress_text, sizeof(progress_text), "Brute force phase: %6.02f%%", 100.0 * (float)num_keys_tested / (float)(thread_arg->maximum_states));
+                    uint64_t elapsed_time = msclock() - bf_start_time;
+                    float keys_per_second = elapsed_time ? (float)num_keys_tested * 1000.0 / elapsed_time : 0.0;
+                    snprintf(progress_text, sizeof(progress_text), "Brute force phase: %6.02f%%, %6.1f million keys/s",
+                             100.0 * (float)num_keys_tested / (float)(thread_arg->maximum_states), keys_per_second / 1000000);
                     float remaining_bruteforce = thread_arg->nonces[thread_arg->best_first_bytes[0]].expected_num_brute_force - (float)num_keys_tested / 2;
                     hardnested_print_progress(thread_arg->num_acquired_nonces, progress_text, remaining_bruteforce, 5000);
                 }
             }
         }
-        current_bucket += NUM_BRUTE_FORCE_THREADS;
     }
     return NULL;
 }
 
+static int compare_bucket_size(const void *b1, const void *b2) {
+    const statelist_t *p1 = *(statelist_t *const *)b1;
+    const statelist_t *p2 = *(statelist_t *const *)b2;
+    uint64_t size1 = (uint64_t)p1->len[ODD_STATE] * p1->len[EVEN_STATE];
+    uint64_t size2 = (uint64_t)p2->len[ODD_STATE] * p2->len[EVEN_STATE];
+    return (size1 < size2) - (size1 > size2);
+}
+
 
 void prepare_bf_test_nonces(noncelist_t *nonces, uint8_t best_first_byte) {
     // we do bitsliced brute forcing with best_first_bytes[0] only.
@@ -326,8 +349,11 @@ bool brute_force_bs(float *bf_rate, statelist_t *candidates, uint32_t cuid, uint
             bucket_count++;
         }
     }
+    qsort(buckets, bucket_count, sizeof(statelist_t *), compare_bucket_size);
+    next_bucket = 0;
 
     uint64_t start_time = msclock();
+    bf_start_time = start_time;
 
 #if defined(__linux__) ||  defined(__APPLE__)
     if (NUM_BRUTE_FORCE_THREADS < 0)
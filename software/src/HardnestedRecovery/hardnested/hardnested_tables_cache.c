@@ -0,0 +1,240 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// On-disk cache of the decompressed bitflip tables
+//-----------------------------------------------------------------------------
+
+#include "hardnested_tables_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tables.h"
+#include "../pm3/ui.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define BITFLIP_CACHE_MAGIC       "HNBFLIP"
+#define BITFLIP_CACHE_VERSION     1
+#define BITFLIP_CACHE_FILE        "hardnested_bitflips.bin"
+#define BITFLIP_TABLE_SIZE        (sizeof(uint32_t) * (1 << 19))
+// tables start on a 64k boundary, which is page aligned on every platform we run on
+#define BITFLIP_CACHE_ALIGN       0x10000
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_tables;
+    uint64_t tables_hash;
+    uint32_t table_size;
+    uint32_t data_offset;
+} bitflip_cache_header_t;
+
+typedef struct {
+    uint16_t odd_even;
+    uint16_t bitflip;
+    uint32_t count;
+} bitflip_cache_entry_t;
+
+// FNV-1a, 64 bit
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t bitflip_tables_hash(float ignore_threshold) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint32_t version = BITFLIP_CACHE_VERSION;
+    hash = fnv1a(hash, &version, sizeof(version));
+    hash = fnv1a(hash, &ignore_threshold, sizeof(ignore_threshold));
+    for (odd_even_t odd_even = EVEN_STATE; odd_even <= ODD_STATE; odd_even++) {
+        for (uint16_t bitflip = 0x001; bitflip < 0x400; bitflip++) {
+            bitflip_info p = get_bitflip(odd_even, bitflip);
+            uint32_t len = (p.input_buffer != NULL) ? p.len : 0;
+            hash = fnv1a(hash, &len, sizeof(len));
+            if (len != 0) {
+                hash = fnv1a(hash, p.input_buffer, len);
+            }
+        }
+    }
+    return hash;
+}
+
+#ifndef _WIN32
+
+static void *cache_map = NULL;
+static size_t cache_map_size = 0;
+
+static bool bitflip_cache_path(char *path, size_t len, bool create_dir) {
+    const char *env = getenv("HARDNESTED_CACHE");
+    if (env != NULL) {
+        if (env[0] == '\0') {
+            return false;
+        }
+        return (size_t)snprintf(path, len, "%s", env) < len;
+    }
+
+    char dir[1024];
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (xdg != NULL && xdg[0] != '\0') {
+        if ((size_t)snprintf(dir, sizeof(dir), "%s", xdg) >= sizeof(dir)) return false;
+    } else if (home != NULL && home[0] != '\0') {
+        if ((size_t)snprintf(dir, sizeof(dir), "%s/.cache", home) >= sizeof(dir)) return false;
+    } else {
+        return false;
+    }
+    if (create_dir && mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    if (strlen(dir) + sizeof("/chameleonultra") > sizeof(dir)) return false;
+    strcat(dir, "/chameleonultra");
+    if (create_dir && mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    return (size_t)snprintf(path, len, "%s/" BITFLIP_CACHE_FILE, dir) < len;
+}
+
+bool load_bitflip_cache(uint64_t tables_hash, uint32_t *bitarrays[][0x400], uint32_t counts[][0x400]) {
+    char path[1100];
+    if (!bitflip_cache_path(path, sizeof(path), false)) {
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(bitflip_cache_header_t)) {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const bitflip_cache_header_t *hdr = (const bitflip_cache_header_t *)map;
+    const bitflip_cache_entry_t *entries = (const bitflip_cache_entry_t *)(map + sizeof(bitflip_cache_header_t));
+    bool valid = memcmp(hdr->magic, BITFLIP_CACHE_MAGIC, sizeof(hdr->magic)) == 0
+                 && hdr->version == BITFLIP_CACHE_VERSION
+                 && hdr->tables_hash == tables_hash
+                 && hdr->table_size == BITFLIP_TABLE_SIZE
+                 && hdr->num_tables <= 2 * 0x400
+                 && hdr->data_offset % BITFLIP_CACHE_ALIGN == 0
+                 && sizeof(bitflip_cache_header_t) + hdr->num_tables * sizeof(bitflip_cache_entry_t) <= hdr->data_offset
+                 && (size_t)hdr->data_offset + (size_t)hdr->num_tables * BITFLIP_TABLE_SIZE == size;
+    for (uint32_t i = 0; valid && i < hdr->num_tables; i++) {
+        valid = entries[i].odd_even <= ODD_STATE && entries[i].bitflip > 0 && entries[i].bitflip < 0x400;
+    }
+    if (!valid) {
+        munmap(map, size);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < hdr->num_tables; i++) {
+        bitarrays[entries[i].odd_even][entries[i].bitflip] = (uint32_t *)(map + hdr->data_offset + (size_t)i * BITFLIP_TABLE_SIZE);
+        counts[entries[i].odd_even][entries[i].bitflip] = entries[i].count;
+    }
+    madvise(map, size, MADV_WILLNEED);
+    cache_map = map;
+    cache_map_size = size;
+    return true;
+}
+
+void save_bitflip_cache(uint64_t tables_hash, uint32_t *bitarrays[][0x400], uint32_t counts[][0x400]) {
+    char path[1100];
+    char tmp_path[1200];
+    if (!bitflip_cache_path(path, sizeof(path), true)) {
+        return;
+    }
+    // write aside and rename, so concurrent runs never map a half written file
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%ld.tmp", path, (long)getpid());
+
+    bitflip_cache_header_t hdr = {0};
+    memcpy(hdr.magic, BITFLIP_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = BITFLIP_CACHE_VERSION;
+    hdr.tables_hash = tables_hash;
+    hdr.table_size = BITFLIP_TABLE_SIZE;
+    for (odd_even_t odd_even = EVEN_STATE; odd_even <= ODD_STATE; odd_even++) {
+        for (uint16_t bitflip = 0x001; bitflip < 0x400; bitflip++) {
+            if (bitarrays[odd_even][bitflip] != NULL) {
+                hdr.num_tables++;
+            }
+        }
+    }
+    size_t index_end = sizeof(hdr) + hdr.num_tables * sizeof(bitflip_cache_entry_t);
+    hdr.data_offset = (index_end + BITFLIP_CACHE_ALIGN - 1) & ~(BITFLIP_CACHE_ALIGN - 1);
+
+    FILE *f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        return;
+    }
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    for (odd_even_t odd_even = EVEN_STATE; ok && odd_even <= ODD_STATE; odd_even++) {
+        for (uint16_t bitflip = 0x001; ok && bitflip < 0x400; bitflip++) {
+            if (bitarrays[odd_even][bitflip] != NULL) {
+                bitflip_cache_entry_t e = {odd_even, bitflip, counts[odd_even][bitflip]};
+                ok = fwrite(&e, sizeof(e), 1, f) == 1;
+            }
+        }
+    }
+    for (size_t pad = index_end; ok && pad < hdr.data_offset; pad++) {
+        ok = fputc(0, f) != EOF;
+    }
+    for (odd_even_t odd_even = EVEN_STATE; ok && odd_even <= ODD_STATE; odd_even++) {
+        for (uint16_t bitflip = 0x001; ok && bitflip < 0x400; bitflip++) {
+            if (bitarrays[odd_even][bitflip] != NULL) {
+                ok = fwrite(bitarrays[odd_even][bitflip], BITFLIP_TABLE_SIZE, 1, f) == 1;
+            }
+        }
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp_path, path) != 0) {
+        PrintAndLogEx(WARNING, "Could not write bitflip table cache %s", path);
+        remove(tmp_path);
+    }
+}
+
+void unmap_bitflip_cache(void) {
+    if (cache_map != NULL) {
+        munmap(cache_map, cache_map_size);
+        cache_map = NULL;
+        cache_map_size = 0;
+    }
+}
+
+#else // _WIN32: no mmap, always inflate the embedded tables
+
+bool load_bitflip_cache(uint64_t tables_hash, uint32_t *bitarrays[][0x400], uint32_t counts[][0x400]) {
+    (void)tables_hash;
+    (void)bitarrays;
+    (void)counts;
+    return false;
+}
+
+void save_bitflip_cache(uint64_t tables_hash, uint32_t *bitarrays[][0x400], uint32_t counts[][0x400]) {
+    (void)tables_hash;
+    (void)bitarrays;
+    (void)counts;
+}
+
+void unmap_bitflip_cache(void) {
+}
+
+#endif
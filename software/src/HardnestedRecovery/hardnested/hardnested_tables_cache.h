@@ -0,0 +1,29 @@
+//-----------------------------------------------------------------------------
+// This code is licensed to you under the terms of the GNU GPL, version 2 or,
+// at your option, any later version. See the LICENSE.txt file for the text of
+// the license.
+//-----------------------------------------------------------------------------
+// On-disk cache of the decompressed bitflip tables.
+//
+// Inflating the embedded tables costs a noticeable part of every hardnested
+// start. The cache keeps the effective tables (the ones below the ignore
+// threshold) in a single file which later runs map read-only. The file is
+// tied to the embedded tables by a content hash, so a binary built with
+// different tables rejects it and rewrites it.
+//
+// Location: $HARDNESTED_CACHE if set (empty disables the cache), otherwise
+// $XDG_CACHE_HOME/chameleonultra/ or ~/.cache/chameleonultra/.
+//-----------------------------------------------------------------------------
+
+#ifndef HARDNESTED_TABLES_CACHE_H__
+#define HARDNESTED_TABLES_CACHE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+uint64_t bitflip_tables_hash(float ignore_threshold);
+bool load_bitflip_cache(uint64_t tables_hash, uint32_t *bitarrays[][0x400], uint32_t counts[][0x400]);
+void save_bitflip_cache(uint64_t tables_hash, uint32_t *bitarrays[][0x400], uint32_t counts[][0x400]);
+void unmap_bitflip_cache(void);
+
+#endif
@@ -5,10 +5,17 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include <errno.h> // For error handling
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 #include "cmdhfmfhard.h"
 #include "crapto1.h"
 #include "parity.h"
+#include "pm3/commonutil.h"
+#include "hardnested/hardnested_bf_core.h"
+#include "hardnested/hardnested_bitarray_core.h"
 
 
 typedef enum {
@@ -67,17 +74,150 @@ bool read_uint8(FILE *f, uint8_t *value) {
 }
 
 
+// Map a --simd= value to the instruction set. Returns false for unknown names
+// and for instruction sets which were not compiled in for this platform.
+static bool parse_simd_instr(const char *name, SIMDExecInstr *instr) {
+    if (strcmp(name, "auto") == 0) {
+        *instr = SIMD_AUTO;
+#if defined(COMPILER_HAS_SIMD_AVX512)
+    } else if (strcmp(name, "avx512") == 0) {
+        *instr = SIMD_AVX512;
+#endif
+#if defined(COMPILER_HAS_SIMD_X86)
+    } else if (strcmp(name, "avx2") == 0) {
+        *instr = SIMD_AVX2;
+    } else if (strcmp(name, "avx") == 0) {
+        *instr = SIMD_AVX;
+    } else if (strcmp(name, "sse2") == 0) {
+        *instr = SIMD_SSE2;
+    } else if (strcmp(name, "mmx") == 0) {
+        *instr = SIMD_MMX;
+#endif
+#if defined(COMPILER_HAS_SIMD_NEON)
+    } else if (strcmp(name, "neon") == 0) {
+        *instr = SIMD_NEON;
+#endif
+    } else if (strcmp(name, "none") == 0) {
+        *instr = SIMD_NONE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+// Read the whole nonce body in one go and decode it into nonce/parity pairs.
+// Each chunk is nt_enc1 (BE32), nt_enc2 (BE32) and one byte holding both parities.
+// Returns NULL on error, otherwise a malloc'ed list of 2 * *num_pairs nonces.
+static hardnested_nonce_t *read_nonce_body(FILE *bin_fp, size_t *num_pairs) {
+    const size_t chunk_size = 9;
+    long body_start = ftell(bin_fp);
+    if (body_start < 0 || fseek(bin_fp, 0, SEEK_END) != 0) {
+        perror("Error seeking binary file");
+        return NULL;
+    }
+    long file_end = ftell(bin_fp);
+    if (file_end < body_start || fseek(bin_fp, body_start, SEEK_SET) != 0) {
+        perror("Error seeking binary file");
+        return NULL;
+    }
+    size_t body_size = (size_t)(file_end - body_start);
+    if (body_size % chunk_size != 0) {
+        fprintf(stderr, "Error: binary file body is %zu bytes, not a multiple of %zu (truncated file?).\n",
+                body_size, chunk_size);
+        return NULL;
+    }
+    size_t nonces_processed = body_size / chunk_size; // Counts pairs of nonces (nt1, nt2)
+
+    if (nonces_processed == 0) {
+        fprintf(stderr, "Error: No nonce data chunks found in the binary file after the header.\n");
+        return NULL;
+    }
+
+    uint8_t *body = malloc(body_size);
+    hardnested_nonce_t *nonce_list = malloc(nonces_processed * 2 * sizeof(hardnested_nonce_t));
+    if (body == NULL || nonce_list == NULL) {
+        fprintf(stderr, "Error: out of memory reading %zu nonce pairs.\n", nonces_processed);
+        free(body);
+        free(nonce_list);
+        return NULL;
+    }
+    if (fread(body, 1, body_size, bin_fp) != body_size) {
+        perror("Error reading nonce data from binary file");
+        free(body);
+        free(nonce_list);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < nonces_processed; i++) {
+        const uint8_t *chunk = body + i * chunk_size;
+        uint8_t par_packed = chunk[8];
+        nonce_list[2 * i].nonce_enc = bytes_to_num((uint8_t *)chunk, 4);
+        nonce_list[2 * i].par_enc = par_packed >> 4;
+        nonce_list[2 * i + 1].nonce_enc = bytes_to_num((uint8_t *)chunk + 4, 4);
+        nonce_list[2 * i + 1].par_enc = par_packed & 0x0F;
+    }
+    free(body);
+
+    *num_pairs = nonces_processed;
+    return nonce_list;
+}
+
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        // Updated usage message for the new binary input
-        fprintf(stderr, "Usage: %s <binary_nonce_file_path.bin>\n", argv[0]);
+    char *binary_file_path = NULL;
+    SIMDExecInstr simd_instr = SIMD_AUTO;
+    bool bench_bitarray = false;
+    bool stream = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--simd=", 7) == 0) {
+            if (!parse_simd_instr(argv[i] + 7, &simd_instr)) {
+                fprintf(stderr, "Error: Unknown or unsupported SIMD instruction set '%s'.\n", argv[i] + 7);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bench-bitarray") == 0) {
+            bench_bitarray = true;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = true;
+        } else if (binary_file_path == NULL) {
+            binary_file_path = argv[i];
+        } else {
+            binary_file_path = NULL;
+            break;
+        }
+    }
+
+    if ((binary_file_path == NULL) != (stream || bench_bitarray)) {
+        fprintf(stderr, "Usage: %s [--simd=auto|avx512|avx2|avx|sse2|mmx|neon|none] <binary_nonce_file_path.bin>\n", argv[0]);
+        fprintf(stderr, "       %s [--simd=...] --stream   (nonce file header and batches on stdin)\n", argv[0]);
+        fprintf(stderr, "       %s [--simd=...] --bench-bitarray\n", argv[0]);
         return 1;
     }
 
-    char *binary_file_path = argv[1];
+    // The enum is ordered from the widest to the narrowest instruction set, so
+    // anything wider than what the CPU reports would crash with SIGILL.
+    if (simd_instr != SIMD_AUTO && simd_instr < GetSIMDInstrAuto()) {
+        fprintf(stderr, "Error: The requested SIMD instruction set is not supported by this CPU.\n");
+        return 1;
+    }
+    SetSIMDInstr(simd_instr);
+
+    if (bench_bitarray) {
+        printf("Bitarray core in use: %s\n", get_bitarray_core_name());
+        bitarray_benchmark();
+        return 0;
+    }
 
     // --- Open binary input file ---
-    FILE *bin_fp = fopen(binary_file_path, "rb"); // Open in binary read mode
+    FILE *bin_fp;
+    if (stream) {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        bin_fp = stdin;
+    } else {
+        bin_fp = fopen(binary_file_path, "rb"); // Open in binary read mode
+    }
     if (bin_fp == NULL) {
         perror("Error opening binary nonce file");
         return 1;
@@ -114,95 +254,33 @@ int main(int argc, char *argv[]) {
     }
     key_type_t key_type = (key_type_t)key_type_byte;
 
-    // --- Create and open temporary text file ---
-    char temp_file[] = "temp_nonces.txt";
-    FILE *temp_fp = fopen(temp_file, "w");
-    if (temp_fp == NULL) {
-        perror("Error creating temporary file");
-        fclose(bin_fp);
-        return 1;
-    }
-
     printf("Read Header -> UID: %08x, Sector: %u, Key type: %c\n",
            uid, sector, (key_type == KEY_A) ? 'A' : 'B');
-    printf("Reading nonce data from binary file: %s\n", binary_file_path);
-
-    // --- Read binary file (nonce data) and write to temp text file ---
-    uint32_t nt_enc1, nt_enc2;
-    uint8_t par_packed;
-    uint8_t par_enc1, par_enc2;
-    size_t nonces_processed = 0; // Counts pairs of nonces (nt1, nt2)
-
-    while (true) {
-        // *** Use Big-Endian reader for nonces ***
-        if (!read_uint32_be(bin_fp, &nt_enc1)) {
-            if (feof(bin_fp)) break; // Expected EOF after last full chunk
-            fprintf(stderr, "Error reading nt_enc1 (BE) from binary file body.\n");
-            fclose(bin_fp);
-            fclose(temp_fp);
-            remove(temp_file);
-            return 1;
-        }
 
-        // *** Use Big-Endian reader for nonces ***
-        if (!read_uint32_be(bin_fp, &nt_enc2)) {
-            // Should not happen if nt_enc1 read succeeded, unless file is truncated
-            fprintf(stderr, "Error reading nt_enc2 (BE) from binary file body (truncated file?).\n");
-            fclose(bin_fp);
-            fclose(temp_fp);
-            remove(temp_file);
-            return 1;
-        }
-
-        // Read packed parity byte (single byte, no endianness issue)
-        if (!read_uint8(bin_fp, &par_packed)) {
-            // Should not happen if nt_enc2 read succeeded, unless file is truncated
-            fprintf(stderr, "Error reading packed parity from binary file body (truncated file?).\n");
-            fclose(bin_fp);
-            fclose(temp_fp);
-            remove(temp_file);
-            return 1;
-        }
-
-        // Extract individual parities
-        par_enc1 = par_packed >> 4;
-        par_enc2 = par_packed & 0x0F;
+    uint64_t foundkey = 0;
+    int result;
+    if (stream) {
+        printf("Reading nonce batches from stdin\n");
+        fflush(stdout);
+        result = mfnestedhard_stream(uid, bin_fp, &foundkey);
+    } else {
+        printf("Reading nonce data from binary file: %s\n", binary_file_path);
 
-        // Write both nonce/parity pairs to temp file in expected text format
-        if (fprintf(temp_fp, "%u|%u\n", nt_enc1, par_enc1) < 0) {
-            perror("Error writing nt_enc1 pair to temporary file");
-            fclose(bin_fp);
-            fclose(temp_fp);
-            remove(temp_file);
-            return 1;
-        }
-        if (fprintf(temp_fp, "%u|%u\n", nt_enc2, par_enc2) < 0) {
-            perror("Error writing nt_enc2 pair to temporary file");
-            fclose(bin_fp);
-            fclose(temp_fp);
-            remove(temp_file);
+        size_t nonces_processed = 0;
+        hardnested_nonce_t *nonce_list = read_nonce_body(bin_fp, &nonces_processed);
+        fclose(bin_fp);
+        if (nonce_list == NULL) {
             return 1;
         }
+        printf("Processed %zu nonce pairs (total %zu nonces) from binary file.\n", nonces_processed, nonces_processed * 2);
 
-        nonces_processed++;
-    }
-
-    fclose(bin_fp);
-    fclose(temp_fp); // Close temp file so mfnestedhard can read it
-
-    printf("Processed %zu nonce pairs (total %zu nonces) from binary file.\n", nonces_processed, nonces_processed * 2);
-
-    if (nonces_processed == 0) {
-        fprintf(stderr, "Error: No nonce data chunks found in the binary file after the header.\n");
-        remove(temp_file);
-        return 1;
+        // --- Call the core attack function ---
+        // mfnestedhard expects keyType as 0 for A, 1 for B, which matches our enum/byte value
+        result = mfnestedhard(sector, key_type, NULL, 0, 0, NULL, false, false, false, &foundkey, NULL, uid, nonce_list,
+                              (uint32_t)(nonces_processed * 2));
+        free(nonce_list);
     }
 
-    // --- Call the core attack function ---
-    uint64_t foundkey = 0;
-    // mfnestedhard expects keyType as 0 for A, 1 for B, which matches our enum/byte value
-    int result = mfnestedhard(sector, key_type, NULL, 0, 0, NULL, false, false, false, &foundkey, NULL, uid, temp_file);
-
     // --- Report result ---
     if (result == 1) {
         printf("Key found: %012" PRIx64 "\n", foundkey);
@@ -215,8 +293,5 @@ int main(int argc, char *argv[]) {
                uid, sector, (key_type == KEY_A) ? 'A' : 'B');
     }
 
-    // --- Cleanup ---
-    remove(temp_file);
-
     return (result == 1) ? 0 : 1; // Return 0 on success (key found), 1 otherwise
 }
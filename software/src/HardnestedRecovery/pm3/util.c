@@ -17,6 +17,7 @@
 //-----------------------------------------------------------------------------
 
 #include "util.h"
+#include "../../common.h"
 
 #ifdef _WIN32 // Only compile this block on Windows
 
@@ -53,23 +54,7 @@ uint8_t g_debugMode = 0;
 uint8_t g_printAndLog = PRINTANDLOG_PRINT | PRINTANDLOG_LOG;
 // global client tell if a pending prompt is present
 
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <unistd.h>
-#endif
-
 // determine number of logical CPU cores (use for multithreaded functions)
 int num_CPUs(void) {
-#if defined(_WIN32)
-#include <sysinfoapi.h>
-    SYSTEM_INFO sysinfo;
-    GetSystemInfo(&sysinfo);
-    return sysinfo.dwNumberOfProcessors;
-#else
-    int count = sysconf(_SC_NPROCESSORS_ONLN);
-    if (count <= 0)
-        count = 1;
-    return count;
-#endif
+    return num_cpus();
 }
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""
+Offline benchmark of the recovery tools against the known-key vectors of fixtures.json.
+
+Every case runs its steps in a fresh temporary directory, `repeat` times per thread count, and
+passes when the output (and the optional output file) holds all its keys. For each thread count
+the report gives the median wall time, peak RSS of the largest step, candidates/s where the tool
+tells how many candidates it went through, and the speedup over one thread.
+
+Thread counts are set by restricting the CPU affinity of the tools, which size their thread pools
+from it (Linux only, elsewhere the cases run once on all CPUs). `{threads}` in the arguments is
+replaced with the thread count for the tools taking it on the command line. A step still running
+after STEP_TIMEOUT seconds is killed and its case fails.
+
+    python3 run_bench.py --bin-dir ../../script/bin --output bench.json
+
+or `cmake --build . --target bench` which writes bench.json into the build directory.
+"""
+import argparse
+import contextlib
+import datetime
+import json
+import os
+import platform
+import re
+import signal
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from pathlib import Path
+from typing import Optional, Union
+
+STEP_TIMEOUT = 600
+
+
+def find_tool(bin_dir: Path, name: str) -> Path:
+    for candidate in (bin_dir / name, bin_dir / f"{name}.exe"):
+        if candidate.exists():
+            return candidate
+    raise FileNotFoundError(f"{name} not found in {bin_dir}")
+
+
+def thread_counts(limit: Optional[int]) -> list[int]:
+    if not hasattr(os, 'sched_setaffinity'):
+        return [os.cpu_count() or 1]
+    cpus = len(os.sched_getaffinity(0))
+    if limit:
+        cpus = min(cpus, limit)
+    counts = []
+    n = 1
+    while n < cpus:
+        counts.append(n)
+        n *= 2
+    counts.append(cpus)
+    return counts
+
+
+def run_step(cmd: list[str], cwd: str, cpus: Optional[list[int]]) -> tuple[int, str, Optional[int]]:
+    """Runs one step, returns its exit code, output and peak RSS in kB (None where unknown)."""
+    preexec = None
+    if cpus is not None:
+        def preexec():
+            os.sched_setaffinity(0, cpus)
+    with tempfile.TemporaryFile(dir=cwd) as out:
+        proc = subprocess.Popen(cmd, cwd=cwd, stdout=out, stderr=subprocess.STDOUT, preexec_fn=preexec)
+        killed = threading.Event()
+
+        def kill():
+            if proc.returncode is not None:
+                return
+            killed.set()
+            if hasattr(os, 'wait4'):
+                # by pid, Popen.kill could reap the child before wait4 gets its rusage
+                with contextlib.suppress(ProcessLookupError):
+                    os.kill(proc.pid, signal.SIGKILL)
+            else:
+                proc.kill()
+
+        # the wait below returns once the killed step exits
+        timer = threading.Timer(STEP_TIMEOUT, kill)
+        timer.start()
+        try:
+            if hasattr(os, 'wait4'):
+                # wait4 gives the rusage of this child alone
+                _, status, usage = os.wait4(proc.pid, 0)
+                proc.returncode = os.waitstatus_to_exitcode(status)
+                # ru_maxrss is in bytes on macOS, kB elsewhere
+                rss = usage.ru_maxrss // 1024 if sys.platform == 'darwin' else usage.ru_maxrss
+            else:
+                proc.wait()
+                rss = None
+        finally:
+            timer.cancel()
+        out.seek(0)
+        output = out.read().decode(errors='replace')
+        if killed.is_set():
+            output += f"\n{cmd[0]} killed after {STEP_TIMEOUT} s\n"
+        return proc.returncode, output, rss
+
+
+def count_candidates(spec: Union[int, dict, None], output: str) -> Optional[int]:
+    if spec is None or isinstance(spec, int):
+        return spec
+    matches = re.findall(spec['pattern'], output, re.MULTILINE)
+    if not matches:
+        return None
+    return sum(int(m) for m in matches)
+
+
+def run_once(case: dict, bin_dir: Path, threads: int, pin: bool) -> dict:
+    cpus = sorted(os.sched_getaffinity(0))[:threads] if pin else None
+    with tempfile.TemporaryDirectory(prefix=f"bench_{case['name']}_") as cwd:
+        output = ''
+        peak_rss = None
+        start = time.perf_counter()
+        for step in case['steps']:
+            cmd = [str(find_tool(bin_dir, step[0]))] + [arg.replace('{threads}', str(threads)) for arg in step[1:]]
+            code, text, rss = run_step(cmd, cwd, cpus)
+            output += text
+            if rss is not None:
+                peak_rss = max(peak_rss or 0, rss)
+            if code != 0:
+                break
+        wall = time.perf_counter() - start
+        searched = output
+        if 'output' in case and os.path.exists(os.path.join(cwd, case['output'])):
+            with open(os.path.join(cwd, case['output']), errors='replace') as f:
+                searched += f.read()
+    found = all(key.lower() in searched.lower() for key in case['keys'])
+    return {
+        'wall_s': wall,
+        'peak_rss_kb': peak_rss,
+        'candidates': count_candidates(case.get('candidates'), output),
+        'found': found,
+    }
+
+
+def run_case(case: dict, bin_dir: Path, counts: list[int], repeat: Optional[int]) -> dict:
+    pin = hasattr(os, 'sched_setaffinity')
+    runs = []
+    for threads in (counts if case.get('scaling') else counts[-1:]):
+        results = [run_once(case, bin_dir, threads, pin) for _ in range(repeat or case.get('repeat', 3))]
+        wall = statistics.median(r['wall_s'] for r in results)
+        candidates = results[0]['candidates']
+        rss = [r['peak_rss_kb'] for r in results if r['peak_rss_kb'] is not None]
+        runs.append({
+            'threads': threads,
+            'repeat': len(results),
+            'wall_s': round(wall, 6),
+            'wall_s_min': round(min(r['wall_s'] for r in results), 6),
+            'peak_rss_kb': max(rss) if rss else None,
+            'candidates': candidates,
+            'candidates_per_s': round(candidates / wall) if candidates and wall > 0 else None,
+            'found': all(r['found'] for r in results),
+        })
+    for run in runs:
+        run['speedup'] = round(runs[0]['wall_s'] / run['wall_s'], 3) if run['wall_s'] > 0 else None
+    return {
+        'name': case['name'],
+        'tools': sorted({step[0] for step in case['steps']}),
+        'found': all(run['found'] for run in runs),
+        'runs': runs,
+    }
+
+
+def main() -> int:
+    here = Path(__file__).resolve().parent
+    parser = argparse.ArgumentParser(description='Benchmark the recovery tools against known-key vectors')
+    parser.add_argument('--bin-dir', type=Path, default=here.parent.parent / 'script' / 'bin',
+                        help='directory of the built tools')
+    parser.add_argument('--fixtures', type=Path, default=here / 'fixtures.json')
+    parser.add_argument('--output', type=Path, default=Path('bench.json'), help='JSON report')
+    parser.add_argument('--case', action='append', help='only run this case, can be repeated')
+    parser.add_argument('--repeat', type=int, help='override the repeat count of every case')
+    parser.add_argument('--max-threads', type=int, help='highest thread count of the scaling runs')
+    args = parser.parse_args()
+
+    with open(args.fixtures) as f:
+        cases = json.load(f)['cases']
+    if args.case:
+        unknown = set(args.case) - {case['name'] for case in cases}
+        if unknown:
+            parser.error(f"unknown case(s): {', '.join(sorted(unknown))}")
+        cases = [case for case in cases if case['name'] in args.case]
+
+    counts = thread_counts(args.max_threads)
+    results = []
+    for case in cases:
+        result = run_case(case, args.bin_dir, counts, args.repeat)
+        results.append(result)
+        for run in result['runs']:
+            print(f"{result['name']:<18} threads={run['threads']:<3} wall={run['wall_s']:.3f}s "
+                  f"rss={run['peak_rss_kb']}kB cand/s={run['candidates_per_s']} "
+                  f"speedup={run['speedup']} {'ok' if run['found'] else 'KEY NOT FOUND'}")
+
+    report = {
+        'date': datetime.datetime.now(datetime.timezone.utc).isoformat(timespec='seconds'),
+        'host': {
+            'system': platform.system(),
+            'machine': platform.machine(),
+            'processor': platform.processor(),
+            'cpus': os.cpu_count(),
+            'python': platform.python_version(),
+        },
+        'bin_dir': str(args.bin_dir.resolve()),
+        'cases': results,
+    }
+    with open(args.output, 'w') as f:
+        json.dump(report, f, indent=2)
+    print(f"Report written to {args.output}")
+    return 0 if all(result['found'] for result in results) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,5 +1,14 @@
 #include <stdint.h>
 
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sched.h>
+#include "unistd.h"
+#endif
+
+#include "common.h"
+
 
 uint64_t atoui(const char *str) {
 
@@ -18,3 +27,21 @@ void num_to_bytes(uint64_t n, uint32_t len, uint8_t *dest) {
         n >>= 8;
     }
 }
+
+int num_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return sysinfo.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#if defined(CPU_COUNT)
+    // only the CPUs this process may run on, as restricted by taskset or a cpuset
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+        count = CPU_COUNT(&set);
+    }
+#endif
+    return (count > 0) ? count : 1;
+#endif
+}
@@ -3,5 +3,7 @@
 
 uint64_t atoui(const char *str);
 void num_to_bytes(uint64_t n, uint32_t len, uint8_t *dest);
+// logical CPUs this process may run on
+int num_cpus(void);
 
 #endif
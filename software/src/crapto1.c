@@ -18,6 +18,7 @@
     Copyright (C) 2008-2014 bla <blapost@gmail.com>
 */
 #include <stdlib.h>
+#include <string.h>
 #include "parity.h"
 
 #include "crapto1.h"
@@ -126,72 +127,216 @@ recover(uint32_t *o_head, uint32_t *o_tail, uint32_t oks,
 
 
 #if !defined(__arm__) || defined(__linux__) || defined(_WIN32) || defined(__APPLE__) // bare metal ARM Proxmark lacks malloc()/free()
-/** lfsr_recovery
- * recover the state of the lfsr given 32 bits of the keystream
- * additionally you can use the in parameter to specify the value
- * that was fed into the lfsr at the time the keystream was generated
+/** Crypto1Recovery
+ * workspace of lfsr_recovery32, tens of MB that are worth keeping between calls
  */
-struct Crypto1State *lfsr_recovery32(uint32_t ks2, uint32_t in) {
+struct Crypto1Recovery {
+    uint32_t *odd_head, *even_head;
     struct Crypto1State *statelist;
-    uint32_t *odd_head = 0, *odd_tail = 0, oks = 0;
-    uint32_t *even_head = 0, *even_tail = 0, eks = 0;
-    int i;
-
-    // split the keystream into an odd and even part
-    for (i = 31; i >= 0; i -= 2)
-        oks = oks << 1 | BEBIT(ks2, i);
-    for (i = 30; i >= 0; i -= 2)
-        eks = eks << 1 | BEBIT(ks2, i);
+    bucket_array_t bucket;
+    // statelists of one half after its first 5 keystream bits, for the last two patterns
+    // of those bits. Both halves start from the same list for the same pattern.
+    uint32_t *prefix[2];
+    uint32_t prefix_size[2];
+    int prefix_pattern[2];
+};
 
-    odd_head = odd_tail = malloc(sizeof(uint32_t) << 21);
-    even_head = even_tail = malloc(sizeof(uint32_t) << 21);
-    statelist =  malloc(sizeof(struct Crypto1State) << 18);
-    if (!odd_tail-- || !even_tail-- || !statelist) {
-        free(statelist);
-        statelist = 0;
-        goto out;
-    }
+static struct Crypto1Recovery *recovery_alloc(bool with_prefix) {
+    struct Crypto1Recovery *ctx = calloc(1, sizeof(struct Crypto1Recovery));
+    if (!ctx)
+        return 0;
 
-    statelist->odd = statelist->even = 0;
+    ctx->odd_head = malloc(sizeof(uint32_t) << 21);
+    ctx->even_head = malloc(sizeof(uint32_t) << 21);
+    ctx->statelist = malloc(sizeof(struct Crypto1State) << 18);
+    int ok = ctx->odd_head && ctx->even_head && ctx->statelist;
 
     // allocate memory for out of place bucket_sort
-    bucket_array_t bucket;
-
-    for (i = 0; i < 2; i++) {
-        for (uint32_t j = 0; j <= 0xff; j++) {
-            bucket[i][j].head = malloc(sizeof(uint32_t) << 14);
-            if (!bucket[i][j].head) {
-                goto out;
-            }
+    for (int i = 0; ok && i < 2; i++) {
+        for (uint32_t j = 0; ok && j <= 0xff; j++) {
+            ctx->bucket[i][j].head = malloc(sizeof(uint32_t) << 14);
+            ok = ctx->bucket[i][j].head != 0;
         }
     }
 
-    // initialize statelists: add all possible states which would result into the rightmost 2 bits of the keystream
-    for (i = 1 << 20; i >= 0; --i) {
-        if (filter(i) == (oks & 1))
-            *++odd_tail = i;
-        if (filter(i) == (eks & 1))
-            *++even_tail = i;
+    for (int slot = 0; ok && with_prefix && slot < 2; slot++) {
+        ctx->prefix[slot] = malloc(sizeof(uint32_t) << 21);
+        ctx->prefix_pattern[slot] = -1;
+        ok = ctx->prefix[slot] != 0;
     }
 
-    // extend the statelists. Look at the next 8 Bits of the keystream (4 Bit each odd and even):
-    for (i = 0; i < 4; i++) {
-        extend_table_simple(odd_head,  &odd_tail, (oks >>= 1) & 1);
-        extend_table_simple(even_head, &even_tail, (eks >>= 1) & 1);
+    if (!ok) {
+        lfsr_recovery_destroy(ctx);
+        return 0;
+    }
+    return ctx;
+}
+
+struct Crypto1Recovery *lfsr_recovery_create(void) {
+    return recovery_alloc(true);
+}
+
+void lfsr_recovery_destroy(struct Crypto1Recovery *ctx) {
+    if (!ctx)
+        return;
+    for (int i = 0; i < 2; i++)
+        for (uint32_t j = 0; j <= 0xff; j++)
+            free(ctx->bucket[i][j].head);
+    free(ctx->prefix[0]);
+    free(ctx->prefix[1]);
+    free(ctx->odd_head);
+    free(ctx->even_head);
+    free(ctx->statelist);
+    free(ctx);
+}
+
+/** split_keystream
+ * odd and even part of the keystream, its rightmost bits in bit 0
+ */
+static inline void split_keystream(uint32_t ks2, uint32_t *oks, uint32_t *eks) {
+    int i;
+    *oks = *eks = 0;
+    for (i = 31; i >= 0; i -= 2)
+        *oks = *oks << 1 | BEBIT(ks2, i);
+    for (i = 30; i >= 0; i -= 2)
+        *eks = *eks << 1 | BEBIT(ks2, i);
+}
+
+/** prefix_slot
+ * slot of ctx with the statelist after the 5 keystream bits of pattern, which is
+ * built on a miss in the slot other than keep
+ */
+static int prefix_slot(struct Crypto1Recovery *ctx, uint32_t pattern, int keep) {
+    int slot;
+    for (slot = 0; slot < 2; slot++)
+        if (ctx->prefix_pattern[slot] == (int)pattern)
+            return slot;
+
+    slot = keep == 0;
+    uint32_t *head = ctx->prefix[slot], *tail = head - 1, bits = pattern;
+    for (int i = 1 << 20; i >= 0; --i)
+        if (filter(i) == (bits & 1))
+            *++tail = i;
+    for (int i = 0; i < 4; i++)
+        extend_table_simple(head, &tail, (bits >>= 1) & 1);
+    ctx->prefix_size[slot] = tail + 1 - head;
+    ctx->prefix_pattern[slot] = (int)pattern;
+    return slot;
+}
+
+/** lfsr_recovery32_ctx
+ * same as lfsr_recovery32, within the workspace of ctx. The returned list belongs
+ * to ctx and is only valid until its next use.
+ */
+struct Crypto1State *lfsr_recovery32_ctx(struct Crypto1Recovery *ctx, uint32_t ks2, uint32_t in) {
+    uint32_t *odd_head = ctx->odd_head, *odd_tail = ctx->odd_head - 1, oks;
+    uint32_t *even_head = ctx->even_head, *even_tail = ctx->even_head - 1, eks;
+    int i;
+
+    // split the keystream into an odd and even part
+    split_keystream(ks2, &oks, &eks);
+
+    ctx->statelist->odd = ctx->statelist->even = 0;
+
+    if (ctx->prefix[0]) {
+        // the statelists after the rightmost 10 bits of the keystream, kept from an earlier call
+        int even_slot = ctx->prefix_pattern[1] == (int)(eks & 0x1f);
+        int odd_slot = prefix_slot(ctx, oks & 0x1f, even_slot);
+        even_slot = prefix_slot(ctx, eks & 0x1f, odd_slot);
+        memcpy(odd_head, ctx->prefix[odd_slot], sizeof(uint32_t) * ctx->prefix_size[odd_slot]);
+        odd_tail += ctx->prefix_size[odd_slot];
+        memcpy(even_head, ctx->prefix[even_slot], sizeof(uint32_t) * ctx->prefix_size[even_slot]);
+        even_tail += ctx->prefix_size[even_slot];
+        oks >>= 4;
+        eks >>= 4;
+    } else {
+        // initialize statelists: add all possible states which would result into the rightmost 2 bits of the keystream
+        for (i = 1 << 20; i >= 0; --i) {
+            if (filter(i) == (oks & 1))
+                *++odd_tail = i;
+            if (filter(i) == (eks & 1))
+                *++even_tail = i;
+        }
+
+        // extend the statelists. Look at the next 8 Bits of the keystream (4 Bit each odd and even):
+        for (i = 0; i < 4; i++) {
+            extend_table_simple(odd_head,  &odd_tail, (oks >>= 1) & 1);
+            extend_table_simple(even_head, &even_tail, (eks >>= 1) & 1);
+        }
     }
 
     // the statelists now contain all states which could have generated the last 10 Bits of the keystream.
     // 22 bits to go to recover 32 bits in total. From now on, we need to take the "in"
     // parameter into account.
     in = (in >> 16 & 0xff) | (in << 16) | (in & 0xff00); // Byte swapping
-    recover(odd_head, odd_tail, oks, even_head, even_tail, eks, 11, statelist, in << 1, bucket);
+    recover(odd_head, odd_tail, oks, even_head, even_tail, eks, 11, ctx->statelist, in << 1, ctx->bucket);
 
-out:
-    for (i = 0; i < 2; i++)
-        for (uint32_t j = 0; j <= 0xff; j++)
-            free(bucket[i][j].head);
-    free(odd_head);
-    free(even_head);
+    return ctx->statelist;
+}
+
+/** lfsr_recovery32_batch
+ * recover count keystreams in the same workspace, handing each statelist to cb with the
+ * index of its keystream. The keystreams are taken grouped by the patterns of their first
+ * 5 odd and even bits, so the statelists of those bits are built once per group instead of
+ * once per keystream. Stops early when cb returns false, returns the number of lists handed.
+ */
+size_t lfsr_recovery32_batch(struct Crypto1Recovery *ctx, const uint32_t *ks2, const uint32_t *in, size_t count,
+                             lfsr_recovery_cb cb, void *arg) {
+    uint32_t *order = malloc(sizeof(uint32_t) * count);
+    uint32_t *start = calloc(1 << 10 | 1, sizeof(uint32_t));
+    size_t i;
+
+    if (order && start) {
+        // counting sort on the smaller pattern, then the larger one, as either half can use either slot
+        uint16_t *group = malloc(sizeof(uint16_t) * count);
+        if (group) {
+            for (i = 0; i < count; i++) {
+                uint32_t oks, eks;
+                split_keystream(ks2[i], &oks, &eks);
+                oks &= 0x1f;
+                eks &= 0x1f;
+                group[i] = oks < eks ? oks << 5 | eks : eks << 5 | oks;
+                start[group[i] + 1]++;
+            }
+            for (i = 1; i <= 1 << 10; i++)
+                start[i] += start[i - 1];
+            for (i = 0; i < count; i++)
+                order[start[group[i]]++] = i;
+            free(group);
+        } else {
+            free(order);
+            order = 0;
+        }
+    }
+    free(start);
+
+    for (i = 0; i < count; i++) {
+        size_t k = order ? order[i] : i;
+        if (!cb(lfsr_recovery32_ctx(ctx, ks2[k], in ? in[k] : 0), k, arg)) {
+            i++;
+            break;
+        }
+    }
+    free(order);
+    return i;
+}
+
+/** lfsr_recovery
+ * recover the state of the lfsr given 32 bits of the keystream
+ * additionally you can use the in parameter to specify the value
+ * that was fed into the lfsr at the time the keystream was generated
+ */
+struct Crypto1State *lfsr_recovery32(uint32_t ks2, uint32_t in) {
+    struct Crypto1Recovery *ctx = recovery_alloc(false);
+    if (!ctx)
+        return 0;
+
+    lfsr_recovery32_ctx(ctx, ks2, in);
+
+    // hand the statelist over to the caller
+    struct Crypto1State *statelist = ctx->statelist;
+    ctx->statelist = 0;
+    lfsr_recovery_destroy(ctx);
     return statelist;
 }
 
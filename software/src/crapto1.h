@@ -39,6 +39,13 @@ uint32_t prng_successor(uint32_t x, uint32_t n);
 
 #if !defined(__arm__) || defined(__linux__) || defined(_WIN32) || defined(__APPLE__) // bare metal ARM Proxmark lacks malloc()/free()
 struct Crypto1State *lfsr_recovery32(uint32_t ks2, uint32_t in);
+struct Crypto1Recovery;
+typedef bool (*lfsr_recovery_cb)(struct Crypto1State *states, size_t index, void *arg);
+struct Crypto1Recovery *lfsr_recovery_create(void);
+void lfsr_recovery_destroy(struct Crypto1Recovery *ctx);
+struct Crypto1State *lfsr_recovery32_ctx(struct Crypto1Recovery *ctx, uint32_t ks2, uint32_t in);
+size_t lfsr_recovery32_batch(struct Crypto1Recovery *ctx, const uint32_t *ks2, const uint32_t *in, size_t count,
+                             lfsr_recovery_cb cb, void *arg);
 struct Crypto1State *lfsr_recovery64(uint32_t ks2, uint32_t ks3);
 struct Crypto1State *
 lfsr_common_prefix(uint32_t pfx, uint32_t rr, uint8_t ks[8], uint8_t par[8][8], uint32_t no_par);
@@ -4,111 +4,122 @@
 #include <string.h>
 #include <ctype.h>
 
-#include "parity.h"
-#include "crapto1.h"
-#include "mfkey.h"
-#include "common.h"
+#if WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
-typedef struct {
-    uint32_t nt;
-    uint32_t nr;
-    uint32_t ar;
+#include "common.h"
+#include "mfcrack.h"
 
-    uint64_t par_list;
-    uint64_t ks_list;
-} DarksideParam;
+// Binary input on stdin, used without arguments: the MF1_DARKSIDE_ACQUIRE responses after their
+// status byte, 32 bytes each, big endian: uint32_t uid, nt, uint64_t par, ks, uint32_t nr, ar
+#define DARKSIDE_RECORD_SIZE 32
 
-int main(int argc, char *argv[]) {
-
-    if (((argc - 2) % 5) != 0) {
-        printf("Unexpected param count\n");
-        return EXIT_FAILURE;
+static uint64_t get_be(const uint8_t *p, int len) {
+    uint64_t v = 0;
+    for (int i = 0; i < len; i++) {
+        v = (v << 8) | p[i];
     }
-    // Initialize UID
-    uint32_t uid = (uint32_t)atoui(argv[1]);
-    uint32_t count = 0, i, j;
-    uint32_t keycount = 0;
-    uint64_t *keylist = NULL, *last_keylist = NULL;
-    DarksideParam *dps = NULL;
-    bool no_key_recover = true;
+    return v;
+}
 
-    for (i = 1; i + 5 < argc;) {
-        void *pTmp = realloc(dps, sizeof(DarksideParam) * ++count);
-        if (pTmp == NULL) {
-            printf("Can't malloc at param construct.");
-            return EXIT_FAILURE;
+// reads the records of stdin, returns the trace count or -1
+static int32_t read_records(uint32_t *uid, mfcrack_darkside_t **dps) {
+#if WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    uint32_t count = 0, capacity = 16;
+    uint8_t record[DARKSIDE_RECORD_SIZE];
+    *dps = malloc(capacity * sizeof(mfcrack_darkside_t));
+    while (*dps != NULL && fread(record, 1, DARKSIDE_RECORD_SIZE, stdin) == DARKSIDE_RECORD_SIZE) {
+        uint32_t record_uid = (uint32_t)get_be(record, 4);
+        if (count == 0) {
+            *uid = record_uid;
+        } else if (record_uid != *uid) {
+            printf("Traces of different tags\n");
+            free(*dps);
+            return -1;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            void *tmp = realloc(*dps, capacity * sizeof(mfcrack_darkside_t));
+            if (tmp == NULL) {
+                free(*dps);
+                *dps = NULL;
+                break;
+            }
+            *dps = tmp;
         }
-        dps = pTmp;
-        dps[count - 1].nt = (uint32_t)atoui(argv[++i]);
-        dps[count - 1].ks_list = atoui(argv[++i]);
-        dps[count - 1].par_list = atoui(argv[++i]);
-        dps[count - 1].nr = (uint32_t)atoui(argv[++i]);
-        dps[count - 1].ar = (uint32_t)atoui(argv[++i]);
+        (*dps)[count].nt = (uint32_t)get_be(record + 4, 4);
+        (*dps)[count].par_list = get_be(record + 8, 8);
+        (*dps)[count].ks_list = get_be(record + 16, 8);
+        (*dps)[count].nr = (uint32_t)get_be(record + 24, 4);
+        (*dps)[count].ar = (uint32_t)get_be(record + 28, 4);
+        count++;
     }
+    if (*dps == NULL) {
+        printf("Can't malloc at param construct.");
+        return -1;
+    }
+    return count;
+}
 
-    for (i = 0; i < count; i++) {
-        // Initialize NT, NR, AR
-        uint32_t nt = dps[i].nt;
-        uint32_t nr = dps[i].nr;
-        uint32_t ar = dps[i].ar;
-
-        uint64_t par_list = dps[i].par_list;
-        uint64_t ks_list = dps[i].ks_list;
-
-        /*
-        printf("UID = %"PRIu32"\r\n", uid);
-        printf("NT = %"PRIu32"\r\n", nt);
-        printf("KS = %"PRIu64"\r\n", ks_list);
-        printf("PAR = %"PRIu64"\r\n", par_list);
-        printf("NR = %"PRIu32"\r\n", nr);
-        printf("AR = %"PRIu32"\r\n", ar);
-        */
-
-        // start decrypting
-        keycount = nonce2key(uid, nt, nr, ar, par_list, ks_list, &keylist);
+int main(int argc, char *argv[]) {
+    uint32_t uid = 0, count, i, j;
+    mfcrack_darkside_t *dps = NULL;
 
-        if (keycount == 0) {
-            continue;
+    if (argc == 1) {
+        int32_t read = read_records(&uid, &dps);
+        if (read < 0) {
+            return EXIT_FAILURE;
         }
+        count = read;
+    } else {
+        if (((argc - 2) % 5) != 0) {
+            printf("Unexpected param count\n");
+            return EXIT_FAILURE;
+        }
+        // Initialize UID
+        uid = (uint32_t)atoui(argv[1]);
+        count = (argc - 2) / 5;
 
-        // only parity zero attack
-        if (par_list == 0) {
-            qsort(keylist, keycount, sizeof(*keylist), compare_uint64);
-            keycount = intersection(last_keylist, keylist);
-            if (keycount == 0) {
-                free(last_keylist);
-                last_keylist = keylist;
-                continue;
-            }
+        dps = calloc(count + 1, sizeof(mfcrack_darkside_t));
+        if (dps == NULL) {
+            printf("Can't malloc at param construct.");
+            return EXIT_FAILURE;
         }
-        uint8_t key_tmp[6] = { 0 };
-        if (keycount > 0) {
-            no_key_recover = false;
-            for (j = 0; j < keycount; j++) {
-                if (par_list == 0) {
-                    num_to_bytes(last_keylist[j], 6, key_tmp);
-                } else {
-                    num_to_bytes(keylist[j], 6, key_tmp);
-                }
-                printf("Key%d: %02X%02X%02X%02X%02X%02X\r\n", j + 1, key_tmp[0], key_tmp[1], key_tmp[2], key_tmp[3], key_tmp[4], key_tmp[5]);
-            }
+
+        for (i = 0, j = 1; i < count; i++) {
+            dps[i].nt = (uint32_t)atoui(argv[++j]);
+            dps[i].ks_list = atoui(argv[++j]);
+            dps[i].par_list = atoui(argv[++j]);
+            dps[i].nr = (uint32_t)atoui(argv[++j]);
+            dps[i].ar = (uint32_t)atoui(argv[++j]);
         }
     }
 
-    if (no_key_recover) {
+    uint64_t *keylist = NULL;
+    uint32_t *remaining = calloc(count + 1, sizeof(uint32_t));
+    int32_t keycount = remaining ? mfcrack_darkside(uid, dps, count, &keylist, remaining) : -1;
+    free(dps);
+
+    // how far each trace narrowed the candidates down
+    for (i = 0; keycount >= 0 && i < count; i++) {
+        printf("Trace %u: %u candidates\r\n", i + 1, remaining[i]);
+    }
+    free(remaining);
+
+    if (keycount <= 0) {
         printf("key not found\r\n");
     }
 
-    if (last_keylist == keylist && last_keylist != NULL) {
-        free(keylist);
-    } else {
-        if (last_keylist) {
-            free(last_keylist);
-        }
-        if (keylist) {
-            free(keylist);
-        }
+    uint8_t key_tmp[6] = { 0 };
+    for (j = 0; (int32_t)j < keycount; j++) {
+        num_to_bytes(keylist[j], 6, key_tmp);
+        printf("Key%d: %02X%02X%02X%02X%02X%02X\r\n", j + 1, key_tmp[0], key_tmp[1], key_tmp[2], key_tmp[3], key_tmp[4], key_tmp[5]);
     }
-    free(dps);
+
+    mfcrack_free(keylist);
     return EXIT_SUCCESS;
 }
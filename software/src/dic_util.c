@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if WIN32
+#include "windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "unistd.h"
+#endif
+
+#include "dic_util.h"
+
+#define KEY_DIC_KEY_SIZE 6
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// Whole file in memory: mapped where possible, read otherwise. NULL on error.
+static uint8_t *map_file(const char *filename, size_t *size) {
+    static uint8_t empty[1];
+#if WIN32
+    FILE *fptr = fopen(filename, "rb");
+    if (fptr == NULL) {
+        return NULL;
+    }
+    fseek(fptr, 0, SEEK_END);
+    long len = ftell(fptr);
+    rewind(fptr);
+    if (len <= 0) {
+        fclose(fptr);
+        *size = 0;
+        return (len == 0) ? empty : NULL;
+    }
+    uint8_t *data = malloc(len);
+    if ((data == NULL) || (fread(data, 1, len, fptr) != (size_t)len)) {
+        free(data);
+        fclose(fptr);
+        return NULL;
+    }
+    fclose(fptr);
+    *size = len;
+    return data;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    *size = st.st_size;
+    if (*size == 0) {
+        close(fd);
+        return empty;
+    }
+    uint8_t *data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(data, *size, MADV_SEQUENTIAL);
+    return data;
+#endif
+}
+
+static void unmap_file(uint8_t *data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+#if WIN32
+    free(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+static int hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool is_space(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Same keys as fscanf("%012" PRIx64) in a loop: up to 12 hex digits per key, stops at garbage.
+static uint32_t parse_text_keys(const uint8_t *data, size_t size, uint64_t *keys) {
+    uint32_t count = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        while (pos < size && is_space(data[pos])) {
+            pos++;
+        }
+        if (pos == size || hex_value(data[pos]) < 0) {
+            break;
+        }
+        uint64_t key = 0;
+        for (int digits = 0; digits < 12 && pos < size && hex_value(data[pos]) >= 0; digits++, pos++) {
+            key = (key << 4) | hex_value(data[pos]);
+        }
+        if (keys != NULL) {
+            keys[count] = key;
+        }
+        count++;
+    }
+    return count;
+}
+
+uint64_t *load_key_dic(const char *filename, KeyDicInfo *info, uint32_t *keyCount) {
+    size_t size = 0;
+    uint8_t *data = map_file(filename, &size);
+    if (data == NULL) {
+        fprintf(stderr, "Warning: Cannot open %s\n", filename);
+        return NULL;
+    }
+
+    memset(info, 0, sizeof(KeyDicInfo));
+    uint64_t *keys = NULL;
+    if (size >= KEY_DIC_HEADER_SIZE && memcmp(data, KEY_DIC_MAGIC, 8) == 0) {
+        uint32_t count = get_le32(data + 24);
+        if (get_le32(data + 8) != KEY_DIC_VERSION ||
+                (size - KEY_DIC_HEADER_SIZE) / KEY_DIC_KEY_SIZE < count) {
+            fprintf(stderr, "Error: %s is not a valid key dictionary\n", filename);
+            unmap_file(data, size);
+            return NULL;
+        }
+        info->binary = true;
+        info->uid = get_le32(data + 12);
+        info->sector = get_le32(data + 16);
+        info->nt = get_le32(data + 20);
+
+        keys = (uint64_t *)calloc(count + 1, sizeof(uint64_t));
+        if (keys != NULL) {
+            const uint8_t *p = data + KEY_DIC_HEADER_SIZE;
+            for (uint32_t i = 0; i < count; i++, p += KEY_DIC_KEY_SIZE) {
+                keys[i] = ((uint64_t)p[0] << 40) | ((uint64_t)p[1] << 32) | ((uint64_t)p[2] << 24) |
+                          ((uint64_t)p[3] << 16) | ((uint64_t)p[4] << 8) | p[5];
+            }
+            *keyCount = count;
+        }
+    } else {
+        uint32_t count = parse_text_keys(data, size, NULL);
+        keys = (uint64_t *)calloc(count + 1, sizeof(uint64_t));
+        if (keys != NULL) {
+            parse_text_keys(data, size, keys);
+            *keyCount = count;
+        }
+    }
+    if (keys == NULL) {
+        perror("Failed to allocate memory");
+    }
+
+    unmap_file(data, size);
+    return keys;
+}
+
+bool save_key_dic(const char *filename, const KeyDicInfo *info, const uint64_t *keys, uint32_t keyCount) {
+    static const char hex[] = "0123456789abcdef";
+    size_t size = info->binary ? KEY_DIC_HEADER_SIZE + (size_t)keyCount * KEY_DIC_KEY_SIZE : (size_t)keyCount * 13;
+    uint8_t *buf = malloc(size + 1);
+    if (buf == NULL) {
+        perror("Failed to allocate memory");
+        return false;
+    }
+
+    uint8_t *p = buf;
+    if (info->binary) {
+        memcpy(p, KEY_DIC_MAGIC, 8);
+        put_le32(p + 8, KEY_DIC_VERSION);
+        put_le32(p + 12, info->uid);
+        put_le32(p + 16, info->sector);
+        put_le32(p + 20, info->nt);
+        put_le32(p + 24, keyCount);
+        put_le32(p + 28, 0);
+        p += KEY_DIC_HEADER_SIZE;
+        for (uint32_t i = 0; i < keyCount; i++) {
+            for (int b = 5; b >= 0; b--) {
+                *p++ = keys[i] >> (8 * b);
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < keyCount; i++) {
+            for (int d = 11; d >= 0; d--) {
+                *p++ = hex[(keys[i] >> (4 * d)) & 0xF];
+            }
+            *p++ = '\n';
+        }
+    }
+
+    FILE *fptr = fopen(filename, info->binary ? "wb" : "w");
+    bool ok = (fptr != NULL);
+    if (ok) {
+        ok = fwrite(buf, 1, size, fptr) == size;
+        ok = (fclose(fptr) == 0) && ok;
+    }
+    if (!ok) {
+        fprintf(stderr, "Warning: Cannot save keys in %s\n", filename);
+    }
+    free(buf);
+    return ok;
+}
@@ -0,0 +1,35 @@
+#ifndef DIC_UTIL_H__
+#define DIC_UTIL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Key candidate dictionaries (keys_<uid>_<sector>_<nt>.dic)
+//
+// Binary layout, all fields little endian:
+//   char     magic[8]    "MFKEYDIC"
+//   uint32_t version     KEY_DIC_VERSION
+//   uint32_t uid
+//   uint32_t sector
+//   uint32_t nt
+//   uint32_t count
+//   uint32_t reserved
+//   count * 6 bytes      48-bit keys, big endian like their hex form
+//
+// The text form is one %012x key per line. Loaders accept both.
+
+#define KEY_DIC_MAGIC       "MFKEYDIC"
+#define KEY_DIC_VERSION     1
+#define KEY_DIC_HEADER_SIZE 32
+
+typedef struct {
+    bool binary;
+    uint32_t uid;
+    uint32_t sector;
+    uint32_t nt;
+} KeyDicInfo;
+
+uint64_t *load_key_dic(const char *filename, KeyDicInfo *info, uint32_t *keyCount);
+bool save_key_dic(const char *filename, const KeyDicInfo *info, const uint64_t *keys, uint32_t keyCount);
+
+#endif
@@ -0,0 +1,126 @@
+// Time per candidate and peak RSS of lfsr_recovery32, with a fresh allocation per
+// candidate (alloc), a reused workspace (ctx) or the batch entry point (batch).
+// Peak RSS is per process, so run one mode per invocation to compare them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#define PSAPI_VERSION 2
+#include <psapi.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+#include "crapto1.h"
+
+static uint64_t usclock(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart * 1000000 / freq.QuadPart);
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+#endif
+}
+
+static uint64_t peak_rss_kb(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return pmc.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static uint64_t count_states(const struct Crypto1State *states) {
+    uint64_t count = 0;
+    for (; states->odd | states->even; states++) {
+        count++;
+    }
+    return count;
+}
+
+static bool count_batch_states(struct Crypto1State *states, size_t index, void *arg) {
+    (void)index;
+    *(uint64_t *)arg += count_states(states);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || (strcmp(argv[1], "alloc") && strcmp(argv[1], "ctx") && strcmp(argv[1], "batch"))) {
+        printf("Usage:\n  %s <alloc|ctx|batch> [candidates]\n", argv[0]);
+        return 1;
+    }
+    const char *mode = argv[1];
+    uint32_t count = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 64;
+    if (count == 0) {
+        count = 1;
+    }
+
+    uint32_t *ks2 = calloc(count, sizeof(uint32_t));
+    uint32_t *in = calloc(count, sizeof(uint32_t));
+    if ((ks2 == NULL) || (in == NULL)) {
+        perror("Failed to allocate memory");
+        return 1;
+    }
+    // fixed pseudo random candidates, so every mode does the same work
+    uint32_t x = 0x12345678;
+    for (uint32_t i = 0; i < count; i++) {
+        x = x * 1103515245 + 12345;
+        ks2[i] = x;
+        x = x * 1103515245 + 12345;
+        in[i] = x;
+    }
+
+    uint64_t states = 0;
+    uint64_t start = usclock();
+    if (strcmp(mode, "alloc") == 0) {
+        for (uint32_t i = 0; i < count; i++) {
+            struct Crypto1State *s = lfsr_recovery32(ks2[i], in[i]);
+            if (s == NULL) {
+                perror("lfsr_recovery32");
+                return 1;
+            }
+            states += count_states(s);
+            free(s);
+        }
+    } else {
+        struct Crypto1Recovery *ctx = lfsr_recovery_create();
+        if (ctx == NULL) {
+            perror("lfsr_recovery_create");
+            return 1;
+        }
+        if (strcmp(mode, "ctx") == 0) {
+            for (uint32_t i = 0; i < count; i++) {
+                states += count_states(lfsr_recovery32_ctx(ctx, ks2[i], in[i]));
+            }
+        } else {
+            lfsr_recovery32_batch(ctx, ks2, in, count, count_batch_states, &states);
+        }
+        lfsr_recovery_destroy(ctx);
+    }
+    uint64_t elapsed = usclock() - start;
+
+    printf("mode=%s candidates=%u states=%" PRIu64 " ms_per_candidate=%.3f peak_rss_kb=%" PRIu64 "\n",
+           mode, count, states, elapsed / 1000.0 / count, peak_rss_kb());
+    free(ks2);
+    free(in);
+    return 0;
+}
@@ -0,0 +1,730 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "pthread.h"
+#include "common.h"
+#include "crapto1.h"
+#include "parity.h"
+#include "mfkey.h"
+#include "nested_util.h"
+#include "rf08s_util.h"
+#include "mfulc_des_search.h"
+#include "mfcrack.h"
+
+int mfcrack_api_version(void) {
+    return MFCRACK_API_VERSION;
+}
+
+void mfcrack_free(void *ptr) {
+    free(ptr);
+}
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// upper bound of the worker threads of this thread's calls, 0 for one per core
+static THREAD_LOCAL uint32_t max_threads = 0;
+
+void mfcrack_set_max_threads(uint32_t threads) {
+    max_threads = threads;
+}
+
+// key candidates the last nested, staticnested, mfkey32v2, rf08s or mfulc call of this thread went through
+static THREAD_LOCAL uint64_t last_candidates = 0;
+
+uint64_t mfcrack_last_candidates(void) {
+    return last_candidates;
+}
+
+static uint32_t mfcrack_num_cpus(void) {
+    uint32_t cpus = num_cpus();
+    return (max_threads && max_threads < cpus) ? max_threads : cpus;
+}
+
+int32_t mfcrack_nested(uint32_t uid, uint32_t dist, const mfcrack_nested_nonce_t *nonces, uint32_t count,
+                       uint64_t **keys) {
+    *keys = NULL;
+    last_candidates = 0;
+    if (dist < 14) {
+        return -1;
+    }
+
+    // at most 29 candidates (dist +/- 14) per nonce
+    NtpKs1 *pNK = calloc((size_t)count * 29 + 1, sizeof(NtpKs1));
+    if (pNK == NULL) {
+        return -1;
+    }
+
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t par_arr[3];
+        for (uint32_t m = 0; m < 3; m++) {
+            par_arr[m] = (nonces[i].par >> m) & 0x01;
+        }
+        // Try to recover the keystream1
+        uint32_t nttest = prng_successor(nonces[i].nt, dist - 14);
+        for (uint32_t m = dist - 14; m <= dist + 14; m += 1) {
+            uint32_t ks1 = nonces[i].nt_enc ^ nttest;
+            if (valid_nonce(nttest, nonces[i].nt_enc, ks1, par_arr)) {
+                pNK[j].ntp = nttest;
+                pNK[j].ks1 = ks1;
+                j++;
+            }
+            nttest = prng_successor(nttest, 1);
+        }
+    }
+
+    uint32_t keyCount = 0;
+    if (j > 0) {
+        *keys = nested(pNK, j, uid, &keyCount, &last_candidates, mfcrack_num_cpus());
+    }
+    free(pNK);
+    return keyCount;
+}
+
+int32_t mfcrack_staticnested(uint32_t uid, uint8_t key_type, const mfcrack_static_nonce_t *nonces, uint32_t count,
+                             uint64_t **keys) {
+    *keys = NULL;
+    last_candidates = 0;
+    if (count == 0) {
+        return 0;
+    }
+
+    // Which generation of static tag is detected.
+    uint32_t dist;
+    if (nonces[0].nt == 0x01200145) {
+        // There is no loophole in this generation.
+        // This tag can be decrypted with the default parameter value 160!
+        dist = 160; // st gen1
+    } else if (nonces[0].nt == 0x009080A2) {   // st gen2
+        // We found that the gen2 tag is vulnerable too but parameter must be adapted depending on the attacked key
+        if (key_type == 0x61) {
+            dist = 161;
+        } else if (key_type == 0x60) {
+            dist = 160;
+        } else {
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+
+    NtpKs1 *pNK = calloc(count, sizeof(NtpKs1));
+    if (pNK == NULL) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t nttest = prng_successor(nonces[i].nt, dist);
+        pNK[i].ntp = nttest;
+        pNK[i].ks1 = nonces[i].nt_enc ^ nttest;
+        dist += 160;
+    }
+
+    uint32_t keyCount = 0;
+    *keys = nested(pNK, count, uid, &keyCount, &last_candidates, mfcrack_num_cpus());
+    free(pNK);
+    return keyCount;
+}
+
+// open addressing set of 48-bit keys, UINT64_MAX marks an empty slot
+typedef struct {
+    uint64_t *slots;
+    uint32_t mask;
+} KeySet;
+
+static bool key_set_init(KeySet *set, uint32_t count) {
+    uint32_t size = 16;
+    while (size < 2 * count) {
+        size <<= 1;
+    }
+    set->mask = size - 1;
+    set->slots = malloc(size * sizeof(uint64_t));
+    if (set->slots == NULL) {
+        return false;
+    }
+    memset(set->slots, 0xFF, size * sizeof(uint64_t));
+    return true;
+}
+
+static uint32_t key_set_slot(const KeySet *set, uint64_t key) {
+    uint32_t i = (uint32_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & set->mask;
+    while (set->slots[i] != key && set->slots[i] != UINT64_MAX) {
+        i = (i + 1) & set->mask;
+    }
+    return i;
+}
+
+// false if the key was already in the set
+static bool key_set_add(KeySet *set, uint64_t key) {
+    uint32_t i = key_set_slot(set, key);
+    if (set->slots[i] == key) {
+        return false;
+    }
+    set->slots[i] = key;
+    return true;
+}
+
+static bool key_set_contains(const KeySet *set, uint64_t key) {
+    return set->slots[key_set_slot(set, key)] == key;
+}
+
+typedef struct {
+    uint32_t uid;
+    const mfcrack_darkside_t *params;
+    uint32_t count;
+    uint64_t **keylists;            // candidates of each trace, -1 terminated
+    uint32_t *keycounts;
+    uint32_t next;                  // next trace to decrypt
+    pthread_mutex_t lock;
+} DarksideJob;
+
+static void *darkside_worker(void *arg) {
+    DarksideJob *job = (DarksideJob *)arg;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        uint32_t i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->count) {
+            return NULL;
+        }
+        const mfcrack_darkside_t *dp = &job->params[i];
+        job->keycounts[i] = nonce2key(job->uid, dp->nt, dp->nr, dp->ar, dp->par_list, dp->ks_list, &job->keylists[i]);
+    }
+}
+
+int32_t mfcrack_darkside(uint32_t uid, const mfcrack_darkside_t *params, uint32_t count, uint64_t **keys,
+                         uint32_t *remaining) {
+    *keys = NULL;
+    if (count == 0) {
+        return 0;
+    }
+
+    // the traces are independent, each thread takes the next one
+    DarksideJob job = {
+        .uid = uid, .params = params, .count = count,
+        .keylists = calloc(count, sizeof(uint64_t *)), .keycounts = calloc(count, sizeof(uint32_t)), .next = 0
+    };
+    uint32_t threadCount = mfcrack_num_cpus();
+    if (threadCount > count) {
+        threadCount = count;
+    }
+    pthread_t *threads = calloc(threadCount, sizeof(pthread_t));
+    if ((job.keylists == NULL) || (job.keycounts == NULL) || (threads == NULL)) {
+        free(job.keylists);
+        free(job.keycounts);
+        free(threads);
+        return -1;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+    for (uint32_t t = 0; t < threadCount; t++) {
+        pthread_create(&threads[t], NULL, darkside_worker, &job);
+    }
+    for (uint32_t t = 0; t < threadCount; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_mutex_destroy(&job.lock);
+    free(threads);
+
+    // Parity zero traces narrow the candidates down, in acquisition order: the running set is
+    // replaced by the trace candidates when they have nothing in common. Other traces stand on
+    // their own. The candidates left after the last trace are returned, without duplicates.
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        total += job.keycounts[i];
+    }
+    uint64_t *survivors = malloc((total ? total : 1) * sizeof(uint64_t));
+    uint32_t survivor_count = 0;
+    const uint64_t *current = NULL;
+    uint32_t current_count = 0;
+    bool ok = (survivors != NULL);
+    for (uint32_t i = 0; ok && i < count; i++) {
+        const uint64_t *keylist = job.keylists[i];
+        uint32_t keycount = job.keycounts[i];
+        if (keycount == 0 || params[i].par_list != 0) {
+            // only parity zero attack
+            if (keycount) {
+                current = keylist;
+                current_count = keycount;
+            }
+            if (remaining != NULL) {
+                remaining[i] = current_count;
+            }
+            continue;
+        }
+
+        KeySet trace = { 0 };
+        if (!key_set_init(&trace, keycount)) {
+            ok = false;
+            break;
+        }
+        uint32_t common = 0;
+        if (survivor_count) {
+            for (uint32_t k = 0; k < keycount; k++) {
+                key_set_add(&trace, keylist[k]);
+            }
+            for (uint32_t k = 0; k < survivor_count; k++) {
+                if (key_set_contains(&trace, survivors[k])) {
+                    survivors[common++] = survivors[k];
+                }
+            }
+        }
+        if (common) {
+            survivor_count = common;
+        } else {
+            // nothing in common, start over from this trace
+            memset(trace.slots, 0xFF, (trace.mask + 1) * sizeof(uint64_t));
+            survivor_count = 0;
+            for (uint32_t k = 0; k < keycount; k++) {
+                if (key_set_add(&trace, keylist[k])) {
+                    survivors[survivor_count++] = keylist[k];
+                }
+            }
+        }
+        free(trace.slots);
+        current = survivors;
+        current_count = survivor_count;
+        if (remaining != NULL) {
+            remaining[i] = survivor_count;
+        }
+    }
+
+    uint64_t *found = malloc((current_count ? current_count : 1) * sizeof(uint64_t));
+    uint32_t found_count = 0;
+    KeySet seen = { 0 };
+    ok = ok && (found != NULL) && key_set_init(&seen, current_count);
+    for (uint32_t k = 0; ok && k < current_count; k++) {
+        if (key_set_add(&seen, current[k])) {
+            found[found_count++] = current[k];
+        }
+    }
+    if (ok && remaining != NULL) {
+        // the last trace may list a key twice
+        remaining[count - 1] = found_count;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        free(job.keylists[i]);
+    }
+    free(job.keylists);
+    free(job.keycounts);
+    free(survivors);
+    free(seen.slots);
+    if (!ok) {
+        free(found);
+        return -1;
+    }
+    *keys = found;
+    return found_count;
+}
+
+// first key of the states recovered from ar0_enc that also produces the second authentication
+// tested, if not NULL, gets the number of states tried
+static bool mfkey32v2_states(struct Crypto1State *s, uint32_t uid, uint32_t nt0, uint32_t nr0_enc,
+                             uint32_t nt1, uint32_t nr1_enc, uint32_t ar1_enc, uint64_t *key, uint64_t *tested) {
+    struct Crypto1State *t;
+    uint32_t p64b = prng_successor(nt1, 64);
+
+    for (t = s; t->odd | t->even; ++t) {
+        if (tested != NULL) {
+            (*tested)++;
+        }
+        lfsr_rollback_word(t, 0, 0);
+        lfsr_rollback_word(t, nr0_enc, 1);
+        lfsr_rollback_word(t, uid ^ nt0, 0);
+        crypto1_get_lfsr(t, key);
+
+        crypto1_word(t, uid ^ nt1, 0);
+        crypto1_word(t, nr1_enc, 1);
+        if (ar1_enc == (crypto1_word(t, 0, 0) ^ p64b)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool mfcrack_mfkey32v2(uint32_t uid, uint32_t nt0, uint32_t nr0_enc, uint32_t ar0_enc,
+                       uint32_t nt1, uint32_t nr1_enc, uint32_t ar1_enc, uint64_t *key) {
+    // Generate lfsr successors of the tag challenge
+    uint32_t p64 = prng_successor(nt0, 64);
+
+    last_candidates = 0;
+    struct Crypto1State *s = lfsr_recovery32(ar0_enc ^ p64, 0);
+    if (s == NULL) {
+        return false;
+    }
+    bool found = mfkey32v2_states(s, uid, nt0, nr0_enc, nt1, nr1_enc, ar1_enc, key, &last_candidates);
+    free(s);
+    return found;
+}
+
+// whether the reader of this authentication used key
+// crypto1_word() steps inlined, stopping at the first bit of ks2 that does not give the expected ar
+static bool reader_has_key(const mfcrack_auth_t *auth, uint64_t key) {
+    struct Crypto1State s;
+    crypto1_init(&s, key);
+    uint32_t odd = s.odd, even = s.even, t;
+    uint32_t uid_nt = auth->uid ^ auth->nt;
+    uint32_t ks2 = auth->ar_enc ^ prng_successor(auth->nt, 64);
+
+    for (int i = 0; i < 32; i++) {
+        even = even << 1 | evenparity32(BEBIT(uid_nt, i) ^ (LF_POLY_ODD & odd) ^ (LF_POLY_EVEN & even));
+        t = odd, odd = even, even = t;
+    }
+    for (int i = 0; i < 32; i++) {
+        uint32_t feedin = filter(odd) ^ BEBIT(auth->nr_enc, i);
+        even = even << 1 | evenparity32(feedin ^ (LF_POLY_ODD & odd) ^ (LF_POLY_EVEN & even));
+        t = odd, odd = even, even = t;
+    }
+    for (int i = 0; i < 32; i++) {
+        if ((uint32_t)filter(odd) != BEBIT(ks2, i)) {
+            return false;
+        }
+        even = even << 1 | evenparity32((LF_POLY_ODD & odd) ^ (LF_POLY_EVEN & even));
+        t = odd, odd = even, even = t;
+    }
+    return true;
+}
+
+typedef struct {
+    const mfcrack_auth_t **auths;   // distinct auths of one uid/block/key type
+    bool *found;                    // auth explained by one of the keys
+    uint32_t size;
+    uint64_t *keys;
+    uint32_t keyCount;
+    uint32_t next_i, next_j;        // next pair to crack
+    bool failed;
+    pthread_mutex_t lock;
+} LogGroup;
+
+// adds key if new and marks the auths it explains, called with the lock held
+static bool log_group_add_key(LogGroup *g, uint64_t key) {
+    for (uint32_t k = 0; k < g->keyCount; k++) {
+        if (g->keys[k] == key) {
+            return true;
+        }
+    }
+    bool used = false;
+    for (uint32_t i = 0; i < g->size; i++) {
+        if (!g->found[i] && reader_has_key(g->auths[i], key)) {
+            g->found[i] = true;
+            used = true;
+        }
+    }
+    if (used) {
+        // a group holds at most one key per auth
+        g->keys[g->keyCount++] = key;
+    }
+    return used;
+}
+
+// next pair where neither auth is explained yet, pairs are only built on demand
+static bool log_group_next_pair(LogGroup *g, uint32_t *i, uint32_t *j) {
+    bool ok = false;
+    pthread_mutex_lock(&g->lock);
+    while (!g->failed && g->next_i + 1 < g->size) {
+        if (g->found[g->next_i] || g->next_j >= g->size) {
+            g->next_i++;
+            g->next_j = g->next_i + 1;
+            continue;
+        }
+        uint32_t next_j = g->next_j++;
+        if (!g->found[next_j]) {
+            *i = g->next_i;
+            *j = next_j;
+            ok = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g->lock);
+    return ok;
+}
+
+static void *log_group_worker(void *arg) {
+    LogGroup *g = (LogGroup *)arg;
+    uint32_t i, j;
+
+    // one recovery workspace per thread, reused for all its pairs
+    struct Crypto1Recovery *ctx = lfsr_recovery_create();
+    if (ctx == NULL) {
+        pthread_mutex_lock(&g->lock);
+        g->failed = true;
+        pthread_mutex_unlock(&g->lock);
+        return NULL;
+    }
+
+    while (log_group_next_pair(g, &i, &j)) {
+        const mfcrack_auth_t *a0 = g->auths[i], *a1 = g->auths[j];
+        uint64_t key;
+        struct Crypto1State *s = lfsr_recovery32_ctx(ctx, a0->ar_enc ^ prng_successor(a0->nt, 64), 0);
+        if (mfkey32v2_states(s, a0->uid, a0->nt, a0->nr_enc, a1->nt, a1->nr_enc, a1->ar_enc, &key, NULL)) {
+            pthread_mutex_lock(&g->lock);
+            log_group_add_key(g, key);
+            pthread_mutex_unlock(&g->lock);
+        }
+    }
+    lfsr_recovery_destroy(ctx);
+    return NULL;
+}
+
+typedef struct {
+    const mfcrack_auth_t *auths;
+    uint32_t count;
+    const uint64_t *keys;
+    uint32_t first_key, last_key;   // rows of the match matrix handled by this thread
+    uint8_t *matches;
+    uint32_t matchCount;
+} KeyTestRange;
+
+static void *key_test_worker(void *arg) {
+    KeyTestRange *r = (KeyTestRange *)arg;
+    for (uint32_t k = r->first_key; k < r->last_key; k++) {
+        uint8_t *row = r->matches + (size_t)k * r->count;
+        for (uint32_t i = 0; i < r->count; i++) {
+            row[i] = reader_has_key(&r->auths[i], r->keys[k]);
+            r->matchCount += row[i];
+        }
+    }
+    return NULL;
+}
+
+int32_t mfcrack_test_keys(const mfcrack_auth_t *auths, uint32_t count, const uint64_t *keys, uint32_t key_count,
+                          uint8_t *matches) {
+    if (((auths == NULL) && count) || ((keys == NULL) && key_count) || ((matches == NULL) && count && key_count)) {
+        return -1;
+    }
+
+    // small matrices are not worth a thread
+    uint32_t threadCount = ((uint64_t)count * key_count < 4096) ? 1 : mfcrack_num_cpus();
+    if (threadCount > key_count) {
+        threadCount = key_count ? key_count : 1;
+    }
+    KeyTestRange *ranges = calloc(threadCount, sizeof(KeyTestRange));
+    pthread_t *threads = calloc(threadCount, sizeof(pthread_t));
+    if ((ranges == NULL) || (threads == NULL)) {
+        free(ranges);
+        free(threads);
+        return -1;
+    }
+    for (uint32_t t = 0; t < threadCount; t++) {
+        ranges[t].auths = auths;
+        ranges[t].count = count;
+        ranges[t].keys = keys;
+        ranges[t].first_key = (uint32_t)((uint64_t)key_count * t / threadCount);
+        ranges[t].last_key = (uint32_t)((uint64_t)key_count * (t + 1) / threadCount);
+        ranges[t].matches = matches;
+    }
+    if (threadCount == 1) {
+        key_test_worker(&ranges[0]);
+    } else {
+        for (uint32_t t = 0; t < threadCount; t++) {
+            pthread_create(&threads[t], NULL, key_test_worker, &ranges[t]);
+        }
+        for (uint32_t t = 0; t < threadCount; t++) {
+            pthread_join(threads[t], NULL);
+        }
+    }
+
+    int32_t matchCount = 0;
+    for (uint32_t t = 0; t < threadCount; t++) {
+        matchCount += ranges[t].matchCount;
+    }
+    free(ranges);
+    free(threads);
+    return matchCount;
+}
+
+static bool same_group(const mfcrack_auth_t *a, const mfcrack_auth_t *b) {
+    return a->uid == b->uid && a->block == b->block && a->key_type == b->key_type;
+}
+
+static bool same_auth(const mfcrack_auth_t *a, const mfcrack_auth_t *b) {
+    return same_group(a, b) && a->nt == b->nt && a->nr_enc == b->nr_enc && a->ar_enc == b->ar_enc;
+}
+
+static int compare_log_keys(const void *a, const void *b) {
+    uint64_t ka = ((const mfcrack_log_key_t *)a)->key, kb = ((const mfcrack_log_key_t *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+int32_t mfcrack_mfkey32_log(const mfcrack_auth_t *auths, uint32_t count, mfcrack_log_key_t **keys) {
+    *keys = NULL;
+    if (count == 0) {
+        return 0;
+    }
+
+    const mfcrack_auth_t **order = calloc(count, sizeof(mfcrack_auth_t *));
+    bool *found = calloc(count, sizeof(bool));
+    uint64_t *group_keys = calloc(count, sizeof(uint64_t));
+    mfcrack_log_key_t *result = calloc(count, sizeof(mfcrack_log_key_t));
+    uint32_t manyThread = mfcrack_num_cpus();
+    pthread_t *threads = calloc(manyThread, sizeof(pthread_t));
+    if ((order == NULL) || (found == NULL) || (group_keys == NULL) || (result == NULL) || (threads == NULL)) {
+        free(order);
+        free(found);
+        free(group_keys);
+        free(result);
+        free(threads);
+        return -1;
+    }
+
+    // Groups in log order: by uid, then by block, key A before key B, so the keys of a uid
+    // are known before its later groups are cracked. Duplicated auths are dropped.
+    uint32_t ordered = 0;
+    for (uint32_t u = 0; u < count; u++) {
+        bool uid_seen = false;
+        for (uint32_t p = 0; p < u && !uid_seen; p++) {
+            uid_seen = auths[p].uid == auths[u].uid;
+        }
+        if (uid_seen) {
+            continue;
+        }
+        for (uint32_t b = u; b < count; b++) {
+            bool block_seen = auths[b].uid != auths[u].uid;
+            for (uint32_t p = u; p < b && !block_seen; p++) {
+                block_seen = auths[p].uid == auths[u].uid && auths[p].block == auths[b].block;
+            }
+            if (block_seen) {
+                continue;
+            }
+            for (uint8_t type = 0; type < 2; type++) {
+                for (uint32_t i = b; i < count; i++) {
+                    if (auths[i].uid != auths[b].uid || auths[i].block != auths[b].block || auths[i].key_type != type) {
+                        continue;
+                    }
+                    bool dup = false;
+                    for (uint32_t k = ordered; k > 0 && !dup && same_group(order[k - 1], &auths[i]); k--) {
+                        dup = same_auth(order[k - 1], &auths[i]);
+                    }
+                    if (!dup) {
+                        order[ordered++] = &auths[i];
+                    }
+                }
+            }
+        }
+    }
+
+    uint32_t resultCount = 0;
+    bool failed = false;
+    for (uint32_t start = 0, end; start < ordered && !failed; start = end) {
+        for (end = start + 1; end < ordered && same_group(order[start], order[end]); end++);
+
+        LogGroup g = {
+            .auths = order + start, .found = found + start, .size = end - start,
+            .keys = group_keys, .keyCount = 0, .next_i = 0, .next_j = 1, .failed = false
+        };
+        pthread_mutex_init(&g.lock, NULL);
+
+        // keys already found for this uid first
+        for (uint32_t r = 0; r < resultCount; r++) {
+            if (result[r].uid == order[start]->uid) {
+                log_group_add_key(&g, result[r].key);
+            }
+        }
+
+        uint32_t threadCount = manyThread;
+        if (threadCount > g.size) {
+            threadCount = g.size;
+        }
+        for (uint32_t t = 0; t < threadCount; t++) {
+            pthread_create(&threads[t], NULL, log_group_worker, &g);
+        }
+        for (uint32_t t = 0; t < threadCount; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        pthread_mutex_destroy(&g.lock);
+        failed = g.failed;
+
+        uint32_t first = resultCount;
+        for (uint32_t k = 0; k < g.keyCount; k++) {
+            result[resultCount].uid = order[start]->uid;
+            result[resultCount].block = order[start]->block;
+            result[resultCount].key_type = order[start]->key_type;
+            result[resultCount].key = g.keys[k];
+            resultCount++;
+        }
+        // threads find keys in any order
+        qsort(result + first, resultCount - first, sizeof(mfcrack_log_key_t), compare_log_keys);
+    }
+
+    free(order);
+    free(found);
+    free(group_keys);
+    free(threads);
+    if (failed) {
+        free(result);
+        return -1;
+    }
+    *keys = result;
+    return resultCount;
+}
+
+int32_t mfcrack_rf08s_filter(uint32_t nt1, const uint64_t *keys1, uint32_t count1, uint8_t *keep1,
+                             uint32_t nt2, const uint64_t *keys2, uint32_t count2, uint8_t *keep2) {
+    last_candidates = 0;
+    if (nt1 == nt2) {
+        return -1;
+    }
+    init_lfsr16_table();
+    int32_t kept = rf08s_filter_keys(nt1, keys1, count1, keep1, nt2, keys2, count2, keep2, mfcrack_num_cpus());
+    if (kept >= 0) {
+        last_candidates = (uint64_t)count1 + count2;
+    }
+    return kept;
+}
+
+int32_t mfcrack_rf08s_1key(uint32_t nt1, uint64_t key1, uint32_t nt2, const uint64_t *keys2, uint32_t count2,
+                           uint64_t **keys) {
+    *keys = NULL;
+    last_candidates = 0;
+    if (nt1 == nt2) {
+        return -1;
+    }
+    // matches are moved to the start of a copy of keys2
+    uint64_t *found = malloc(((size_t)count2 + 1) * sizeof(uint64_t));
+    if (found == NULL) {
+        return -1;
+    }
+    memcpy(found, keys2, (size_t)count2 * sizeof(uint64_t));
+    init_lfsr16_table();
+    int32_t count = rf08s_match_keys(nt1, key1, nt2, found, count2, mfcrack_num_cpus());
+    if (count < 0) {
+        free(found);
+        return -1;
+    }
+    last_candidates = count2;
+    *keys = found;
+    return count;
+}
+
+int32_t mfcrack_mfulc_segments(const uint8_t null_erndb[8], const uint8_t erndb[4][8], uint8_t key[16]) {
+    last_candidates = 0;
+    mfulc_search_t *search = calloc(1, sizeof(mfulc_search_t));
+    if (search == NULL) {
+        return -1;
+    }
+    search->lfsr_type = mfulc_detect_lfsr_type(null_erndb);
+    if (search->lfsr_type == LFSR_UNDEF) {
+        free(search);
+        return 0;
+    }
+    if (!mfulc_search_start(search, (int)mfcrack_num_cpus())) {
+        free(search);
+        return -1;
+    }
+
+    unsigned char ciphertexts[4][MFULC_BLOCK_SIZE];
+    memcpy(ciphertexts, erndb, sizeof(ciphertexts));
+    int32_t found = mfulc_search_segments(search, ciphertexts) ? 1 : 0;
+    if (found) {
+        memcpy(key, search->base_key, MFULC_KEY_SIZE);
+    }
+    last_candidates = search->searched;
+    mfulc_search_stop(search);
+    free(search);
+    return found;
+}
@@ -0,0 +1,99 @@
+#ifndef MFCRACK_H__
+#define MFCRACK_H__
+
+// In-process API of the key recovery tools, built as the mfcrack shared library.
+//
+// Functions returning keys allocate the array, the caller releases it with mfcrack_free().
+// The return value is the number of keys, or -1 on invalid input or allocation failure.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(_WIN32) && defined(MFCRACK_EXPORTS)
+#define MFCRACK_API __declspec(dllexport)
+#else
+#define MFCRACK_API
+#endif
+
+// bumped whenever a signature below changes
+#define MFCRACK_API_VERSION 6
+
+typedef struct {
+    uint32_t nt;
+    uint32_t nt_enc;
+    uint8_t par;        // parity bits of the 3 first bytes, as returned by the device
+} mfcrack_nested_nonce_t;
+
+typedef struct {
+    uint32_t nt;
+    uint32_t nt_enc;
+} mfcrack_static_nonce_t;
+
+typedef struct {
+    uint32_t nt;
+    uint64_t ks_list;
+    uint64_t par_list;
+    uint32_t nr;
+    uint32_t ar;
+} mfcrack_darkside_t;
+
+// one reader authentication of the detection log
+typedef struct {
+    uint32_t uid;
+    uint32_t nt;
+    uint32_t nr_enc;
+    uint32_t ar_enc;
+    uint8_t block;
+    uint8_t key_type;   // 0 for key A, 1 for key B
+} mfcrack_auth_t;
+
+typedef struct {
+    uint32_t uid;
+    uint8_t block;
+    uint8_t key_type;
+    uint64_t key;
+} mfcrack_log_key_t;
+
+MFCRACK_API int mfcrack_api_version(void);
+MFCRACK_API void mfcrack_free(void *ptr);
+// Upper bound of the worker threads of the calls below made by the calling thread, 0 (the default)
+// for one per core. Each thread has its own, so concurrent callers can split the cores.
+MFCRACK_API void mfcrack_set_max_threads(uint32_t threads);
+// Key candidates the last call of the calling thread went through: LFSR states for nested, staticnested
+// and mfkey32v2, dictionary keys for rf08s, DES keys for mfulc
+MFCRACK_API uint64_t mfcrack_last_candidates(void);
+
+MFCRACK_API int32_t mfcrack_nested(uint32_t uid, uint32_t dist, const mfcrack_nested_nonce_t *nonces, uint32_t count,
+                                   uint64_t **keys);
+MFCRACK_API int32_t mfcrack_staticnested(uint32_t uid, uint8_t key_type, const mfcrack_static_nonce_t *nonces,
+                                         uint32_t count, uint64_t **keys);
+// The traces are decrypted in parallel. keys gets the candidates left after the last trace: the running
+// intersection of the parity zero traces, or the candidates of the last other trace if that came later.
+// remaining, if not NULL, gets for each trace the number of candidates left after it.
+MFCRACK_API int32_t mfcrack_darkside(uint32_t uid, const mfcrack_darkside_t *params, uint32_t count, uint64_t **keys,
+                                     uint32_t *remaining);
+MFCRACK_API bool mfcrack_mfkey32v2(uint32_t uid, uint32_t nt0, uint32_t nr0_enc, uint32_t ar0_enc,
+                                   uint32_t nt1, uint32_t nr1_enc, uint32_t ar1_enc, uint64_t *key);
+// Keys of a whole detection log: auths are grouped by uid/block/key type, each group is
+// cracked pair by pair on all cores until every auth is explained by a found key.
+// Keys found for a uid are tried first on its other groups.
+MFCRACK_API int32_t mfcrack_mfkey32_log(const mfcrack_auth_t *auths, uint32_t count, mfcrack_log_key_t **keys);
+// Tests every key against every auth: matches[k * count + i] is 1 when keys[k] explains auths[i].
+// matches is provided by the caller (key_count * count bytes), the return value is the number of matches.
+MFCRACK_API int32_t mfcrack_test_keys(const mfcrack_auth_t *auths, uint32_t count, const uint64_t *keys,
+                                      uint32_t key_count, uint8_t *matches);
+// FM11RF08S backdoor, static nested candidates of both keys of a sector: keys1 are the candidates
+// for nt1 and keys2 those for nt2. keep1[i] is set when keys1[i] can go with a key of keys2, and
+// keep2 the other way round. keep1 and keep2 are provided by the caller (count1 and count2 bytes),
+// the return value is the number of keys kept.
+MFCRACK_API int32_t mfcrack_rf08s_filter(uint32_t nt1, const uint64_t *keys1, uint32_t count1, uint8_t *keep1,
+                                         uint32_t nt2, const uint64_t *keys2, uint32_t count2, uint8_t *keep2);
+// The candidates of keys2 (for nt2) that can go with key1, the key found for nt1 of the same sector
+MFCRACK_API int32_t mfcrack_rf08s_1key(uint32_t nt1, uint64_t key1, uint32_t nt2, const uint64_t *keys2,
+                                       uint32_t count2, uint64_t **keys);
+// MIFARE Ultralight C counterfeit key recovery of all 4 segments, as mfulc_des_brute -a: null_erndb is
+// ERndB under the null key, erndb[s] the ERndB of segment s + 1. key gets the 16 byte key. Returns 1
+// when found, 0 when the LFSR is unknown or a segment has no match, -1 on allocation failure.
+MFCRACK_API int32_t mfcrack_mfulc_segments(const uint8_t null_erndb[8], const uint8_t erndb[4][8], uint8_t key[16]);
+
+#endif
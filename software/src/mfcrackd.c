@@ -0,0 +1,683 @@
+// mfcrackd: runs the recoveries of the mfcrack library in one long-running process, so the
+// crapto1 tables, the page cache and the CPU stay warm between the many short jobs of a session.
+//
+// Jobs come in over a Unix domain socket. A client sends requests and reads one response per
+// request, in order, on the same connection. All integers are little endian.
+//
+//   request:  "MFCQ", u16 version, u16 op, u32 job id, u16 threads, u16 reserved, u32 length, payload
+//   response: "MFCR", u16 version, u16 op, u32 job id, i32 status, u32 length, payload
+//
+// threads is the thread budget of the job, 0 for all the threads of the daemon. status is the
+// result count of the op, or a negative MFCRACKD_E_* error without payload.
+//
+//   PING          -> u32 api version, u32 max threads, u32 jobs queued, u32 jobs done
+//   NESTED        u32 uid, u32 dist, u32 n, n x (u32 nt, u32 nt_enc, u8 par) -> status x u64 key
+//   STATICNESTED  u32 uid, u32 key type (0x60/0x61), u32 n, n x (u32 nt, u32 nt_enc) -> status x u64 key
+//   DARKSIDE      u32 uid, u32 n, n x (u32 nt, u64 ks, u64 par, u32 nr, u32 ar)
+//                 -> n x u32 candidates left, status x u64 key
+//   MFKEY32V2     u32 uid, nt0, nr0_enc, ar0_enc, nt1, nr1_enc, ar1_enc -> status 1 and u64 key, or status 0
+//   MFKEY32_LOG   u32 n, n x (u32 uid, nt, nr_enc, ar_enc, u8 block, u8 key type 0/1)
+//                 -> status x (u32 uid, u8 block, u8 key type, u64 key)
+//   TEST_KEYS     u32 n, u32 k, n x (u32 uid, nt, nr_enc, ar_enc), k x u64 key
+//                 -> k x n match bytes (key major), status is the number of matches
+//   RF08S_FILTER  u32 nt1, u32 n1, u32 nt2, u32 n2, n1 x u64 key, n2 x u64 key
+//                 -> n1 + n2 keep bytes, status is the number of keys kept
+//   RF08S_1KEY    u32 nt1, u64 key1, u32 nt2, u32 n, n x u64 key -> status x u64 key
+//   MFULC         8 bytes null key ERndB, 4 x 8 bytes ERndB of segments 1-4
+//                 -> status 1 and the 16 byte key, or status 0
+//
+// Jobs start in arrival order and run side by side as long as their budgets fit in the threads
+// of the daemon (-t), each on the thread of its connection. PING is answered right away, also
+// while jobs run.
+//
+// Hardnested is not in the mfcrack library yet, so it still runs as the hardnested tool, which
+// pays its table setup on every run.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+
+#include "unistd.h"
+#include "pthread.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "common.h"
+#include "mfcrack.h"
+
+#define MFCRACKD_VERSION            1
+#define MFCRACKD_HEADER_SIZE        20
+#define MFCRACKD_MAX_PAYLOAD        (64 << 20)
+
+#define MFCRACKD_OP_PING            0
+#define MFCRACKD_OP_NESTED          1
+#define MFCRACKD_OP_STATICNESTED    2
+#define MFCRACKD_OP_DARKSIDE        3
+#define MFCRACKD_OP_MFKEY32V2       4
+#define MFCRACKD_OP_MFKEY32_LOG     5
+#define MFCRACKD_OP_TEST_KEYS       6
+#define MFCRACKD_OP_RF08S_FILTER    7
+#define MFCRACKD_OP_RF08S_1KEY      8
+#define MFCRACKD_OP_MFULC           9
+
+#define MFCRACKD_E_FAILED           -1  // invalid input or out of memory, as returned by the library
+#define MFCRACKD_E_UNKNOWN_OP       -2
+#define MFCRACKD_E_MALFORMED        -3
+
+typedef struct {
+    const uint8_t *p;
+    size_t left;
+    bool ok;
+} reader_t;
+
+typedef struct {
+    uint8_t *data;
+    size_t len, capacity;
+    bool ok;
+} writer_t;
+
+typedef struct job {
+    struct job *next;
+    uint16_t op;
+    uint32_t id;
+    uint16_t threads;
+    uint32_t budget;            // threads taken from the daemon while it runs
+    uint8_t *payload;
+    uint32_t length;
+    int32_t status;
+    writer_t out;
+    bool done;
+} job_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;     // a job was added, started or finished
+    job_t *head, *tail;         // jobs waiting for threads
+    uint32_t count, done;       // jobs waiting or running, jobs finished
+    uint32_t free_threads;      // threads no running job took
+} queue = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, 0, 0 };
+
+static uint32_t max_threads;
+static char socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+static uint64_t msclock(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+static uint64_t get_le(reader_t *r, int len) {
+    uint64_t v = 0;
+    if (r->left < (size_t)len) {
+        r->ok = false;
+        return 0;
+    }
+    for (int i = len - 1; i >= 0; i--) {
+        v = (v << 8) | r->p[i];
+    }
+    r->p += len;
+    r->left -= len;
+    return v;
+}
+
+static uint32_t get_u32(reader_t *r) {
+    return (uint32_t)get_le(r, 4);
+}
+
+// count records of size bytes must follow, checked before allocating for them
+static bool has_records(const reader_t *r, uint32_t count, size_t size) {
+    return r->ok && r->left >= (uint64_t)count * size;
+}
+
+static void put_le(writer_t *w, uint64_t v, int len) {
+    if (w->len + len > w->capacity) {
+        size_t capacity = w->capacity ? 2 * w->capacity : 256;
+        while (capacity < w->len + len) {
+            capacity *= 2;
+        }
+        uint8_t *tmp = realloc(w->data, capacity);
+        if (tmp == NULL) {
+            w->ok = false;
+            return;
+        }
+        w->data = tmp;
+        w->capacity = capacity;
+    }
+    for (int i = 0; i < len; i++) {
+        w->data[w->len++] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void put_keys(writer_t *w, const uint64_t *keys, int32_t count) {
+    for (int32_t i = 0; i < count; i++) {
+        put_le(w, keys[i], 8);
+    }
+}
+
+static int32_t run_nested(reader_t *r, writer_t *w) {
+    uint32_t uid = get_u32(r), dist = get_u32(r), count = get_u32(r);
+    if (!has_records(r, count, 9)) {
+        return MFCRACKD_E_MALFORMED;
+    }
+    mfcrack_nested_nonce_t *nonces = calloc(count + 1, sizeof(mfcrack_nested_nonce_t));
+    if (nonces == NULL) {
+        return MFCRACKD_E_FAILED;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        nonces[i].nt = get_u32(r);
+        nonces[i].nt_enc = get_u32(r);
+        nonces[i].par = (uint8_t)get_le(r, 1);
+    }
+    uint64_t *keys = NULL;
+    int32_t n = mfcrack_nested(uid, dist, nonces, count, &keys);
+    put_keys(w, keys, n);
+    mfcrack_free(keys);
+    free(nonces);
+    return n;
+}
+
+static int32_t run_staticnested(reader_t *r, writer_t *w) {
+    uint32_t uid = get_u32(r), key_type = get_u32(r), count = get_u32(r);
+    if (!has_records(r, count, 8)) {
+        return MFCRACKD_E_MALFORMED;
+    }
+    mfcrack_static_nonce_t *nonces = calloc(count + 1, sizeof(mfcrack_static_nonce_t));
+    if (nonces == NULL) {
+        return MFCRACKD_E_FAILED;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        nonces[i].nt = get_u32(r);
+        nonces[i].nt_enc = get_u32(r);
+    }
+    uint64_t *keys = NULL;
+    int32_t n = mfcrack_staticnested(uid, (uint8_t)key_type, nonces, count, &keys);
+    put_keys(w, keys, n);
+    mfcrack_free(keys);
+    free(nonces);
+    return n;
+}
+
+static int32_t run_darkside(reader_t *r, writer_t *w) {
+    uint32_t uid = get_u32(r), count = get_u32(r);
+    if (!has_records(r, count, 28)) {
+        return MFCRACKD_E_MALFORMED;
+    }
+    mfcrack_darkside_t *params = calloc(count + 1, sizeof(mfcrack_darkside_t));
+    uint32_t *remaining = calloc(count + 1, sizeof(uint32_t));
+    if ((params == NULL) || (remaining == NULL)) {
+        free(params);
+        free(remaining);
+        return MFCRACKD_E_FAILED;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        params[i].nt = get_u32(r);
+        params[i].ks_list = get_le(r, 8);
+        params[i].par_list = get_le(r, 8);
+        params[i].nr = get_u32(r);
+        params[i].ar = get_u32(r);
+    }
+    uint64_t *keys = NULL;
+    int32_t n = mfcrack_darkside(uid, params, count, &keys, remaining);
+    if (n >= 0) {
+        for (uint32_t i = 0; i < count; i++) {
+            put_le(w, remaining[i], 4);
+        }
+        put_keys(w, keys, n);
+    }
+    mfcrack_free(keys);
+    free(params);
+    free(remaining);
+    return n;
+}
+
+static int32_t run_mfkey32v2(reader_t *r, writer_t *w) {
+    uint32_t v[7];
+    for (int i = 0; i < 7; i++) {
+        v[i] = get_u32(r);
+    }
+    if (!r->ok) {
+        return MFCRACKD_E_MALFORMED;
+    }
+    uint64_t key = 0;
+    if (!mfcrack_mfkey32v2(v[0], v[1], v[2], v[3], v[4], v[5], v[6], &key)) {
+        return 0;
+    }
+    put_le(w, key, 8);
+    return 1;
+}
+
+static bool read_auths(reader_t *r, uint32_t count, size_t size, mfcrack_auth_t **auths) {
+    if (!has_records(r, count, size)) {
+        return false;
+    }
+    *auths = calloc(count + 1, sizeof(mfcrack_auth_t));
+    for (uint32_t i = 0; *auths != NULL && i < count; i++) {
+        (*auths)[i].uid = get_u32(r);
+        (*auths)[i].nt = get_u32(r);
+        (*auths)[i].nr_enc = get_u32(r);
+        (*auths)[i].ar_enc = get_u32(r);
+        if (size > 16) {
+            (*auths)[i].block = (uint8_t)get_le(r, 1);
+            (*auths)[i].key_type = (uint8_t)get_le(r, 1);
+        }
+    }
+    return true;
+}
+
+static int32_t run_mfkey32_log(reader_t *r, writer_t *w) {
+    uint32_t count = get_u32(r);
+    mfcrack_auth_t *auths = NULL;
+    if (!read_auths(r, count, 18, &auths)) {
+        return MFCRACKD_E_MALFORMED;
+    }
+    if (auths == NULL) {
+        return MFCRACKD_E_FAILED;
+    }
+    mfcrack_log_key_t *keys = NULL;
+    int32_t n = mfcrack_mfkey32_log(auths, count, &keys);
+    for (int32_t i = 0; i < n; i++) {
+        put_le(w, keys[i].uid, 4);
+        put_le(w, keys[i].block, 1);
+        put_le(w, keys[i].key_type, 1);
+        put_le(w, keys[i].key, 8);
+    }
+    mfcrack_free(keys);
+    free(auths);
+    return n;
+}
+
+static int32_t run_test_keys(reader_t *r, writer_t *w) {
+    uint32_t count = get_u32(r), key_count = get_u32(r);
+    mfcrack_auth_t *auths = NULL;
+    if (!read_auths(r, count, 16, &auths) || !has_records(r, key_count, 8)) {
+        free(auths);
+        return MFCRACKD_E_MALFORMED;
+    }
+    uint64_t *keys = calloc((size_t)key_count + 1, sizeof(uint64_t));
+    uint8_t *matches = calloc((size_t)key_count * count + 1, 1);
+    int32_t n = MFCRACKD_E_FAILED;
+    if ((auths != NULL) && (keys != NULL) && (matches != NULL)) {
+        for (uint32_t k = 0; k < key_count; k++) {
+            keys[k] = get_le(r, 8);
+        }
+        n = mfcrack_test_keys(auths, count, keys, key_count, matches);
+        for (size_t i = 0; n >= 0 && i < (size_t)key_count * count; i++) {
+            put_le(w, matches[i], 1);
+        }
+    }
+    free(auths);
+    free(keys);
+    free(matches);
+    return n;
+}
+
+static uint64_t *read_keys(reader_t *r, uint32_t count) {
+    uint64_t *keys = calloc((size_t)count + 1, sizeof(uint64_t));
+    for (uint32_t i = 0; keys != NULL && i < count; i++) {
+        keys[i] = get_le(r, 8);
+    }
+    return keys;
+}
+
+static int32_t run_rf08s_filter(reader_t *r, writer_t *w) {
+    uint32_t nt1 = get_u32(r), count1 = get_u32(r), nt2 = get_u32(r), count2 = get_u32(r);
+    // both lists, one after the other
+    if (!r->ok || r->left / 8 < (uint64_t)count1 + count2) {
+        return MFCRACKD_E_MALFORMED;
+    }
+    uint64_t *keys1 = read_keys(r, count1);
+    uint64_t *keys2 = read_keys(r, count2);
+    uint8_t *keep = calloc((size_t)count1 + count2 + 1, 1);
+    int32_t n = MFCRACKD_E_FAILED;
+    if ((keys1 != NULL) && (keys2 != NULL) && (keep != NULL)) {
+        n = mfcrack_rf08s_filter(nt1, keys1, count1, keep, nt2, keys2, count2, keep + count1);
+        for (size_t i = 0; n >= 0 && i < (size_t)count1 + count2; i++) {
+            put_le(w, keep[i], 1);
+        }
+    }
+    free(keys1);
+    free(keys2);
+    free(keep);
+    return n;
+}
+
+static int32_t run_rf08s_1key(reader_t *r, writer_t *w) {
+    uint32_t nt1 = get_u32(r);
+    uint64_t key1 = get_le(r, 8);
+    uint32_t nt2 = get_u32(r), count = get_u32(r);
+    if (!has_records(r, count, 8)) {
+        return MFCRACKD_E_MALFORMED;
+    }
+    uint64_t *keys2 = read_keys(r, count);
+    if (keys2 == NULL) {
+        return MFCRACKD_E_FAILED;
+    }
+    uint64_t *keys = NULL;
+    int32_t n = mfcrack_rf08s_1key(nt1, key1, nt2, keys2, count, &keys);
+    put_keys(w, keys, n);
+    mfcrack_free(keys);
+    free(keys2);
+    return n;
+}
+
+static int32_t run_mfulc(reader_t *r, writer_t *w) {
+    uint8_t null_erndb[8], erndb[4][8], key[16];
+    if (!has_records(r, 5, 8)) {
+        return MFCRACKD_E_MALFORMED;
+    }
+    for (int i = 0; i < 8; i++) {
+        null_erndb[i] = (uint8_t)get_le(r, 1);
+    }
+    for (int i = 0; i < 32; i++) {
+        erndb[i / 8][i % 8] = (uint8_t)get_le(r, 1);
+    }
+    int32_t n = mfcrack_mfulc_segments(null_erndb, (const uint8_t (*)[8])erndb, key);
+    for (int i = 0; n == 1 && i < 16; i++) {
+        put_le(w, key[i], 1);
+    }
+    return n;
+}
+
+static void run_job(job_t *job) {
+    reader_t r = { job->payload, job->length, true };
+    job->out.ok = true;
+    mfcrack_set_max_threads(job->budget);
+    switch (job->op) {
+        case MFCRACKD_OP_NESTED:
+            job->status = run_nested(&r, &job->out);
+            break;
+        case MFCRACKD_OP_STATICNESTED:
+            job->status = run_staticnested(&r, &job->out);
+            break;
+        case MFCRACKD_OP_DARKSIDE:
+            job->status = run_darkside(&r, &job->out);
+            break;
+        case MFCRACKD_OP_MFKEY32V2:
+            job->status = run_mfkey32v2(&r, &job->out);
+            break;
+        case MFCRACKD_OP_MFKEY32_LOG:
+            job->status = run_mfkey32_log(&r, &job->out);
+            break;
+        case MFCRACKD_OP_TEST_KEYS:
+            job->status = run_test_keys(&r, &job->out);
+            break;
+        case MFCRACKD_OP_RF08S_FILTER:
+            job->status = run_rf08s_filter(&r, &job->out);
+            break;
+        case MFCRACKD_OP_RF08S_1KEY:
+            job->status = run_rf08s_1key(&r, &job->out);
+            break;
+        case MFCRACKD_OP_MFULC:
+            job->status = run_mfulc(&r, &job->out);
+            break;
+        default:
+            job->status = MFCRACKD_E_UNKNOWN_OP;
+            break;
+    }
+    if (!job->out.ok) {
+        job->status = MFCRACKD_E_FAILED;
+    }
+    if (job->status < 0) {
+        job->out.len = 0;
+    }
+}
+
+// runs the job once it is the first waiting and its threads are free, so a large job is not
+// overtaken forever by smaller ones
+static void submit(job_t *job) {
+    job->budget = (job->threads && job->threads < max_threads) ? job->threads : max_threads;
+    pthread_mutex_lock(&queue.lock);
+    if (queue.tail != NULL) {
+        queue.tail->next = job;
+    } else {
+        queue.head = job;
+    }
+    queue.tail = job;
+    queue.count++;
+    while (queue.head != job || queue.free_threads < job->budget) {
+        pthread_cond_wait(&queue.changed, &queue.lock);
+    }
+    queue.head = job->next;
+    if (queue.head == NULL) {
+        queue.tail = NULL;
+    }
+    queue.free_threads -= job->budget;
+    // the next job may fit in the threads left
+    pthread_cond_broadcast(&queue.changed);
+    pthread_mutex_unlock(&queue.lock);
+
+    run_job(job);
+
+    pthread_mutex_lock(&queue.lock);
+    queue.free_threads += job->budget;
+    queue.count--;
+    queue.done++;
+    pthread_cond_broadcast(&queue.changed);
+    pthread_mutex_unlock(&queue.lock);
+}
+
+static bool read_full(int fd, void *buf, size_t len) {
+    uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool send_response(int fd, const job_t *job) {
+    writer_t w = { NULL, 0, 0, true };
+    put_le(&w, 'M' | 'F' << 8 | 'C' << 16 | (uint32_t)'R' << 24, 4);
+    put_le(&w, MFCRACKD_VERSION, 2);
+    put_le(&w, job->op, 2);
+    put_le(&w, job->id, 4);
+    put_le(&w, (uint32_t)job->status, 4);
+    put_le(&w, job->out.len, 4);
+    bool ok = w.ok && write_full(fd, w.data, w.len) && write_full(fd, job->out.data, job->out.len);
+    free(w.data);
+    return ok;
+}
+
+// one thread per client, serving its requests in order
+static void *connection(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    uint8_t header[MFCRACKD_HEADER_SIZE];
+    while (read_full(fd, header, sizeof(header))) {
+        reader_t r = { header, sizeof(header), true };
+        uint32_t magic = get_u32(&r);
+        uint16_t version = (uint16_t)get_le(&r, 2);
+        job_t job = { .op = (uint16_t)get_le(&r, 2), .id = get_u32(&r), .threads = (uint16_t)get_le(&r, 2) };
+        get_le(&r, 2);
+        job.length = get_u32(&r);
+        if (magic != ('M' | 'F' << 8 | 'C' << 16 | (uint32_t)'Q' << 24) || version != MFCRACKD_VERSION
+                || job.length > MFCRACKD_MAX_PAYLOAD) {
+            job.status = MFCRACKD_E_MALFORMED;
+            send_response(fd, &job);
+            break;
+        }
+        job.payload = malloc(job.length + 1);
+        if ((job.payload == NULL) || !read_full(fd, job.payload, job.length)) {
+            free(job.payload);
+            break;
+        }
+        if (job.op == MFCRACKD_OP_PING) {
+            pthread_mutex_lock(&queue.lock);
+            job.out.ok = true;
+            put_le(&job.out, MFCRACK_API_VERSION, 4);
+            put_le(&job.out, max_threads, 4);
+            put_le(&job.out, queue.count, 4);
+            put_le(&job.out, queue.done, 4);
+            pthread_mutex_unlock(&queue.lock);
+            job.status = job.out.ok ? 1 : MFCRACKD_E_FAILED;
+        } else {
+            submit(&job);
+        }
+        bool ok = send_response(fd, &job);
+        free(job.payload);
+        free(job.out.data);
+        if (!ok) {
+            break;
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+// the directory of the socket when there is no $XDG_RUNTIME_DIR, only its owner may enter it
+static bool private_dir(const char *dir) {
+    struct stat st;
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+        perror(dir);
+        return false;
+    }
+    if (lstat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 077) != 0) {
+        printf("%s must be a directory of user %ld with mode 0700\n", dir, (long)getuid());
+        return false;
+    }
+    return true;
+}
+
+static bool default_socket_path(char *path, size_t len) {
+    const char *env = getenv("MFCRACKD_SOCKET");
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    if (env != NULL && env[0] != '\0') {
+        snprintf(path, len, "%s", env);
+    } else if (runtime != NULL && runtime[0] != '\0') {
+        snprintf(path, len, "%s/mfcrackd.sock", runtime);
+    } else {
+        snprintf(path, len, "/tmp/mfcrackd-%ld", (long)getuid());
+        if (!private_dir(path)) {
+            return false;
+        }
+        snprintf(path + strlen(path), len - strlen(path), "/mfcrackd.sock");
+    }
+    return true;
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    unlink(socket_path);
+    _exit(EXIT_SUCCESS);
+}
+
+static int listen_socket(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    // a socket file nobody answers on is left over from a daemon that died
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        printf("mfcrackd is already running on %s\n", path);
+        close(fd);
+        return -1;
+    }
+    unlink(path);
+    mode_t mask = umask(0077);
+    int rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(mask);
+    if (rc != 0 || listen(fd, 16) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    bool have_path = default_socket_path(socket_path, sizeof(socket_path));
+    max_threads = num_cpus();
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:t:h")) != -1) {
+        switch (opt) {
+            case 's':
+                snprintf(socket_path, sizeof(socket_path), "%s", optarg);
+                have_path = true;
+                break;
+            case 't':
+                max_threads = (uint32_t)strtoul(optarg, NULL, 10);
+                if (max_threads == 0) {
+                    max_threads = 1;
+                }
+                break;
+            default:
+                printf("Usage:\n  %s [-s <socket path>] [-t <threads shared by the jobs>]\n", argv[0]);
+                printf("  the socket defaults to $MFCRACKD_SOCKET, $XDG_RUNTIME_DIR/mfcrackd.sock or /tmp/mfcrackd-<uid>/mfcrackd.sock\n");
+                return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    int listen_fd = have_path ? listen_socket(socket_path) : -1;
+    if (listen_fd < 0) {
+        return EXIT_FAILURE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    // the first recovery maps (or writes) the crapto1 tables, do it before the first client waits on it
+    uint64_t start = msclock(), key = 0;
+    mfcrack_set_max_threads(max_threads);
+    bool warm = mfcrack_mfkey32v2(0x6eb12b16, 0x0ae4a9ee, 0x67d0b42c, 0x7311ef59, 0xe3104016, 0x826eafc1, 0xab67b013, &key)
+                && key == 0xc6386be8b8d6;
+    printf("mfcrackd listening on %s, %u threads, warm-up %s in %" PRIu64 " ms\n",
+           socket_path, max_threads, warm ? "ok" : "FAILED", msclock() - start);
+    fflush(stdout);
+
+    queue.free_threads = max_threads;
+
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            perror("accept");
+            break;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, connection, (void *)(intptr_t)fd) != 0) {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    unlink(socket_path);
+    return EXIT_FAILURE;
+}
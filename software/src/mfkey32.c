@@ -52,7 +52,9 @@ int main(int argc, char *argv[]) {
 
     s = lfsr_recovery32(ar0_enc ^ p64, 0);
 
+    uint32_t candidates = 0;
     for (t = s; t->odd | t->even; ++t) {
+        candidates++;
         lfsr_rollback_word(t, 0, 0);
         lfsr_rollback_word(t, nr0_enc, 1);
         lfsr_rollback_word(t, uid ^ nt, 0);
@@ -64,6 +66,7 @@ int main(int argc, char *argv[]) {
             break;
         }
     }
+    printf("Candidates: %u\n", candidates);
     free(s);
     return 0;
 }
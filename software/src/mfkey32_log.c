@@ -0,0 +1,88 @@
+// Recover the keys of a whole MF1 detection log at once
+//
+// Input: the raw records as returned by MF1_GET_DETECTION_LOG, 18 bytes each, big endian:
+//   uint8_t block, uint8_t flags (bit 0: key B), uint32_t uid, nt, {nr}, {ar}
+// Output: one "<uid:08x> <block> <A|B> <key:012x>" line per key found.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "mfcrack.h"
+
+#define LOG_RECORD_SIZE 18
+
+static uint32_t get_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2 || (argc == 2 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0))) {
+        printf("Usage:\n  %s [detection_log.bin]\n"
+               "  reads the raw detection log records from the file, or from stdin without one\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fptr = stdin;
+    if (argc == 2) {
+        fptr = fopen(argv[1], "rb");
+        if (fptr == NULL) {
+            fprintf(stderr, "Error: Cannot open %s\n", argv[1]);
+            return 1;
+        }
+    } else {
+#if WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    }
+
+    uint32_t count = 0, capacity = 1024;
+    mfcrack_auth_t *auths = malloc(capacity * sizeof(mfcrack_auth_t));
+    uint8_t record[LOG_RECORD_SIZE];
+    while (auths != NULL && fread(record, 1, LOG_RECORD_SIZE, fptr) == LOG_RECORD_SIZE) {
+        if (count == capacity) {
+            capacity *= 2;
+            void *tmp = realloc(auths, capacity * sizeof(mfcrack_auth_t));
+            if (tmp == NULL) {
+                free(auths);
+                auths = NULL;
+                break;
+            }
+            auths = tmp;
+        }
+        auths[count].block = record[0];
+        auths[count].key_type = record[1] & 0x01;
+        auths[count].uid = get_be32(record + 2);
+        auths[count].nt = get_be32(record + 6);
+        auths[count].nr_enc = get_be32(record + 10);
+        auths[count].ar_enc = get_be32(record + 14);
+        count++;
+    }
+    if (fptr != stdin) {
+        fclose(fptr);
+    }
+    if (auths == NULL) {
+        perror("Failed to allocate memory");
+        return 1;
+    }
+
+    mfcrack_log_key_t *keys = NULL;
+    int32_t keyCount = mfcrack_mfkey32_log(auths, count, &keys);
+    free(auths);
+    if (keyCount < 0) {
+        fprintf(stderr, "Error: Failed to allocate memory\n");
+        return 1;
+    }
+
+    for (int32_t i = 0; i < keyCount; i++) {
+        printf("%08x %u %c %012" PRIx64 "\n", keys[i].uid, keys[i].block, keys[i].key_type ? 'B' : 'A', keys[i].key);
+    }
+    mfcrack_free(keys);
+    return 0;
+}
@@ -109,6 +109,8 @@ int main(int argc, char *argv[]) {
     lfsr_rollback_word(revstate, uid ^ nt, 0);
     crypto1_get_lfsr(revstate, &key);
     printf("\nFound Key: [%012" PRIx64 "]\n\n", key);
+    // 64 bits of keystream give the state right away
+    printf("Candidates: 1\n");
     crypto1_destroy(revstate);
     return 0;
 }
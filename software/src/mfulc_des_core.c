@@ -0,0 +1,359 @@
+// Bitsliced 2TDEA decryption cores for mfulc_des_brute, see mfulc_des_core.h.
+//
+// Every lane of a bitslice word decrypts under its own candidate: the candidate bits that
+// differ between lanes are fixed lane patterns, all other key bits are constant words. DES
+// round keys are only a selection of key bits, so no key schedule is computed per candidate.
+
+#include "mfulc_des_core.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// this needs to be compiled several times for each instruction set.
+// For each instruction set, define a dedicated function name:
+#if defined (__AVX2__)
+#define DES_BS_LANES 256
+#define DES_BS_CRACK des_bs_crack_AVX2
+#elif defined (__SSE2__) && !defined(NOSIMD_BUILD)
+#define DES_BS_LANES 128
+#define DES_BS_CRACK des_bs_crack_SSE2
+#elif defined (__ARM_NEON) && !defined(NOSIMD_BUILD)
+#define DES_BS_LANES 128
+#define DES_BS_CRACK des_bs_crack_NEON
+#else
+#define DES_BS_LANES 64
+#define DES_BS_CRACK des_bs_crack_NOSIMD
+#endif
+
+#if DES_BS_LANES == 64
+typedef uint64_t bs_t;
+#else
+typedef uint64_t bs_t __attribute__((vector_size(DES_BS_LANES / 8)));
+#endif
+
+#ifdef _MSC_VER
+#define DES_BS_INLINE __forceinline
+#define DES_BS_NOINLINE __declspec(noinline)
+#define DES_BS_UNROLL(n)
+#else
+#define DES_BS_INLINE inline __attribute__((always_inline))
+#define DES_BS_NOINLINE __attribute__((noinline))
+#define DES_BS_UNROLL(n) _Pragma(#n)
+#endif
+
+typedef union {
+    bs_t value;
+    uint64_t lanes64[DES_BS_LANES / 64];
+} bs_lanes_t;
+
+#include "mfulc_des_sboxes.h"
+
+// key bit used by each bit of the round keys, as selected by PC1, the rotations and PC2
+static const uint8_t des_key_bits[16][48] = {
+    { 9, 50, 33, 59, 48, 16, 32, 56,  1,  8, 18, 41,  2, 34, 25, 24, 43, 57, 58,  0, 35, 26, 17, 40,
+     21, 27, 38, 53, 36,  3, 46, 29,  4, 52, 22, 28, 60, 20, 37, 62, 14, 19, 44, 13, 12, 61, 54, 30},
+    { 1, 42, 25, 51, 40,  8, 24, 48, 58,  0, 10, 33, 59, 26, 17, 16, 35, 49, 50, 57, 56, 18,  9, 32,
+     13, 19, 30, 45, 28, 62, 38, 21, 27, 44, 14, 20, 52, 12, 29, 54,  6, 11, 36,  5,  4, 53, 46, 22},
+    {50, 26,  9, 35, 24, 57,  8, 32, 42, 49, 59, 17, 43, 10,  1,  0, 48, 33, 34, 41, 40,  2, 58, 16,
+     60,  3, 14, 29, 12, 46, 22,  5, 11, 28, 61,  4, 36, 27, 13, 38, 53, 62, 20, 52, 19, 37, 30,  6},
+    {34, 10, 58, 48,  8, 41, 57, 16, 26, 33, 43,  1, 56, 59, 50, 49, 32, 17, 18, 25, 24, 51, 42,  0,
+     44, 54, 61, 13, 27, 30,  6, 52, 62, 12, 45, 19, 20, 11, 60, 22, 37, 46,  4, 36,  3, 21, 14, 53},
+    {18, 59, 42, 32, 57, 25, 41,  0, 10, 17, 56, 50, 40, 43, 34, 33, 16,  1,  2,  9,  8, 35, 26, 49,
+     28, 38, 45, 60, 11, 14, 53, 36, 46, 27, 29,  3,  4, 62, 44,  6, 21, 30, 19, 20, 54,  5, 61, 37},
+    { 2, 43, 26, 16, 41,  9, 25, 49, 59,  1, 40, 34, 24, 56, 18, 17,  0, 50, 51, 58, 57, 48, 10, 33,
+     12, 22, 29, 44, 62, 61, 37, 20, 30, 11, 13, 54, 19, 46, 28, 53,  5, 14,  3,  4, 38, 52, 45, 21},
+    {51, 56, 10,  0, 25, 58,  9, 33, 43, 50, 24, 18,  8, 40,  2,  1, 49, 34, 35, 42, 41, 32, 59, 17,
+     27,  6, 13, 28, 46, 45, 21,  4, 14, 62, 60, 38,  3, 30, 12, 37, 52, 61, 54, 19, 22, 36, 29,  5},
+    {35, 40, 59, 49,  9, 42, 58, 17, 56, 34,  8,  2, 57, 24, 51, 50, 33, 18, 48, 26, 25, 16, 43,  1,
+     11, 53, 60, 12, 30, 29,  5, 19, 61, 46, 44, 22, 54, 14, 27, 21, 36, 45, 38,  3,  6, 20, 13, 52},
+    {56, 32, 51, 41,  1, 34, 50,  9, 48, 26,  0, 59, 49, 16, 43, 42, 25, 10, 40, 18, 17,  8, 35, 58,
+      3, 45, 52,  4, 22, 21, 60, 11, 53, 38, 36, 14, 46,  6, 19, 13, 28, 37, 30, 62, 61, 12,  5, 44},
+    {40, 16, 35, 25, 50, 18, 34, 58, 32, 10, 49, 43, 33,  0, 56, 26,  9, 59, 24,  2,  1, 57, 48, 42,
+     54, 29, 36, 19,  6,  5, 44, 62, 37, 22, 20, 61, 30, 53,  3, 60, 12, 21, 14, 46, 45, 27, 52, 28},
+    {24,  0, 48,  9, 34,  2, 18, 42, 16, 59, 33, 56, 17, 49, 40, 10, 58, 43,  8, 51, 50, 41, 32, 26,
+     38, 13, 20,  3, 53, 52, 28, 46, 21,  6,  4, 45, 14, 37, 54, 44, 27,  5, 61, 30, 29, 11, 36, 12},
+    { 8, 49, 32, 58, 18, 51,  2, 26,  0, 43, 17, 40,  1, 33, 24, 59, 42, 56, 57, 35, 34, 25, 16, 10,
+     22, 60,  4, 54, 37, 36, 12, 30,  5, 53, 19, 29, 61, 21, 38, 28, 11, 52, 45, 14, 13, 62, 20, 27},
+    {57, 33, 16, 42,  2, 35, 51, 10, 49, 56,  1, 24, 50, 17,  8, 43, 26, 40, 41, 48, 18,  9,  0, 59,
+      6, 44, 19, 38, 21, 20, 27, 14, 52, 37,  3, 13, 45,  5, 22, 12, 62, 36, 29, 61, 60, 46,  4, 11},
+    {41, 17,  0, 26, 51, 48, 35, 59, 33, 40, 50,  8, 34,  1, 57, 56, 10, 24, 25, 32,  2, 58, 49, 43,
+     53, 28,  3, 22,  5,  4, 11, 61, 36, 21, 54, 60, 29, 52,  6, 27, 46, 20, 13, 45, 44, 30, 19, 62},
+    {25,  1, 49, 10, 35, 32, 48, 43, 17, 24, 34, 57, 18, 50, 41, 40, 59,  8,  9, 16, 51, 42, 33, 56,
+     37, 12, 54,  6, 52, 19, 62, 45, 20,  5, 38, 44, 13, 36, 53, 11, 30,  4, 60, 29, 28, 14,  3, 46},
+    {17, 58, 41,  2, 56, 24, 40, 35,  9, 16, 26, 49, 10, 42, 33, 32, 51,  0,  1,  8, 43, 34, 25, 48,
+     29,  4, 46, 61, 44, 11, 54, 37, 12, 60, 30, 36,  5, 28, 45,  3, 22, 27, 52, 21, 20,  6, 62, 38},
+};
+
+// initial permutation, bit numbers from 0
+static const uint8_t des_ip[64] = {
+    57, 49, 41, 33, 25, 17,  9,  1, 59, 51, 43, 35, 27, 19, 11,  3,
+    61, 53, 45, 37, 29, 21, 13,  5, 63, 55, 47, 39, 31, 23, 15,  7,
+    56, 48, 40, 32, 24, 16,  8,  0, 58, 50, 42, 34, 26, 18, 10,  2,
+    60, 52, 44, 36, 28, 20, 12,  4, 62, 54, 46, 38, 30, 22, 14,  6,
+};
+
+// final permutation, bit numbers from 0
+static const uint8_t des_fp[64] = {
+    39,  7, 47, 15, 55, 23, 63, 31, 38,  6, 46, 14, 54, 22, 62, 30,
+    37,  5, 45, 13, 53, 21, 61, 29, 36,  4, 44, 12, 52, 20, 60, 28,
+    35,  3, 43, 11, 51, 19, 59, 27, 34,  2, 42, 10, 50, 18, 58, 26,
+    33,  1, 41,  9, 49, 17, 57, 25, 32,  0, 40,  8, 48, 16, 56, 24,
+};
+
+// expansion, bit numbers from 0
+static const uint8_t des_e[48] = {
+    31,  0,  1,  2,  3,  4,  3,  4,  5,  6,  7,  8,  7,  8,  9, 10,
+    11, 12, 11, 12, 13, 14, 15, 16, 15, 16, 17, 18, 19, 20, 19, 20,
+    21, 22, 23, 24, 23, 24, 25, 26, 27, 28, 27, 28, 29, 30, 31,  0,
+};
+
+// permutation of the S-box outputs, bit numbers from 0
+static const uint8_t des_p[32] = {
+    15,  6, 19, 20, 28, 11, 27, 16,  0, 14, 22, 25,  4, 17, 30,  9,
+     1,  7, 23, 13, 31, 26,  2,  8, 18, 12, 29,  5, 21, 10,  3, 24,
+};
+
+#ifdef NOSIMD_BUILD
+static const uint8_t des_sbox[8][64] = {
+    {14,  4, 13,  1,  2, 15, 11,  8,  3, 10,  6, 12,  5,  9,  0,  7,
+      0, 15,  7,  4, 14,  2, 13,  1, 10,  6, 12, 11,  9,  5,  3,  8,
+      4,  1, 14,  8, 13,  6,  2, 11, 15, 12,  9,  7,  3, 10,  5,  0,
+     15, 12,  8,  2,  4,  9,  1,  7,  5, 11,  3, 14, 10,  0,  6, 13},
+    {15,  1,  8, 14,  6, 11,  3,  4,  9,  7,  2, 13, 12,  0,  5, 10,
+      3, 13,  4,  7, 15,  2,  8, 14, 12,  0,  1, 10,  6,  9, 11,  5,
+      0, 14,  7, 11, 10,  4, 13,  1,  5,  8, 12,  6,  9,  3,  2, 15,
+     13,  8, 10,  1,  3, 15,  4,  2, 11,  6,  7, 12,  0,  5, 14,  9},
+    {10,  0,  9, 14,  6,  3, 15,  5,  1, 13, 12,  7, 11,  4,  2,  8,
+     13,  7,  0,  9,  3,  4,  6, 10,  2,  8,  5, 14, 12, 11, 15,  1,
+     13,  6,  4,  9,  8, 15,  3,  0, 11,  1,  2, 12,  5, 10, 14,  7,
+      1, 10, 13,  0,  6,  9,  8,  7,  4, 15, 14,  3, 11,  5,  2, 12},
+    { 7, 13, 14,  3,  0,  6,  9, 10,  1,  2,  8,  5, 11, 12,  4, 15,
+     13,  8, 11,  5,  6, 15,  0,  3,  4,  7,  2, 12,  1, 10, 14,  9,
+     10,  6,  9,  0, 12, 11,  7, 13, 15,  1,  3, 14,  5,  2,  8,  4,
+      3, 15,  0,  6, 10,  1, 13,  8,  9,  4,  5, 11, 12,  7,  2, 14},
+    { 2, 12,  4,  1,  7, 10, 11,  6,  8,  5,  3, 15, 13,  0, 14,  9,
+     14, 11,  2, 12,  4,  7, 13,  1,  5,  0, 15, 10,  3,  9,  8,  6,
+      4,  2,  1, 11, 10, 13,  7,  8, 15,  9, 12,  5,  6,  3,  0, 14,
+     11,  8, 12,  7,  1, 14,  2, 13,  6, 15,  0,  9, 10,  4,  5,  3},
+    {12,  1, 10, 15,  9,  2,  6,  8,  0, 13,  3,  4, 14,  7,  5, 11,
+     10, 15,  4,  2,  7, 12,  9,  5,  6,  1, 13, 14,  0, 11,  3,  8,
+      9, 14, 15,  5,  2,  8, 12,  3,  7,  0,  4, 10,  1, 13, 11,  6,
+      4,  3,  2, 12,  9,  5, 15, 10, 11, 14,  1,  7,  6,  0,  8, 13},
+    { 4, 11,  2, 14, 15,  0,  8, 13,  3, 12,  9,  7,  5, 10,  6,  1,
+     13,  0, 11,  7,  4,  9,  1, 10, 14,  3,  5, 12,  2, 15,  8,  6,
+      1,  4, 11, 13, 12,  3,  7, 14, 10, 15,  6,  8,  0,  5,  9,  2,
+      6, 11, 13,  8,  1,  4, 10,  7,  9,  5,  0, 15, 14,  2,  3, 12},
+    {13,  2,  8,  4,  6, 15, 11,  1, 10,  9,  3, 14,  5,  0, 12,  7,
+      1, 15, 13,  8, 10,  3,  7,  4, 12,  5,  6, 11,  0, 14,  9,  2,
+      7, 11,  4,  1,  9, 12, 14,  2,  0,  6, 10, 13, 15,  3,  5,  8,
+      2,  1, 14,  7,  4, 10,  8, 13, 15, 12,  9,  0,  3,  5,  6, 11},
+};
+#endif
+
+// lanes of a 64-bit word in which bit k of the lane index is set
+static const uint64_t lane_index_bits[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+static inline bs_t bs_broadcast(bool bit) {
+    bs_lanes_t w;
+    for (int e = 0; e < DES_BS_LANES / 64; e++) {
+        w.lanes64[e] = bit ? ~0ULL : 0;
+    }
+    return w.value;
+}
+
+// bit n of a key or block, numbered as in the DES standard from the MSB of byte 0
+static inline bool block_bit(const uint8_t *block, int n) {
+    return (block[n >> 3] >> (7 - (n & 7))) & 1;
+}
+
+// key words of the candidate half: bit k of the 28-bit candidate index is bit k % 7 + 1 of
+// candidate byte k / 7, so lanes differ in the key bits of the low index bits only
+static void bs_candidate_key(bs_t key[64], const des_bs_job_t *job, uint32_t first) {
+    for (int n = 0; n < 64; n++) {
+        key[n] = bs_broadcast(block_bit(job->candidate_half, n));
+    }
+    for (int k = 0; k < 28; k++) {
+        bs_lanes_t w;
+        for (int e = 0; e < DES_BS_LANES / 64; e++) {
+            if (k < 6) {
+                w.lanes64[e] = lane_index_bits[k];
+            } else {
+                w.lanes64[e] = (((first + 64 * e) >> k) & 1) ? ~0ULL : 0;
+            }
+        }
+        key[8 * (job->var_offset + k / 7) + 6 - k % 7] = w.value;
+    }
+}
+
+static DES_BS_INLINE void des_bs_f(bs_t *l, const bs_t *r, const bs_t *key, const uint8_t *kb) {
+    bs_t o[32];
+#define DES_BS_SBOX(n) des_sbox##n( \
+        r[des_e[6 * (n - 1)]] ^ key[kb[6 * (n - 1)]], \
+        r[des_e[6 * (n - 1) + 1]] ^ key[kb[6 * (n - 1) + 1]], \
+        r[des_e[6 * (n - 1) + 2]] ^ key[kb[6 * (n - 1) + 2]], \
+        r[des_e[6 * (n - 1) + 3]] ^ key[kb[6 * (n - 1) + 3]], \
+        r[des_e[6 * (n - 1) + 4]] ^ key[kb[6 * (n - 1) + 4]], \
+        r[des_e[6 * (n - 1) + 5]] ^ key[kb[6 * (n - 1) + 5]], \
+        &o[4 * (n - 1)], &o[4 * (n - 1) + 1], &o[4 * (n - 1) + 2], &o[4 * (n - 1) + 3])
+    DES_BS_SBOX(1);
+    DES_BS_SBOX(2);
+    DES_BS_SBOX(3);
+    DES_BS_SBOX(4);
+    DES_BS_SBOX(5);
+    DES_BS_SBOX(6);
+    DES_BS_SBOX(7);
+    DES_BS_SBOX(8);
+#undef DES_BS_SBOX
+    DES_BS_UNROLL(GCC unroll 32)
+    for (int i = 0; i < 32; i++) {
+        l[i] ^= o[des_p[i]];
+    }
+}
+
+// 16 DES rounds on (l, r) after IP. On return the block before FP is (r, l), which is also
+// the input of a chained DES after its IP. Fully unrolled, so that all the bit selections
+// become constant offsets; one copy for encryption and one for decryption.
+static DES_BS_INLINE void des_bs_rounds(bs_t *l, bs_t *r, const bs_t *key, bool decrypt) {
+    DES_BS_UNROLL(GCC unroll 16)
+    for (int round = 0; round < 16; round++) {
+        des_bs_f(l, r, key, des_key_bits[decrypt ? 15 - round : round]);
+        bs_t *t = l;
+        l = r;
+        r = t;
+    }
+}
+
+static DES_BS_NOINLINE void des_bs_encrypt(bs_t *l, bs_t *r, const bs_t *key) {
+    des_bs_rounds(l, r, key, false);
+}
+
+static DES_BS_NOINLINE void des_bs_decrypt(bs_t *l, bs_t *r, const bs_t *key) {
+    des_bs_rounds(l, r, key, true);
+}
+
+// swaps the off-diagonal blocks recursively: bit j of a[i] ends up as bit i of a[j]
+static void transpose64(uint64_t a[64]) {
+    uint64_t m = 0x00000000FFFFFFFFULL;
+    for (int j = 32; j != 0; j >>= 1, m ^= m << j) {
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+// applies FP to (hi, lo) and turns the bitsliced output into one 64-bit value per lane,
+// holding the output bytes in memory order like the block read as a uint64_t
+static void bs_output(const bs_t *hi, const bs_t *lo, uint64_t *out) {
+    bs_lanes_t pre[64];
+    for (int i = 0; i < 32; i++) {
+        pre[i].value = hi[i];
+        pre[32 + i].value = lo[i];
+    }
+    for (int e = 0; e < DES_BS_LANES / 64; e++) {
+        uint64_t m[64];
+        for (int n = 0; n < 64; n++) {
+            m[8 * (n >> 3) + 7 - (n & 7)] = pre[des_fp[n]].lanes64[e];
+        }
+        transpose64(m);
+        memcpy(out + 64 * e, m, sizeof(m));
+    }
+}
+
+void DES_BS_CRACK(const des_bs_job_t *job, uint32_t first, uint64_t out[2][DES_BS_MAX_LANES]) {
+    bs_t cand[64], fixed[64];
+    bs_candidate_key(cand, job, first);
+    for (int n = 0; n < 64; n++) {
+        fixed[n] = bs_broadcast(block_bit(job->fixed_half, n));
+    }
+
+    for (int b = 0; b < job->blocks; b++) {
+        // the same ciphertext in every lane
+        bs_t x[32], y[32];
+        for (int i = 0; i < 32; i++) {
+            x[i] = bs_broadcast(block_bit(job->block[b], des_ip[i]));
+            y[i] = bs_broadcast(block_bit(job->block[b], des_ip[32 + i]));
+        }
+        if (job->candidate_in_k1) {
+            // D_cand(E_fixed(D_cand(C)))
+            des_bs_decrypt(x, y, cand);
+            des_bs_encrypt(y, x, fixed);
+            des_bs_decrypt(x, y, cand);
+            bs_output(y, x, out[b]);
+        } else {
+            // D_fixed(E_cand(X)), X = D_fixed(C) being the same for all candidates
+            des_bs_encrypt(x, y, cand);
+            des_bs_decrypt(y, x, fixed);
+            bs_output(x, y, out[b]);
+        }
+    }
+}
+
+#ifdef NOSIMD_BUILD
+
+void des_ecb(const uint8_t key[8], const uint8_t in[8], uint8_t out[8], bool decrypt) {
+    uint8_t lr[64], t[64];
+    for (int i = 0; i < 64; i++) {
+        lr[i] = block_bit(in, des_ip[i]);
+    }
+    uint8_t *l = lr, *r = lr + 32;
+    for (int round = 0; round < 16; round++) {
+        const uint8_t *kb = des_key_bits[decrypt ? 15 - round : round];
+        uint8_t f[32];
+        for (int s = 0; s < 8; s++) {
+            uint8_t x[6];
+            for (int j = 0; j < 6; j++) {
+                x[j] = r[des_e[6 * s + j]] ^ block_bit(key, kb[6 * s + j]);
+            }
+            uint8_t v = des_sbox[s][16 * (x[0] << 1 | x[5]) + (x[1] << 3 | x[2] << 2 | x[3] << 1 | x[4])];
+            for (int j = 0; j < 4; j++) {
+                f[4 * s + j] = (v >> (3 - j)) & 1;
+            }
+        }
+        for (int i = 0; i < 32; i++) {
+            l[i] ^= f[des_p[i]];
+        }
+        uint8_t *tmp = l;
+        l = r;
+        r = tmp;
+    }
+    // (r, l) before FP
+    memcpy(t, r, 32);
+    memcpy(t + 32, l, 32);
+    memset(out, 0, 8);
+    for (int n = 0; n < 64; n++) {
+        out[n >> 3] |= t[des_fp[n]] << (7 - (n & 7));
+    }
+}
+
+des_bs_crack_t *des_bs_select(uint32_t *lanes, const char **name) {
+#if defined(MFULC_DES_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        *lanes = 256;
+        *name = "AVX2";
+        return des_bs_crack_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        *lanes = 128;
+        *name = "SSE2";
+        return des_bs_crack_SSE2;
+    }
+#endif
+#if defined(MFULC_DES_SIMD_NEON)
+    *lanes = 128;
+    *name = "NEON";
+    return des_bs_crack_NEON;
+#else
+    *lanes = 64;
+    *name = "NOSIMD";
+    return des_bs_crack_NOSIMD;
+#endif
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef MFULC_DES_CORE_H__
+#define MFULC_DES_CORE_H__
+
+// Bitsliced 2TDEA decryption for mfulc_des_brute.
+//
+// mfulc_des_core.c is compiled once per instruction set (64, 128 or 256 lanes). Only the
+// NOSIMD build defines NOSIMD_BUILD and carries the scalar DES and the dispatcher, which
+// selects the widest core the running CPU supports.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if ( defined (__i386__) || defined (__x86_64__) ) && !defined(_MSC_VER)
+#define MFULC_DES_SIMD_X86
+#endif
+#if ( defined(__arm64__) || defined(__aarch64__) ) && !defined(_MSC_VER)
+#define MFULC_DES_SIMD_NEON
+#endif
+
+// widest core, sizes the per batch output buffers
+#define DES_BS_MAX_LANES 256
+
+typedef struct {
+    bool candidate_in_k1;       // candidate bytes in K1 (segments 1-2) or in K2 (segments 3-4)
+    int var_offset;             // offset of the 4 candidate bytes in their key half
+    uint8_t candidate_half[8];  // key half holding the candidate, candidate bytes ignored
+    uint8_t fixed_half[8];      // the other key half
+    int blocks;                 // 1, or 2 in reader mode
+    uint8_t block[2][8];        // ciphertexts, D_fixed() already applied when candidate_in_k1 is false
+} des_bs_job_t;
+
+// Decrypts the job blocks with 2TDEA under candidates first .. first + lanes - 1, first being a
+// multiple of lanes. out[b][lane] gets block b in the in-memory byte order of the block.
+typedef void des_bs_crack_t(const des_bs_job_t *job, uint32_t first, uint64_t out[2][DES_BS_MAX_LANES]);
+des_bs_crack_t des_bs_crack_AVX2;
+des_bs_crack_t des_bs_crack_SSE2;
+des_bs_crack_t des_bs_crack_NEON;
+des_bs_crack_t des_bs_crack_NOSIMD;
+
+// Picks the widest core for this CPU, returns it and sets *lanes to its width.
+des_bs_crack_t *des_bs_select(uint32_t *lanes, const char **name);
+
+// Scalar single DES of one 8-byte block, used outside of the brute force loop.
+void des_ecb(const uint8_t key[8], const uint8_t in[8], uint8_t out[8], bool decrypt);
+
+#endif
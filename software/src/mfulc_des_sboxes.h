@@ -0,0 +1,746 @@
+// DES S-boxes as gate circuits for the bitsliced DES cores (mfulc_des_core.c).
+//
+// Generated from the DES S-box tables by Shannon/Davio decomposition with shared subterms,
+// taking for each S-box the variable order with the fewest gates. Inputs a1..a6 are the six
+// S-box input bits (a1 and a6 select the row), outputs o1..o4 the four output bits, MSB first.
+// bs_t is the bitslice type of the including core.
+
+#ifndef MFULC_DES_SBOXES_H__
+#define MFULC_DES_SBOXES_H__
+
+// 93 gates
+static inline void des_sbox1(bs_t a1, bs_t a2, bs_t a3, bs_t a4, bs_t a5, bs_t a6,
+                             bs_t *o1, bs_t *o2, bs_t *o3, bs_t *o4) {
+    bs_t t0 = ~a6;
+    bs_t t1 = a6 ^ a5;
+    bs_t t2 = a6 & a5;
+    bs_t t3 = t1 ^ t2;
+    bs_t t4 = t3 & a4;
+    bs_t t5 = t1 ^ t4;
+    bs_t t6 = t1 & a4;
+    bs_t t7 = t6 & ~a3;
+    bs_t t8 = t5 ^ t7;
+    bs_t t9 = ~a4;
+    bs_t t10 = t9 & ~a3;
+    bs_t t11 = a4 ^ t10;
+    bs_t t12 = t11 & ~a2;
+    bs_t t13 = t8 ^ t12;
+    bs_t t14 = ~a5;
+    bs_t t15 = a6 | t14;
+    bs_t t16 = ~t2;
+    bs_t t17 = a5 & a4;
+    bs_t t18 = t15 ^ t17;
+    bs_t t19 = t18 & ~a3;
+    bs_t t20 = ~t17;
+    bs_t t21 = a6 & ~a5;
+    bs_t t22 = t0 & a4;
+    bs_t t23 = t16 ^ t22;
+    bs_t t24 = t23 & ~a3;
+    bs_t t25 = t20 ^ t24;
+    bs_t t26 = t25 & ~a2;
+    bs_t t27 = t19 ^ t26;
+    bs_t t28 = t27 & a1;
+    bs_t t29 = t13 ^ t28;
+    bs_t t30 = ~t1;
+    bs_t t31 = ~t15;
+    bs_t t32 = t30 ^ t31;
+    bs_t t33 = t32 & a4;
+    bs_t t34 = t30 ^ t33;
+    bs_t t35 = ~t3;
+    bs_t t36 = t21 & a4;
+    bs_t t37 = t35 ^ t36;
+    bs_t t38 = t37 & ~a3;
+    bs_t t39 = t34 ^ t38;
+    bs_t t40 = t1 | t9;
+    bs_t t41 = a6 & ~a3;
+    bs_t t42 = t40 ^ t41;
+    bs_t t43 = t42 & ~a2;
+    bs_t t44 = t39 ^ t43;
+    bs_t t45 = t30 | a4;
+    bs_t t46 = t1 ^ t36;
+    bs_t t47 = t46 & ~a3;
+    bs_t t48 = t45 ^ t47;
+    bs_t t49 = t2 ^ t33;
+    bs_t t50 = t35 ^ t22;
+    bs_t t51 = t50 & ~a3;
+    bs_t t52 = t49 ^ t51;
+    bs_t t53 = t52 & ~a2;
+    bs_t t54 = t48 ^ t53;
+    bs_t t55 = t54 & a1;
+    bs_t t56 = t44 ^ t55;
+    bs_t t57 = ~a3;
+    bs_t t58 = t6 ^ t57;
+    bs_t t59 = t16 | t9;
+    bs_t t60 = t30 ^ t22;
+    bs_t t61 = t60 & ~a3;
+    bs_t t62 = t59 ^ t61;
+    bs_t t63 = t62 & ~a2;
+    bs_t t64 = t58 ^ t63;
+    bs_t t65 = t14 & a4;
+    bs_t t66 = t16 ^ t65;
+    bs_t t67 = t66 ^ t38;
+    bs_t t68 = t31 & a4;
+    bs_t t69 = a5 ^ t68;
+    bs_t t70 = t69 ^ t51;
+    bs_t t71 = t70 & ~a2;
+    bs_t t72 = t67 ^ t71;
+    bs_t t73 = t72 & a1;
+    bs_t t74 = t64 ^ t73;
+    bs_t t75 = t3 & ~a3;
+    bs_t t76 = t40 ^ t75;
+    bs_t t77 = t15 ^ t6;
+    bs_t t78 = t21 & ~a3;
+    bs_t t79 = t77 ^ t78;
+    bs_t t80 = t79 & ~a2;
+    bs_t t81 = t76 ^ t80;
+    bs_t t82 = t3 | a4;
+    bs_t t83 = t31 & ~a4;
+    bs_t t84 = t83 & ~a3;
+    bs_t t85 = t82 ^ t84;
+    bs_t t86 = t30 & a4;
+    bs_t t87 = t14 ^ t86;
+    bs_t t88 = t87 ^ t24;
+    bs_t t89 = t88 & ~a2;
+    bs_t t90 = t85 ^ t89;
+    bs_t t91 = t90 & a1;
+    bs_t t92 = t81 ^ t91;
+    *o1 = t29;
+    *o2 = t56;
+    *o3 = t74;
+    *o4 = t92;
+}
+
+// 80 gates
+static inline void des_sbox2(bs_t a1, bs_t a2, bs_t a3, bs_t a4, bs_t a5, bs_t a6,
+                             bs_t *o1, bs_t *o2, bs_t *o3, bs_t *o4) {
+    bs_t t0 = ~a6;
+    bs_t t1 = t0 ^ a3;
+    bs_t t2 = ~t1;
+    bs_t t3 = t1 ^ a1;
+    bs_t t4 = ~a3;
+    bs_t t5 = t0 | t4;
+    bs_t t6 = t5 & a1;
+    bs_t t7 = ~a1;
+    bs_t t8 = a6 | t7;
+    bs_t t9 = t8 & ~a4;
+    bs_t t10 = t6 ^ t9;
+    bs_t t11 = t10 & a5;
+    bs_t t12 = t3 ^ t11;
+    bs_t t13 = t0 & ~a3;
+    bs_t t14 = t13 | a1;
+    bs_t t15 = ~a4;
+    bs_t t16 = t14 ^ t15;
+    bs_t t17 = t7 ^ t9;
+    bs_t t18 = t17 & a5;
+    bs_t t19 = t16 ^ t18;
+    bs_t t20 = t19 & a2;
+    bs_t t21 = t12 ^ t20;
+    bs_t t22 = a6 & ~a3;
+    bs_t t23 = ~t22;
+    bs_t t24 = t22 ^ a1;
+    bs_t t25 = t24 ^ t15;
+    bs_t t26 = t22 & ~a4;
+    bs_t t27 = t23 ^ t26;
+    bs_t t28 = t27 & a5;
+    bs_t t29 = t25 ^ t28;
+    bs_t t30 = t0 & ~a4;
+    bs_t t31 = t2 ^ t30;
+    bs_t t32 = t13 & a1;
+    bs_t t33 = ~t8;
+    bs_t t34 = t33 & ~a4;
+    bs_t t35 = t32 ^ t34;
+    bs_t t36 = t35 & a5;
+    bs_t t37 = t31 ^ t36;
+    bs_t t38 = t37 & a2;
+    bs_t t39 = t29 ^ t38;
+    bs_t t40 = t0 & a3;
+    bs_t t41 = t40 ^ t6;
+    bs_t t42 = ~t40;
+    bs_t t43 = t42 | a1;
+    bs_t t44 = t43 & ~a4;
+    bs_t t45 = t41 ^ t44;
+    bs_t t46 = a3 | a1;
+    bs_t t47 = t46 & ~a4;
+    bs_t t48 = t8 ^ t47;
+    bs_t t49 = t48 & a5;
+    bs_t t50 = t45 ^ t49;
+    bs_t t51 = t1 & a1;
+    bs_t t52 = a6 ^ t51;
+    bs_t t53 = t52 & ~a4;
+    bs_t t54 = t23 ^ t53;
+    bs_t t55 = a6 & ~a1;
+    bs_t t56 = t55 & ~a4;
+    bs_t t57 = t32 ^ t56;
+    bs_t t58 = t57 & a5;
+    bs_t t59 = t54 ^ t58;
+    bs_t t60 = t59 & a2;
+    bs_t t61 = t50 ^ t60;
+    bs_t t62 = t40 ^ t32;
+    bs_t t63 = t62 ^ t15;
+    bs_t t64 = t40 & a1;
+    bs_t t65 = t2 ^ t64;
+    bs_t t66 = t65 ^ t56;
+    bs_t t67 = t66 & a5;
+    bs_t t68 = t63 ^ t67;
+    bs_t t69 = t23 & a1;
+    bs_t t70 = a6 ^ t69;
+    bs_t t71 = a6 & a1;
+    bs_t t72 = t71 & ~a4;
+    bs_t t73 = t70 ^ t72;
+    bs_t t74 = t13 ^ t69;
+    bs_t t75 = t74 ^ t30;
+    bs_t t76 = t75 & a5;
+    bs_t t77 = t73 ^ t76;
+    bs_t t78 = t77 & a2;
+    bs_t t79 = t68 ^ t78;
+    *o1 = t21;
+    *o2 = t39;
+    *o3 = t61;
+    *o4 = t79;
+}
+
+// 85 gates
+static inline void des_sbox3(bs_t a1, bs_t a2, bs_t a3, bs_t a4, bs_t a5, bs_t a6,
+                             bs_t *o1, bs_t *o2, bs_t *o3, bs_t *o4) {
+    bs_t t0 = ~a1;
+    bs_t t1 = a1 ^ a4;
+    bs_t t2 = a3 | t0;
+    bs_t t3 = t2 ^ a3;
+    bs_t t4 = t3 & a4;
+    bs_t t5 = t2 ^ t4;
+    bs_t t6 = t5 & a2;
+    bs_t t7 = t1 ^ t6;
+    bs_t t8 = ~t2;
+    bs_t t9 = ~a3;
+    bs_t t10 = a3 ^ a1;
+    bs_t t11 = t8 ^ t10;
+    bs_t t12 = t11 & a4;
+    bs_t t13 = t8 ^ t12;
+    bs_t t14 = ~t10;
+    bs_t t15 = t0 & a4;
+    bs_t t16 = a3 ^ t15;
+    bs_t t17 = t16 & a2;
+    bs_t t18 = t13 ^ t17;
+    bs_t t19 = t18 & ~a6;
+    bs_t t20 = t7 ^ t19;
+    bs_t t21 = ~t11;
+    bs_t t22 = t21 | a4;
+    bs_t t23 = a3 & a1;
+    bs_t t24 = t23 ^ t4;
+    bs_t t25 = t24 ^ t17;
+    bs_t t26 = t25 & ~a6;
+    bs_t t27 = t22 ^ t26;
+    bs_t t28 = t27 & ~a5;
+    bs_t t29 = t20 ^ t28;
+    bs_t t30 = t2 & a4;
+    bs_t t31 = t0 ^ t30;
+    bs_t t32 = ~a4;
+    bs_t t33 = t3 | t32;
+    bs_t t34 = t33 & a2;
+    bs_t t35 = t31 ^ t34;
+    bs_t t36 = t2 | t32;
+    bs_t t37 = a4 & a2;
+    bs_t t38 = t36 ^ t37;
+    bs_t t39 = t38 & ~a6;
+    bs_t t40 = t35 ^ t39;
+    bs_t t41 = ~t3;
+    bs_t t42 = t8 & a4;
+    bs_t t43 = a3 ^ t42;
+    bs_t t44 = t3 & a2;
+    bs_t t45 = t30 ^ t44;
+    bs_t t46 = t45 & ~a6;
+    bs_t t47 = t43 ^ t46;
+    bs_t t48 = t47 & ~a5;
+    bs_t t49 = t40 ^ t48;
+    bs_t t50 = t9 ^ a4;
+    bs_t t51 = t0 | a4;
+    bs_t t52 = t51 & a2;
+    bs_t t53 = t50 ^ t52;
+    bs_t t54 = ~t23;
+    bs_t t55 = t9 ^ t12;
+    bs_t t56 = t55 & a2;
+    bs_t t57 = t2 ^ t56;
+    bs_t t58 = t57 & ~a6;
+    bs_t t59 = t53 ^ t58;
+    bs_t t60 = t23 | t32;
+    bs_t t61 = t15 & a2;
+    bs_t t62 = t60 ^ t61;
+    bs_t t63 = t11 ^ t4;
+    bs_t t64 = t63 ^ t52;
+    bs_t t65 = t64 & ~a6;
+    bs_t t66 = t62 ^ t65;
+    bs_t t67 = t66 & ~a5;
+    bs_t t68 = t59 ^ t67;
+    bs_t t69 = t54 | a4;
+    bs_t t70 = t69 & a2;
+    bs_t t71 = t14 ^ t70;
+    bs_t t72 = ~t69;
+    bs_t t73 = t72 & a2;
+    bs_t t74 = t51 ^ t73;
+    bs_t t75 = t74 & ~a6;
+    bs_t t76 = t71 ^ t75;
+    bs_t t77 = t41 ^ t15;
+    bs_t t78 = t23 & a2;
+    bs_t t79 = t77 ^ t78;
+    bs_t t80 = a1 & a2;
+    bs_t t81 = t80 & ~a6;
+    bs_t t82 = t79 ^ t81;
+    bs_t t83 = t82 & ~a5;
+    bs_t t84 = t76 ^ t83;
+    *o1 = t29;
+    *o2 = t49;
+    *o3 = t68;
+    *o4 = t84;
+}
+
+// 60 gates
+static inline void des_sbox4(bs_t a1, bs_t a2, bs_t a3, bs_t a4, bs_t a5, bs_t a6,
+                             bs_t *o1, bs_t *o2, bs_t *o3, bs_t *o4) {
+    bs_t t0 = ~a5;
+    bs_t t1 = t0 | a3;
+    bs_t t2 = t0 ^ a3;
+    bs_t t3 = t1 ^ t2;
+    bs_t t4 = t3 & a1;
+    bs_t t5 = t1 ^ t4;
+    bs_t t6 = ~a1;
+    bs_t t7 = t3 | t6;
+    bs_t t8 = t7 & ~a4;
+    bs_t t9 = t5 ^ t8;
+    bs_t t10 = t3 | a1;
+    bs_t t11 = ~a3;
+    bs_t t12 = t2 & a1;
+    bs_t t13 = a5 ^ t12;
+    bs_t t14 = t13 & ~a4;
+    bs_t t15 = t10 ^ t14;
+    bs_t t16 = t15 & a2;
+    bs_t t17 = t9 ^ t16;
+    bs_t t18 = t0 & ~a3;
+    bs_t t19 = t1 & a1;
+    bs_t t20 = t18 ^ t19;
+    bs_t t21 = a5 & ~a4;
+    bs_t t22 = t20 ^ t21;
+    bs_t t23 = ~t12;
+    bs_t t24 = a3 ^ t12;
+    bs_t t25 = t24 & ~a4;
+    bs_t t26 = t23 ^ t25;
+    bs_t t27 = t26 & a2;
+    bs_t t28 = t22 ^ t27;
+    bs_t t29 = t17 ^ t28;
+    bs_t t30 = t29 & a6;
+    bs_t t31 = t17 ^ t30;
+    bs_t t32 = ~t17;
+    bs_t t33 = t28 ^ t32;
+    bs_t t34 = t33 & a6;
+    bs_t t35 = t28 ^ t34;
+    bs_t t36 = ~t3;
+    bs_t t37 = t36 ^ a1;
+    bs_t t38 = ~t1;
+    bs_t t39 = t38 | a1;
+    bs_t t40 = t39 & ~a4;
+    bs_t t41 = t37 ^ t40;
+    bs_t t42 = t11 ^ t4;
+    bs_t t43 = t42 ^ t25;
+    bs_t t44 = t43 & a2;
+    bs_t t45 = t41 ^ t44;
+    bs_t t46 = t36 & a1;
+    bs_t t47 = t2 ^ t46;
+    bs_t t48 = t0 & ~a4;
+    bs_t t49 = t47 ^ t48;
+    bs_t t50 = a3 ^ t14;
+    bs_t t51 = t50 & a2;
+    bs_t t52 = t49 ^ t51;
+    bs_t t53 = t45 ^ t52;
+    bs_t t54 = t53 & a6;
+    bs_t t55 = t45 ^ t54;
+    bs_t t56 = ~t52;
+    bs_t t57 = t56 ^ t45;
+    bs_t t58 = t57 & a6;
+    bs_t t59 = t56 ^ t58;
+    *o1 = t31;
+    *o2 = t35;
+    *o3 = t55;
+    *o4 = t59;
+}
+
+// 91 gates
+static inline void des_sbox5(bs_t a1, bs_t a2, bs_t a3, bs_t a4, bs_t a5, bs_t a6,
+                             bs_t *o1, bs_t *o2, bs_t *o3, bs_t *o4) {
+    bs_t t0 = ~a5;
+    bs_t t1 = a5 ^ a2;
+    bs_t t2 = a2 & a3;
+    bs_t t3 = t1 ^ t2;
+    bs_t t4 = a5 & a2;
+    bs_t t5 = ~a3;
+    bs_t t6 = t4 | t5;
+    bs_t t7 = t6 & a6;
+    bs_t t8 = t3 ^ t7;
+    bs_t t9 = ~t1;
+    bs_t t10 = a5 ^ t9;
+    bs_t t11 = t10 & a3;
+    bs_t t12 = a5 ^ t11;
+    bs_t t13 = t0 | a2;
+    bs_t t14 = t0 & a3;
+    bs_t t15 = t4 ^ t14;
+    bs_t t16 = t15 & a6;
+    bs_t t17 = t12 ^ t16;
+    bs_t t18 = t17 & ~a4;
+    bs_t t19 = t8 ^ t18;
+    bs_t t20 = a5 | a2;
+    bs_t t21 = ~t4;
+    bs_t t22 = t9 & a3;
+    bs_t t23 = t20 ^ t22;
+    bs_t t24 = t9 & ~a3;
+    bs_t t25 = t24 & a6;
+    bs_t t26 = t23 ^ t25;
+    bs_t t27 = t0 & a2;
+    bs_t t28 = ~t13;
+    bs_t t29 = t1 & a3;
+    bs_t t30 = t27 ^ t29;
+    bs_t t31 = ~t27;
+    bs_t t32 = t31 & a6;
+    bs_t t33 = t30 ^ t32;
+    bs_t t34 = t33 & ~a4;
+    bs_t t35 = t26 ^ t34;
+    bs_t t36 = t35 & ~a1;
+    bs_t t37 = t19 ^ t36;
+    bs_t t38 = a2 ^ t14;
+    bs_t t39 = t38 ^ a6;
+    bs_t t40 = t9 | a3;
+    bs_t t41 = t1 ^ t14;
+    bs_t t42 = t41 & a6;
+    bs_t t43 = t40 ^ t42;
+    bs_t t44 = t43 & ~a4;
+    bs_t t45 = t39 ^ t44;
+    bs_t t46 = t0 | a3;
+    bs_t t47 = a5 ^ t29;
+    bs_t t48 = t3 & a6;
+    bs_t t49 = t47 ^ t48;
+    bs_t t50 = t49 & ~a4;
+    bs_t t51 = t46 ^ t50;
+    bs_t t52 = t51 & ~a1;
+    bs_t t53 = t45 ^ t52;
+    bs_t t54 = t31 & a3;
+    bs_t t55 = t28 ^ t54;
+    bs_t t56 = t27 ^ t32;
+    bs_t t57 = t56 & ~a4;
+    bs_t t58 = t55 ^ t57;
+    bs_t t59 = ~t20;
+    bs_t t60 = t59 | a3;
+    bs_t t61 = t60 & a6;
+    bs_t t62 = t20 ^ t61;
+    bs_t t63 = t4 ^ t22;
+    bs_t t64 = t63 & a6;
+    bs_t t65 = t24 ^ t64;
+    bs_t t66 = t65 & ~a4;
+    bs_t t67 = t62 ^ t66;
+    bs_t t68 = t67 & ~a1;
+    bs_t t69 = t58 ^ t68;
+    bs_t t70 = a5 & a3;
+    bs_t t71 = t31 ^ t70;
+    bs_t t72 = t71 ^ t61;
+    bs_t t73 = t21 ^ t2;
+    bs_t t74 = t27 & a6;
+    bs_t t75 = t73 ^ t74;
+    bs_t t76 = t75 & ~a4;
+    bs_t t77 = t72 ^ t76;
+    bs_t t78 = t13 & a3;
+    bs_t t79 = t0 ^ t78;
+    bs_t t80 = t20 & a3;
+    bs_t t81 = t31 ^ t80;
+    bs_t t82 = t81 & a6;
+    bs_t t83 = t79 ^ t82;
+    bs_t t84 = t59 ^ t29;
+    bs_t t85 = t14 & a6;
+    bs_t t86 = t84 ^ t85;
+    bs_t t87 = t86 & ~a4;
+    bs_t t88 = t83 ^ t87;
+    bs_t t89 = t88 & ~a1;
+    bs_t t90 = t77 ^ t89;
+    *o1 = t37;
+    *o2 = t53;
+    *o3 = t69;
+    *o4 = t90;
+}
+
+// 86 gates
+static inline void des_sbox6(bs_t a1, bs_t a2, bs_t a3, bs_t a4, bs_t a5, bs_t a6,
+                             bs_t *o1, bs_t *o2, bs_t *o3, bs_t *o4) {
+    bs_t t0 = ~a6;
+    bs_t t1 = t0 ^ a2;
+    bs_t t2 = ~a2;
+    bs_t t3 = a6 | t2;
+    bs_t t4 = t3 ^ a2;
+    bs_t t5 = t4 & a5;
+    bs_t t6 = t3 ^ t5;
+    bs_t t7 = t6 & a3;
+    bs_t t8 = t1 ^ t7;
+    bs_t t9 = ~t4;
+    bs_t t10 = t9 | a5;
+    bs_t t11 = t0 & ~a5;
+    bs_t t12 = t11 & a3;
+    bs_t t13 = t10 ^ t12;
+    bs_t t14 = t13 & a4;
+    bs_t t15 = t8 ^ t14;
+    bs_t t16 = ~t11;
+    bs_t t17 = t0 | a2;
+    bs_t t18 = t17 & ~a5;
+    bs_t t19 = t18 & a3;
+    bs_t t20 = t16 ^ t19;
+    bs_t t21 = ~t17;
+    bs_t t22 = t21 & ~a5;
+    bs_t t23 = t9 & a3;
+    bs_t t24 = t22 ^ t23;
+    bs_t t25 = t24 & a4;
+    bs_t t26 = t20 ^ t25;
+    bs_t t27 = t26 & ~a1;
+    bs_t t28 = t15 ^ t27;
+    bs_t t29 = ~t1;
+    bs_t t30 = t29 ^ a5;
+    bs_t t31 = a6 | a2;
+    bs_t t32 = t31 | a5;
+    bs_t t33 = t32 & a3;
+    bs_t t34 = t30 ^ t33;
+    bs_t t35 = t2 ^ t21;
+    bs_t t36 = t35 & a5;
+    bs_t t37 = t2 ^ t36;
+    bs_t t38 = t37 ^ t23;
+    bs_t t39 = t38 & a4;
+    bs_t t40 = t34 ^ t39;
+    bs_t t41 = t35 | a5;
+    bs_t t42 = t41 & a3;
+    bs_t t43 = ~t42;
+    bs_t t44 = t1 & a5;
+    bs_t t45 = t9 ^ a5;
+    bs_t t46 = t45 & a3;
+    bs_t t47 = t44 ^ t46;
+    bs_t t48 = t47 & a4;
+    bs_t t49 = t43 ^ t48;
+    bs_t t50 = t49 & ~a1;
+    bs_t t51 = t40 ^ t50;
+    bs_t t52 = a2 ^ t5;
+    bs_t t53 = t31 & a5;
+    bs_t t54 = t0 ^ t53;
+    bs_t t55 = t54 & a3;
+    bs_t t56 = t52 ^ t55;
+    bs_t t57 = ~a5;
+    bs_t t58 = t4 | t57;
+    bs_t t59 = t58 & a4;
+    bs_t t60 = t56 ^ t59;
+    bs_t t61 = ~t3;
+    bs_t t62 = t17 & a5;
+    bs_t t63 = t1 ^ t62;
+    bs_t t64 = t63 & a3;
+    bs_t t65 = t30 ^ t64;
+    bs_t t66 = t53 & a4;
+    bs_t t67 = t65 ^ t66;
+    bs_t t68 = t67 & ~a1;
+    bs_t t69 = t60 ^ t68;
+    bs_t t70 = t17 ^ a5;
+    bs_t t71 = t3 ^ a5;
+    bs_t t72 = t71 & a3;
+    bs_t t73 = t70 ^ t72;
+    bs_t t74 = ~t71;
+    bs_t t75 = t61 & a3;
+    bs_t t76 = t74 ^ t75;
+    bs_t t77 = t76 & a4;
+    bs_t t78 = t73 ^ t77;
+    bs_t t79 = t17 ^ t46;
+    bs_t t80 = t9 ^ t62;
+    bs_t t81 = t80 ^ t12;
+    bs_t t82 = t81 & a4;
+    bs_t t83 = t79 ^ t82;
+    bs_t t84 = t83 & ~a1;
+    bs_t t85 = t78 ^ t84;
+    *o1 = t28;
+    *o2 = t51;
+    *o3 = t69;
+    *o4 = t85;
+}
+
+// 84 gates
+static inline void des_sbox7(bs_t a1, bs_t a2, bs_t a3, bs_t a4, bs_t a5, bs_t a6,
+                             bs_t *o1, bs_t *o2, bs_t *o3, bs_t *o4) {
+    bs_t t0 = ~a5;
+    bs_t t1 = a5 ^ a3;
+    bs_t t2 = a5 | a3;
+    bs_t t3 = t1 ^ t2;
+    bs_t t4 = t3 & a4;
+    bs_t t5 = t1 ^ t4;
+    bs_t t6 = a3 | a4;
+    bs_t t7 = t6 & a2;
+    bs_t t8 = t5 ^ t7;
+    bs_t t9 = ~t4;
+    bs_t t10 = a3 & ~a4;
+    bs_t t11 = t10 & a2;
+    bs_t t12 = t9 ^ t11;
+    bs_t t13 = t12 & a6;
+    bs_t t14 = t8 ^ t13;
+    bs_t t15 = t0 & a3;
+    bs_t t16 = ~t15;
+    bs_t t17 = t15 ^ a4;
+    bs_t t18 = ~t3;
+    bs_t t19 = a5 & a4;
+    bs_t t20 = t18 ^ t19;
+    bs_t t21 = t20 & a2;
+    bs_t t22 = t17 ^ t21;
+    bs_t t23 = t1 ^ t19;
+    bs_t t24 = t23 & a6;
+    bs_t t25 = t22 ^ t24;
+    bs_t t26 = t14 ^ t25;
+    bs_t t27 = t26 & a1;
+    bs_t t28 = t14 ^ t27;
+    bs_t t29 = t0 ^ a4;
+    bs_t t30 = ~a3;
+    bs_t t31 = t30 ^ a4;
+    bs_t t32 = t31 & a2;
+    bs_t t33 = t29 ^ t32;
+    bs_t t34 = ~t19;
+    bs_t t35 = t34 & a2;
+    bs_t t36 = t4 ^ t35;
+    bs_t t37 = t36 & a6;
+    bs_t t38 = t33 ^ t37;
+    bs_t t39 = t9 ^ t32;
+    bs_t t40 = t39 & a6;
+    bs_t t41 = t8 ^ t40;
+    bs_t t42 = t38 ^ t41;
+    bs_t t43 = t42 & a1;
+    bs_t t44 = t38 ^ t43;
+    bs_t t45 = t0 & a4;
+    bs_t t46 = t1 ^ t45;
+    bs_t t47 = t46 ^ t35;
+    bs_t t48 = t2 & a4;
+    bs_t t49 = t1 ^ t48;
+    bs_t t50 = t1 & a4;
+    bs_t t51 = t50 & a2;
+    bs_t t52 = t49 ^ t51;
+    bs_t t53 = t52 & a6;
+    bs_t t54 = t47 ^ t53;
+    bs_t t55 = t3 ^ t45;
+    bs_t t56 = ~t17;
+    bs_t t57 = t56 & a2;
+    bs_t t58 = t55 ^ t57;
+    bs_t t59 = t16 ^ t19;
+    bs_t t60 = ~t59;
+    bs_t t61 = t60 & a2;
+    bs_t t62 = t59 ^ t61;
+    bs_t t63 = t62 & a6;
+    bs_t t64 = t58 ^ t63;
+    bs_t t65 = t54 ^ t64;
+    bs_t t66 = t65 & a1;
+    bs_t t67 = t54 ^ t66;
+    bs_t t68 = t30 & a2;
+    bs_t t69 = t49 ^ t68;
+    bs_t t70 = t45 & a2;
+    bs_t t71 = ~t70;
+    bs_t t72 = t71 & a6;
+    bs_t t73 = t69 ^ t72;
+    bs_t t74 = ~t69;
+    bs_t t75 = ~a4;
+    bs_t t76 = t2 | t75;
+    bs_t t77 = t23 & a2;
+    bs_t t78 = t76 ^ t77;
+    bs_t t79 = t78 & a6;
+    bs_t t80 = t74 ^ t79;
+    bs_t t81 = t73 ^ t80;
+    bs_t t82 = t81 & a1;
+    bs_t t83 = t73 ^ t82;
+    *o1 = t28;
+    *o2 = t44;
+    *o3 = t67;
+    *o4 = t83;
+}
+
+// 84 gates
+static inline void des_sbox8(bs_t a1, bs_t a2, bs_t a3, bs_t a4, bs_t a5, bs_t a6,
+                             bs_t *o1, bs_t *o2, bs_t *o3, bs_t *o4) {
+    bs_t t0 = ~a1;
+    bs_t t1 = a5 | a1;
+    bs_t t2 = t0 ^ t1;
+    bs_t t3 = t2 & a4;
+    bs_t t4 = t0 ^ t3;
+    bs_t t5 = ~a5;
+    bs_t t6 = t5 | t0;
+    bs_t t7 = t6 & a3;
+    bs_t t8 = t4 ^ t7;
+    bs_t t9 = a5 | a4;
+    bs_t t10 = t0 & a4;
+    bs_t t11 = t10 & a3;
+    bs_t t12 = t9 ^ t11;
+    bs_t t13 = t12 & ~a2;
+    bs_t t14 = t8 ^ t13;
+    bs_t t15 = a5 ^ a1;
+    bs_t t16 = t2 ^ t15;
+    bs_t t17 = t16 & a4;
+    bs_t t18 = t2 ^ t17;
+    bs_t t19 = t18 ^ a3;
+    bs_t t20 = ~t1;
+    bs_t t21 = ~a4;
+    bs_t t22 = t20 | t21;
+    bs_t t23 = ~t16;
+    bs_t t24 = t23 & a3;
+    bs_t t25 = t22 ^ t24;
+    bs_t t26 = t25 & ~a2;
+    bs_t t27 = t19 ^ t26;
+    bs_t t28 = t14 ^ t27;
+    bs_t t29 = t28 & a6;
+    bs_t t30 = t14 ^ t29;
+    bs_t t31 = ~t6;
+    bs_t t32 = t31 ^ a5;
+    bs_t t33 = t32 & a4;
+    bs_t t34 = t31 ^ t33;
+    bs_t t35 = t2 & a3;
+    bs_t t36 = t34 ^ t35;
+    bs_t t37 = t20 & a4;
+    bs_t t38 = t2 ^ t37;
+    bs_t t39 = t0 | a4;
+    bs_t t40 = t39 & a3;
+    bs_t t41 = t38 ^ t40;
+    bs_t t42 = t41 & ~a2;
+    bs_t t43 = t36 ^ t42;
+    bs_t t44 = t5 & a3;
+    bs_t t45 = t22 ^ t44;
+    bs_t t46 = t0 & a3;
+    bs_t t47 = t38 ^ t46;
+    bs_t t48 = t47 & ~a2;
+    bs_t t49 = t45 ^ t48;
+    bs_t t50 = t43 ^ t49;
+    bs_t t51 = t50 & a6;
+    bs_t t52 = t43 ^ t51;
+    bs_t t53 = ~t15;
+    bs_t t54 = t1 & a4;
+    bs_t t55 = t53 ^ t54;
+    bs_t t56 = t55 ^ t44;
+    bs_t t57 = t31 & a3;
+    bs_t t58 = t6 ^ t57;
+    bs_t t59 = t58 & ~a2;
+    bs_t t60 = t56 ^ t59;
+    bs_t t61 = t6 & a4;
+    bs_t t62 = t23 ^ t61;
+    bs_t t63 = t32 ^ a4;
+    bs_t t64 = t63 & a3;
+    bs_t t65 = t62 ^ t64;
+    bs_t t66 = t32 | a4;
+    bs_t t67 = t21 & a3;
+    bs_t t68 = t66 ^ t67;
+    bs_t t69 = t68 & ~a2;
+    bs_t t70 = t65 ^ t69;
+    bs_t t71 = t60 ^ t70;
+    bs_t t72 = t71 & a6;
+    bs_t t73 = t60 ^ t72;
+    bs_t t74 = ~t27;
+    bs_t t75 = t9 & a3;
+    bs_t t76 = t15 ^ t75;
+    bs_t t77 = t2 | a4;
+    bs_t t78 = t77 ^ t40;
+    bs_t t79 = t78 & ~a2;
+    bs_t t80 = t76 ^ t79;
+    bs_t t81 = t74 ^ t80;
+    bs_t t82 = t81 & a6;
+    bs_t t83 = t74 ^ t82;
+    *o1 = t30;
+    *o2 = t52;
+    *o3 = t73;
+    *o4 = t83;
+}
+
+#endif
@@ -0,0 +1,292 @@
+// noproto & doegox, 2025
+// cf "BREAKMEIFYOUCAN!: Exploiting Keyspace Reduction and Relay Attacks in 3DES and AES-protected NFC Technologies"
+// for more info
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "mfulc_des_search.h"
+
+#ifdef _MSC_VER
+# define bswap64 _byteswap_uint64
+#else
+# define bswap64 __builtin_bswap64
+#endif
+
+#define BENCHMARK_FULL_KEYSPACE 0
+#define CHUNK_CANDIDATES (1UL << 14)  // handed out to the threads on demand, multiple of DES_BS_MAX_LANES
+#define PROGRESS_INTERVAL_MS 500
+
+typedef struct {
+    mfulc_search_t *search;
+    int thread_id;
+} thread_args_t;
+
+static bool valid_lfsr_ulcg(uint64_t x64) {
+    x64 = bswap64(x64);
+    uint16_t x16 = x64 >> 48;
+    x16 = x16 << 15 | ((x16 >> 1) ^ ((x16 >> 3 ^ x16 >> 4 ^ x16 >> 6) & 1));
+    if (x16 != ((x64 >> 32) & 0xFFFF)) return false;
+    x16 = x16 << 15 | ((x16 >> 1) ^ ((x16 >> 3 ^ x16 >> 4 ^ x16 >> 6) & 1));
+    if (x16 != ((x64 >> 16) & 0xFFFF)) return false;
+    x16 = x16 << 15 | ((x16 >> 1) ^ ((x16 >> 3 ^ x16 >> 4 ^ x16 >> 6) & 1));
+    if (x16 != (x64 & 0xFFFF)) return false;
+    return true;
+}
+
+static bool valid_lfsr_uscuidul(uint64_t x64) {
+    x64 = bswap64(x64);
+    uint16_t x16 = x64 & 0xFFFF;
+    for (int i = 0; i < 16; i++) x16 = x16 >> 1 | (x16 ^ x16 >> 2 ^ x16 >> 3 ^ x16 >> 5) << 15;
+    if (x16 != ((x64 >> 16) & 0xFFFF)) return false;
+    for (int i = 0; i < 16; i++) x16 = x16 >> 1 | (x16 ^ x16 >> 2 ^ x16 >> 3 ^ x16 >> 5) << 15;
+    if (x16 != ((x64 >> 32) & 0xFFFF)) return false;
+    for (int i = 0; i < 16; i++) x16 = x16 >> 1 | (x16 ^ x16 >> 2 ^ x16 >> 3 ^ x16 >> 5) << 15;
+    if (x16 != ((x64 >> 48) & 0xFFFF)) return false;
+    return true;
+}
+
+
+static bool valid_lfsr(uint64_t x64, lfsr_t lfsr_type) {
+    switch (lfsr_type) {
+        case LFSR_ULCG:
+            return valid_lfsr_ulcg(x64);
+        case LFSR_USCUIDUL:
+            return valid_lfsr_uscuidul(x64);
+        case LFSR_UNDEF:
+        default:
+            return false;
+    }
+}
+
+lfsr_t mfulc_detect_lfsr_type(const unsigned char *init_ciphertext) {
+    const uint8_t fixed_key[8] = {0};
+    uint64_t out;
+    des_ecb(fixed_key, init_ciphertext, (uint8_t *)&out, true);
+    if (valid_lfsr_ulcg(out)) {
+        return LFSR_ULCG;
+    } else if (valid_lfsr_uscuidul(out)) {
+        return LFSR_USCUIDUL;
+    }
+    return LFSR_UNDEF;
+}
+
+static uint64_t msclock(void) {
+#ifdef _WIN32
+    return GetTickCount64();
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000 + t.tv_nsec / 1000000;
+#endif
+}
+
+// Next chunk of candidates, false once the key space is exhausted or the key was found.
+static bool next_chunk(mfulc_search_t *search, uint32_t *start) {
+    bool ok = false;
+    pthread_mutex_lock(&search->lock);
+    if ((!search->key_found || BENCHMARK_FULL_KEYSPACE) && search->next_candidate < MFULC_CANDIDATES) {
+        *start = search->next_candidate;
+        search->next_candidate += CHUNK_CANDIDATES;
+        ok = true;
+    }
+    pthread_mutex_unlock(&search->lock);
+    return ok;
+}
+
+static void report_key(mfulc_search_t *search, int thread_id, uint32_t idx) {
+    pthread_mutex_lock(&search->lock);
+    search->key_found = 1;  // signal to other threads
+    search->found_index = idx;
+    search->found_thread = thread_id;
+    pthread_mutex_unlock(&search->lock);
+}
+
+void mfulc_apply_candidate(unsigned char *key, int key_mode, uint32_t idx) {
+    int seg_offset = key_mode * 4;  // key_mode: 0->bytes0, 1->bytes4, 2->bytes8, 3->bytes12.
+    for (int i = 0; i < 4; i++) {
+        // Each candidate byte is a 7-bit chunk of the index shifted left by 1 so that the LSB is zero.
+        key[seg_offset + i] = ((idx >> (7 * i)) & 0x7F) << 1;
+    }
+}
+
+// Takes chunks of candidates of the current job until the key is found and decrypts them a
+// bitslice batch at a time.
+static void search_segment(mfulc_search_t *search, int thread_id) {
+    uint64_t out[2][DES_BS_MAX_LANES];
+    uint32_t start;
+
+    while (next_chunk(search, &start)) {
+        for (uint32_t first = start; first < start + CHUNK_CANDIDATES; first += search->lanes) {
+            if (search->key_found && !BENCHMARK_FULL_KEYSPACE)
+                return;  // Some other thread already found the key.
+            search->crack(&search->job, first, out);
+
+            for (uint32_t lane = 0; lane < search->lanes; lane++) {
+                bool match;
+                if (search->is_reader_mode) {
+                    // In reader mode out[1] is the decrypted init_ciphertext, check the rotation relationship.
+                    // Apply XOR block to the second decrypted block (for CBC mode)
+                    uint64_t dec = out[0][lane] ^ search->prev_ciphertext;
+
+                    // Check if out is 8-bit (1-byte) left rotated version of init_out
+                    // Need to convert to big-endian for byte rotation, then back to little-endian
+                    uint64_t init_be = bswap64(out[1][lane]);
+                    uint64_t rotated_be = (init_be << 8) | (init_be >> 56);
+                    match = (dec == bswap64(rotated_be));
+                } else {
+                    // In counterfeit mode, check the resulting plaintext against LFSR
+                    match = valid_lfsr(out[0][lane], search->lfsr_type);
+                }
+                if (match) {
+                    report_key(search, thread_id, first + lane);
+                    if (!BENCHMARK_FULL_KEYSPACE)
+                        return;
+                }
+            }
+        }
+    }
+}
+
+// Worker thread function: searches each job until told to quit.
+static void *worker(void *arg) {
+    thread_args_t *targs = (thread_args_t *) arg;
+    mfulc_search_t *search = targs->search;
+    unsigned int generation = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&search->lock);
+        while (!search->quit && search->generation == generation)
+            pthread_cond_wait(&search->wake, &search->lock);
+        generation = search->generation;
+        bool quit = search->quit;
+        pthread_mutex_unlock(&search->lock);
+        if (quit)
+            return NULL;
+
+        search_segment(search, targs->thread_id);
+
+        pthread_mutex_lock(&search->lock);
+        if (--search->running == 0)
+            pthread_cond_signal(&search->done);
+        pthread_mutex_unlock(&search->lock);
+    }
+}
+
+bool mfulc_search_start(mfulc_search_t *search, int threads) {
+    search->crack = des_bs_select(&search->lanes, &search->core_name);
+    search->workers = malloc(threads * sizeof(pthread_t));
+    thread_args_t *targs = malloc(threads * sizeof(thread_args_t));
+    if (!search->workers || !targs) {
+        free(search->workers);
+        free(targs);
+        search->workers = NULL;
+        return false;
+    }
+    search->worker_args = targs;
+    pthread_mutex_init(&search->lock, NULL);
+    pthread_cond_init(&search->wake, NULL);
+    pthread_cond_init(&search->done, NULL);
+
+    // Threads take chunks of the 2^28 candidates as they go, so none idles while others still work.
+    // They are started once and wait for the next job in between segments.
+    search->threads = threads;
+    for (int i = 0; i < threads; i++) {
+        targs[i].search = search;
+        targs[i].thread_id = i;
+        pthread_create(&search->workers[i], NULL, worker, &targs[i]);
+    }
+    return true;
+}
+
+void mfulc_search_stop(mfulc_search_t *search) {
+    pthread_mutex_lock(&search->lock);
+    search->quit = true;
+    pthread_cond_broadcast(&search->wake);
+    pthread_mutex_unlock(&search->lock);
+    for (int i = 0; i < search->threads; i++)
+        pthread_join(search->workers[i], NULL);
+    pthread_cond_destroy(&search->done);
+    pthread_cond_destroy(&search->wake);
+    pthread_mutex_destroy(&search->lock);
+
+    free(search->workers);
+    free(search->worker_args);
+    search->workers = NULL;
+    search->worker_args = NULL;
+}
+
+// Hands the prepared job to the workers and waits for them to finish it, calling progress every
+// PROGRESS_INTERVAL_MS if set.
+bool mfulc_run_job(mfulc_search_t *search) {
+    pthread_mutex_lock(&search->lock);
+    search->key_found = 0;
+    search->next_candidate = 0;
+    search->running = search->threads;
+    search->generation++;
+    pthread_cond_broadcast(&search->wake);
+    while (search->running > 0) {
+        if (!search->progress) {
+            pthread_cond_wait(&search->done, &search->lock);
+            continue;
+        }
+        struct timespec deadline;
+        timespec_get(&deadline, TIME_UTC);
+        deadline.tv_nsec += PROGRESS_INTERVAL_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        if (pthread_cond_timedwait(&search->done, &search->lock, &deadline) != 0 && search->running > 0) {
+            uint32_t next_candidate = search->next_candidate;
+            pthread_mutex_unlock(&search->lock);
+            search->progress(search, next_candidate);
+            pthread_mutex_lock(&search->lock);
+        }
+    }
+    search->searched += search->next_candidate;
+    bool found = search->key_found;
+    pthread_mutex_unlock(&search->lock);
+    return found;
+}
+
+void mfulc_setup_job(mfulc_search_t *search, int key_mode, unsigned char blocks[][MFULC_BLOCK_SIZE], int block_count) {
+    search->key_mode = key_mode;
+
+    // For key_mode 0 or 1 the candidate is in K1; for key_mode 2 or 3 the candidate is in K2,
+    // at offset 0 for segments 1 and 3, at offset 4 for segments 2 and 4.
+    des_bs_job_t *job = &search->job;
+    job->candidate_in_k1 = key_mode < 2;
+    job->var_offset = (key_mode % 2) * 4;
+    memcpy(job->candidate_half, search->base_key + (job->candidate_in_k1 ? 0 : 8), 8);
+    memcpy(job->fixed_half, search->base_key + (job->candidate_in_k1 ? 8 : 0), 8);
+    job->blocks = block_count;
+    for (int b = 0; b < block_count; b++) {
+        memcpy(job->block[b], blocks[b], MFULC_BLOCK_SIZE);
+        if (!job->candidate_in_k1) {
+            // D_K1(E_K2(D_K1(C))): the inner decryption doesn't depend on the candidate
+            des_ecb(job->fixed_half, job->block[b], job->block[b], true);
+        }
+    }
+}
+
+bool mfulc_search_segments(mfulc_search_t *search, unsigned char ciphertexts[4][MFULC_BLOCK_SIZE]) {
+    // the order the ERndB were taken in
+    static const int segment_order[4] = {2, 1, 4, 3};
+    search->start_ms = msclock();
+    for (int i = 0; i < 4; i++) {
+        search->segment = segment_order[i];
+        search->segment_index = i;
+        search->segments_left = 3 - i;
+        mfulc_setup_job(search, search->segment - 1, &ciphertexts[search->segment - 1], 1);
+        if (!mfulc_run_job(search))
+            return false;
+        mfulc_apply_candidate(search->base_key, search->key_mode, search->found_index);
+        if (search->found)
+            search->found(search);
+    }
+    return true;
+}
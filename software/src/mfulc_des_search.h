@@ -0,0 +1,83 @@
+#ifndef MFULC_DES_SEARCH_H__
+#define MFULC_DES_SEARCH_H__
+
+// Multithreaded search of one 4-byte segment of a MIFARE Ultralight C 2TDEA key, shared by
+// mfulc_des_brute and the mfcrack library.
+//
+// mfulc_search_start() starts the workers once, then each mfulc_setup_job() / mfulc_run_job()
+// pair searches one segment with them until mfulc_search_stop().
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pthread.h"
+#include "mfulc_des_core.h"
+
+#define MFULC_BLOCK_SIZE 8   // DES (and 3DES) block size in bytes
+#define MFULC_KEY_SIZE   16  // Full 2TDEA key size (K1 || K2)
+#define MFULC_CANDIDATES (1UL << 28)
+
+typedef enum {
+    LFSR_UNDEF = 0,
+    LFSR_ULCG = 1,
+    LFSR_USCUIDUL = 2
+} lfsr_t;
+
+typedef struct mfulc_search mfulc_search_t;
+
+// progress is called every half second while a job runs, found after each segment found by
+// mfulc_search_segments()
+typedef void mfulc_progress_cb(const mfulc_search_t *search, uint32_t next_candidate);
+typedef void mfulc_found_cb(const mfulc_search_t *search);
+
+struct mfulc_search {
+    des_bs_job_t job;
+    des_bs_crack_t *crack;
+    uint32_t lanes;
+    const char *core_name;
+    int key_mode;                 // 0 to 3 (i.e. brute force segment 1-4 as 0-indexed)
+    uint64_t prev_ciphertext;     // "IV" of ciphertext for CBC mode in reader mode
+    unsigned char base_key[MFULC_KEY_SIZE];  // the 3DES base key provided by the user
+    lfsr_t lfsr_type;
+    bool is_reader_mode;          // true for -r mode, false for -c mode
+    uint32_t next_candidate;      // start of the next chunk to hand out
+    volatile int key_found;       // set by the worker finding the key, stops the others
+    uint32_t found_index;
+    int found_thread;
+    // The workers stay alive across segments: each job bumps generation, the workers take it
+    // up and the last one to run out of work signals done.
+    int threads;
+    pthread_t *workers;
+    void *worker_args;
+    unsigned int generation;
+    int running;
+    bool quit;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    mfulc_progress_cb *progress;  // NULL for none
+    mfulc_found_cb *found;        // NULL for none
+    int segment;                  // 1-4, the segment being searched
+    int segment_index;            // segments searched before it
+    int segments_left;            // after it
+    uint64_t searched;            // candidates tried in the finished jobs
+    uint64_t start_ms;
+};
+
+lfsr_t mfulc_detect_lfsr_type(const unsigned char *init_ciphertext);
+// Selects the DES core and starts threads workers on a zeroed search. False if they could not be started.
+bool mfulc_search_start(mfulc_search_t *search, int threads);
+void mfulc_search_stop(mfulc_search_t *search);
+// Prepares the job of segment key_mode from the raw ciphertexts, with the other segments
+// taken from the base key.
+void mfulc_setup_job(mfulc_search_t *search, int key_mode, unsigned char blocks[][MFULC_BLOCK_SIZE], int block_count);
+// Searches the prepared job, returns whether the key was found.
+bool mfulc_run_job(mfulc_search_t *search);
+// Substitutes the candidate idx into the segment key_mode of key.
+void mfulc_apply_candidate(unsigned char *key, int key_mode, uint32_t idx);
+// Counterfeit key recovery of all segments into base_key, in the order 2, 1, 4, 3: ciphertexts[s] is the
+// ERndB of segment s + 1, taken with the segments searched before it holding the card key and all others
+// zeroed. lfsr_type must be set. Returns false at the first segment without a match, left in segment.
+bool mfulc_search_segments(mfulc_search_t *search, unsigned char ciphertexts[4][MFULC_BLOCK_SIZE]);
+
+#endif
@@ -6,17 +6,11 @@
 #include <ctype.h>
 #include "parity.h"
 
-#if WIN32
-#include "windows.h"
-#else
-#include "unistd.h"
-#endif
-
 #include "pthread.h"
 #include "nested_util.h"
 
 
-#define MEM_CHUNK               10000
+#define ARENA_KEYS              (1 << 17)   // about two candidates worth of states
 #define TRY_KEYS                50
 
 
@@ -27,225 +21,260 @@ typedef struct {
 
 typedef struct {
     NtpKs1 *pNK;
+    uint32_t sizePNK;
     uint32_t authuid;
 
+    // next candidate to decrypt, shared by all threads
+    uint32_t *nextPos;
+    pthread_mutex_t *nextLock;
+    uint32_t threadCount;
+
+    // keystreams and lfsr inputs of the candidates taken, batched through one workspace
+    uint32_t *ks1;
+    uint32_t *ntProbe;
+
+    // per thread arena, grown by doubling
     uint64_t *keys;
     uint32_t keyCount;
-
-    uint32_t startPos;
-    uint32_t endPos;
+    uint32_t keyCapacity;
+    bool is_ok;
 } RecPar;
 
 
-inline static int compar_int(const void *a, const void *b) {
-    if (*(uint64_t *)b == *(uint64_t *)a) return 0;
-    if (*(uint64_t *)b < * (uint64_t *)a) return 1;
-    return -1;
+// Compare countKeys structure: most seen first, then by key
+static int compar_special_int(const void *a, const void *b) {
+    const countKeys *ka = (const countKeys *)a, *kb = (const countKeys *)b;
+    if (ka->count != kb->count) return kb->count - ka->count;
+    if (ka->key != kb->key) return (ka->key > kb->key) ? 1 : -1;
+    return 0;
 }
 
-// Compare countKeys structure
-int compar_special_int(const void *a, const void *b) {
-    return (((countKeys *)b)->count - ((countKeys *)a)->count);
+// LSD radix sort of 48-bit keys, 16 bits per pass. Returns whichever buffer holds the result.
+static uint64_t *radix_sort_keys(uint64_t *keys, uint64_t *tmp, uint32_t size) {
+    uint32_t *hist = malloc((1 << 16) * sizeof(uint32_t));
+    if (hist == NULL) {
+        return NULL;
+    }
+    for (uint32_t shift = 0; shift < 48; shift += 16) {
+        memset(hist, 0, (1 << 16) * sizeof(uint32_t));
+        for (uint32_t i = 0; i < size; i++) {
+            hist[(keys[i] >> shift) & 0xFFFF]++;
+        }
+        uint32_t sum = 0;
+        for (uint32_t d = 0; d < (1 << 16); d++) {
+            uint32_t c = hist[d];
+            hist[d] = sum;
+            sum += c;
+        }
+        for (uint32_t i = 0; i < size; i++) {
+            tmp[hist[(keys[i] >> shift) & 0xFFFF]++] = keys[i];
+        }
+        uint64_t *swap = keys;
+        keys = tmp;
+        tmp = swap;
+    }
+    free(hist);
+    return keys;
 }
 
-// keys qsort and unique.
-countKeys *uniqsort(uint64_t *possibleKeys, uint32_t size) {
-    unsigned int i, j = 0;
-    int count = 0;
-    countKeys *our_counts;
-
-    qsort(possibleKeys, size, sizeof(uint64_t), compar_int);
-
-    our_counts = calloc(size, sizeof(countKeys));
-    if (our_counts == NULL) {
-        printf("Memory allocation error for our_counts");
-        exit(EXIT_FAILURE);
+// keys sort and count, only the keys seen more than once are kept, most seen first.
+static countKeys *uniqsort(uint64_t *possibleKeys, uint32_t size, uint32_t *uniqCount) {
+    *uniqCount = 0;
+    uint64_t *tmp = malloc(size * sizeof(uint64_t));
+    if (tmp == NULL) {
+        return NULL;
+    }
+    uint64_t *sorted = radix_sort_keys(possibleKeys, tmp, size);
+    if (sorted == NULL) {
+        free(tmp);
+        return NULL;
     }
 
-    for (i = 0; i < size; i++) {
-        if (possibleKeys[i + 1] == possibleKeys[i]) {
-            count++;
-        } else {
-            our_counts[j].key = possibleKeys[i];
-            our_counts[j].count = count;
-            j++;
-            count = 0;
+    countKeys *our_counts = calloc(size / 2 + 1, sizeof(countKeys));
+    if (our_counts != NULL) {
+        uint32_t j = 0;
+        for (uint32_t i = 0; i < size;) {
+            uint32_t run = 1;
+            while (i + run < size && sorted[i + run] == sorted[i]) {
+                run++;
+            }
+            if (run > 1) {
+                our_counts[j].key = sorted[i];
+                our_counts[j].count = run - 1;
+                j++;
+            }
+            i += run;
         }
+        qsort(our_counts, j, sizeof(countKeys), compar_special_int);
+        *uniqCount = j;
     }
-    qsort(our_counts, j, sizeof(countKeys), compar_special_int);
-    return (our_counts);
+    free(tmp);
+    return our_counts;
 }
 
-// nested decrypt
-static void *nested_revover(void *args) {
-    struct Crypto1State *revstate, *revstate_start = NULL;
-    uint64_t lfsr = 0;
-    uint32_t i, kcount = 0;
-    bool is_ok = true;
-
-    RecPar *rp = (RecPar *)args;
-
-    rp->keyCount = 0;
-    rp->keys = NULL;
+// takes a share of the remaining candidates, smaller as they run out so no thread idles while others still have work
+static uint32_t next_candidates(RecPar *rp, uint32_t *pos) {
+    pthread_mutex_lock(rp->nextLock);
+    *pos = *rp->nextPos;
+    uint32_t count = (rp->sizePNK - *pos + rp->threadCount - 1) / rp->threadCount;
+    *rp->nextPos += count;
+    pthread_mutex_unlock(rp->nextLock);
+    return count;
+}
 
-    //printf("Start pos is %d, End pos is %d\r\n", rp->startPos, rp->endPos);
+static bool add_candidate_keys(struct Crypto1State *revstate, size_t index, void *arg) {
+    RecPar *rp = (RecPar *)arg;
+    uint32_t nt_probe = rp->ntProbe[index];
 
-    for (i = rp->startPos; i < rp->endPos; i++) {
-        uint32_t nt_probe = rp->pNK[i].ntp ^ rp->authuid;
-        uint32_t ks1 = rp->pNK[i].ks1;
+    while ((revstate->odd != 0x0) || (revstate->even != 0x0)) {
+        if (rp->keyCount == rp->keyCapacity) {
+            void *tmp = realloc(rp->keys, 2 * (size_t)rp->keyCapacity * sizeof(uint64_t));
+            if (tmp == NULL) {
+                printf("Memory allocation error for pk->possibleKeys");
+                rp->is_ok = false;
+                return false;
+            }
+            rp->keys = (uint64_t *)tmp;
+            rp->keyCapacity *= 2;
+        }
+        lfsr_rollback_word(revstate, nt_probe, 0);
+        crypto1_get_lfsr(revstate, &rp->keys[rp->keyCount++]);
+        revstate++;
+    }
+    return true;
+}
 
-        /*
-        printf("     ntp = %"PRIu32"\r\n", nt_probe);
-        printf("     ks1 = %"PRIu32"\r\n", ks1);
-        printf("\r\n");
-        */
+// nested decrypt, the candidates taken go through lfsr_recovery32_batch together
+static void *nested_revover(void *args) {
+    uint32_t i, pos, count;
 
-        // And finally recover the first 32 bits of the key
-        revstate = lfsr_recovery32(ks1, nt_probe);
-        if (revstate_start == NULL) {
-            revstate_start = revstate;
-        }
+    RecPar *rp = (RecPar *)args;
 
-        while ((revstate->odd != 0x0) || (revstate->even != 0x0)) {
-            lfsr_rollback_word(revstate, nt_probe, 0);
-            crypto1_get_lfsr(revstate, &lfsr);
-            if (((kcount % MEM_CHUNK) == 0) || (kcount >= rp->keyCount)) {
-                rp->keyCount += MEM_CHUNK;
-                // printf("New chunk by %d, sizeof %lu\n", kcount, rp->keyCount * sizeof(uint64_t));
-                void *tmp = realloc(rp->keys, rp->keyCount * sizeof(uint64_t));
-                if (tmp == NULL) {
-                    printf("Memory allocation error for pk->possibleKeys");
-                    rp->keyCount = 0;
-                    is_ok = false;
-                    break;
-                }
-                rp->keys = (uint64_t *)tmp;
-            }
-            rp->keys[kcount] = lfsr;
-            kcount++;
-            revstate++;
-        }
-        --kcount;
-        free(revstate_start);
-        revstate_start = NULL;
-        if (!is_ok) {
-            break;
-        }
+    // one recovery workspace per thread, reused for all its candidates
+    struct Crypto1Recovery *ctx = lfsr_recovery_create();
+    if (ctx == NULL) {
+        printf("Memory allocation error for lfsr_recovery_create");
+        rp->is_ok = false;
+        return NULL;
     }
-    if (is_ok) {
-        if (kcount != 0) {
-            rp->keyCount = kcount;
-            void *tmp = (uint64_t *)realloc(rp->keys, rp->keyCount * sizeof(uint64_t));
-            if (tmp == NULL) {
-                printf("Memory allocation error for pk->possibleKeys");
-                rp->keyCount = 0;
-                free(rp->keys);
-            } else {
-                rp->keys = tmp;
-            }
+
+    while (rp->is_ok && (count = next_candidates(rp, &pos)) != 0) {
+        for (i = 0; i < count; i++) {
+            rp->ks1[i] = rp->pNK[pos + i].ks1;
+            rp->ntProbe[i] = rp->pNK[pos + i].ntp ^ rp->authuid;
         }
-    } else {
-        rp->keyCount = 0;
-        free(rp->keys);
+        // And finally recover the first 32 bits of the key
+        lfsr_recovery32_batch(ctx, rp->ks1, rp->ntProbe, count, add_candidate_keys, rp);
     }
+    lfsr_recovery_destroy(ctx);
     return NULL;
 }
 
-uint64_t *nested(NtpKs1 *pNK, uint32_t sizePNK, uint32_t authuid, uint32_t *keyCount) {
-#define THREAD_MAX 4
-
+uint64_t *nested(NtpKs1 *pNK, uint32_t sizePNK, uint32_t authuid, uint32_t *keyCount, uint64_t *candidateCount,
+                 uint32_t threadCount) {
     *keyCount = 0;
     uint32_t i, j, manyThread;
     uint64_t *keys = (uint64_t *)NULL;
+    bool is_ok = true;
+
+    if (sizePNK == 0) {
+        return NULL;
+    }
 
-    manyThread = THREAD_MAX;
+    manyThread = threadCount ? threadCount : 1;
     if (manyThread > sizePNK) {
         manyThread = sizePNK;
     }
 
     // pthread handle
-    pthread_t *threads = calloc(sizePNK, sizeof(pthread_t));
+    pthread_t *threads = calloc(manyThread, sizeof(pthread_t));
     if (threads == NULL)  return NULL;
 
     // Param
-    RecPar *pRPs = calloc(sizePNK, sizeof(RecPar));
+    RecPar *pRPs = calloc(manyThread, sizeof(RecPar));
     if (pRPs == NULL) {
         free(threads);
         return NULL;
     }
 
-    uint32_t average = sizePNK / manyThread;
-    uint32_t modules = sizePNK % manyThread;
+    uint32_t nextPos = 0;
+    pthread_mutex_t nextLock;
+    pthread_mutex_init(&nextLock, NULL);
 
     // Assign tasks
-    for (i = 0, j = 0; i < manyThread; i++, j += average) {
+    for (i = 0; i < manyThread; i++) {
         pRPs[i].pNK = pNK;
+        pRPs[i].sizePNK = sizePNK;
         pRPs[i].authuid = authuid;
-        pRPs[i].startPos = j;
-        pRPs[i].endPos = j + average;
-        pRPs[i].keys = NULL;
-        // last thread can decrypt more pNK
-        if (i == (manyThread - 1) && modules > 0) {
-            (pRPs[i].endPos) += modules;
-        }
+        pRPs[i].nextPos = &nextPos;
+        pRPs[i].nextLock = &nextLock;
+        pRPs[i].threadCount = manyThread;
+        pRPs[i].ks1 = malloc(sizePNK * sizeof(uint32_t));
+        pRPs[i].ntProbe = malloc(sizePNK * sizeof(uint32_t));
+        pRPs[i].keyCapacity = ARENA_KEYS;
+        pRPs[i].keys = malloc(ARENA_KEYS * sizeof(uint64_t));
+        pRPs[i].is_ok = (pRPs[i].keys != NULL) && (pRPs[i].ks1 != NULL) && (pRPs[i].ntProbe != NULL);
         pthread_create(&threads[i], NULL, nested_revover, &(pRPs[i]));
     }
 
+    uint32_t total = 0;
     for (i = 0; i < manyThread; i++) {
         // wait thread exit...
         pthread_join(threads[i], NULL);
-        *keyCount += pRPs[i].keyCount;
+        total += pRPs[i].keyCount;
+        is_ok = is_ok && pRPs[i].is_ok;
     }
     free(threads);
+    pthread_mutex_destroy(&nextLock);
+    if (candidateCount != NULL) {
+        *candidateCount = total;
+    }
 
-    if (*keyCount != 0) {
-        keys = malloc((*keyCount) * sizeof(uint64_t));
-        if (keys != NULL) {
-            for (i = 0, j = 0; i < manyThread; i++) {
-                if (pRPs[i].keyCount > 0) {
-                    // printf("The thread %d recover %d keys.\r\n", i, pRPs[i].keyCount);
-                    if (pRPs[i].keys != NULL) {
-                        memcpy(
-                            keys + j,
-                            pRPs[i].keys,
-                            pRPs[i].keyCount * sizeof(uint64_t)
-                        );
-                        j += pRPs[i].keyCount;
-                        free(pRPs[i].keys);
-                    }
-                }
-            }
+    uint64_t *allKeys = NULL;
+    if (is_ok && total != 0) {
+        allKeys = malloc(total * sizeof(uint64_t));
+        if (allKeys == NULL) {
+            printf("Cannot allocate memory to merge keys.\r\n");
+        }
+    }
+    for (i = 0, j = 0; i < manyThread; i++) {
+        if (allKeys != NULL) {
+            memcpy(allKeys + j, pRPs[i].keys, pRPs[i].keyCount * sizeof(uint64_t));
+            j += pRPs[i].keyCount;
+        }
+        free(pRPs[i].keys);
+        free(pRPs[i].ks1);
+        free(pRPs[i].ntProbe);
+    }
+    free(pRPs);
 
-            countKeys *ck = uniqsort(keys, *keyCount);
-            free(keys);
-            keys = (uint64_t *)NULL;
-            *keyCount = 0;
-
-            if (ck != NULL) {
-                for (i = 0; i < TRY_KEYS; i++) {
-                    // We don't known this key, try to break it
-                    // This key can be found here two or more times
-                    if (ck[i].count > 0) {
-                        *keyCount += 1;
-                        void *tmp = realloc(keys, sizeof(uint64_t) * (*keyCount));
-                        if (tmp != NULL) {
-                            keys = tmp;
-                            keys[*keyCount - 1] = ck[i].key;
-                        } else {
-                            printf("Cannot allocate memory for keys on merge.");
-                            free(keys);
-                            break;
-                        }
+    if (allKeys != NULL) {
+        uint32_t uniqCount = 0;
+        countKeys *ck = uniqsort(allKeys, total, &uniqCount);
+        free(allKeys);
+
+        if (ck != NULL) {
+            // We don't known this key, try to break it
+            // This key can be found here two or more times
+            if (uniqCount > TRY_KEYS) {
+                uniqCount = TRY_KEYS;
+            }
+            if (uniqCount > 0) {
+                keys = malloc(uniqCount * sizeof(uint64_t));
+                if (keys != NULL) {
+                    for (i = 0; i < uniqCount; i++) {
+                        keys[i] = ck[i].key;
                     }
+                    *keyCount = uniqCount;
+                } else {
+                    printf("Cannot allocate memory for keys on merge.");
                 }
-            } else {
-                printf("Cannot allocate memory for ck on uniqsort.");
             }
+            free(ck);
         } else {
-            printf("Cannot allocate memory to merge keys.\r\n");
+            printf("Cannot allocate memory for ck on uniqsort.");
         }
     }
-    free(pRPs);
     return keys;
 }
 
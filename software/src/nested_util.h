@@ -9,6 +9,9 @@ typedef struct {
 } NtpKs1;
 
 uint8_t valid_nonce(uint32_t Nt, uint32_t NtEnc, uint32_t Ks1, uint8_t *parity);
-uint64_t *nested(NtpKs1 *pNK, uint32_t sizePNK, uint32_t authuid, uint32_t *keyCount);
+// threadCount: worker threads, at most one per candidate is used
+// candidateCount, if not NULL, gets the number of keys recovered from all candidates before counting duplicates
+uint64_t *nested(NtpKs1 *pNK, uint32_t sizePNK, uint32_t authuid, uint32_t *keyCount, uint64_t *candidateCount,
+                 uint32_t threadCount);
 
 #endif
@@ -0,0 +1,207 @@
+// Shared helpers of the FM11RF08S static nested tools
+//
+//  Doegox, 2024, cf https://eprint.iacr.org/2024/1275 for more info
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <time.h>
+#endif
+
+#include "pthread.h"
+#include "common.h"
+#include "rf08s_util.h"
+
+static uint16_t i_lfsr16[1 << 16] = {0};
+static uint16_t s_lfsr16[1 << 16] = {0};
+// jump tables: 14 and 8 steps back through the 16-bit LFSR in one lookup
+static uint16_t prev14_lfsr16[1 << 16] = {0};
+static uint16_t prev8_lfsr16[1 << 16] = {0};
+// nibble substitution of one key byte, for even and odd byte positions
+static uint16_t key_xor_lfsr16[2][1 << 8] = {{0}};
+
+// static uint16_t next_lfsr16(uint16_t nonce) {
+//     uint16_t i = i_lfsr16[nonce];
+//     if (i == 0xffff) {
+//         i = 1;
+//     } else {
+//         i++;
+//     }
+//     return s_lfsr16[i];
+// }
+
+static uint16_t prev_lfsr16(uint16_t nonce) {
+    uint16_t i = i_lfsr16[nonce];
+    if (i == 1) {
+        i = 0xffff;
+    } else {
+        i--;
+    }
+    return s_lfsr16[i];
+}
+
+static pthread_once_t lfsr16_once = PTHREAD_ONCE_INIT;
+
+static void fill_lfsr16_tables(void) {
+    uint16_t x = 1;
+    for (uint16_t i = 1; i; ++i) {
+        i_lfsr16[(x & 0xff) << 8 | x >> 8] = i;
+        s_lfsr16[i] = (x & 0xff) << 8 | x >> 8;
+        x = x >> 1 | (x ^ x >> 2 ^ x >> 3 ^ x >> 5) << 15;
+    }
+
+    for (uint32_t n = 0; n < (1 << 16); n++) {
+        uint16_t nt = n;
+        for (uint8_t i = 0; i < 8; i++) {
+            nt = prev_lfsr16(nt);
+        }
+        prev8_lfsr16[n] = nt;
+        for (uint8_t i = 8; i < 14; i++) {
+            nt = prev_lfsr16(nt);
+        }
+        prev14_lfsr16[n] = nt;
+    }
+
+    const uint8_t a[] = {0, 8, 9, 4, 6, 11, 1, 15, 12, 5, 2, 13, 10, 14, 3, 7};
+    const uint8_t b[] = {0, 13, 1, 14, 4, 10, 15, 7, 5, 3, 8, 6, 9, 2, 12, 11};
+    for (uint16_t k = 0; k < (1 << 8); k++) {
+        key_xor_lfsr16[0][k] = a[k & 0xF] | b[k >> 4] << 4;
+        key_xor_lfsr16[1][k] = b[k & 0xF] | a[k >> 4] << 4;
+    }
+}
+
+// builds the tables on the first call, also when several threads make it at once
+void init_lfsr16_table(void) {
+    pthread_once(&lfsr16_once, fill_lfsr16_tables);
+}
+
+uint16_t compute_seednt16_nt32(uint32_t nt32, uint64_t key) {
+    uint16_t nt = prev14_lfsr16[nt32 >> 16];
+    for (uint8_t i = 0; i < 6; i++) {
+        nt = prev8_lfsr16[nt ^ key_xor_lfsr16[i & 1][(key >> (8 * i)) & 0xFF]];
+    }
+    return nt;
+}
+
+typedef struct {
+    uint32_t nt32;
+    const uint64_t *keys;
+    uint16_t *seeds;
+    uint32_t start;
+    uint32_t end;
+} SeedJob;
+
+static void *compute_seeds_thread(void *arg) {
+    SeedJob *job = (SeedJob *)arg;
+    for (uint32_t i = job->start; i < job->end; i++) {
+        job->seeds[i] = compute_seednt16_nt32(job->nt32, job->keys[i]);
+    }
+    return NULL;
+}
+
+// seeds[i] = compute_seednt16_nt32(nt32, keys[i]), split over threadCount threads
+void compute_seeds(uint32_t nt32, const uint64_t *keys, uint16_t *seeds, uint32_t count, uint32_t threadCount) {
+    uint32_t manyThread = threadCount;
+    if (manyThread > count) {
+        manyThread = count;
+    }
+
+    pthread_t *threads = calloc(manyThread, sizeof(pthread_t));
+    SeedJob *jobs = calloc(manyThread, sizeof(SeedJob));
+    if ((threads == NULL) || (jobs == NULL) || (manyThread < 2)) {
+        // not worth (or not possible) to spawn threads
+        free(threads);
+        free(jobs);
+        for (uint32_t i = 0; i < count; i++) {
+            seeds[i] = compute_seednt16_nt32(nt32, keys[i]);
+        }
+        return;
+    }
+
+    uint32_t average = count / manyThread;
+    uint32_t modules = count % manyThread;
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < manyThread; i++) {
+        jobs[i].nt32 = nt32;
+        jobs[i].keys = keys;
+        jobs[i].seeds = seeds;
+        jobs[i].start = start;
+        start += average + (i < modules ? 1 : 0);
+        jobs[i].end = start;
+        pthread_create(&threads[i], NULL, compute_seeds_thread, &jobs[i]);
+    }
+    for (uint32_t i = 0; i < manyThread; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    free(jobs);
+}
+
+int32_t rf08s_filter_keys(uint32_t nt1, const uint64_t *keys1, uint32_t count1, uint8_t *keep1,
+                          uint32_t nt2, const uint64_t *keys2, uint32_t count2, uint8_t *keep2, uint32_t threadCount) {
+    uint16_t *seednt1 = (uint16_t *)calloc(count1 + 1, sizeof(uint16_t));
+    uint16_t *seednt2 = (uint16_t *)calloc(count2 + 1, sizeof(uint16_t));
+    // which 16-bit seeds occur in keys1, then in keys2
+    uint8_t *seen = (uint8_t *)calloc(2 << 16, sizeof(uint8_t));
+    int32_t kept = -1;
+
+    if ((seednt1 != NULL) && (seednt2 != NULL) && (seen != NULL)) {
+        compute_seeds(nt1, keys1, seednt1, count1, threadCount);
+        compute_seeds(nt2, keys2, seednt2, count2, threadCount);
+
+        // A key survives if its seed also occurs on the other side, so a presence table
+        // indexed by the 16-bit seed replaces comparing every pair of keys.
+        for (uint32_t i = 0; i < count1; i++) {
+            seen[seednt1[i]] = 1;
+        }
+        for (uint32_t j = 0; j < count2; j++) {
+            seen[(1 << 16) + seednt2[j]] = 1;
+        }
+        kept = 0;
+        for (uint32_t i = 0; i < count1; i++) {
+            keep1[i] = seen[(1 << 16) + seednt1[i]];
+            kept += keep1[i];
+        }
+        for (uint32_t j = 0; j < count2; j++) {
+            keep2[j] = seen[seednt2[j]];
+            kept += keep2[j];
+        }
+    }
+
+    free(seednt1);
+    free(seednt2);
+    free(seen);
+    return kept;
+}
+
+int32_t rf08s_match_keys(uint32_t nt1, uint64_t key1, uint32_t nt2, uint64_t *keys2, uint32_t count2, uint32_t threadCount) {
+    uint16_t *seednt2 = (uint16_t *)calloc(count2 + 1, sizeof(uint16_t));
+    if (seednt2 == NULL) {
+        return -1;
+    }
+    compute_seeds(nt2, keys2, seednt2, count2, threadCount);
+
+    int32_t found = 0;
+    uint16_t seednt1 = compute_seednt16_nt32(nt1, key1);
+    for (uint32_t i = 0; i < count2; i++) {
+        if (seednt1 == seednt2[i]) {
+            keys2[found++] = keys2[i];
+        }
+    }
+    free(seednt2);
+    return found;
+}
+
+uint64_t msclock(void) {
+#ifdef _WIN32
+    return GetTickCount64();
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000 + t.tv_nsec / 1000000;
+#endif
+}
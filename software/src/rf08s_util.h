@@ -0,0 +1,18 @@
+#ifndef RF08S_UTIL_H__
+#define RF08S_UTIL_H__
+
+#include <stdint.h>
+
+void init_lfsr16_table(void);
+uint16_t compute_seednt16_nt32(uint32_t nt32, uint64_t key);
+void compute_seeds(uint32_t nt32, const uint64_t *keys, uint16_t *seeds, uint32_t count, uint32_t threadCount);
+// keep1[i] is set when the seed of keys1[i] for nt1 is also the seed of a key of keys2 for nt2, and the
+// other way round for keep2. Returns the number of keys kept, -1 on allocation failure.
+int32_t rf08s_filter_keys(uint32_t nt1, const uint64_t *keys1, uint32_t count1, uint8_t *keep1,
+                          uint32_t nt2, const uint64_t *keys2, uint32_t count2, uint8_t *keep2, uint32_t threadCount);
+// Moves the keys of keys2 whose seed for nt2 is the seed of key1 for nt1 to its start, returns
+// their count, -1 on allocation failure.
+int32_t rf08s_match_keys(uint32_t nt1, uint64_t key1, uint32_t nt2, uint64_t *keys2, uint32_t count2, uint32_t threadCount);
+uint64_t msclock(void);
+
+#endif
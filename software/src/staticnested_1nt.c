@@ -17,6 +17,7 @@
 #include "common.h"
 #include "crapto1.h"
 #include "parity.h"
+#include "dic_util.h"
 
 #define KEY_SPACE_SIZE (1 << 18)
 
@@ -110,9 +111,11 @@ static uint64_t *generate_keys(uint64_t authuid, uint32_t nt, uint32_t nt_enc, u
 
 int main(int argc, char *const argv[]) {
 
-    if (argc != 6) {
+    bool text = (argc == 7) && (strcmp(argv[6], "--text") == 0);
+    if ((argc != 6) && !text) {
         int cmdlen = strlen(argv[0]);
-        printf("Usage:\n  %s <uid:hex> <sector:dec> <nt:hex> <nt_enc:hex> <nt_par_err:bin>\n"
+        printf("Usage:\n  %s <uid:hex> <sector:dec> <nt:hex> <nt_enc:hex> <nt_par_err:bin> [--text]\n"
+               "  the dictionary is binary unless --text asks for one hex key per line\n"
                "  parity example:  if for block 63 == sector 15, nt in trace is 7b! fc! 7a! 5b\n"
                "                   then nt_enc is 7bfc7a5b and nt_par_err is 1110\n"
                "Example:\n"
@@ -161,21 +164,11 @@ int main(int argc, char *const argv[]) {
 
     printf("Finding phase complete, found %u keys\n", keyCount);
 
-    FILE *fptr;
     char filename[30];
     snprintf(filename, sizeof(filename), "keys_%08x_%02u_%08x.dic", authuid, sector, nt);
 
-    fptr = fopen(filename, "w");
-    if (fptr != NULL) {
-        if (keyCount > 0) {
-            for (uint32_t j = 0; j < keyCount; j++) {
-                fprintf(fptr, "%012" PRIx64 "\n", keys[j]);
-            }
-        }
-        fclose(fptr);
-    } else {
-        fprintf(stderr, "Warning: Cannot save keys in %s\n", filename);
-    }
+    KeyDicInfo info = { .binary = !text, .uid = authuid, .sector = sector, .nt = nt };
+    save_key_dic(filename, &info, keys, keyCount);
 
     if (keys != NULL) {
         free(keys);
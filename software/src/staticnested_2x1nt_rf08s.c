@@ -17,78 +17,12 @@
 #include <stdbool.h>
 #include <string.h>
 #include <inttypes.h>
+#include "common.h"
+#include "rf08s_util.h"
+#include "dic_util.h"
 
-uint16_t i_lfsr16[1 << 16] = {0};
-uint16_t s_lfsr16[1 << 16] = {0};
-
-static void init_lfsr16_table(void) {
-    uint16_t x = 1;
-    for (uint16_t i = 1; i; ++i) {
-        i_lfsr16[(x & 0xff) << 8 | x >> 8] = i;
-        s_lfsr16[i] = (x & 0xff) << 8 | x >> 8;
-        x = x >> 1 | (x ^ x >> 2 ^ x >> 3 ^ x >> 5) << 15;
-    }
-}
-
-// static uint16_t next_lfsr16(uint16_t nonce) {
-//     uint16_t i = i_lfsr16[nonce];
-//     if (i == 0xffff) {
-//         i = 1;
-//     } else {
-//         i++;
-//     }
-//     return s_lfsr16[i];
-// }
-
-static uint16_t prev_lfsr16(uint16_t nonce) {
-    uint16_t i = i_lfsr16[nonce];
-    if (i == 1) {
-        i = 0xffff;
-    } else {
-        i--;
-    }
-    return s_lfsr16[i];
-}
-
-static uint16_t compute_seednt16_nt32(uint32_t nt32, uint64_t key) {
-    uint8_t a[] = {0, 8, 9, 4, 6, 11, 1, 15, 12, 5, 2, 13, 10, 14, 3, 7};
-    uint8_t b[] = {0, 13, 1, 14, 4, 10, 15, 7, 5, 3, 8, 6, 9, 2, 12, 11};
-    uint16_t nt = nt32 >> 16;
-    uint8_t prev = 14;
-    for (uint8_t i = 0; i < prev; i++) {
-        nt = prev_lfsr16(nt);
-    }
-    uint8_t prevoff = 8;
-    bool odd = 1;
-
-    for (uint8_t i = 0; i < 6 * 8; i += 8) {
-        if (odd) {
-            nt ^= (a[(key >> i) & 0xF]);
-            nt ^= (b[(key >> i >> 4) & 0xF]) << 4;
-        } else {
-            nt ^= (b[(key >> i) & 0xF]);
-            nt ^= (a[(key >> i >> 4) & 0xF]) << 4;
-        }
-        odd ^= 1;
-        prev += prevoff;
-        for (uint8_t j = 0; j < prevoff; j++) {
-            nt = prev_lfsr16(nt);
-        }
-    }
-    return nt;
-}
-
-int main(int argc, char *const argv[]) {
-
-    if (argc != 3) {
-        printf("Usage:\n  %s keys_<uid:08x>_<sector:02>_<nt1:08x>.dic keys_<uid:08x>_<sector:02>_<nt2:08x>.dic\n"
-               "  where both dict files are produced by staticnested_1nt *for the same UID and same sector*\n",
-               argv[0]);
-        return 1;
-    }
-
+static int filter_pair(char *filename1, char *filename2) {
     uint32_t uid1, sector1, nt1, uid2, sector2, nt2;
-    char *filename1 = argv[1], *filename2 = argv[2];
 
     int result = sscanf(filename1, "keys_%8x_%2u_%8x.dic", &uid1, &sector1, &nt1);
     if (result != 3) {
@@ -117,142 +51,75 @@ int main(int argc, char *const argv[]) {
         return 1;
     }
 
-    init_lfsr16_table();
+    uint64_t start_time = msclock();
 
     uint32_t keycount1 = 0;
     uint64_t *keys1 = NULL;
     uint8_t *filter_keys1 = NULL;
-    uint16_t *seednt1 = NULL;
     uint32_t keycount2 = 0;
     uint64_t *keys2 = NULL;
     uint8_t *filter_keys2 = NULL;
-    FILE *fptr;
-
-    fptr = fopen(filename1, "r");
-    if (fptr != NULL) {
-
-        uint64_t buffer;
-        while (fscanf(fptr, "%012" PRIx64, &buffer) == 1) {
-            keycount1++;
-        }
+    KeyDicInfo info1, info2;
 
-        keys1 = (uint64_t *)calloc(1, keycount1 * sizeof(uint64_t));
-        filter_keys1 = (uint8_t *)calloc(keycount1, sizeof(uint8_t));
-        if ((keys1 == NULL) || (filter_keys1 == NULL)) {
-            perror("Failed to allocate memory");
-            fclose(fptr);
-            goto end;
-        }
-
-        rewind(fptr);
-
-        for (uint32_t i = 0; i < keycount1; i++) {
-            if (fscanf(fptr, "%012" PRIx64, &keys1[i]) != 1) {
-                perror("Failed to read key");
-                fclose(fptr);
-                goto end;
-            }
-        }
-        fclose(fptr);
-    } else {
-        fprintf(stderr, "Warning: Cannot open %s\n", filename1);
+    keys1 = load_key_dic(filename1, &info1, &keycount1);
+    keys2 = load_key_dic(filename2, &info2, &keycount2);
+    if ((keys1 == NULL) || (keys2 == NULL)) {
+        goto end;
+    }
+    if ((info1.binary && (info1.uid != uid1 || info1.sector != sector1 || info1.nt != nt1)) ||
+            (info2.binary && (info2.uid != uid2 || info2.sector != sector2 || info2.nt != nt2))) {
+        fprintf(stderr, "Error: Dictionary header does not match its filename.\n");
         goto end;
     }
 
-    fptr = fopen(filename2, "r");
-    if (fptr != NULL) {
-
-        uint64_t buffer;
-        while (fscanf(fptr, "%012" PRIx64, &buffer) == 1) {
-            keycount2++;
-        }
-
-        keys2 = (uint64_t *)calloc(1, keycount2 * sizeof(uint64_t));
-        filter_keys2 = (uint8_t *)calloc(keycount2, sizeof(uint8_t));
-        if ((keys2 == NULL) || (filter_keys2 == NULL)) {
-            perror("Failed to allocate memory");
-            fclose(fptr);
-            goto end;
-        }
-
-        rewind(fptr);
-
-        for (uint32_t i = 0; i < keycount2; i++) {
-            if (fscanf(fptr, "%012" PRIx64, &keys2[i]) != 1) {
-                perror("Failed to read key");
-                fclose(fptr);
-                goto end;
-            }
-        }
-        fclose(fptr);
-    } else {
-        fprintf(stderr, "Warning: Cannot open %s\n", filename2);
+    filter_keys1 = (uint8_t *)calloc(keycount1 + 1, sizeof(uint8_t));
+    filter_keys2 = (uint8_t *)calloc(keycount2 + 1, sizeof(uint8_t));
+    if ((filter_keys1 == NULL) || (filter_keys2 == NULL)) {
+        perror("Failed to allocate memory");
         goto end;
     }
 
     printf("%s: %u keys loaded\n", filename1, keycount1);
     printf("%s: %u keys loaded\n", filename2, keycount2);
 
-    seednt1 = (uint16_t *)calloc(1, keycount1 * sizeof(uint16_t));
-    if (seednt1 == NULL) {
+    uint64_t filter_time = msclock();
+    if (rf08s_filter_keys(nt1, keys1, keycount1, filter_keys1, nt2, keys2, keycount2, filter_keys2, num_cpus()) < 0) {
         perror("Failed to allocate memory");
         goto end;
     }
+    filter_time = msclock() - filter_time;
 
-    for (uint32_t i = 0; i < keycount1; i++) {
-        seednt1[i] = compute_seednt16_nt32(nt1, keys1[i]);
-    }
-
-    for (uint32_t j = 0; j < keycount2; j++) {
-        uint16_t seednt2 = compute_seednt16_nt32(nt2, keys2[j]);
-        for (uint32_t i = 0; i < keycount1; i++) {
-            if (seednt2 == seednt1[i]) {
-//                printf("MATCH: key1=%012" PRIx64 " key2=%012" PRIx64 "\n", keys1[i], keys2[j]);
-                filter_keys1[i] = 1;
-                filter_keys2[j] = 1;
-            }
-        }
-    }
-
+    // filtered dictionaries keep the format of their input, compacted in place
     char filter_filename1[40];
     uint32_t filter_keycount1 = 0;
     snprintf(filter_filename1, sizeof(filter_filename1), "keys_%08x_%02u_%08x_filtered.dic", uid1, sector1, nt1);
-
-    fptr = fopen(filter_filename1, "w");
-    if (fptr != NULL) {
-
-        for (uint32_t j = 0; j < keycount1; j++) {
-            if (filter_keys1[j]) {
-                filter_keycount1++;
-                fprintf(fptr, "%012" PRIx64 "\n", keys1[j]);
-            }
+    for (uint32_t j = 0; j < keycount1; j++) {
+        if (filter_keys1[j]) {
+            keys1[filter_keycount1++] = keys1[j];
         }
-        fclose(fptr);
-
-    } else {
-        fprintf(stderr, "Warning: Cannot save keys in %s\n", filter_filename1);
     }
+    info1.uid = uid1;
+    info1.sector = sector1;
+    info1.nt = nt1;
+    save_key_dic(filter_filename1, &info1, keys1, filter_keycount1);
 
     char filter_filename2[40];
     uint32_t filter_keycount2 = 0;
     snprintf(filter_filename2, sizeof(filter_filename2), "keys_%08x_%02u_%08x_filtered.dic", uid2, sector2, nt2);
-
-    fptr = fopen(filter_filename2, "w");
-    if (fptr != NULL) {
-
-        for (uint32_t j = 0; j < keycount2; j++) {
-            if (filter_keys2[j]) {
-                filter_keycount2++;
-                fprintf(fptr, "%012" PRIx64 "\n", keys2[j]);
-            }
+    for (uint32_t j = 0; j < keycount2; j++) {
+        if (filter_keys2[j]) {
+            keys2[filter_keycount2++] = keys2[j];
         }
-        fclose(fptr);
-
-    } else {
-        fprintf(stderr, "Warning: Cannot save keys in %s\n", filter_filename2);
     }
+    info2.uid = uid2;
+    info2.sector = sector2;
+    info2.nt = nt2;
+    save_key_dic(filter_filename2, &info2, keys2, filter_keycount2);
+
     printf("%s: %u keys saved\n", filter_filename1, filter_keycount1);
     printf("%s: %u keys saved\n", filter_filename2, filter_keycount2);
+    printf("Filter: %.3fs (%d threads), total: %.3fs\n",
+           filter_time / 1000.0, num_cpus(), (msclock() - start_time) / 1000.0);
 
 end:
     if (keys1 != NULL) {
@@ -271,9 +138,25 @@ end:
         free(filter_keys2);
     }
 
-    if (seednt1 != NULL) {
-        free(seednt1);
+    return 0;
+}
+
+int main(int argc, char *const argv[]) {
+
+    if ((argc < 3) || ((argc - 1) % 2 != 0)) {
+        printf("Usage:\n  %s keys_<uid:08x>_<sector:02>_<nt1:08x>.dic keys_<uid:08x>_<sector:02>_<nt2:08x>.dic [more pairs...]\n"
+               "  where both dict files of a pair are produced by staticnested_1nt *for the same UID and same sector*\n",
+               argv[0]);
+        return 1;
     }
 
-    return 0;
+    init_lfsr16_table();
+
+    int ret = 0;
+    for (int i = 1; i < argc; i += 2) {
+        if (filter_pair(argv[i], argv[i + 1]) != 0) {
+            ret = 1;
+        }
+    }
+    return ret;
 }